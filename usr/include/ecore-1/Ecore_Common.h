@@ -461,6 +461,119 @@ EAPI void ecore_main_loop_thread_safe_call_async(Ecore_Cb callback, void *data);
  */
 EAPI void *ecore_main_loop_thread_safe_call_sync(Ecore_Data_Cb callback, void *data);
 
+/**
+ * @typedef Ecore_Thread_Safe_Call_Stats
+ * Counters of ecore_main_loop_thread_safe_call_fast().
+ */
+typedef struct _Ecore_Thread_Safe_Call_Stats
+{
+   unsigned long long posted; /**< Calls put in the ring */
+   unsigned long long wakeups; /**< Times the main loop was woken up for them */
+   unsigned long long dispatched; /**< Calls run in the main loop */
+   unsigned long long full; /**< Calls that found the ring full and were kept aside */
+   unsigned int drain_max; /**< Most calls run in one wakeup */
+   unsigned int size; /**< Slots of the ring */
+} Ecore_Thread_Safe_Call_Stats;
+
+/**
+ * @brief Call callback asynchronously in the main loop, without allocating.
+ *
+ * @param callback The callback to call in the main loop
+ * @param data The data to give to that call back
+ *
+ * This is ecore_main_loop_thread_safe_call_async() for threads posting many
+ * small results. The call goes in a bounded lock-free ring instead of an
+ * allocated node, and the main loop is woken up through an eventfd only if
+ * it was not already about to drain the ring, so a burst of calls costs a
+ * single wakeup. The main loop runs the calls in the order they were put
+ * in the ring.
+ *
+ * When the ring is full a thread waits a little for the main loop to make
+ * room, then keeps its call in a list until the ring is drained past it,
+ * as the main loop may be waiting for that thread. The main loop does not
+ * wait at all. The calls of a thread still run after those it put in the
+ * ring earlier and before those it puts later.
+ *
+ * ecore_main_loop_thread_safe_call_shutdown() has to be called before
+ * ecore_shutdown().
+ *
+ * @see ecore_main_loop_thread_safe_call_batch()
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline void ecore_main_loop_thread_safe_call_fast(Ecore_Cb callback, void *data);
+
+/**
+ * @brief Call a callback asynchronously in the main loop for each data.
+ *
+ * @param callback The callback to call in the main loop
+ * @param data The data to give to each call, @p count of them
+ * @param count How many calls to make
+ *
+ * Like @p count calls to ecore_main_loop_thread_safe_call_fast(), with at
+ * most one wakeup of the main loop for all of them.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline void ecore_main_loop_thread_safe_call_batch(Ecore_Cb callback, void * const *data, unsigned int count);
+
+/**
+ * @brief Set the number of slots of the ring of
+ * ecore_main_loop_thread_safe_call_fast().
+ *
+ * @param size The number of slots, rounded up to a power of two, 4096 by
+ * default.
+ * @return @c EINA_TRUE on success, @c EINA_FALSE if the ring is already in
+ * use.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool ecore_main_loop_thread_safe_call_ring_size_set(unsigned int size);
+
+/**
+ * @brief Run the calls waiting in the ring now.
+ *
+ * Note: This function should only be called in the main loop.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline void ecore_main_loop_thread_safe_call_flush(void);
+
+/**
+ * @brief Run the calls waiting in the ring and free it.
+ *
+ * The ring is watched by a fd handler of the main loop, which does not
+ * survive ecore_shutdown(). This has to be called before it, from the
+ * main loop and once no thread posts calls anymore, so no call is left
+ * behind. The next call to ecore_main_loop_thread_safe_call_fast() after
+ * ecore_init() makes a new ring.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline void ecore_main_loop_thread_safe_call_shutdown(void);
+
+/**
+ * @brief Get the counters of ecore_main_loop_thread_safe_call_fast().
+ *
+ * @param stats Where to store the counters.
+ * @return @c EINA_TRUE on success, @c EINA_FALSE if the ring was never used.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool ecore_main_loop_thread_safe_call_stats_get(Ecore_Thread_Safe_Call_Stats *stats);
+
 /**
  * @brief Wait for the next thread call in the main loop.
  * @since 1.13.0
@@ -1777,6 +1890,175 @@ EAPI Ecore_Win32_Handler *ecore_main_win32_handler_add(void *h, Ecore_Win32_Hand
  */
 EAPI void *ecore_main_win32_handler_del(Ecore_Win32_Handler *win32_handler);
 
+typedef struct _Ecore_Fd_Batch Ecore_Fd_Batch; /**< A handle for a set of fds dispatched together */
+typedef struct _Ecore_Fd_Batch_Timer Ecore_Fd_Batch_Timer; /**< A handle for a timer of an #Ecore_Fd_Batch */
+
+/**
+ * @typedef Ecore_Fd_Batch_Event
+ * A ready fd, as given to an #Ecore_Fd_Batch_Cb.
+ */
+typedef struct _Ecore_Fd_Batch_Event
+{
+   int fd; /**< The ready fd */
+   Ecore_Fd_Handler_Flags flags; /**< What it is ready for */
+   void *data; /**< The data given to ecore_fd_batch_fd_add() */
+} Ecore_Fd_Batch_Event;
+
+/**
+ * @typedef Ecore_Fd_Batch_Cb Ecore_Fd_Batch_Cb
+ * A callback used by an #Ecore_Fd_Batch, called once with all the fds found
+ * ready in a main loop iteration.
+ */
+typedef void (*Ecore_Fd_Batch_Cb)(void *data, Ecore_Fd_Batch *batch, const Ecore_Fd_Batch_Event *events, unsigned int count);
+
+/**
+ * @typedef Ecore_Fd_Batch_Stats
+ * Counters of an #Ecore_Fd_Batch.
+ */
+typedef struct _Ecore_Fd_Batch_Stats
+{
+   unsigned long long wakeups; /**< Times the main loop found the set ready */
+   unsigned long long batches; /**< Calls to the batch callback */
+   unsigned long long events; /**< Events given to it */
+   unsigned int events_max; /**< Largest batch */
+   double dispatch_time; /**< Seconds spent in the batch callback */
+   double dispatch_max; /**< Longest batch callback */
+   unsigned long long timers; /**< Timer callbacks called */
+   double latency_total; /**< Seconds between the timers deadlines and their calls */
+   double latency_max; /**< Largest of those delays */
+} Ecore_Fd_Batch_Stats;
+
+/**
+ * @brief Creates a set of fds dispatched together.
+ * @param max_events The most events given to @p func at once, 0 for 256.
+ * @param func The callback called with the ready fds.
+ * @param data The data to pass to the callback.
+ * @return A new set, @c NULL on failure.
+ *
+ * The fds of the set are watched edge-triggered by an epoll instance of
+ * their own, and only that instance is watched by the main loop. However
+ * many fds the set holds, the main loop sees a single handler, and
+ * every iteration gives all the ready ones to @p func in one call. This
+ * suits daemons with hundreds of mostly idle connections.
+ *
+ * Being edge-triggered, an fd is only reported again once new data comes
+ * after it was drained, @p func has to read or write until EAGAIN.
+ *
+ * The set also holds timers, see ecore_fd_batch_timer_add().
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Ecore_Fd_Batch *ecore_fd_batch_add(unsigned int max_events, Ecore_Fd_Batch_Cb func, const void *data);
+
+/**
+ * @brief Deletes a set of fds.
+ * @param batch The set to delete.
+ * @return The data given to ecore_fd_batch_add().
+ *
+ * The fds are not closed, the timers are deleted without being called.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline void *ecore_fd_batch_del(Ecore_Fd_Batch *batch);
+
+/**
+ * @brief Adds an fd to a set.
+ * @param batch The set.
+ * @param fd The fd to watch, it should be non-blocking.
+ * @param flags @c ECORE_FD_READ and/or @c ECORE_FD_WRITE, errors are
+ * always reported.
+ * @param data The data to give back in #Ecore_Fd_Batch_Event.
+ * @return @c EINA_TRUE on success, @c EINA_FALSE otherwise.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool ecore_fd_batch_fd_add(Ecore_Fd_Batch *batch, int fd, Ecore_Fd_Handler_Flags flags, const void *data);
+
+/**
+ * @brief Changes what an fd of a set is watched for.
+ * @param batch The set.
+ * @param fd The fd, added with ecore_fd_batch_fd_add().
+ * @param flags @c ECORE_FD_READ and/or @c ECORE_FD_WRITE.
+ * @return @c EINA_TRUE on success, @c EINA_FALSE otherwise.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool ecore_fd_batch_fd_modify(Ecore_Fd_Batch *batch, int fd, Ecore_Fd_Handler_Flags flags);
+
+/**
+ * @brief Removes an fd from a set.
+ * @param batch The set.
+ * @param fd The fd, it is not closed and must still be open.
+ * @return The data given to ecore_fd_batch_fd_add().
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline void *ecore_fd_batch_fd_del(Ecore_Fd_Batch *batch, int fd);
+
+/**
+ * @brief Adds a timer to a set.
+ * @param batch The set.
+ * @param in Seconds before the timer is called, with a millisecond
+ * resolution.
+ * @param func The callback, return @c ECORE_CALLBACK_RENEW to have it
+ * called again @p in seconds after its deadline.
+ * @param data The data to pass to the callback.
+ * @return A new timer, @c NULL on failure.
+ *
+ * Overdue timers of the set are called first, if one of them deletes
+ * @p batch, @c NULL is returned.
+ *
+ * The timers live in a hierarchical timing wheel of four levels of 64
+ * slots, so adding and deleting one does not depend on how many there
+ * are, unlike the sorted list of Ecore_Timer. The set sleeps on a timerfd
+ * armed for the first slot that holds timers, it does not wake up on each
+ * tick. Timers are called before the fds of the same iteration.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Ecore_Fd_Batch_Timer *ecore_fd_batch_timer_add(Ecore_Fd_Batch *batch, double in, Ecore_Task_Cb func, const void *data);
+
+/**
+ * @brief Deletes a timer of a set.
+ * @param timer The timer, it may be deleted from its own callback.
+ * @return The data given to ecore_fd_batch_timer_add().
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline void *ecore_fd_batch_timer_del(Ecore_Fd_Batch_Timer *timer);
+
+/**
+ * @brief Gets the counters of a set.
+ * @param batch The set.
+ * @param stats Where to store the counters.
+ * @return @c EINA_TRUE on success, @c EINA_FALSE otherwise.
+ *
+ * The timer latency is how late the callbacks ran compared to their
+ * deadline, it includes the time the main loop was busy elsewhere. The
+ * dispatch time is what the batch callback cost.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool ecore_fd_batch_stats_get(const Ecore_Fd_Batch *batch, Ecore_Fd_Batch_Stats *stats);
+
+#include "ecore_inline_main.x"
+
 /**
  * @}
  */
@@ -2701,6 +2983,196 @@ EAPI Eina_Bool ecore_thread_global_data_del(const char *key);
  */
 EAPI void *ecore_thread_global_data_wait(const char *key, double seconds);
 
+/**
+ * @typedef Ecore_Thread_Job
+ * A job of the work-stealing pool, see ecore_thread_job_run().
+ */
+typedef struct _Ecore_Thread_Job Ecore_Thread_Job;
+
+/**
+ * @typedef Ecore_Thread_Job_Cb
+ * A callback used by the work-stealing pool.
+ */
+typedef void (*Ecore_Thread_Job_Cb)(void *data, Ecore_Thread_Job *job);
+
+/**
+ * @typedef Ecore_Thread_Class
+ * The priority classes of the work-stealing pool.
+ */
+typedef enum _Ecore_Thread_Class
+{
+   ECORE_THREAD_CLASS_INTERACTIVE = 0, /**< Work the user is waiting for, picked before anything else */
+   ECORE_THREAD_CLASS_NORMAL, /**< Everything else */
+   ECORE_THREAD_CLASS_BACKGROUND, /**< Bulk work, started on at most half of the workers */
+   ECORE_THREAD_CLASS_LAST /**< Sentinel, not a valid class */
+} Ecore_Thread_Class;
+
+/**
+ * @typedef Ecore_Thread_Class_Stats
+ * Counters of one priority class of the work-stealing pool.
+ */
+typedef struct _Ecore_Thread_Class_Stats
+{
+   unsigned long long done; /**< Jobs run to the end, children included */
+   unsigned long long cancelled; /**< Jobs cancelled before or while running */
+   unsigned int pending; /**< Jobs waiting for a worker */
+   double wait_total; /**< Seconds spent queued by all the jobs */
+   double wait_max; /**< Longest time a job was queued */
+   double run_total; /**< Seconds spent running all the jobs */
+   double run_max; /**< Longest time a job ran */
+} Ecore_Thread_Class_Stats;
+
+/**
+ * @typedef Ecore_Thread_Pool_Stats
+ * Counters of the work-stealing pool.
+ */
+typedef struct _Ecore_Thread_Pool_Stats
+{
+   Ecore_Thread_Class_Stats classes[ECORE_THREAD_CLASS_LAST]; /**< Per class counters */
+   unsigned long long steals; /**< Jobs taken from another worker's queue */
+   unsigned int workers; /**< Worker threads in the pool */
+} Ecore_Thread_Pool_Stats;
+
+/**
+ * Schedule a task on the work-stealing pool
+ *
+ * @param cls The priority class of the task.
+ * @param func_blocking The function that should run in another thread.
+ * @param func_end Function to call from main loop when @p func_blocking
+ * completes its task successfully (may be NULL)
+ * @param func_cancel Function to call from main loop if the task was
+ * cancelled (may be NULL)
+ * @param data User context data to pass to all callbacks.
+ * @return A new job handler, or @c NULL on failure.
+ *
+ * This works like ecore_thread_run(), on a pool separate from the one of
+ * Ecore_Thread. Each worker has its own queues where the children of its
+ * jobs go, see ecore_thread_job_spawn(), and idle workers steal from them.
+ * Jobs are picked by class: a worker takes an interactive job before
+ * anything else, and background jobs are never started on more than half
+ * of the workers, so bulk work like thumbnailing or directory scanning
+ * leaves room for what the user is waiting for.
+ *
+ * The pool is started on first use with ecore_thread_max_get() workers.
+ * The job handler is valid until @p func_end or @p func_cancel returns.
+ * This must be called from the main loop.
+ *
+ * @see ecore_thread_pool_shutdown()
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Ecore_Thread_Job *ecore_thread_job_run(Ecore_Thread_Class cls, Ecore_Thread_Job_Cb func_blocking, Ecore_Thread_Job_Cb func_end, Ecore_Thread_Job_Cb func_cancel, const void *data);
+
+/**
+ * Schedule a child task from a running job
+ *
+ * @param parent The job running on the calling worker.
+ * @param func The function to run.
+ * @param data User context data to pass to @p func.
+ * @return @c EINA_TRUE on success, @c EINA_FALSE on failure.
+ *
+ * The child has the class of @p parent and goes to the calling worker's
+ * own queue, where it is run by the worker itself while joining, or
+ * stolen by an idle one. @p parent does not finish before its children:
+ * its function returning waits for them like ecore_thread_job_join().
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool ecore_thread_job_spawn(Ecore_Thread_Job *parent, Ecore_Thread_Job_Cb func, const void *data);
+
+/**
+ * Wait for the children of a job
+ *
+ * @param job The job running on the calling worker.
+ *
+ * Instead of blocking, the worker runs its own queued jobs and steals
+ * queued children of other jobs until all the children of @p job are done.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline void ecore_thread_job_join(Ecore_Thread_Job *job);
+
+/**
+ * Cancel a job of the work-stealing pool
+ *
+ * @param job The job to cancel.
+ * @return @c EINA_TRUE if the job will be cancelled, @c EINA_FALSE if it
+ * already finished.
+ *
+ * A queued job does not run, a running one sees ecore_thread_job_check()
+ * return @c EINA_TRUE, as do its children. Either way the cancel callback
+ * is called from the main loop instead of the end one. Once the job and
+ * its children are done, the end callback is called even if it did not
+ * run yet.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool ecore_thread_job_cancel(Ecore_Thread_Job *job);
+
+/**
+ * Check if a job of the work-stealing pool was cancelled
+ *
+ * @param job The job to check, a child job is cancelled with its parent.
+ * @return @c EINA_TRUE if the job was cancelled, @c EINA_FALSE otherwise.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool ecore_thread_job_check(const Ecore_Thread_Job *job);
+
+/**
+ * Gets the number of jobs of a class waiting for a worker
+ *
+ * @param cls The priority class.
+ * @return The number of queued jobs of @p cls, children included.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline int ecore_thread_pool_pending_get(Ecore_Thread_Class cls);
+
+/**
+ * Gets the counters of the work-stealing pool
+ *
+ * @param stats Where to store the counters.
+ * @return @c EINA_TRUE on success, @c EINA_FALSE if the pool is not running.
+ *
+ * Queue wait is the time between a job being scheduled and a worker
+ * starting it, run time is how long its function took. Together with
+ * ecore_thread_pool_pending_get() they tell if a class is starved.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool ecore_thread_pool_stats_get(Ecore_Thread_Pool_Stats *stats);
+
+/**
+ * Stop the work-stealing pool
+ *
+ * Running jobs are finished and the workers are joined, the jobs still
+ * queued are cancelled. Call it from the main loop before ecore_shutdown()
+ * when ecore_thread_job_run() was used, the next call to it restarts the
+ * pool.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline void ecore_thread_pool_shutdown(void);
+
+#include "ecore_inline_thread.x"
+
 /**
  * @}
  */
@@ -0,0 +1,960 @@
+/* ECORE - EFL core event loop library
+ * Copyright (C) 2016 Samsung Electronics Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library;
+ * if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ECORE_INLINE_MAIN_X_
+#define ECORE_INLINE_MAIN_X_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+
+/**
+ * @cond LOCAL
+ */
+
+#define ECORE_FD_BATCH_WHEEL_BITS 6
+#define ECORE_FD_BATCH_WHEEL_SLOTS (1 << ECORE_FD_BATCH_WHEEL_BITS)
+#define ECORE_FD_BATCH_WHEEL_MASK (ECORE_FD_BATCH_WHEEL_SLOTS - 1)
+#define ECORE_FD_BATCH_WHEEL_LEVELS 4
+#define ECORE_FD_BATCH_TICK 0.001
+
+typedef struct _Ecore_Fd_Batch_Fd Ecore_Fd_Batch_Fd;
+
+struct _Ecore_Fd_Batch_Fd
+{
+   void *data;
+   Eina_Bool used;
+};
+
+struct _Ecore_Fd_Batch_Timer
+{
+   Ecore_Fd_Batch_Timer *next;
+   Ecore_Fd_Batch_Timer **pprev; // whatever list it is in, NULL if none
+   Ecore_Fd_Batch *batch;
+   Ecore_Task_Cb func;
+   const void *data;
+   double deadline;
+   double interval;
+   uint64_t expires; // tick
+   Eina_Bool running : 1;
+   Eina_Bool delete_me : 1;
+};
+
+struct _Ecore_Fd_Batch
+{
+   Ecore_Fd_Handler *handler;
+   Ecore_Fd_Batch_Cb func;
+   const void *data;
+   int epfd;
+   int tfd;
+
+   struct epoll_event *raw;
+   Ecore_Fd_Batch_Event *events;
+   unsigned int max;
+
+   Ecore_Fd_Batch_Fd *fds; // indexed by fd
+   unsigned int fds_size;
+
+   Ecore_Fd_Batch_Timer *wheel[ECORE_FD_BATCH_WHEEL_LEVELS][ECORE_FD_BATCH_WHEEL_SLOTS];
+   unsigned int timers;
+   double base; // time of tick 0
+   uint64_t cur; // every timer up to this tick was called
+   uint64_t armed; // tick the timerfd is set to, 0 if disarmed
+
+   Ecore_Fd_Batch_Stats stats;
+
+   Eina_Bool dispatching : 1;
+   Eina_Bool delete_me : 1;
+};
+
+static inline double
+_ecore_fd_batch_now(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+static inline void
+_ecore_fd_batch_timer_unlink(Ecore_Fd_Batch_Timer *timer)
+{
+   if (!timer->pprev) return;
+   *timer->pprev = timer->next;
+   if (timer->next) timer->next->pprev = timer->pprev;
+   timer->next = NULL;
+   timer->pprev = NULL;
+}
+
+static inline void
+_ecore_fd_batch_timer_link(Ecore_Fd_Batch_Timer **head, Ecore_Fd_Batch_Timer *timer)
+{
+   timer->next = *head;
+   if (timer->next) timer->next->pprev = &timer->next;
+   *head = timer;
+   timer->pprev = head;
+}
+
+/* Level L holds the timers due in less than 64^(L+1) ticks, in the slot
+ * of bits [6L, 6L+6) of their expiry. A slot of level L > 0 is moved one
+ * level down when the bits below it wrap, see _ecore_fd_batch_advance(). */
+static inline void
+_ecore_fd_batch_timer_insert(Ecore_Fd_Batch *b, Ecore_Fd_Batch_Timer *timer)
+{
+   uint64_t delta;
+   int level;
+
+   if (timer->expires <= b->cur) timer->expires = b->cur + 1;
+   delta = timer->expires - b->cur;
+   for (level = 0; level < ECORE_FD_BATCH_WHEEL_LEVELS - 1; level++)
+     if (delta < (1ULL << (ECORE_FD_BATCH_WHEEL_BITS * (level + 1))))
+       break;
+   // Beyond the wheel, park it in the last slot and look again when it comes
+   if (delta >= (1ULL << (ECORE_FD_BATCH_WHEEL_BITS * ECORE_FD_BATCH_WHEEL_LEVELS)))
+     timer->expires = b->cur + (1ULL << (ECORE_FD_BATCH_WHEEL_BITS * ECORE_FD_BATCH_WHEEL_LEVELS)) - 1;
+
+   _ecore_fd_batch_timer_link(&b->wheel[level][(timer->expires >> (ECORE_FD_BATCH_WHEEL_BITS * level)) & ECORE_FD_BATCH_WHEEL_MASK],
+                              timer);
+}
+
+static inline void
+_ecore_fd_batch_timer_schedule(Ecore_Fd_Batch *b, Ecore_Fd_Batch_Timer *timer)
+{
+   double ticks = (timer->deadline - b->base) / ECORE_FD_BATCH_TICK;
+
+   timer->expires = ticks > 0 ? (uint64_t)ticks : 0;
+   if ((double)timer->expires < ticks) timer->expires++;
+   _ecore_fd_batch_timer_insert(b, timer);
+}
+
+static inline void
+_ecore_fd_batch_timer_free(Ecore_Fd_Batch_Timer *timer)
+{
+   _ecore_fd_batch_timer_unlink(timer);
+   timer->batch->timers--;
+   free(timer);
+}
+
+static inline Eina_Bool
+_ecore_fd_batch_cascade(Ecore_Fd_Batch *b, int level)
+{
+   unsigned int idx;
+   Ecore_Fd_Batch_Timer *list, *timer;
+
+   idx = (b->cur >> (ECORE_FD_BATCH_WHEEL_BITS * level)) & ECORE_FD_BATCH_WHEEL_MASK;
+   list = b->wheel[level][idx];
+   b->wheel[level][idx] = NULL;
+   if (list) list->pprev = &list;
+   while ((timer = list))
+     {
+        _ecore_fd_batch_timer_unlink(timer);
+        // Due on this very tick, its level 0 slot is expired right after
+        if (timer->expires <= b->cur)
+          _ecore_fd_batch_timer_link(&b->wheel[0][b->cur & ECORE_FD_BATCH_WHEEL_MASK], timer);
+        else
+          _ecore_fd_batch_timer_insert(b, timer);
+     }
+   return idx == 0;
+}
+
+static inline void
+_ecore_fd_batch_expire(Ecore_Fd_Batch *b, double now)
+{
+   Ecore_Fd_Batch_Timer *list, *timer;
+   unsigned int idx;
+   double late;
+   Eina_Bool renew;
+
+   idx = b->cur & ECORE_FD_BATCH_WHEEL_MASK;
+   list = b->wheel[0][idx];
+   if (!list) return;
+   // Detached so callbacks can add and delete timers while it is walked
+   b->wheel[0][idx] = NULL;
+   list->pprev = &list;
+
+   while ((timer = list))
+     {
+        if (b->delete_me)
+          {
+             _ecore_fd_batch_timer_free(timer);
+             continue;
+          }
+        _ecore_fd_batch_timer_unlink(timer);
+        // Parked past the end of the wheel, not due yet
+        if (timer->deadline > now + ECORE_FD_BATCH_TICK)
+          {
+             _ecore_fd_batch_timer_schedule(b, timer);
+             continue;
+          }
+
+        late = now - timer->deadline;
+        if (late < 0.0) late = 0.0;
+        b->stats.timers++;
+        b->stats.latency_total += late;
+        if (late > b->stats.latency_max) b->stats.latency_max = late;
+
+        timer->running = EINA_TRUE;
+        renew = timer->func((void *)timer->data);
+        timer->running = EINA_FALSE;
+
+        if (renew && !timer->delete_me && !b->delete_me)
+          {
+             timer->deadline += timer->interval;
+             // Do not try to catch up on missed periods
+             if (timer->deadline < now) timer->deadline = now + timer->interval;
+             _ecore_fd_batch_timer_schedule(b, timer);
+          }
+        else
+          _ecore_fd_batch_timer_free(timer);
+     }
+}
+
+static inline void
+_ecore_fd_batch_advance(Ecore_Fd_Batch *b, double now)
+{
+   // Rounding must not leave the tick the timerfd woke us for undone
+   double t = (now - b->base) / ECORE_FD_BATCH_TICK + 0.000001;
+   uint64_t target = t > 0 ? (uint64_t)t : 0;
+   int level;
+
+   if (!b->timers)
+     {
+        if (target > b->cur) b->cur = target;
+        return;
+     }
+
+   while (b->cur < target && !b->delete_me)
+     {
+        b->cur++;
+        if (!(b->cur & ECORE_FD_BATCH_WHEEL_MASK))
+          for (level = 1; level < ECORE_FD_BATCH_WHEEL_LEVELS; level++)
+            if (!_ecore_fd_batch_cascade(b, level)) break;
+        _ecore_fd_batch_expire(b, now);
+     }
+}
+
+/* The first tick something has to be done: a level 0 slot to expire or a
+ * slot of another level to cascade. 0 if there are no timers. */
+static inline uint64_t
+_ecore_fd_batch_next(const Ecore_Fd_Batch *b)
+{
+   uint64_t next = 0, tick;
+   unsigned int k;
+   int level;
+
+   if (!b->timers) return 0;
+   for (level = 0; level < ECORE_FD_BATCH_WHEEL_LEVELS; level++)
+     {
+        uint64_t pos = b->cur >> (ECORE_FD_BATCH_WHEEL_BITS * level);
+
+        for (k = 1; k <= ECORE_FD_BATCH_WHEEL_SLOTS; k++)
+          if (b->wheel[level][(pos + k) & ECORE_FD_BATCH_WHEEL_MASK])
+            break;
+        if (k > ECORE_FD_BATCH_WHEEL_SLOTS) continue;
+
+        tick = (pos + k) << (ECORE_FD_BATCH_WHEEL_BITS * level);
+        if (!next || tick < next) next = tick;
+     }
+   return next;
+}
+
+static inline void
+_ecore_fd_batch_arm(Ecore_Fd_Batch *b)
+{
+   struct itimerspec its;
+   uint64_t next;
+   double at;
+
+   next = _ecore_fd_batch_next(b);
+   if (next == b->armed) return;
+   b->armed = next;
+
+   memset(&its, 0, sizeof (its));
+   if (next)
+     {
+        at = b->base + (double)next * ECORE_FD_BATCH_TICK;
+        its.it_value.tv_sec = (time_t)at;
+        its.it_value.tv_nsec = (long)((at - (double)its.it_value.tv_sec) * 1000000000.0);
+        // An all zero value would disarm it
+        if (!its.it_value.tv_sec && !its.it_value.tv_nsec) its.it_value.tv_nsec = 1;
+     }
+   timerfd_settime(b->tfd, TFD_TIMER_ABSTIME, &its, NULL);
+}
+
+static inline void
+_ecore_fd_batch_free(Ecore_Fd_Batch *b)
+{
+   Ecore_Fd_Batch_Timer *timer;
+   int level, idx;
+
+   for (level = 0; level < ECORE_FD_BATCH_WHEEL_LEVELS; level++)
+     for (idx = 0; idx < ECORE_FD_BATCH_WHEEL_SLOTS; idx++)
+       while ((timer = b->wheel[level][idx]))
+         _ecore_fd_batch_timer_free(timer);
+
+   if (b->handler) ecore_main_fd_handler_del(b->handler);
+   if (b->tfd >= 0) close(b->tfd);
+   if (b->epfd >= 0) close(b->epfd);
+   free(b->fds);
+   free(b->events);
+   free(b->raw);
+   free(b);
+}
+
+static inline Eina_Bool
+_ecore_fd_batch_dispatch(void *data, Ecore_Fd_Handler *fd_handler EINA_UNUSED)
+{
+   Ecore_Fd_Batch *b = (Ecore_Fd_Batch *)data;
+   Eina_Bool timers_due = EINA_FALSE;
+   unsigned int count = 0;
+   double start, spent;
+   int n, i;
+
+   b->stats.wakeups++;
+   n = epoll_wait(b->epfd, b->raw, b->max, 0);
+   for (i = 0; i < n; i++)
+     {
+        Ecore_Fd_Batch_Event *ev;
+        int fd = b->raw[i].data.fd;
+        uint32_t events = b->raw[i].events;
+        int flags = 0;
+
+        if (fd == b->tfd)
+          {
+             uint64_t expirations;
+
+             if (read(b->tfd, &expirations, sizeof (expirations)) > 0)
+               timers_due = EINA_TRUE;
+             continue;
+          }
+        if ((unsigned int)fd >= b->fds_size || !b->fds[fd].used) continue;
+
+        if (events & (EPOLLIN | EPOLLRDHUP | EPOLLPRI)) flags |= ECORE_FD_READ;
+        if (events & EPOLLOUT) flags |= ECORE_FD_WRITE;
+        if (events & (EPOLLERR | EPOLLHUP)) flags |= ECORE_FD_ERROR;
+
+        ev = &b->events[count++];
+        ev->fd = fd;
+        ev->flags = (Ecore_Fd_Handler_Flags)flags;
+        ev->data = b->fds[fd].data;
+     }
+
+   b->dispatching = EINA_TRUE;
+   // The timerfd is spent, it has to be set again even for the same tick
+   if (timers_due) b->armed = 0;
+   if (b->timers)
+     _ecore_fd_batch_advance(b, _ecore_fd_batch_now());
+
+   if (count && !b->delete_me)
+     {
+        start = _ecore_fd_batch_now();
+        b->func((void *)b->data, b, b->events, count);
+        spent = _ecore_fd_batch_now() - start;
+
+        b->stats.batches++;
+        b->stats.events += count;
+        if (count > b->stats.events_max) b->stats.events_max = count;
+        b->stats.dispatch_time += spent;
+        if (spent > b->stats.dispatch_max) b->stats.dispatch_max = spent;
+     }
+   b->dispatching = EINA_FALSE;
+
+   if (b->delete_me)
+     {
+        // The handler is ours, let the main loop remove it
+        b->handler = NULL;
+        _ecore_fd_batch_free(b);
+        return ECORE_CALLBACK_CANCEL;
+     }
+   _ecore_fd_batch_arm(b);
+   return ECORE_CALLBACK_RENEW;
+}
+
+static inline uint32_t
+_ecore_fd_batch_epoll_events(Ecore_Fd_Handler_Flags flags)
+{
+   uint32_t events = EPOLLET | EPOLLERR | EPOLLHUP;
+
+   if (flags & ECORE_FD_READ) events |= EPOLLIN | EPOLLRDHUP;
+   if (flags & ECORE_FD_WRITE) events |= EPOLLOUT;
+   return events;
+}
+/**
+ * @endcond
+ */
+
+static inline Ecore_Fd_Batch *
+ecore_fd_batch_add(unsigned int max_events, Ecore_Fd_Batch_Cb func, const void *data)
+{
+   struct epoll_event ev;
+   Ecore_Fd_Batch *b;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(func, NULL);
+   if (!max_events) max_events = 256;
+
+   b = (Ecore_Fd_Batch *)calloc(1, sizeof (Ecore_Fd_Batch));
+   if (!b) return NULL;
+   b->func = func;
+   b->data = data;
+   b->max = max_events;
+   b->tfd = -1;
+   b->base = _ecore_fd_batch_now();
+
+   b->epfd = epoll_create1(EPOLL_CLOEXEC);
+   if (b->epfd < 0) goto on_error;
+   b->tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+   if (b->tfd < 0) goto on_error;
+
+   memset(&ev, 0, sizeof (ev));
+   ev.events = EPOLLIN;
+   ev.data.fd = b->tfd;
+   if (epoll_ctl(b->epfd, EPOLL_CTL_ADD, b->tfd, &ev) < 0) goto on_error;
+
+   b->raw = (struct epoll_event *)malloc(max_events * sizeof (struct epoll_event));
+   b->events = (Ecore_Fd_Batch_Event *)malloc(max_events * sizeof (Ecore_Fd_Batch_Event));
+   if (!b->raw || !b->events) goto on_error;
+
+   b->handler = ecore_main_fd_handler_add(b->epfd, ECORE_FD_READ,
+                                          _ecore_fd_batch_dispatch, b,
+                                          NULL, NULL);
+   if (!b->handler) goto on_error;
+   return b;
+
+ on_error:
+   _ecore_fd_batch_free(b);
+   return NULL;
+}
+
+static inline void *
+ecore_fd_batch_del(Ecore_Fd_Batch *batch)
+{
+   void *data;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(batch, NULL);
+   EINA_SAFETY_ON_TRUE_RETURN_VAL(batch->delete_me, NULL);
+
+   data = (void *)batch->data;
+   if (batch->dispatching) batch->delete_me = EINA_TRUE;
+   else _ecore_fd_batch_free(batch);
+   return data;
+}
+
+static inline Eina_Bool
+ecore_fd_batch_fd_add(Ecore_Fd_Batch *batch, int fd, Ecore_Fd_Handler_Flags flags, const void *data)
+{
+   struct epoll_event ev;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(batch, EINA_FALSE);
+   EINA_SAFETY_ON_TRUE_RETURN_VAL(fd < 0, EINA_FALSE);
+
+   if ((unsigned int)fd >= batch->fds_size)
+     {
+        Ecore_Fd_Batch_Fd *fds;
+        unsigned int size = batch->fds_size ? batch->fds_size : 64;
+
+        while (size <= (unsigned int)fd) size *= 2;
+        fds = (Ecore_Fd_Batch_Fd *)realloc(batch->fds, size * sizeof (Ecore_Fd_Batch_Fd));
+        if (!fds) return EINA_FALSE;
+        memset(fds + batch->fds_size, 0, (size - batch->fds_size) * sizeof (Ecore_Fd_Batch_Fd));
+        batch->fds = fds;
+        batch->fds_size = size;
+     }
+   EINA_SAFETY_ON_TRUE_RETURN_VAL(batch->fds[fd].used, EINA_FALSE);
+
+   memset(&ev, 0, sizeof (ev));
+   ev.events = _ecore_fd_batch_epoll_events(flags);
+   ev.data.fd = fd;
+   if (epoll_ctl(batch->epfd, EPOLL_CTL_ADD, fd, &ev) < 0) return EINA_FALSE;
+
+   batch->fds[fd].data = (void *)data;
+   batch->fds[fd].used = EINA_TRUE;
+   return EINA_TRUE;
+}
+
+static inline Eina_Bool
+ecore_fd_batch_fd_modify(Ecore_Fd_Batch *batch, int fd, Ecore_Fd_Handler_Flags flags)
+{
+   struct epoll_event ev;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(batch, EINA_FALSE);
+   if (fd < 0 || (unsigned int)fd >= batch->fds_size || !batch->fds[fd].used)
+     return EINA_FALSE;
+
+   memset(&ev, 0, sizeof (ev));
+   ev.events = _ecore_fd_batch_epoll_events(flags);
+   ev.data.fd = fd;
+   return epoll_ctl(batch->epfd, EPOLL_CTL_MOD, fd, &ev) == 0;
+}
+
+static inline void *
+ecore_fd_batch_fd_del(Ecore_Fd_Batch *batch, int fd)
+{
+   void *data;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(batch, NULL);
+   if (fd < 0 || (unsigned int)fd >= batch->fds_size || !batch->fds[fd].used)
+     return NULL;
+
+   epoll_ctl(batch->epfd, EPOLL_CTL_DEL, fd, NULL);
+   data = batch->fds[fd].data;
+   batch->fds[fd].data = NULL;
+   batch->fds[fd].used = EINA_FALSE;
+   return data;
+}
+
+static inline Ecore_Fd_Batch_Timer *
+ecore_fd_batch_timer_add(Ecore_Fd_Batch *batch, double in, Ecore_Task_Cb func, const void *data)
+{
+   Ecore_Fd_Batch_Timer *timer;
+   double now;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(batch, NULL);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(func, NULL);
+   // A renewed timer must not be due again in the same dispatch
+   if (in < ECORE_FD_BATCH_TICK) in = ECORE_FD_BATCH_TICK;
+
+   now = _ecore_fd_batch_now();
+   /* Catch up first so the timer is placed relative to the present. The
+    * overdue timers this calls may add timers or delete the set, as when
+    * called from the dispatch. */
+   if (!batch->dispatching)
+     {
+        batch->dispatching = EINA_TRUE;
+        _ecore_fd_batch_advance(batch, now);
+        batch->dispatching = EINA_FALSE;
+        if (batch->delete_me)
+          {
+             _ecore_fd_batch_free(batch);
+             return NULL;
+          }
+     }
+
+   timer = (Ecore_Fd_Batch_Timer *)calloc(1, sizeof (Ecore_Fd_Batch_Timer));
+   if (!timer)
+     {
+        if (!batch->dispatching) _ecore_fd_batch_arm(batch);
+        return NULL;
+     }
+   timer->batch = batch;
+   timer->func = func;
+   timer->data = data;
+   timer->interval = in;
+   timer->deadline = now + in;
+   batch->timers++;
+   _ecore_fd_batch_timer_schedule(batch, timer);
+   if (!batch->dispatching) _ecore_fd_batch_arm(batch);
+   return timer;
+}
+
+static inline void *
+ecore_fd_batch_timer_del(Ecore_Fd_Batch_Timer *timer)
+{
+   void *data;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(timer, NULL);
+   EINA_SAFETY_ON_TRUE_RETURN_VAL(timer->delete_me, NULL);
+
+   data = (void *)timer->data;
+   if (timer->running) timer->delete_me = EINA_TRUE;
+   else _ecore_fd_batch_timer_free(timer);
+   return data;
+}
+
+static inline Eina_Bool
+ecore_fd_batch_stats_get(const Ecore_Fd_Batch *batch, Ecore_Fd_Batch_Stats *stats)
+{
+   EINA_SAFETY_ON_NULL_RETURN_VAL(batch, EINA_FALSE);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(stats, EINA_FALSE);
+
+   *stats = batch->stats;
+   return EINA_TRUE;
+}
+
+/**
+ * @cond LOCAL
+ */
+
+/* The ring has to be unique in the process while this code is compiled in
+ * every user, let the linker merge the copies. */
+#define ECORE_CALL_RING_SHARED __attribute__ ((weak))
+
+// Times a thread lets the main loop make room in a full ring
+#define ECORE_CALL_RING_TRIES 64
+
+typedef struct _Ecore_Call_Ring Ecore_Call_Ring;
+typedef struct _Ecore_Call_Ring_Slot Ecore_Call_Ring_Slot;
+typedef struct _Ecore_Call_Ring_Spill Ecore_Call_Ring_Spill;
+
+/* Bounded queue of Dmitry Vyukov: a slot is free for position p when its
+ * sequence is p, holds the call of position p when it is p + 1. */
+struct _Ecore_Call_Ring_Slot
+{
+   volatile unsigned long seq;
+   Ecore_Cb cb;
+   void *data;
+};
+
+/* A call that did not fit in the ring */
+struct _Ecore_Call_Ring_Spill
+{
+   Ecore_Call_Ring_Spill *next;
+   Ecore_Cb cb;
+   void *data;
+};
+
+struct _Ecore_Call_Ring
+{
+   Ecore_Call_Ring_Slot *slots;
+   unsigned long mask;
+   volatile unsigned long head; // next position to fill, shared by the threads
+   unsigned long tail; // next position to run, main loop only
+   volatile int wake_pending;
+   int fd;
+   Ecore_Fd_Handler *handler;
+   Eina_Spinlock spill_lock;
+   Ecore_Call_Ring_Spill * volatile spill; // run after the calls in the ring before it
+   Ecore_Call_Ring_Spill **spill_last;
+   unsigned long spill_pos; // head when the ring was found full
+   Ecore_Thread_Safe_Call_Stats stats;
+};
+
+ECORE_CALL_RING_SHARED Ecore_Call_Ring *_ecore_call_ring = NULL;
+ECORE_CALL_RING_SHARED unsigned int _ecore_call_ring_size = 4096;
+
+static inline Eina_Bool
+_ecore_call_ring_pop(Ecore_Call_Ring *r, Ecore_Cb *cb, void **data)
+{
+   Ecore_Call_Ring_Slot *slot = &r->slots[r->tail & r->mask];
+
+   if (slot->seq != r->tail + 1) return EINA_FALSE;
+   __sync_synchronize();
+   *cb = slot->cb;
+   *data = slot->data;
+   __sync_synchronize();
+   slot->seq = r->tail + r->mask + 1;
+   r->tail++;
+   return EINA_TRUE;
+}
+
+/* What was put in the ring before the first spilled call sits below
+ * spill_pos, with @p due the spilled calls only go once those are done. */
+static inline Eina_Bool
+_ecore_call_ring_spill_pop(Ecore_Call_Ring *r, Eina_Bool due, Ecore_Cb *cb, void **data)
+{
+   Ecore_Call_Ring_Spill *s;
+
+   if (!r->spill) return EINA_FALSE;
+   eina_spinlock_take(&r->spill_lock);
+   s = r->spill;
+   if ((s) && (due) && ((long)(r->tail - r->spill_pos) < 0)) s = NULL;
+   else if (s)
+     {
+        r->spill = s->next;
+        if (!r->spill) r->spill_last = (Ecore_Call_Ring_Spill **)&r->spill;
+     }
+   eina_spinlock_release(&r->spill_lock);
+   if (!s) return EINA_FALSE;
+   *cb = s->cb;
+   *data = s->data;
+   free(s);
+   return EINA_TRUE;
+}
+
+static inline void
+_ecore_call_ring_wake(Ecore_Call_Ring *r)
+{
+   uint64_t v = 1;
+
+   // Only the first call after a drain started has to wake the main loop
+   if (__sync_lock_test_and_set(&r->wake_pending, 1)) return;
+   __sync_fetch_and_add(&r->stats.wakeups, 1);
+   if (write(r->fd, &v, sizeof (v)) < 0)
+     r->wake_pending = 0;
+}
+
+static inline unsigned int
+_ecore_call_ring_drain(Ecore_Call_Ring *r)
+{
+   unsigned int n = 0;
+   Ecore_Cb cb;
+   void *data;
+
+   // Bounded so a flood of calls does not starve the rest of the main loop
+   while (n <= r->mask)
+     {
+        if (!_ecore_call_ring_spill_pop(r, EINA_TRUE, &cb, &data) &&
+            !_ecore_call_ring_pop(r, &cb, &data) &&
+            !_ecore_call_ring_spill_pop(r, EINA_FALSE, &cb, &data))
+          break;
+        cb(data);
+        n++;
+     }
+   r->stats.dispatched += n;
+   if (n > r->stats.drain_max) r->stats.drain_max = n;
+   return n;
+}
+
+static inline Eina_Bool
+_ecore_call_ring_dispatch(void *data, Ecore_Fd_Handler *fd_handler EINA_UNUSED)
+{
+   Ecore_Call_Ring *r = (Ecore_Call_Ring *)data;
+   uint64_t v;
+
+   if (read(r->fd, &v, sizeof (v)) < 0) return ECORE_CALLBACK_RENEW;
+   // Cleared before draining, a call put after this wakes us up again
+   __sync_lock_release(&r->wake_pending);
+   __sync_synchronize();
+   if (_ecore_call_ring_drain(r) > r->mask)
+     _ecore_call_ring_wake(r);
+   return ECORE_CALLBACK_RENEW;
+}
+
+/* Called through ecore_main_loop_thread_safe_call_async() for a ring
+ * made in a thread, which may be gone by then. */
+static inline void
+_ecore_call_ring_attach(void *data EINA_UNUSED)
+{
+   Ecore_Call_Ring *r = _ecore_call_ring;
+
+   if (!r || r->handler) return;
+   r->handler = ecore_main_fd_handler_add(r->fd, ECORE_FD_READ,
+                                          _ecore_call_ring_dispatch, r,
+                                          NULL, NULL);
+}
+
+static inline void
+_ecore_call_ring_free(Ecore_Call_Ring *r)
+{
+   eina_spinlock_free(&r->spill_lock);
+   close(r->fd);
+   free(r->slots);
+   free(r);
+}
+
+static inline Ecore_Call_Ring *
+_ecore_call_ring_get(void)
+{
+   Ecore_Call_Ring *r = _ecore_call_ring;
+   unsigned long i, size;
+
+   if (r) return r;
+
+   for (size = 64; size < _ecore_call_ring_size; size <<= 1)
+     ;
+   r = (Ecore_Call_Ring *)calloc(1, sizeof (Ecore_Call_Ring));
+   if (!r) return NULL;
+   r->slots = (Ecore_Call_Ring_Slot *)malloc(size * sizeof (Ecore_Call_Ring_Slot));
+   r->fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+   if (!r->slots || r->fd < 0 || !eina_spinlock_new(&r->spill_lock))
+     {
+        if (r->fd >= 0) close(r->fd);
+        free(r->slots);
+        free(r);
+        return NULL;
+     }
+   for (i = 0; i < size; i++)
+     r->slots[i].seq = i;
+   r->mask = size - 1;
+   r->spill_last = (Ecore_Call_Ring_Spill **)&r->spill;
+   r->stats.size = size;
+
+   // Several threads may get here first, only one ring survives
+   if (!__sync_bool_compare_and_swap(&_ecore_call_ring, NULL, r))
+     {
+        _ecore_call_ring_free(r);
+        return _ecore_call_ring;
+     }
+
+   // The eventfd keeps the wakeups until the handler is there to see them
+   if (eina_main_loop_is()) _ecore_call_ring_attach(NULL);
+   else ecore_main_loop_thread_safe_call_async(_ecore_call_ring_attach, NULL);
+   return r;
+}
+
+static inline Eina_Bool
+_ecore_call_ring_push(Ecore_Call_Ring *r, Ecore_Cb callback, void *data)
+{
+   Ecore_Call_Ring_Slot *slot;
+   unsigned long pos = r->head;
+   long diff;
+
+   for (;;)
+     {
+        slot = &r->slots[pos & r->mask];
+        diff = (long)(slot->seq - pos);
+        if (!diff)
+          {
+             if (__sync_bool_compare_and_swap(&r->head, pos, pos + 1)) break;
+             pos = r->head;
+          }
+        else if (diff < 0) return EINA_FALSE; // full
+        else pos = r->head;
+     }
+
+   slot->cb = callback;
+   slot->data = data;
+   __sync_synchronize();
+   slot->seq = pos + 1;
+   return EINA_TRUE;
+}
+
+static inline Eina_Bool
+_ecore_call_ring_spill_push(Ecore_Call_Ring *r, Ecore_Cb callback, void *data)
+{
+   Ecore_Call_Ring_Spill *s;
+
+   s = (Ecore_Call_Ring_Spill *)malloc(sizeof (Ecore_Call_Ring_Spill));
+   if (!s) return EINA_FALSE;
+   s->next = NULL;
+   s->cb = callback;
+   s->data = data;
+   eina_spinlock_take(&r->spill_lock);
+   if (!r->spill) r->spill_pos = r->head;
+   *r->spill_last = s;
+   r->spill_last = &s->next;
+   eina_spinlock_release(&r->spill_lock);
+   return EINA_TRUE;
+}
+
+/* Once a call is spilled, the next ones follow it there until the drain
+ * catches up, so the calls of a thread still run in the order they came. */
+static inline void
+_ecore_call_ring_post(Ecore_Call_Ring *r, Ecore_Cb callback, void *data, Eina_Bool main_loop)
+{
+   unsigned int tries = 0;
+
+   while (r->spill || !_ecore_call_ring_push(r, callback, data))
+     {
+        /* Waiting for ourselves would never end, and the main loop may be
+         * waiting for the calling thread, so it only gets a few chances. */
+        if (main_loop || tries++ >= ECORE_CALL_RING_TRIES)
+          {
+             __sync_fetch_and_add(&r->stats.full, 1);
+             if (!_ecore_call_ring_spill_push(r, callback, data))
+               ecore_main_loop_thread_safe_call_async(callback, data);
+             return;
+          }
+        _ecore_call_ring_wake(r);
+        sched_yield();
+     }
+   __sync_fetch_and_add(&r->stats.posted, 1);
+}
+/**
+ * @endcond
+ */
+
+static inline void
+ecore_main_loop_thread_safe_call_fast(Ecore_Cb callback, void *data)
+{
+   Ecore_Call_Ring *r;
+
+   EINA_SAFETY_ON_NULL_RETURN(callback);
+
+   r = _ecore_call_ring_get();
+   if (!r)
+     {
+        ecore_main_loop_thread_safe_call_async(callback, data);
+        return;
+     }
+   _ecore_call_ring_post(r, callback, data, eina_main_loop_is());
+   _ecore_call_ring_wake(r);
+}
+
+static inline void
+ecore_main_loop_thread_safe_call_batch(Ecore_Cb callback, void * const *data, unsigned int count)
+{
+   Ecore_Call_Ring *r;
+   Eina_Bool main_loop;
+   unsigned int i;
+
+   EINA_SAFETY_ON_NULL_RETURN(callback);
+   if (!count) return;
+   EINA_SAFETY_ON_NULL_RETURN(data);
+
+   r = _ecore_call_ring_get();
+   if (!r)
+     {
+        for (i = 0; i < count; i++)
+          ecore_main_loop_thread_safe_call_async(callback, data[i]);
+        return;
+     }
+   main_loop = eina_main_loop_is();
+   for (i = 0; i < count; i++)
+     _ecore_call_ring_post(r, callback, data[i], main_loop);
+   _ecore_call_ring_wake(r);
+}
+
+static inline Eina_Bool
+ecore_main_loop_thread_safe_call_ring_size_set(unsigned int size)
+{
+   if (_ecore_call_ring) return EINA_FALSE;
+   _ecore_call_ring_size = size ? size : 4096;
+   return EINA_TRUE;
+}
+
+static inline void
+ecore_main_loop_thread_safe_call_flush(void)
+{
+   Ecore_Call_Ring *r = _ecore_call_ring;
+
+   if (!r) return;
+   while (_ecore_call_ring_drain(r) > r->mask)
+     ;
+}
+
+static inline void
+ecore_main_loop_thread_safe_call_shutdown(void)
+{
+   Ecore_Call_Ring *r = _ecore_call_ring;
+
+   if (!r) return;
+   ecore_main_loop_thread_safe_call_flush();
+   // The next call makes a new ring, with a handler in the new main loop
+   _ecore_call_ring = NULL;
+   if (r->handler) ecore_main_fd_handler_del(r->handler);
+   _ecore_call_ring_free(r);
+}
+
+static inline Eina_Bool
+ecore_main_loop_thread_safe_call_stats_get(Ecore_Thread_Safe_Call_Stats *stats)
+{
+   EINA_SAFETY_ON_NULL_RETURN_VAL(stats, EINA_FALSE);
+   if (!_ecore_call_ring) return EINA_FALSE;
+
+   *stats = _ecore_call_ring->stats;
+   return EINA_TRUE;
+}
+
+#undef ECORE_CALL_RING_TRIES
+#undef ECORE_CALL_RING_SHARED
+
+#undef ECORE_FD_BATCH_WHEEL_BITS
+#undef ECORE_FD_BATCH_WHEEL_SLOTS
+#undef ECORE_FD_BATCH_WHEEL_MASK
+#undef ECORE_FD_BATCH_WHEEL_LEVELS
+#undef ECORE_FD_BATCH_TICK
+
+#endif
@@ -0,0 +1,687 @@
+/* ECORE - EFL core event loop library
+ * Copyright (C) 2016 Samsung Electronics Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library;
+ * if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ECORE_INLINE_THREAD_X_
+#define ECORE_INLINE_THREAD_X_
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+/**
+ * @cond LOCAL
+ */
+
+/* There is one pool per process while this code is compiled in every
+ * user, let the linker merge the copies. */
+#define ECORE_THREAD_POOL_SHARED __attribute__ ((weak))
+
+typedef struct _Ecore_Thread_Pool Ecore_Thread_Pool;
+typedef struct _Ecore_Thread_Pool_Queue Ecore_Thread_Pool_Queue;
+typedef struct _Ecore_Thread_Pool_Worker Ecore_Thread_Pool_Worker;
+
+/* Whichever of the worker and ecore_thread_job_cancel() comes first
+ * settles the outcome of a job. */
+typedef enum _Ecore_Thread_Job_State
+{
+   ECORE_THREAD_JOB_PENDING = 0,
+   ECORE_THREAD_JOB_CANCELLED,
+   ECORE_THREAD_JOB_DONE
+} Ecore_Thread_Job_State;
+
+struct _Ecore_Thread_Job
+{
+   Ecore_Thread_Job_Cb func_blocking;
+   Ecore_Thread_Job_Cb func_end;
+   Ecore_Thread_Job_Cb func_cancel;
+   const void *data;
+   Ecore_Thread_Job *parent; // NULL for jobs started from the main loop
+   double queued;
+   volatile int children; // not finished yet
+   Ecore_Thread_Class cls;
+   volatile int state; // Ecore_Thread_Job_State
+   volatile Eina_Bool cancel;
+};
+
+struct _Ecore_Thread_Pool_Queue
+{
+   Eina_Spinlock lock;
+   Ecore_Thread_Job **jobs; // ring of size entries starting at head
+   unsigned int head, count, size;
+};
+
+struct _Ecore_Thread_Pool_Worker
+{
+   Ecore_Thread_Pool_Queue deques[ECORE_THREAD_CLASS_LAST];
+   Ecore_Thread_Pool *pool;
+   Eina_Thread thread;
+   unsigned int index;
+};
+
+struct _Ecore_Thread_Pool
+{
+   Ecore_Thread_Pool_Queue injected[ECORE_THREAD_CLASS_LAST]; // from the main loop
+   Ecore_Thread_Pool_Worker *workers;
+   unsigned int count;
+
+   volatile int pending[ECORE_THREAD_CLASS_LAST];
+   volatile int sleeping;
+   volatile int joining;
+   volatile unsigned int pushed; // jobs ever pushed, wakes the joiners
+   volatile int background_running; // raised under injected[BACKGROUND].lock
+   int background_max;
+   volatile Eina_Bool quit;
+
+   Eina_Lock lock; // only to sleep
+   Eina_Condition cond;
+   Eina_Condition joined; // a job lost its last child or work was pushed
+
+   Eina_Spinlock stats_lock;
+   Ecore_Thread_Pool_Stats stats;
+};
+
+ECORE_THREAD_POOL_SHARED Ecore_Thread_Pool *_ecore_thread_pool = NULL;
+ECORE_THREAD_POOL_SHARED pthread_mutex_t _ecore_thread_pool_start_lock = PTHREAD_MUTEX_INITIALIZER;
+ECORE_THREAD_POOL_SHARED __thread Ecore_Thread_Pool_Worker *_ecore_thread_pool_self = NULL;
+
+static inline Eina_Bool
+_ecore_thread_pool_queue_push(Ecore_Thread_Pool_Queue *q, Ecore_Thread_Job *job)
+{
+   eina_spinlock_take(&q->lock);
+   if (q->count == q->size)
+     {
+        Ecore_Thread_Job **jobs;
+        unsigned int size = q->size ? q->size * 2 : 16;
+        unsigned int i;
+
+        jobs = (Ecore_Thread_Job **)malloc(size * sizeof (Ecore_Thread_Job *));
+        if (!jobs)
+          {
+             eina_spinlock_release(&q->lock);
+             return EINA_FALSE;
+          }
+        for (i = 0; i < q->count; i++)
+          jobs[i] = q->jobs[(q->head + i) % q->size];
+        free(q->jobs);
+        q->jobs = jobs;
+        q->head = 0;
+        q->size = size;
+     }
+   q->jobs[(q->head + q->count) % q->size] = job;
+   q->count++;
+   eina_spinlock_release(&q->lock);
+   return EINA_TRUE;
+}
+
+/* The owner takes the newest job, it is the most likely to still be in
+ * cache, everybody else takes the oldest one. The queue is locked. */
+static inline Ecore_Thread_Job *
+_ecore_thread_pool_queue_take(Ecore_Thread_Pool_Queue *q, Eina_Bool newest)
+{
+   Ecore_Thread_Job *job;
+
+   if (!q->count) return NULL;
+   q->count--;
+   if (newest)
+     {
+        job = q->jobs[(q->head + q->count) % q->size];
+     }
+   else
+     {
+        job = q->jobs[q->head];
+        q->head = (q->head + 1) % q->size;
+     }
+   return job;
+}
+
+static inline Ecore_Thread_Job *
+_ecore_thread_pool_queue_pop(Ecore_Thread_Pool_Queue *q, Eina_Bool newest)
+{
+   Ecore_Thread_Job *job;
+
+   if (!q->count) return NULL; // racy hint, checked again under the lock
+
+   eina_spinlock_take(&q->lock);
+   job = _ecore_thread_pool_queue_take(q, newest);
+   eina_spinlock_release(&q->lock);
+   return job;
+}
+
+/* Background jobs from the main loop are limited to background_max at
+ * once, the slot is taken with the job so two workers can not both get
+ * the last one. */
+static inline Ecore_Thread_Job *
+_ecore_thread_pool_background_pop(Ecore_Thread_Pool *pool)
+{
+   Ecore_Thread_Pool_Queue *q = &pool->injected[ECORE_THREAD_CLASS_BACKGROUND];
+   Ecore_Thread_Job *job = NULL;
+
+   if (!q->count) return NULL; // racy hint, checked again under the lock
+
+   eina_spinlock_take(&q->lock);
+   if (pool->background_running < pool->background_max)
+     {
+        job = _ecore_thread_pool_queue_take(q, EINA_FALSE);
+        if (job) __sync_fetch_and_add(&pool->background_running, 1);
+     }
+   eina_spinlock_release(&q->lock);
+   return job;
+}
+
+static inline void
+_ecore_thread_pool_queue_init(Ecore_Thread_Pool_Queue *q)
+{
+   memset(q, 0, sizeof (Ecore_Thread_Pool_Queue));
+   eina_spinlock_new(&q->lock);
+}
+
+static inline void
+_ecore_thread_pool_wake(Ecore_Thread_Pool *pool)
+{
+   // The sleeper raised sleeping before checking for work, see the worker
+   if (!pool->sleeping) return;
+   eina_lock_take(&pool->lock);
+   eina_condition_signal(&pool->cond);
+   eina_lock_release(&pool->lock);
+}
+
+static inline void
+_ecore_thread_pool_wake_joiners(Ecore_Thread_Pool *pool)
+{
+   // Same as above, joiners raise joining before they check
+   if (!pool->joining) return;
+   eina_lock_take(&pool->lock);
+   eina_condition_broadcast(&pool->joined);
+   eina_lock_release(&pool->lock);
+}
+
+static inline Eina_Bool
+_ecore_thread_pool_has_work(Ecore_Thread_Pool *pool)
+{
+   int cls;
+
+   for (cls = 0; cls < ECORE_THREAD_CLASS_LAST; cls++)
+     {
+        if (pool->pending[cls] <= 0) continue;
+        // Queued background jobs wait for a running one to finish
+        if (cls == ECORE_THREAD_CLASS_BACKGROUND &&
+            pool->background_running >= pool->background_max &&
+            pool->pending[cls] <= (int)pool->injected[cls].count)
+          continue;
+        return EINA_TRUE;
+     }
+   return EINA_FALSE;
+}
+
+static inline Eina_Bool
+_ecore_thread_pool_push(Ecore_Thread_Pool *pool, Ecore_Thread_Job *job)
+{
+   Ecore_Thread_Pool_Worker *self = _ecore_thread_pool_self;
+   Ecore_Thread_Pool_Queue *q;
+
+   if (job->parent && self && self->pool == pool)
+     q = &self->deques[job->cls];
+   else
+     q = &pool->injected[job->cls];
+
+   job->queued = ecore_time_get();
+   if (!_ecore_thread_pool_queue_push(q, job)) return EINA_FALSE;
+   __sync_fetch_and_add(&pool->pending[job->cls], 1);
+   __sync_fetch_and_add(&pool->pushed, 1);
+   _ecore_thread_pool_wake(pool);
+   _ecore_thread_pool_wake_joiners(pool);
+   return EINA_TRUE;
+}
+
+/* Takes a job by class: the worker's own queue, then the jobs from the
+ * main loop, then the queues of the other workers. Joining workers skip
+ * the main loop jobs, they only help with children. */
+static inline Ecore_Thread_Job *
+_ecore_thread_pool_get(Ecore_Thread_Pool *pool, Ecore_Thread_Pool_Worker *w, Eina_Bool joining)
+{
+   Ecore_Thread_Job *job;
+   unsigned int i;
+   int cls;
+
+   for (cls = 0; cls < ECORE_THREAD_CLASS_LAST; cls++)
+     {
+        if (pool->pending[cls] <= 0) continue;
+
+        job = _ecore_thread_pool_queue_pop(&w->deques[cls], EINA_TRUE);
+        if (!job && !joining)
+          {
+             if (cls == ECORE_THREAD_CLASS_BACKGROUND)
+               job = _ecore_thread_pool_background_pop(pool);
+             else
+               job = _ecore_thread_pool_queue_pop(&pool->injected[cls], EINA_FALSE);
+          }
+        for (i = 1; !job && i < pool->count; i++)
+          {
+             job = _ecore_thread_pool_queue_pop(&pool->workers[(w->index + i) % pool->count].deques[cls], EINA_FALSE);
+             if (job)
+               {
+                  eina_spinlock_take(&pool->stats_lock);
+                  pool->stats.steals++;
+                  eina_spinlock_release(&pool->stats_lock);
+               }
+          }
+
+        if (job)
+          {
+             __sync_fetch_and_sub(&pool->pending[cls], 1);
+             return job;
+          }
+     }
+   return NULL;
+}
+
+static inline void
+_ecore_thread_pool_end(void *data)
+{
+   Ecore_Thread_Job *job = (Ecore_Thread_Job *)data;
+
+   if (job->cancel)
+     {
+        if (job->func_cancel) job->func_cancel((void *)job->data, job);
+     }
+   else
+     {
+        if (job->func_end) job->func_end((void *)job->data, job);
+     }
+   free(job);
+}
+
+static inline void _ecore_thread_pool_join(Ecore_Thread_Pool *pool, Ecore_Thread_Job *job);
+
+static inline void
+_ecore_thread_pool_run(Ecore_Thread_Pool *pool, Ecore_Thread_Job *job)
+{
+   Ecore_Thread_Class_Stats *st;
+   Eina_Bool background;
+   Eina_Bool cancelled;
+   double start, end;
+
+   // Counted by _ecore_thread_pool_background_pop() already
+   background = (!job->parent && job->cls == ECORE_THREAD_CLASS_BACKGROUND);
+
+   start = ecore_time_get();
+   eina_evlog_ring("+ecore_thread_job", job, NULL);
+   if (!ecore_thread_job_check(job))
+     job->func_blocking((void *)job->data, job);
+   eina_evlog_ring("-ecore_thread_job", job, NULL);
+   // The children may still point to the job
+   if (job->children > 0) _ecore_thread_pool_join(pool, job);
+   end = ecore_time_get();
+   cancelled = !__sync_bool_compare_and_swap(&job->state,
+                                             ECORE_THREAD_JOB_PENDING,
+                                             ECORE_THREAD_JOB_DONE);
+   // Children also give up with their parent
+   if (!cancelled) cancelled = ecore_thread_job_check(job->parent);
+
+   eina_spinlock_take(&pool->stats_lock);
+   st = &pool->stats.classes[job->cls];
+   if (cancelled) st->cancelled++;
+   else st->done++;
+   st->wait_total += start - job->queued;
+   if (start - job->queued > st->wait_max) st->wait_max = start - job->queued;
+   st->run_total += end - start;
+   if (end - start > st->run_max) st->run_max = end - start;
+   eina_spinlock_release(&pool->stats_lock);
+
+   if (background)
+     {
+        __sync_fetch_and_sub(&pool->background_running, 1);
+        _ecore_thread_pool_wake(pool);
+     }
+
+   if (job->parent)
+     {
+        if (__sync_sub_and_fetch(&job->parent->children, 1) == 0)
+          _ecore_thread_pool_wake_joiners(pool);
+        free(job);
+     }
+   else
+     {
+        job->cancel = cancelled;
+        ecore_main_loop_thread_safe_call_async(_ecore_thread_pool_end, job);
+     }
+}
+
+static inline void
+_ecore_thread_pool_join(Ecore_Thread_Pool *pool, Ecore_Thread_Job *job)
+{
+   Ecore_Thread_Pool_Worker *self = _ecore_thread_pool_self;
+   Ecore_Thread_Job *other;
+   unsigned int pushed;
+
+   if (self && self->pool != pool) self = NULL;
+   while (job->children > 0)
+     {
+        pushed = pool->pushed;
+        if (self)
+          {
+             other = _ecore_thread_pool_get(pool, self, EINA_TRUE);
+             if (other)
+               {
+                  _ecore_thread_pool_run(pool, other);
+                  continue;
+               }
+          }
+
+        /* The last children are running elsewhere. Workers also wake up
+         * when more work is pushed, it may be children they can help
+         * with. */
+        eina_lock_take(&pool->lock);
+        __sync_fetch_and_add(&pool->joining, 1);
+        while ((job->children > 0) && ((!self) || (pushed == pool->pushed)))
+          eina_condition_wait(&pool->joined);
+        __sync_fetch_and_sub(&pool->joining, 1);
+        eina_lock_release(&pool->lock);
+     }
+}
+
+static inline void *
+_ecore_thread_pool_worker(void *data, Eina_Thread t EINA_UNUSED)
+{
+   Ecore_Thread_Pool_Worker *w = (Ecore_Thread_Pool_Worker *)data;
+   Ecore_Thread_Pool *pool = w->pool;
+   Ecore_Thread_Job *job;
+
+   _ecore_thread_pool_self = w;
+   while (!pool->quit)
+     {
+        job = _ecore_thread_pool_get(pool, w, EINA_FALSE);
+        if (job)
+          {
+             _ecore_thread_pool_run(pool, job);
+             continue;
+          }
+
+        eina_lock_take(&pool->lock);
+        // Raised before looking at the queues so a push either is seen
+        // here or sees us sleeping and signals
+        __sync_fetch_and_add(&pool->sleeping, 1);
+        while (!pool->quit && !_ecore_thread_pool_has_work(pool))
+          eina_condition_wait(&pool->cond);
+        __sync_fetch_and_sub(&pool->sleeping, 1);
+        eina_lock_release(&pool->lock);
+     }
+   _ecore_thread_pool_self = NULL;
+   return NULL;
+}
+
+static inline void _ecore_thread_pool_stop(Ecore_Thread_Pool *pool);
+static inline void _ecore_thread_pool_free(Ecore_Thread_Pool *pool);
+
+static inline Ecore_Thread_Pool *
+_ecore_thread_pool_get_or_start(void)
+{
+   Ecore_Thread_Pool *pool;
+   unsigned int i, cls;
+   int count;
+
+   pool = __atomic_load_n(&_ecore_thread_pool, __ATOMIC_ACQUIRE);
+   if (pool) return pool;
+
+   // Several threads may ask for the first job at once, only one starts
+   pthread_mutex_lock(&_ecore_thread_pool_start_lock);
+   pool = _ecore_thread_pool;
+   if (pool) goto end;
+
+   count = ecore_thread_max_get();
+   if (count < 1) count = 1;
+
+   pool = (Ecore_Thread_Pool *)calloc(1, sizeof (Ecore_Thread_Pool));
+   if (!pool) goto end;
+   pool->workers = (Ecore_Thread_Pool_Worker *)calloc(count, sizeof (Ecore_Thread_Pool_Worker));
+   if (!pool->workers)
+     {
+        free(pool);
+        pool = NULL;
+        goto end;
+     }
+   pool->background_max = (count + 1) / 2;
+   eina_lock_new(&pool->lock);
+   eina_condition_new(&pool->cond, &pool->lock);
+   eina_condition_new(&pool->joined, &pool->lock);
+   eina_spinlock_new(&pool->stats_lock);
+   for (cls = 0; cls < ECORE_THREAD_CLASS_LAST; cls++)
+     _ecore_thread_pool_queue_init(&pool->injected[cls]);
+
+   for (i = 0; i < (unsigned int)count; i++)
+     {
+        Ecore_Thread_Pool_Worker *w = &pool->workers[pool->count];
+
+        for (cls = 0; cls < ECORE_THREAD_CLASS_LAST; cls++)
+          _ecore_thread_pool_queue_init(&w->deques[cls]);
+        w->pool = pool;
+        w->index = pool->count;
+        // Workers read count, so it only grows once they can see it
+        pool->count++;
+        if (!eina_thread_create(&w->thread, EINA_THREAD_NORMAL, -1,
+                                _ecore_thread_pool_worker, w))
+          {
+             pool->count--;
+             for (cls = 0; cls < ECORE_THREAD_CLASS_LAST; cls++)
+               eina_spinlock_free(&w->deques[cls].lock);
+             break;
+          }
+     }
+
+   if (!pool->count)
+     {
+        _ecore_thread_pool_free(pool);
+        pool = NULL;
+        goto end;
+     }
+   __atomic_store_n(&_ecore_thread_pool, pool, __ATOMIC_RELEASE);
+
+ end:
+   pthread_mutex_unlock(&_ecore_thread_pool_start_lock);
+   return pool;
+}
+
+static inline void
+_ecore_thread_pool_queue_cancel(Ecore_Thread_Pool_Queue *q)
+{
+   Ecore_Thread_Job *job;
+
+   while ((job = _ecore_thread_pool_queue_pop(q, EINA_FALSE)))
+     {
+        // Children were all joined by their parent before the workers left
+        if (!job->parent)
+          {
+             job->cancel = EINA_TRUE;
+             _ecore_thread_pool_end(job);
+          }
+        else free(job);
+     }
+   free(q->jobs);
+   eina_spinlock_free(&q->lock);
+}
+/**
+ * @endcond
+ */
+
+static inline Ecore_Thread_Job *
+ecore_thread_job_run(Ecore_Thread_Class cls, Ecore_Thread_Job_Cb func_blocking,
+                     Ecore_Thread_Job_Cb func_end, Ecore_Thread_Job_Cb func_cancel,
+                     const void *data)
+{
+   Ecore_Thread_Pool *pool;
+   Ecore_Thread_Job *job;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(func_blocking, NULL);
+   if ((unsigned int)cls >= ECORE_THREAD_CLASS_LAST) cls = ECORE_THREAD_CLASS_NORMAL;
+
+   pool = _ecore_thread_pool_get_or_start();
+   if (!pool) return NULL;
+
+   job = (Ecore_Thread_Job *)calloc(1, sizeof (Ecore_Thread_Job));
+   if (!job) return NULL;
+   job->func_blocking = func_blocking;
+   job->func_end = func_end;
+   job->func_cancel = func_cancel;
+   job->data = data;
+   job->cls = cls;
+
+   if (!_ecore_thread_pool_push(pool, job))
+     {
+        free(job);
+        return NULL;
+     }
+   return job;
+}
+
+static inline Eina_Bool
+ecore_thread_job_spawn(Ecore_Thread_Job *parent, Ecore_Thread_Job_Cb func, const void *data)
+{
+   Ecore_Thread_Job *job;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(parent, EINA_FALSE);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(func, EINA_FALSE);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(_ecore_thread_pool, EINA_FALSE);
+
+   job = (Ecore_Thread_Job *)calloc(1, sizeof (Ecore_Thread_Job));
+   if (!job) return EINA_FALSE;
+   job->func_blocking = func;
+   job->data = data;
+   job->parent = parent;
+   job->cls = parent->cls;
+
+   __sync_fetch_and_add(&parent->children, 1);
+   if (!_ecore_thread_pool_push(_ecore_thread_pool, job))
+     {
+        __sync_fetch_and_sub(&parent->children, 1);
+        free(job);
+        return EINA_FALSE;
+     }
+   return EINA_TRUE;
+}
+
+static inline void
+ecore_thread_job_join(Ecore_Thread_Job *job)
+{
+   EINA_SAFETY_ON_NULL_RETURN(job);
+   EINA_SAFETY_ON_NULL_RETURN(_ecore_thread_pool);
+
+   _ecore_thread_pool_join(_ecore_thread_pool, job);
+}
+
+static inline Eina_Bool
+ecore_thread_job_cancel(Ecore_Thread_Job *job)
+{
+   EINA_SAFETY_ON_NULL_RETURN_VAL(job, EINA_FALSE);
+
+   if (!__sync_bool_compare_and_swap(&job->state, ECORE_THREAD_JOB_PENDING,
+                                     ECORE_THREAD_JOB_CANCELLED))
+     return job->state == ECORE_THREAD_JOB_CANCELLED;
+   job->cancel = EINA_TRUE;
+   return EINA_TRUE;
+}
+
+static inline Eina_Bool
+ecore_thread_job_check(const Ecore_Thread_Job *job)
+{
+   for (; job; job = job->parent)
+     if (job->cancel) return EINA_TRUE;
+   return EINA_FALSE;
+}
+
+static inline int
+ecore_thread_pool_pending_get(Ecore_Thread_Class cls)
+{
+   if (!_ecore_thread_pool) return 0;
+   if ((unsigned int)cls >= ECORE_THREAD_CLASS_LAST) return 0;
+   return _ecore_thread_pool->pending[cls];
+}
+
+static inline Eina_Bool
+ecore_thread_pool_stats_get(Ecore_Thread_Pool_Stats *stats)
+{
+   Ecore_Thread_Pool *pool = _ecore_thread_pool;
+   int cls;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(stats, EINA_FALSE);
+   if (!pool) return EINA_FALSE;
+
+   eina_spinlock_take(&pool->stats_lock);
+   *stats = pool->stats;
+   eina_spinlock_release(&pool->stats_lock);
+
+   for (cls = 0; cls < ECORE_THREAD_CLASS_LAST; cls++)
+     stats->classes[cls].pending = pool->pending[cls] > 0 ? pool->pending[cls] : 0;
+   stats->workers = pool->count;
+   return EINA_TRUE;
+}
+
+static inline void
+_ecore_thread_pool_stop(Ecore_Thread_Pool *pool)
+{
+   unsigned int i;
+
+   eina_lock_take(&pool->lock);
+   pool->quit = EINA_TRUE;
+   eina_condition_broadcast(&pool->cond);
+   eina_lock_release(&pool->lock);
+
+   for (i = 0; i < pool->count; i++)
+     eina_thread_join(pool->workers[i].thread);
+}
+
+/* The workers have to be stopped first */
+static inline void
+_ecore_thread_pool_free(Ecore_Thread_Pool *pool)
+{
+   unsigned int i, cls;
+
+   for (cls = 0; cls < ECORE_THREAD_CLASS_LAST; cls++)
+     {
+        for (i = 0; i < pool->count; i++)
+          _ecore_thread_pool_queue_cancel(&pool->workers[i].deques[cls]);
+        _ecore_thread_pool_queue_cancel(&pool->injected[cls]);
+     }
+
+   eina_spinlock_free(&pool->stats_lock);
+   eina_condition_free(&pool->joined);
+   eina_condition_free(&pool->cond);
+   eina_lock_free(&pool->lock);
+   free(pool->workers);
+   free(pool);
+}
+
+static inline void
+ecore_thread_pool_shutdown(void)
+{
+   Ecore_Thread_Pool *pool;
+
+   pthread_mutex_lock(&_ecore_thread_pool_start_lock);
+   pool = _ecore_thread_pool;
+   if (pool)
+     {
+        // Running jobs may still spawn children until the workers left
+        _ecore_thread_pool_stop(pool);
+        __atomic_store_n(&_ecore_thread_pool, NULL, __ATOMIC_RELEASE);
+        _ecore_thread_pool_free(pool);
+     }
+   pthread_mutex_unlock(&_ecore_thread_pool_start_lock);
+}
+
+#undef ECORE_THREAD_POOL_SHARED
+
+#endif
@@ -1877,6 +1877,156 @@ EAPI Eina_Bool         ecore_con_client_connected_get(const Ecore_Con_Client *cl
  */
 EAPI int               ecore_con_client_port_get(const Ecore_Con_Client *cl);
 
+/**
+ * @typedef Ecore_Con_Sender
+ * A zero-copy send queue on a connection, see ecore_con_sender_add().
+ */
+typedef struct _Ecore_Con_Sender Ecore_Con_Sender;
+
+/**
+ * @typedef Ecore_Con_Sender_Event
+ * What an #Ecore_Con_Sender reports to its callback.
+ */
+typedef enum _Ecore_Con_Sender_Event
+{
+   ECORE_CON_SENDER_HIGH, /**< The queued bytes reached the high watermark, stop producing */
+   ECORE_CON_SENDER_LOW, /**< The queued bytes fell to the low watermark, produce again */
+   ECORE_CON_SENDER_DRAINED, /**< Everything queued was sent */
+   ECORE_CON_SENDER_ERROR /**< Writing failed, what was queued is dropped */
+} Ecore_Con_Sender_Event;
+
+/**
+ * @typedef Ecore_Con_Sender_Cb
+ * A callback reporting the state of an #Ecore_Con_Sender.
+ */
+typedef void (*Ecore_Con_Sender_Cb)(void *data, Ecore_Con_Sender *sender, Ecore_Con_Sender_Event event);
+
+/**
+ * @brief Create a zero-copy send queue on a file descriptor
+ *
+ * @param fd The connected, non-blocking socket to write to.
+ * @param low The low watermark in bytes.
+ * @param high The high watermark in bytes, 0 to never report it.
+ * @param func The callback reporting the watermarks, may be @c NULL.
+ * @param data The data to pass to the callback.
+ * @return The new queue, @c NULL on failure.
+ *
+ * Data queued with ecore_con_server_send() or ecore_con_client_send() is
+ * copied into a buffer before being written. This queue takes file ranges
+ * and buffers instead: file ranges go from the page cache to the socket
+ * with sendfile(), buffers are written in place, several at once with
+ * writev(). The socket is watched for writing by an #Ecore_Fd_Batch shared
+ * by all the queues.
+ *
+ * Once the queued bytes reach @p high, @p func gets
+ * #ECORE_CON_SENDER_HIGH, then #ECORE_CON_SENDER_LOW once they fall to
+ * @p low, so a producer can pause instead of queuing a whole file set.
+ *
+ * Writes use MSG_NOSIGNAL, and SIGPIPE is kept blocked around sendfile(),
+ * so a peer that went away is reported as #ECORE_CON_SENDER_ERROR.
+ *
+ * @warning This writes to the socket directly, nothing else may write to
+ * @p fd while the queue exists. Ecore_Con keeps what it is given in its
+ * own buffer and writes it later, so for its connections use
+ * ecore_con_client_sender_add() instead.
+ *
+ * @see ecore_con_client_sender_add()
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Ecore_Con_Sender *ecore_con_sender_add(int fd, size_t low, size_t high, Ecore_Con_Sender_Cb func, const void *data);
+
+/**
+ * @brief Create a zero-copy send queue on a client
+ *
+ * @param cl The client to send to.
+ * @param low The low watermark in bytes.
+ * @param high The high watermark in bytes, 0 to never report it.
+ * @param func The callback reporting the watermarks, may be @c NULL.
+ * @param data The data to pass to the callback.
+ * @return The new queue, @c NULL on failure.
+ *
+ * The queue works like ecore_con_sender_add() but goes through the buffer
+ * of @p cl with ecore_con_client_send(), a piece at a time as
+ * #ECORE_CON_EVENT_CLIENT_WRITE reports it written. What is queued stays
+ * in order with what is sent with ecore_con_client_send() and SSL clients
+ * work, at the cost of a copy: file ranges are read from a mapping of the
+ * file, not sent with sendfile(). Delete the queue before the client, at
+ * the latest from the #ECORE_CON_EVENT_CLIENT_DEL handler.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Ecore_Con_Sender *ecore_con_client_sender_add(Ecore_Con_Client *cl, size_t low, size_t high, Ecore_Con_Sender_Cb func, const void *data);
+
+/**
+ * @brief Delete a zero-copy send queue
+ *
+ * @param sender The queue, what it still holds is dropped.
+ * @return The data given at creation.
+ *
+ * The socket is not closed. This may be called from the queue callback.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline void *ecore_con_sender_del(Ecore_Con_Sender *sender);
+
+/**
+ * @brief Queue a range of a file
+ *
+ * @param sender The queue.
+ * @param file The file, a reference is kept until the range is sent.
+ * @param offset Where the range starts.
+ * @param length The length of the range, it is cut at the end of the file.
+ * @return @c EINA_TRUE on success, @c EINA_FALSE otherwise.
+ *
+ * The range is sent with sendfile(), the bytes never go through user
+ * space. Virtual files, and systems where sendfile() fails for the
+ * socket, are written from a mapping of the file instead.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool ecore_con_sender_file_send(Ecore_Con_Sender *sender, Eina_File *file, size_t offset, size_t length);
+
+/**
+ * @brief Queue buffers
+ *
+ * @param sender The queue.
+ * @param bufs The buffers, the queue takes them and frees them once sent.
+ * @param count How many buffers are in @p bufs.
+ * @return @c EINA_TRUE on success, @c EINA_FALSE otherwise, then the
+ * buffers are freed.
+ *
+ * Buffers queued one after the other, by this call or several of them,
+ * are written together with a single writev().
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool ecore_con_sender_binbufs_send(Ecore_Con_Sender *sender, Eina_Binbuf **bufs, unsigned int count);
+
+/**
+ * @brief Get the number of bytes waiting in a queue
+ *
+ * @param sender The queue.
+ * @return The bytes queued and not yet written to the socket.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline size_t ecore_con_sender_queued_get(const Ecore_Con_Sender *sender);
+
+#include "ecore_con_inline_sender.x"
+
 
 
 /**
@@ -2711,6 +2861,194 @@ EAPI void ecore_con_url_timeout_set(Ecore_Con_Url *url_con, double timeout);
  * @endif
  */
 EAPI int ecore_con_url_status_code_get(Ecore_Con_Url *url_con);
+
+/**
+ * @typedef Ecore_Con_Url_Pool
+ * A scheduler sharing connections between many transfers, see
+ * ecore_con_url_pool_new().
+ */
+typedef struct _Ecore_Con_Url_Pool Ecore_Con_Url_Pool;
+
+/**
+ * @typedef Ecore_Con_Url_Request
+ * A transfer queued on an #Ecore_Con_Url_Pool.
+ */
+typedef struct _Ecore_Con_Url_Request Ecore_Con_Url_Request;
+
+/**
+ * @typedef Ecore_Con_Url_Priority
+ * The order in which queued requests are started.
+ */
+typedef enum _Ecore_Con_Url_Priority
+{
+   ECORE_CON_URL_PRIORITY_HIGH, /**< Started before anything else, like what is on screen */
+   ECORE_CON_URL_PRIORITY_NORMAL, /**< The default */
+   ECORE_CON_URL_PRIORITY_LOW, /**< Started when nothing else waits, like prefetching */
+   ECORE_CON_URL_PRIORITY_LAST /**< Sentinel value, not a priority */
+} Ecore_Con_Url_Priority;
+
+/**
+ * @typedef Ecore_Con_Url_Request_Cb
+ * A callback receiving the answer to an #Ecore_Con_Url_Request.
+ *
+ * @p status is the HTTP status code, 0 if the transfer failed. @p body is
+ * the whole response, valid until the callback returns. The request is
+ * freed once it returns.
+ */
+typedef void (*Ecore_Con_Url_Request_Cb)(void *data, Ecore_Con_Url_Request *req, int status, const void *body, size_t size);
+
+/**
+ * @typedef Ecore_Con_Url_Pool_Stats
+ * The counters of an #Ecore_Con_Url_Pool.
+ */
+typedef struct _Ecore_Con_Url_Pool_Stats
+{
+   unsigned long long requests; /**< Requests queued */
+   unsigned long long transfers; /**< Transfers started */
+   unsigned long long connections; /**< Ecore_Con_Url objects created */
+   unsigned long long reused; /**< Transfers started on a kept Ecore_Con_Url */
+   unsigned long long cache_hits; /**< Requests answered without a transfer */
+   unsigned long long revalidated; /**< Transfers answered by 304 Not Modified */
+   unsigned long long stored; /**< Responses put in the cache */
+   unsigned long long evicted; /**< Responses pushed out of the cache */
+   unsigned int pending; /**< Requests waiting for a connection */
+   unsigned int running; /**< Transfers in progress */
+   unsigned int cached; /**< Responses in the cache */
+   size_t cached_bytes; /**< Size of the responses in the cache */
+} Ecore_Con_Url_Pool_Stats;
+
+/**
+ * @brief Create a transfer scheduler
+ *
+ * @param max_total How many transfers may run at once, 0 for 16.
+ * @param max_per_host How many of them may go to the same host, 0 for 4.
+ * @return The new pool, @c NULL on failure.
+ *
+ * Starting hundreds of Ecore_Con_Url transfers at once opens as many
+ * connections to the server and lets them all compete. A pool queues the
+ * requests instead, starts the highest priority ones first within the
+ * limits, and hands each finished Ecore_Con_Url to the next request for
+ * the same host. libcurl keeps the finished HTTP/1.1 connections alive, so
+ * the following transfers reuse them instead of connecting again.
+ * Enabling ecore_con_url_pipeline_set() lets them share connections
+ * further.
+ *
+ * The pool listens to #ECORE_CON_EVENT_URL_DATA and
+ * #ECORE_CON_EVENT_URL_COMPLETE, the events of its own transfers are not
+ * passed on to the handlers added after it.
+ *
+ * @see ecore_con_url_pool_get()
+ * @see ecore_con_url_pool_cache_set()
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Ecore_Con_Url_Pool *ecore_con_url_pool_new(unsigned int max_total, unsigned int max_per_host);
+
+/**
+ * @brief Free a transfer scheduler
+ *
+ * @param pool The pool to free.
+ *
+ * Running transfers are aborted, they and the queued requests are dropped
+ * without calling their callbacks.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline void ecore_con_url_pool_free(Ecore_Con_Url_Pool *pool);
+
+/**
+ * @brief Set up the response cache of a pool
+ *
+ * @param pool The pool.
+ * @param max_bytes The size of the cached responses, 0 disables the cache.
+ * @param fresh For how many seconds a cached response is used without
+ * asking the server, 0 to always ask.
+ *
+ * Responses carrying an ETag or a Last-Modified header are kept, the
+ * least recently used are dropped first. A later request for the same URL
+ * sends If-None-Match or If-Modified-Since, and a 304 answer is reported
+ * to its callback as 200 with the cached body.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline void ecore_con_url_pool_cache_set(Ecore_Con_Url_Pool *pool, size_t max_bytes, double fresh);
+
+/**
+ * @brief Drop the cached responses of a pool
+ *
+ * @param pool The pool.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline void ecore_con_url_pool_cache_clear(Ecore_Con_Url_Pool *pool);
+
+/**
+ * @brief Queue a GET request
+ *
+ * @param pool The pool.
+ * @param url The URL to fetch.
+ * @param priority When to start it compared to the other requests.
+ * @param func The callback receiving the response.
+ * @param data The data to pass to the callback.
+ * @return The request, @c NULL on failure.
+ *
+ * @p func is always called from the main loop, never from this call, even
+ * when the answer comes from the cache.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Ecore_Con_Url_Request *ecore_con_url_pool_get(Ecore_Con_Url_Pool *pool, const char *url, Ecore_Con_Url_Priority priority, Ecore_Con_Url_Request_Cb func, const void *data);
+
+/**
+ * @brief Change the priority of a request
+ *
+ * @param req The request.
+ * @param priority The new priority, it only matters while @p req waits.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline void ecore_con_url_pool_priority_set(Ecore_Con_Url_Request *req, Ecore_Con_Url_Priority priority);
+
+/**
+ * @brief Cancel a request
+ *
+ * @param req The request, freed without calling its callback.
+ *
+ * A running transfer is aborted. Calling this from the callback of @p req
+ * does nothing.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline void ecore_con_url_pool_cancel(Ecore_Con_Url_Request *req);
+
+/**
+ * @brief Get the counters of a pool
+ *
+ * @param pool The pool.
+ * @param stats Where to store the counters.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline void ecore_con_url_pool_stats_get(const Ecore_Con_Url_Pool *pool, Ecore_Con_Url_Pool_Stats *stats);
+
+#include "ecore_con_inline_url.x"
+
 /**
  * @}
  */
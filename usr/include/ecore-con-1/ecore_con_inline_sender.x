@@ -0,0 +1,602 @@
+/* ECORE_CON - EFL connection library
+ * Copyright (C) 2016 Samsung Electronics Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library;
+ * if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ECORE_CON_INLINE_SENDER_X_
+#define ECORE_CON_INLINE_SENDER_X_
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <sys/socket.h>
+#include <sys/sendfile.h>
+
+#include <Ecore.h>
+
+/**
+ * @cond LOCAL
+ */
+
+/* The queues share one fd set while this code is compiled in every user,
+ * let the linker merge the copies. */
+#define ECORE_CON_SENDER_SHARED __attribute__ ((weak))
+
+#define ECORE_CON_SENDER_IOV 64
+/* How much a client queue keeps in the buffer of Ecore_Con at once */
+#define ECORE_CON_SENDER_CLIENT_CHUNK (256 * 1024)
+
+typedef struct _Ecore_Con_Sender_Segment Ecore_Con_Sender_Segment;
+
+struct _Ecore_Con_Sender_Segment
+{
+   Ecore_Con_Sender_Segment *next;
+   Eina_Binbuf *buf; // or a file range
+   Eina_File *file;
+   const unsigned char *map; // of the whole file, only once sendfile() failed
+   int fd;
+   size_t offset; // of the next byte to send
+   size_t left;
+};
+
+struct _Ecore_Con_Sender
+{
+   Ecore_Con_Sender *next_zombie;
+   Ecore_Con_Sender *next_client;
+   Ecore_Con_Client *cl; // written through its buffer instead of the fd
+   Ecore_Con_Sender_Segment *head;
+   Ecore_Con_Sender_Segment **tail;
+   Ecore_Con_Sender_Cb func;
+   const void *data;
+   size_t queued;
+   size_t low, high;
+   size_t handed; // given to cl and not reported written yet
+   int fd;
+   unsigned int events; // bits of Ecore_Con_Sender_Event to report
+
+   Eina_Bool above : 1; // HIGH was reported, LOW was not yet
+   Eina_Bool writable : 1;
+   Eina_Bool no_sendfile : 1;
+   Eina_Bool busy : 1;
+   Eina_Bool again : 1;
+   Eina_Bool delete_me : 1;
+};
+
+ECORE_CON_SENDER_SHARED Ecore_Fd_Batch *_ecore_con_sender_batch = NULL;
+ECORE_CON_SENDER_SHARED unsigned int _ecore_con_sender_count = 0;
+ECORE_CON_SENDER_SHARED Eina_Bool _ecore_con_sender_dispatching = EINA_FALSE;
+ECORE_CON_SENDER_SHARED Ecore_Con_Sender *_ecore_con_sender_zombies = NULL;
+ECORE_CON_SENDER_SHARED Ecore_Con_Sender *_ecore_con_sender_clients = NULL;
+ECORE_CON_SENDER_SHARED Ecore_Event_Handler *_ecore_con_sender_client_handler = NULL;
+
+static inline void
+_ecore_con_sender_segment_free(Ecore_Con_Sender_Segment *seg)
+{
+   if (seg->buf) eina_binbuf_free(seg->buf);
+   if (seg->map) eina_file_map_free(seg->file, (void *)seg->map);
+   if (seg->fd >= 0) close(seg->fd);
+   if (seg->file) eina_file_close(seg->file);
+   free(seg);
+}
+
+static inline void
+_ecore_con_sender_consumed(Ecore_Con_Sender *s, size_t n)
+{
+   s->queued -= n;
+   if (s->above && s->queued <= s->low)
+     {
+        s->above = EINA_FALSE;
+        s->events |= 1 << ECORE_CON_SENDER_LOW;
+     }
+}
+
+static inline void
+_ecore_con_sender_pop(Ecore_Con_Sender *s)
+{
+   Ecore_Con_Sender_Segment *seg = s->head;
+
+   s->head = seg->next;
+   if (!s->head) s->tail = &s->head;
+   _ecore_con_sender_segment_free(seg);
+}
+
+static inline void
+_ecore_con_sender_fail(Ecore_Con_Sender *s)
+{
+   while (s->head) _ecore_con_sender_pop(s);
+   s->queued = 0;
+   s->above = EINA_FALSE;
+   s->events |= 1 << ECORE_CON_SENDER_ERROR;
+}
+
+/* Consecutive buffers go in one writev(), returns how much was written. */
+static inline ssize_t
+_ecore_con_sender_write_bufs(Ecore_Con_Sender *s)
+{
+   struct iovec iov[ECORE_CON_SENDER_IOV];
+   struct msghdr msg;
+   Ecore_Con_Sender_Segment *seg;
+   int n = 0;
+   ssize_t r;
+   size_t done;
+
+   for (seg = s->head; seg && seg->buf && n < ECORE_CON_SENDER_IOV; seg = seg->next)
+     {
+        iov[n].iov_base = (void *)(eina_binbuf_string_get(seg->buf) + seg->offset);
+        iov[n].iov_len = seg->left;
+        n++;
+     }
+
+   memset(&msg, 0, sizeof (msg));
+   msg.msg_iov = iov;
+   msg.msg_iovlen = n;
+   // A peer that went away is an error to report, not a reason to die
+   r = sendmsg(s->fd, &msg, MSG_NOSIGNAL);
+   if (r <= 0) return r;
+
+   for (done = r; done && s->head;)
+     {
+        seg = s->head;
+        if (done < seg->left)
+          {
+             seg->offset += done;
+             seg->left -= done;
+             break;
+          }
+        done -= seg->left;
+        _ecore_con_sender_pop(s);
+     }
+   return r;
+}
+
+/* sendfile() has no MSG_NOSIGNAL, keep SIGPIPE blocked around it and take
+ * back the one it raised, unless one was already pending. */
+static inline ssize_t
+_ecore_con_sender_sendfile(int out, int in, off_t *off, size_t count)
+{
+   struct timespec zero = { 0, 0 };
+   sigset_t sigpipe, pending, old;
+   Eina_Bool was_pending;
+   ssize_t r;
+   int err;
+
+   sigemptyset(&sigpipe);
+   sigaddset(&sigpipe, SIGPIPE);
+   pthread_sigmask(SIG_BLOCK, &sigpipe, &old);
+   sigpending(&pending);
+   was_pending = sigismember(&pending, SIGPIPE);
+   r = sendfile(out, in, off, count);
+   err = errno;
+   if (r < 0 && err == EPIPE && !was_pending)
+     sigtimedwait(&sigpipe, NULL, &zero);
+   pthread_sigmask(SIG_SETMASK, &old, NULL);
+   errno = err;
+   return r;
+}
+
+static inline const unsigned char *
+_ecore_con_sender_file_map(Ecore_Con_Sender_Segment *seg)
+{
+   if (!seg->map)
+     seg->map = (const unsigned char *)eina_file_map_all(seg->file, EINA_FILE_SEQUENTIAL);
+   if (!seg->map) errno = EIO;
+   return seg->map;
+}
+
+static inline ssize_t
+_ecore_con_sender_write_file(Ecore_Con_Sender *s)
+{
+   Ecore_Con_Sender_Segment *seg = s->head;
+   size_t chunk = seg->left < 0x7ffff000 ? seg->left : 0x7ffff000;
+   ssize_t r;
+
+   if (seg->fd >= 0 && !s->no_sendfile)
+     {
+        off_t off = seg->offset;
+
+        r = _ecore_con_sender_sendfile(s->fd, seg->fd, &off, chunk);
+        if (r >= 0 || (errno != EINVAL && errno != ENOSYS))
+          goto progress;
+        // The socket family does not support it, fall back for good
+        s->no_sendfile = EINA_TRUE;
+     }
+
+   if (!_ecore_con_sender_file_map(seg)) return -1;
+   r = send(s->fd, seg->map + seg->offset, chunk, MSG_NOSIGNAL);
+
+ progress:
+   if (r <= 0) return r;
+   seg->offset += r;
+   seg->left -= r;
+   if (!seg->left) _ecore_con_sender_pop(s);
+   return r;
+}
+
+/* A piece of the first segment goes to the buffer of the client, the rest
+ * waits for Ecore_Con to report that it wrote what it was handed. */
+static inline ssize_t
+_ecore_con_sender_write_client(Ecore_Con_Sender *s)
+{
+   Ecore_Con_Sender_Segment *seg = s->head;
+   const unsigned char *p;
+   size_t n = ECORE_CON_SENDER_CLIENT_CHUNK - s->handed;
+
+   if (seg->buf) p = eina_binbuf_string_get(seg->buf);
+   else p = _ecore_con_sender_file_map(seg);
+   if (!p) return -1;
+   if (n > seg->left) n = seg->left;
+   if (ecore_con_client_send(s->cl, p + seg->offset, (int)n) <= 0)
+     {
+        errno = EIO;
+        return -1;
+     }
+   s->handed += n;
+   seg->offset += n;
+   seg->left -= n;
+   if (!seg->left) _ecore_con_sender_pop(s);
+   return n;
+}
+
+static inline void
+_ecore_con_sender_flush(Ecore_Con_Sender *s)
+{
+   Eina_Bool had = !!s->head;
+   ssize_t r;
+
+   while (s->head && (s->cl ? s->handed < ECORE_CON_SENDER_CLIENT_CHUNK : s->writable))
+     {
+        if (s->cl) r = _ecore_con_sender_write_client(s);
+        else if (s->head->buf) r = _ecore_con_sender_write_bufs(s);
+        else r = _ecore_con_sender_write_file(s);
+
+        if (r > 0)
+          _ecore_con_sender_consumed(s, r);
+        else if (r < 0 && errno == EINTR)
+          continue;
+        else if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+          s->writable = EINA_FALSE; // edge-triggered, wait for the next edge
+        else
+          _ecore_con_sender_fail(s);
+     }
+   if (had && !s->head && !(s->events & (1 << ECORE_CON_SENDER_ERROR)))
+     s->events |= 1 << ECORE_CON_SENDER_DRAINED;
+}
+
+static inline void
+_ecore_con_sender_free(Ecore_Con_Sender *s)
+{
+   while (s->head) _ecore_con_sender_pop(s);
+   free(s);
+}
+
+/* Writes and reports until there is nothing more to do. Callbacks may
+ * queue more or delete the queue, both are handled here. */
+static inline void
+_ecore_con_sender_kick(Ecore_Con_Sender *s)
+{
+   int ev;
+
+   if (s->busy)
+     {
+        s->again = EINA_TRUE;
+        return;
+     }
+
+   s->busy = EINA_TRUE;
+   do
+     {
+        s->again = EINA_FALSE;
+        _ecore_con_sender_flush(s);
+        for (ev = ECORE_CON_SENDER_HIGH; ev <= ECORE_CON_SENDER_ERROR && !s->delete_me; ev++)
+          {
+             if (!(s->events & (1 << ev))) continue;
+             s->events &= ~(1 << ev);
+             if (s->func) s->func((void *)s->data, s, (Ecore_Con_Sender_Event)ev);
+          }
+     }
+   while ((s->again || s->events) && !s->delete_me);
+   s->busy = EINA_FALSE;
+
+   if (!s->delete_me) return;
+   if (_ecore_con_sender_dispatching)
+     {
+        s->next_zombie = _ecore_con_sender_zombies;
+        _ecore_con_sender_zombies = s;
+     }
+   else
+     _ecore_con_sender_free(s);
+}
+
+static inline void
+_ecore_con_sender_dispatch(void *data EINA_UNUSED, Ecore_Fd_Batch *batch EINA_UNUSED,
+                           const Ecore_Fd_Batch_Event *events, unsigned int count)
+{
+   Ecore_Con_Sender *s;
+   unsigned int i;
+
+   // Deleted queues are kept until the end, later events may point to them
+   _ecore_con_sender_dispatching = EINA_TRUE;
+   for (i = 0; i < count; i++)
+     {
+        s = (Ecore_Con_Sender *)events[i].data;
+        if (s->delete_me) continue;
+        if (events[i].flags & ECORE_FD_ERROR)
+          {
+             s->writable = EINA_FALSE;
+             if (s->head) _ecore_con_sender_fail(s);
+          }
+        else
+          s->writable = EINA_TRUE;
+        _ecore_con_sender_kick(s);
+     }
+   _ecore_con_sender_dispatching = EINA_FALSE;
+
+   while ((s = _ecore_con_sender_zombies))
+     {
+        _ecore_con_sender_zombies = s->next_zombie;
+        _ecore_con_sender_free(s);
+     }
+}
+
+static inline Eina_Bool
+_ecore_con_sender_queue(Ecore_Con_Sender *s, Ecore_Con_Sender_Segment *seg)
+{
+   seg->next = NULL;
+   *s->tail = seg;
+   s->tail = &seg->next;
+   s->queued += seg->left;
+   if (s->high && !s->above && s->queued >= s->high)
+     {
+        s->above = EINA_TRUE;
+        s->events |= 1 << ECORE_CON_SENDER_HIGH;
+     }
+   return EINA_TRUE;
+}
+
+static inline Eina_Bool
+_ecore_con_sender_client_write(void *data EINA_UNUSED, int type EINA_UNUSED, void *event)
+{
+   Ecore_Con_Event_Client_Write *ev = (Ecore_Con_Event_Client_Write *)event;
+   Ecore_Con_Sender *s;
+
+   for (s = _ecore_con_sender_clients; s; s = s->next_client)
+     {
+        if (s->cl != ev->client) continue;
+        // What the client sent itself is counted too, it only delays us
+        if ((size_t)ev->size < s->handed) s->handed -= ev->size;
+        else s->handed = 0;
+        _ecore_con_sender_kick(s);
+        break;
+     }
+   return ECORE_CALLBACK_PASS_ON;
+}
+
+static inline Ecore_Con_Sender *
+_ecore_con_sender_new(size_t low, size_t high, Ecore_Con_Sender_Cb func, const void *data)
+{
+   Ecore_Con_Sender *s;
+
+   s = (Ecore_Con_Sender *)calloc(1, sizeof (Ecore_Con_Sender));
+   if (!s) return NULL;
+   s->tail = &s->head;
+   s->fd = -1;
+   s->low = low;
+   s->high = high;
+   s->func = func;
+   s->data = data;
+   return s;
+}
+/**
+ * @endcond
+ */
+
+static inline Ecore_Con_Sender *
+ecore_con_sender_add(int fd, size_t low, size_t high, Ecore_Con_Sender_Cb func, const void *data)
+{
+   Ecore_Con_Sender *s;
+
+   EINA_SAFETY_ON_TRUE_RETURN_VAL(fd < 0, NULL);
+   EINA_SAFETY_ON_TRUE_RETURN_VAL(high && low > high, NULL);
+
+   if (!_ecore_con_sender_batch)
+     {
+        _ecore_con_sender_batch = ecore_fd_batch_add(0, _ecore_con_sender_dispatch, NULL);
+        if (!_ecore_con_sender_batch) return NULL;
+     }
+
+   s = _ecore_con_sender_new(low, high, func, data);
+   if (!s) goto on_error;
+   s->fd = fd;
+   // Until told otherwise, the first write will tell
+   s->writable = EINA_TRUE;
+
+   if (!ecore_fd_batch_fd_add(_ecore_con_sender_batch, fd, ECORE_FD_WRITE, s))
+     {
+        free(s);
+        goto on_error;
+     }
+   _ecore_con_sender_count++;
+   return s;
+
+ on_error:
+   if (!_ecore_con_sender_count)
+     {
+        ecore_fd_batch_del(_ecore_con_sender_batch);
+        _ecore_con_sender_batch = NULL;
+     }
+   return NULL;
+}
+
+static inline Ecore_Con_Sender *
+ecore_con_client_sender_add(Ecore_Con_Client *cl, size_t low, size_t high, Ecore_Con_Sender_Cb func, const void *data)
+{
+   Ecore_Con_Sender *s;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(cl, NULL);
+   EINA_SAFETY_ON_TRUE_RETURN_VAL(high && low > high, NULL);
+
+   if (!_ecore_con_sender_client_handler)
+     {
+        _ecore_con_sender_client_handler =
+          ecore_event_handler_add(ECORE_CON_EVENT_CLIENT_WRITE,
+                                  _ecore_con_sender_client_write, NULL);
+        if (!_ecore_con_sender_client_handler) return NULL;
+     }
+
+   s = _ecore_con_sender_new(low, high, func, data);
+   if (!s)
+     {
+        if (!_ecore_con_sender_clients)
+          {
+             ecore_event_handler_del(_ecore_con_sender_client_handler);
+             _ecore_con_sender_client_handler = NULL;
+          }
+        return NULL;
+     }
+   s->cl = cl;
+   s->next_client = _ecore_con_sender_clients;
+   _ecore_con_sender_clients = s;
+   return s;
+}
+
+static inline void *
+ecore_con_sender_del(Ecore_Con_Sender *sender)
+{
+   void *data;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(sender, NULL);
+   EINA_SAFETY_ON_TRUE_RETURN_VAL(sender->delete_me, NULL);
+
+   data = (void *)sender->data;
+   sender->delete_me = EINA_TRUE;
+   if (sender->cl)
+     {
+        Ecore_Con_Sender **l;
+
+        for (l = &_ecore_con_sender_clients; *l != sender; l = &(*l)->next_client)
+          ;
+        *l = sender->next_client;
+        // The handler is looked up by the pointer all the copies share
+        if (!_ecore_con_sender_clients)
+          {
+             ecore_event_handler_del(_ecore_con_sender_client_handler);
+             _ecore_con_sender_client_handler = NULL;
+          }
+     }
+   else
+     {
+        ecore_fd_batch_fd_del(_ecore_con_sender_batch, sender->fd);
+        // The batch may be running, keep it, it costs one idle epoll fd
+        _ecore_con_sender_count--;
+     }
+
+   if (sender->busy)
+     ; // freed when its callback returns
+   else if (_ecore_con_sender_dispatching)
+     {
+        sender->next_zombie = _ecore_con_sender_zombies;
+        _ecore_con_sender_zombies = sender;
+     }
+   else
+     _ecore_con_sender_free(sender);
+   return data;
+}
+
+static inline Eina_Bool
+ecore_con_sender_file_send(Ecore_Con_Sender *sender, Eina_File *file, size_t offset, size_t length)
+{
+   Ecore_Con_Sender_Segment *seg;
+   size_t size;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(sender, EINA_FALSE);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(file, EINA_FALSE);
+   EINA_SAFETY_ON_TRUE_RETURN_VAL(sender->delete_me, EINA_FALSE);
+
+   size = eina_file_size_get(file);
+   if (offset >= size) return EINA_TRUE;
+   if (length > size - offset) length = size - offset;
+   if (!length) return EINA_TRUE;
+
+   seg = (Ecore_Con_Sender_Segment *)calloc(1, sizeof (Ecore_Con_Sender_Segment));
+   if (!seg) return EINA_FALSE;
+   seg->file = eina_file_dup(file);
+   seg->offset = offset;
+   seg->left = length;
+   seg->fd = -1;
+   if (!sender->cl && !eina_file_virtual(file))
+     seg->fd = open(eina_file_filename_get(file), O_RDONLY | O_CLOEXEC);
+
+   _ecore_con_sender_queue(sender, seg);
+   _ecore_con_sender_kick(sender);
+   return EINA_TRUE;
+}
+
+static inline Eina_Bool
+ecore_con_sender_binbufs_send(Ecore_Con_Sender *sender, Eina_Binbuf **bufs, unsigned int count)
+{
+   Ecore_Con_Sender_Segment *seg;
+   unsigned int i;
+
+   EINA_SAFETY_ON_TRUE_GOTO(!sender || sender->delete_me, on_error);
+   EINA_SAFETY_ON_TRUE_GOTO(count && !bufs, on_error);
+
+   for (i = 0; i < count; i++)
+     {
+        if (!eina_binbuf_length_get(bufs[i]))
+          {
+             eina_binbuf_free(bufs[i]);
+             continue;
+          }
+        seg = (Ecore_Con_Sender_Segment *)calloc(1, sizeof (Ecore_Con_Sender_Segment));
+        if (!seg)
+          {
+             for (; i < count; i++)
+               eina_binbuf_free(bufs[i]);
+             _ecore_con_sender_kick(sender);
+             return EINA_FALSE;
+          }
+        seg->buf = bufs[i];
+        seg->left = eina_binbuf_length_get(bufs[i]);
+        seg->fd = -1;
+        _ecore_con_sender_queue(sender, seg);
+     }
+   _ecore_con_sender_kick(sender);
+   return EINA_TRUE;
+
+ on_error:
+   for (i = 0; bufs && i < count; i++)
+     eina_binbuf_free(bufs[i]);
+   return EINA_FALSE;
+}
+
+static inline size_t
+ecore_con_sender_queued_get(const Ecore_Con_Sender *sender)
+{
+   EINA_SAFETY_ON_NULL_RETURN_VAL(sender, 0);
+   return sender->queued;
+}
+
+#undef ECORE_CON_SENDER_IOV
+#undef ECORE_CON_SENDER_CLIENT_CHUNK
+#undef ECORE_CON_SENDER_SHARED
+
+#endif
@@ -0,0 +1,709 @@
+/* ECORE_CON - EFL connection library
+ * Copyright (C) 2016 Samsung Electronics Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library;
+ * if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ECORE_CON_INLINE_URL_X_
+#define ECORE_CON_INLINE_URL_X_
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+
+#include <Ecore.h>
+
+/**
+ * @cond LOCAL
+ */
+
+#define ECORE_CON_URL_POOL_HOST_MAX 256
+
+typedef struct _Ecore_Con_Url_Pool_Host Ecore_Con_Url_Pool_Host;
+typedef struct _Ecore_Con_Url_Pool_Entry Ecore_Con_Url_Pool_Entry;
+
+struct _Ecore_Con_Url_Request
+{
+   EINA_INLIST;
+   Ecore_Con_Url_Pool *pool;
+   Ecore_Con_Url_Pool_Host *host; // NULL when answered from the cache
+   Ecore_Con_Url_Pool_Entry *entry; // kept while the answer may need it
+   Ecore_Con_Url *url_con; // while running
+   Eina_Binbuf *body;
+   const char *url;
+   Ecore_Con_Url_Request_Cb func;
+   const void *data;
+   Ecore_Con_Url_Priority priority;
+   Eina_Bool ready : 1;
+   Eina_Bool failed : 1;
+   Eina_Bool delivering : 1;
+};
+
+struct _Ecore_Con_Url_Pool_Host
+{
+   EINA_INLIST;
+   const char *key; // scheme://host:port
+   Eina_Inlist *pending[ECORE_CON_URL_PRIORITY_LAST];
+   Eina_List *idle; // finished Ecore_Con_Url for the next request
+   unsigned int running;
+};
+
+struct _Ecore_Con_Url_Pool_Entry
+{
+   EINA_INLIST; // least recently used first
+   const char *url; // NULL once replaced while still referenced
+   char *etag;
+   char *modified;
+   unsigned char *body;
+   size_t size;
+   double stamp;
+   unsigned int refs;
+};
+
+struct _Ecore_Con_Url_Pool
+{
+   Eina_Inlist *hosts;
+   Eina_Inlist *ready; // answered from the cache by the job
+   Eina_Inlist *lru;
+   Eina_Hash *running; // Ecore_Con_Url -> request
+   Eina_Hash *cache; // url -> entry
+   Ecore_Job *job;
+   Ecore_Event_Handler *data_handler;
+   Ecore_Event_Handler *complete_handler;
+   Ecore_Con_Url_Pool_Stats stats;
+   size_t cache_max;
+   double fresh;
+   unsigned int max_total, max_per_host;
+   unsigned int walking;
+   Eina_Bool delete_me : 1;
+};
+
+/* Requests to the same scheme, host and port share their connections. */
+static inline const char *
+_ecore_con_url_pool_host_key(const char *url, char *buf, size_t size)
+{
+   const char *p, *end;
+   size_t n;
+
+   p = strstr(url, "://");
+   if (!p) return NULL;
+   end = p + 3;
+   end += strcspn(end, "/?#");
+   n = end - url;
+   if (n >= size) n = size - 1;
+   for (size = 0; size < n; size++)
+     buf[size] = tolower((unsigned char)url[size]);
+   buf[n] = '\0';
+   return buf;
+}
+
+static inline Ecore_Con_Url_Pool_Host *
+_ecore_con_url_pool_host_get(Ecore_Con_Url_Pool *pool, const char *url)
+{
+   char buf[ECORE_CON_URL_POOL_HOST_MAX];
+   Ecore_Con_Url_Pool_Host *host;
+   const char *key;
+
+   key = _ecore_con_url_pool_host_key(url, buf, sizeof (buf));
+   if (!key) return NULL;
+
+   EINA_INLIST_FOREACH(pool->hosts, host)
+     if (!strcmp(host->key, key)) return host;
+
+   host = (Ecore_Con_Url_Pool_Host *)calloc(1, sizeof (Ecore_Con_Url_Pool_Host));
+   if (!host) return NULL;
+   host->key = eina_stringshare_add(key);
+   pool->hosts = eina_inlist_append(pool->hosts, EINA_INLIST_GET(host));
+   return host;
+}
+
+static inline void
+_ecore_con_url_pool_entry_free(Ecore_Con_Url_Pool_Entry *e)
+{
+   eina_stringshare_del(e->url);
+   free(e->etag);
+   free(e->modified);
+   free(e->body);
+   free(e);
+}
+
+/* Takes an entry out of the cache, it lives on while requests hold it. */
+static inline void
+_ecore_con_url_pool_entry_unlink(Ecore_Con_Url_Pool *pool, Ecore_Con_Url_Pool_Entry *e)
+{
+   eina_hash_del_by_key(pool->cache, e->url);
+   pool->lru = eina_inlist_remove(pool->lru, EINA_INLIST_GET(e));
+   pool->stats.cached--;
+   pool->stats.cached_bytes -= e->size;
+   eina_stringshare_del(e->url);
+   e->url = NULL;
+   if (!e->refs) _ecore_con_url_pool_entry_free(e);
+}
+
+static inline void
+_ecore_con_url_pool_entry_unref(Ecore_Con_Url_Pool_Entry *e)
+{
+   if (--e->refs || e->url) return;
+   _ecore_con_url_pool_entry_free(e);
+}
+
+static inline void
+_ecore_con_url_pool_cache_trim(Ecore_Con_Url_Pool *pool)
+{
+   Ecore_Con_Url_Pool_Entry *e;
+   Eina_Inlist *l;
+
+   for (l = pool->lru; l && pool->stats.cached_bytes > pool->cache_max;)
+     {
+        e = EINA_INLIST_CONTAINER_GET(l, Ecore_Con_Url_Pool_Entry);
+        l = l->next;
+        _ecore_con_url_pool_entry_unlink(pool, e);
+        pool->stats.evicted++;
+     }
+}
+
+/* Returns the value of a response header, or NULL. */
+static inline char *
+_ecore_con_url_pool_header_get(const Eina_List *headers, const char *name)
+{
+   const Eina_List *l;
+   const char *h, *v = NULL;
+   size_t len = strlen(name), n;
+   void *d;
+   char *r;
+
+   // A redirection has several header blocks, the last one counts
+   EINA_LIST_FOREACH(headers, l, d)
+     {
+        h = (const char *)d;
+        if (!strncasecmp(h, name, len) && h[len] == ':') v = h + len + 1;
+     }
+   if (!v) return NULL;
+
+   while (*v == ' ' || *v == '\t') v++;
+   for (n = strlen(v); n && isspace((unsigned char)v[n - 1]); n--)
+     ;
+   r = (char *)malloc(n + 1);
+   if (!r) return NULL;
+   memcpy(r, v, n);
+   r[n] = '\0';
+   return r;
+}
+
+/* Moves the body of a response to the cache, returns its entry or NULL
+ * when it is not to be kept. */
+static inline Ecore_Con_Url_Pool_Entry *
+_ecore_con_url_pool_store(Ecore_Con_Url_Pool *pool, Ecore_Con_Url_Request *req)
+{
+   const Eina_List *headers = ecore_con_url_response_headers_get(req->url_con);
+   Ecore_Con_Url_Pool_Entry *e, *old;
+   char *cc;
+   size_t size;
+
+   size = eina_binbuf_length_get(req->body);
+   if (!pool->cache_max || !size || size > pool->cache_max) return NULL;
+
+   cc = _ecore_con_url_pool_header_get(headers, "Cache-Control");
+   if (cc && strstr(cc, "no-store"))
+     {
+        free(cc);
+        return NULL;
+     }
+   free(cc);
+
+   e = (Ecore_Con_Url_Pool_Entry *)calloc(1, sizeof (Ecore_Con_Url_Pool_Entry));
+   if (!e) return NULL;
+   e->etag = _ecore_con_url_pool_header_get(headers, "ETag");
+   e->modified = _ecore_con_url_pool_header_get(headers, "Last-Modified");
+   // Without a validator it could only be used while fresh
+   if (!e->etag && !e->modified && pool->fresh <= 0.0) goto on_error;
+   e->size = size;
+   e->body = eina_binbuf_string_steal(req->body);
+   if (!e->body) goto on_error;
+   e->url = eina_stringshare_ref(req->url);
+   e->stamp = ecore_time_get();
+
+   old = (Ecore_Con_Url_Pool_Entry *)eina_hash_find(pool->cache, req->url);
+   if (old) _ecore_con_url_pool_entry_unlink(pool, old);
+   if (!eina_hash_add(pool->cache, e->url, e)) goto on_error;
+   pool->lru = eina_inlist_append(pool->lru, EINA_INLIST_GET(e));
+   pool->stats.cached++;
+   pool->stats.cached_bytes += size;
+   pool->stats.stored++;
+   _ecore_con_url_pool_cache_trim(pool);
+   return e;
+
+ on_error:
+   _ecore_con_url_pool_entry_free(e);
+   return NULL;
+}
+
+static inline void
+_ecore_con_url_pool_request_free(Ecore_Con_Url_Request *req)
+{
+   if (req->entry) _ecore_con_url_pool_entry_unref(req->entry);
+   if (req->body) eina_binbuf_free(req->body);
+   eina_stringshare_del(req->url);
+   free(req);
+}
+
+static inline Eina_Bool
+_ecore_con_url_pool_start(Ecore_Con_Url_Pool *pool, Ecore_Con_Url_Request *req)
+{
+   Ecore_Con_Url_Pool_Host *host = req->host;
+   Ecore_Con_Url *url_con = NULL;
+
+   if (host->idle)
+     {
+        url_con = (Ecore_Con_Url *)eina_list_data_get(host->idle);
+        host->idle = eina_list_remove_list(host->idle, host->idle);
+        ecore_con_url_additional_headers_clear(url_con);
+        if (ecore_con_url_url_set(url_con, req->url))
+          pool->stats.reused++;
+        else
+          {
+             ecore_con_url_free(url_con);
+             url_con = NULL;
+          }
+     }
+   if (!url_con)
+     {
+        url_con = ecore_con_url_new(req->url);
+        if (!url_con) return EINA_FALSE;
+        ecore_con_url_http_version_set(url_con, ECORE_CON_URL_HTTP_VERSION_1_1);
+        pool->stats.connections++;
+     }
+
+   if (req->entry && req->entry->etag)
+     ecore_con_url_additional_header_add(url_con, "If-None-Match", req->entry->etag);
+   else if (req->entry && req->entry->modified)
+     ecore_con_url_additional_header_add(url_con, "If-Modified-Since", req->entry->modified);
+
+   req->body = eina_binbuf_new();
+   if (!req->body || !eina_hash_add(pool->running, &url_con, req)) goto on_error;
+   if (!ecore_con_url_get(url_con))
+     {
+        eina_hash_del_by_key(pool->running, &url_con);
+        goto on_error;
+     }
+
+   req->url_con = url_con;
+   host->running++;
+   pool->stats.running++;
+   pool->stats.transfers++;
+   return EINA_TRUE;
+
+ on_error:
+   if (req->body) eina_binbuf_free(req->body);
+   req->body = NULL;
+   ecore_con_url_free(url_con);
+   return EINA_FALSE;
+}
+
+static inline void _ecore_con_url_pool_job(void *data);
+
+static inline void
+_ecore_con_url_pool_ready(Ecore_Con_Url_Pool *pool, Ecore_Con_Url_Request *req)
+{
+   req->ready = EINA_TRUE;
+   pool->ready = eina_inlist_append(pool->ready, EINA_INLIST_GET(req));
+   if (!pool->job) pool->job = ecore_job_add(_ecore_con_url_pool_job, pool);
+}
+
+/* Starts the highest priority requests the limits allow, going round the
+ * hosts so that a long queue for one does not starve the others. */
+static inline void
+_ecore_con_url_pool_schedule(Ecore_Con_Url_Pool *pool)
+{
+   Ecore_Con_Url_Pool_Host *host;
+   Ecore_Con_Url_Request *req;
+   unsigned int prio;
+
+   if (pool->delete_me) return;
+   while (pool->stats.running < pool->max_total)
+     {
+        req = NULL;
+        for (prio = 0; prio < ECORE_CON_URL_PRIORITY_LAST && !req; prio++)
+          EINA_INLIST_FOREACH(pool->hosts, host)
+            {
+               if (host->running >= pool->max_per_host || !host->pending[prio])
+                 continue;
+               req = EINA_INLIST_CONTAINER_GET(host->pending[prio], Ecore_Con_Url_Request);
+               host->pending[prio] = eina_inlist_remove(host->pending[prio], host->pending[prio]);
+               pool->hosts = eina_inlist_demote(pool->hosts, EINA_INLIST_GET(host));
+               break;
+            }
+        if (!req) break;
+
+        pool->stats.pending--;
+        // Reported as a failed transfer, with the other answers
+        if (!_ecore_con_url_pool_start(pool, req))
+          {
+             req->failed = EINA_TRUE;
+             _ecore_con_url_pool_ready(pool, req);
+          }
+     }
+}
+
+static inline void _ecore_con_url_pool_free_internal(Ecore_Con_Url_Pool *pool);
+
+static inline void
+_ecore_con_url_pool_deliver(Ecore_Con_Url_Pool *pool, Ecore_Con_Url_Request *req,
+                            int status, const void *body, size_t size)
+{
+   pool->walking++;
+   req->delivering = EINA_TRUE;
+   if (req->func) req->func((void *)req->data, req, status, body, size);
+   _ecore_con_url_pool_request_free(req);
+   pool->walking--;
+}
+
+static inline void
+_ecore_con_url_pool_job(void *data)
+{
+   Ecore_Con_Url_Pool *pool = (Ecore_Con_Url_Pool *)data;
+   Ecore_Con_Url_Request *req;
+
+   pool->job = NULL;
+   pool->walking++;
+   while (pool->ready && !pool->delete_me)
+     {
+        req = EINA_INLIST_CONTAINER_GET(pool->ready, Ecore_Con_Url_Request);
+        pool->ready = eina_inlist_remove(pool->ready, pool->ready);
+        if (req->failed || !req->entry)
+          _ecore_con_url_pool_deliver(pool, req, 0, NULL, 0);
+        else
+          _ecore_con_url_pool_deliver(pool, req, 200, req->entry->body, req->entry->size);
+     }
+   pool->walking--;
+   if (pool->delete_me && !pool->walking) _ecore_con_url_pool_free_internal(pool);
+}
+
+static inline Eina_Bool
+_ecore_con_url_pool_data_cb(void *data, int type EINA_UNUSED, void *event)
+{
+   Ecore_Con_Url_Pool *pool = (Ecore_Con_Url_Pool *)data;
+   Ecore_Con_Event_Url_Data *ev = (Ecore_Con_Event_Url_Data *)event;
+   Ecore_Con_Url_Request *req;
+
+   req = (Ecore_Con_Url_Request *)eina_hash_find(pool->running, &ev->url_con);
+   if (!req) return ECORE_CALLBACK_PASS_ON;
+
+   if (ev->size > 0)
+     eina_binbuf_append_length(req->body, ev->data, ev->size);
+   return ECORE_CALLBACK_DONE;
+}
+
+static inline Eina_Bool
+_ecore_con_url_pool_complete_cb(void *data, int type EINA_UNUSED, void *event)
+{
+   Ecore_Con_Url_Pool *pool = (Ecore_Con_Url_Pool *)data;
+   Ecore_Con_Event_Url_Complete *ev = (Ecore_Con_Event_Url_Complete *)event;
+   Ecore_Con_Url_Request *req;
+   Ecore_Con_Url_Pool_Host *host;
+   Ecore_Con_Url_Pool_Entry *e;
+   int status = ev->status;
+
+   req = (Ecore_Con_Url_Request *)eina_hash_find(pool->running, &ev->url_con);
+   if (!req) return ECORE_CALLBACK_PASS_ON;
+
+   eina_hash_del_by_key(pool->running, &ev->url_con);
+   host = req->host;
+   host->running--;
+   pool->stats.running--;
+
+   if (status == 304 && req->entry)
+     {
+        e = req->entry;
+        e->stamp = ecore_time_get();
+        if (e->url)
+          pool->lru = eina_inlist_demote(pool->lru, EINA_INLIST_GET(e));
+        pool->stats.revalidated++;
+        status = 200;
+     }
+   else
+     {
+        // The answer replaces what was sent for revalidation
+        if (req->entry) _ecore_con_url_pool_entry_unref(req->entry);
+        req->entry = NULL;
+        e = status == 200 ? _ecore_con_url_pool_store(pool, req) : NULL;
+        if (e)
+          {
+             e->refs++;
+             req->entry = e;
+          }
+     }
+
+   // A failed transfer may have left its connection in any state
+   if (ev->status && eina_list_count(host->idle) < pool->max_per_host)
+     host->idle = eina_list_prepend(host->idle, req->url_con);
+   else
+     ecore_con_url_free(req->url_con);
+   req->url_con = NULL;
+
+   if (req->entry)
+     _ecore_con_url_pool_deliver(pool, req, status, req->entry->body, req->entry->size);
+   else
+     _ecore_con_url_pool_deliver(pool, req, status, eina_binbuf_string_get(req->body),
+                                 eina_binbuf_length_get(req->body));
+
+   if (pool->delete_me)
+     {
+        if (!pool->walking) _ecore_con_url_pool_free_internal(pool);
+     }
+   else
+     _ecore_con_url_pool_schedule(pool);
+   return ECORE_CALLBACK_DONE;
+}
+
+static inline void
+_ecore_con_url_pool_free_internal(Ecore_Con_Url_Pool *pool)
+{
+   Ecore_Con_Url_Pool_Host *host;
+   Ecore_Con_Url_Request *req;
+   Ecore_Con_Url_Pool_Entry *e;
+   Ecore_Con_Url *url_con;
+   Eina_Iterator *it;
+   unsigned int prio;
+
+   if (pool->job) ecore_job_del(pool->job);
+   ecore_event_handler_del(pool->data_handler);
+   ecore_event_handler_del(pool->complete_handler);
+
+   it = eina_hash_iterator_data_new(pool->running);
+   EINA_ITERATOR_FOREACH(it, req)
+     {
+        ecore_con_url_free(req->url_con);
+        _ecore_con_url_pool_request_free(req);
+     }
+   eina_iterator_free(it);
+   eina_hash_free(pool->running);
+
+   while (pool->ready)
+     {
+        req = EINA_INLIST_CONTAINER_GET(pool->ready, Ecore_Con_Url_Request);
+        pool->ready = eina_inlist_remove(pool->ready, pool->ready);
+        _ecore_con_url_pool_request_free(req);
+     }
+
+   while (pool->hosts)
+     {
+        host = EINA_INLIST_CONTAINER_GET(pool->hosts, Ecore_Con_Url_Pool_Host);
+        pool->hosts = eina_inlist_remove(pool->hosts, pool->hosts);
+        for (prio = 0; prio < ECORE_CON_URL_PRIORITY_LAST; prio++)
+          while (host->pending[prio])
+            {
+               req = EINA_INLIST_CONTAINER_GET(host->pending[prio], Ecore_Con_Url_Request);
+               host->pending[prio] = eina_inlist_remove(host->pending[prio], host->pending[prio]);
+               _ecore_con_url_pool_request_free(req);
+            }
+        while (host->idle)
+          {
+             url_con = (Ecore_Con_Url *)eina_list_data_get(host->idle);
+             host->idle = eina_list_remove_list(host->idle, host->idle);
+             ecore_con_url_free(url_con);
+          }
+        eina_stringshare_del(host->key);
+        free(host);
+     }
+
+   while (pool->lru)
+     {
+        e = EINA_INLIST_CONTAINER_GET(pool->lru, Ecore_Con_Url_Pool_Entry);
+        _ecore_con_url_pool_entry_unlink(pool, e);
+     }
+   eina_hash_free(pool->cache);
+   free(pool);
+}
+/**
+ * @endcond
+ */
+
+static inline Ecore_Con_Url_Pool *
+ecore_con_url_pool_new(unsigned int max_total, unsigned int max_per_host)
+{
+   Ecore_Con_Url_Pool *pool;
+
+   pool = (Ecore_Con_Url_Pool *)calloc(1, sizeof (Ecore_Con_Url_Pool));
+   if (!pool) return NULL;
+
+   pool->max_total = max_total ? max_total : 16;
+   pool->max_per_host = max_per_host ? max_per_host : 4;
+   pool->running = eina_hash_pointer_new(NULL);
+   pool->cache = eina_hash_stringshared_new(NULL);
+   if (!pool->running || !pool->cache) goto on_error;
+
+   pool->data_handler = ecore_event_handler_add(ECORE_CON_EVENT_URL_DATA,
+                                                _ecore_con_url_pool_data_cb, pool);
+   pool->complete_handler = ecore_event_handler_add(ECORE_CON_EVENT_URL_COMPLETE,
+                                                    _ecore_con_url_pool_complete_cb, pool);
+   if (!pool->data_handler || !pool->complete_handler) goto on_error;
+   return pool;
+
+ on_error:
+   if (pool->data_handler) ecore_event_handler_del(pool->data_handler);
+   if (pool->complete_handler) ecore_event_handler_del(pool->complete_handler);
+   if (pool->running) eina_hash_free(pool->running);
+   if (pool->cache) eina_hash_free(pool->cache);
+   free(pool);
+   return NULL;
+}
+
+static inline void
+ecore_con_url_pool_free(Ecore_Con_Url_Pool *pool)
+{
+   EINA_SAFETY_ON_NULL_RETURN(pool);
+
+   if (pool->delete_me) return;
+   pool->delete_me = EINA_TRUE;
+   // Called from a request callback, finished once it returns
+   if (pool->walking) return;
+   _ecore_con_url_pool_free_internal(pool);
+}
+
+static inline void
+ecore_con_url_pool_cache_set(Ecore_Con_Url_Pool *pool, size_t max_bytes, double fresh)
+{
+   EINA_SAFETY_ON_NULL_RETURN(pool);
+
+   pool->cache_max = max_bytes;
+   pool->fresh = fresh > 0.0 ? fresh : 0.0;
+   _ecore_con_url_pool_cache_trim(pool);
+}
+
+static inline void
+ecore_con_url_pool_cache_clear(Ecore_Con_Url_Pool *pool)
+{
+   EINA_SAFETY_ON_NULL_RETURN(pool);
+
+   while (pool->lru)
+     _ecore_con_url_pool_entry_unlink(pool, EINA_INLIST_CONTAINER_GET(pool->lru, Ecore_Con_Url_Pool_Entry));
+}
+
+static inline Ecore_Con_Url_Request *
+ecore_con_url_pool_get(Ecore_Con_Url_Pool *pool, const char *url, Ecore_Con_Url_Priority priority,
+                       Ecore_Con_Url_Request_Cb func, const void *data)
+{
+   Ecore_Con_Url_Request *req;
+   Ecore_Con_Url_Pool_Entry *e;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(pool, NULL);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(url, NULL);
+   EINA_SAFETY_ON_TRUE_RETURN_VAL(pool->delete_me, NULL);
+   EINA_SAFETY_ON_TRUE_RETURN_VAL(priority >= ECORE_CON_URL_PRIORITY_LAST, NULL);
+
+   req = (Ecore_Con_Url_Request *)calloc(1, sizeof (Ecore_Con_Url_Request));
+   if (!req) return NULL;
+   req->pool = pool;
+   req->url = eina_stringshare_add(url);
+   req->priority = priority;
+   req->func = func;
+   req->data = data;
+   pool->stats.requests++;
+
+   e = (Ecore_Con_Url_Pool_Entry *)eina_hash_find(pool->cache, req->url);
+   if (e)
+     {
+        e->refs++;
+        req->entry = e;
+        pool->lru = eina_inlist_demote(pool->lru, EINA_INLIST_GET(e));
+        if (pool->fresh > 0.0 && ecore_time_get() - e->stamp <= pool->fresh)
+          {
+             pool->stats.cache_hits++;
+             _ecore_con_url_pool_ready(pool, req);
+             return req;
+          }
+     }
+
+   req->host = _ecore_con_url_pool_host_get(pool, url);
+   if (!req->host)
+     {
+        _ecore_con_url_pool_request_free(req);
+        return NULL;
+     }
+   req->host->pending[priority] = eina_inlist_append(req->host->pending[priority],
+                                                     EINA_INLIST_GET(req));
+   pool->stats.pending++;
+   _ecore_con_url_pool_schedule(pool);
+   return req;
+}
+
+static inline void
+ecore_con_url_pool_priority_set(Ecore_Con_Url_Request *req, Ecore_Con_Url_Priority priority)
+{
+   Ecore_Con_Url_Pool_Host *host;
+
+   EINA_SAFETY_ON_NULL_RETURN(req);
+   EINA_SAFETY_ON_TRUE_RETURN(priority >= ECORE_CON_URL_PRIORITY_LAST);
+
+   host = req->host;
+   if (req->priority == priority) return;
+   if (host && !req->url_con && !req->ready)
+     {
+        host->pending[req->priority] = eina_inlist_remove(host->pending[req->priority],
+                                                          EINA_INLIST_GET(req));
+        host->pending[priority] = eina_inlist_append(host->pending[priority],
+                                                     EINA_INLIST_GET(req));
+     }
+   req->priority = priority;
+}
+
+static inline void
+ecore_con_url_pool_cancel(Ecore_Con_Url_Request *req)
+{
+   Ecore_Con_Url_Pool *pool;
+   Ecore_Con_Url_Pool_Host *host;
+
+   EINA_SAFETY_ON_NULL_RETURN(req);
+   if (req->delivering) return;
+
+   pool = req->pool;
+   host = req->host;
+   if (req->url_con)
+     {
+        eina_hash_del_by_key(pool->running, &req->url_con);
+        ecore_con_url_free(req->url_con);
+        host->running--;
+        pool->stats.running--;
+        _ecore_con_url_pool_request_free(req);
+        _ecore_con_url_pool_schedule(pool);
+        return;
+     }
+
+   if (req->ready)
+     pool->ready = eina_inlist_remove(pool->ready, EINA_INLIST_GET(req));
+   else
+     {
+        host->pending[req->priority] = eina_inlist_remove(host->pending[req->priority],
+                                                          EINA_INLIST_GET(req));
+        pool->stats.pending--;
+     }
+   _ecore_con_url_pool_request_free(req);
+}
+
+static inline void
+ecore_con_url_pool_stats_get(const Ecore_Con_Url_Pool *pool, Ecore_Con_Url_Pool_Stats *stats)
+{
+   EINA_SAFETY_ON_NULL_RETURN(stats);
+   memset(stats, 0, sizeof (Ecore_Con_Url_Pool_Stats));
+   EINA_SAFETY_ON_NULL_RETURN(pool);
+
+   *stats = pool->stats;
+}
+
+#undef ECORE_CON_URL_POOL_HOST_MAX
+
+#endif
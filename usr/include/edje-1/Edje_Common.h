@@ -103,6 +103,95 @@ typedef void         (*Edje_Signal_Cb)          (void *data, Evas_Object *obj, c
  */
 EAPI void *       edje_object_signal_callback_extra_data_get(void);
 
+/**
+ * @typedef Edje_Signal_Table
+ * A set of signal callbacks shared by many Edje objects.
+ */
+typedef struct _Edje_Signal_Table Edje_Signal_Table;
+
+/**
+ * @brief Create a signal table.
+ *
+ * @return The table, or @c NULL on errors.
+ *
+ * Each callback given to edje_object_signal_callback_add() is matched
+ * against every signal the object emits, and lists or genlist items
+ * register the same callbacks on hundreds of objects. A signal table
+ * holds the callbacks once, for all the objects it is attached to. The
+ * first time a pair of emission and source is seen, the table works out
+ * which callbacks it reaches and keeps the answer; the next times the
+ * callbacks are called straight away, with no pattern matching and no
+ * allocation.
+ *
+ * Callbacks are called in the order they were added, and
+ * edje_object_signal_callback_extra_data_get() works from within them.
+ * The table is not thread safe, use it from the main loop.
+ *
+ * @see edje_signal_table_callback_add()
+ * @see edje_signal_table_attach()
+ */
+static inline Edje_Signal_Table *edje_signal_table_new(void);
+
+/**
+ * @brief Detach a signal table from its objects and free it.
+ *
+ * @param table The table to free.
+ *
+ * It is safe to call from one of the table's callbacks.
+ */
+static inline void edje_signal_table_free(Edje_Signal_Table *table);
+
+/**
+ * @brief Add a callback to a signal table.
+ *
+ * @param table The table.
+ * @param emission The signal's "emission" string, may be a glob pattern.
+ * @param source The signal's "source" string, may be a glob pattern.
+ * @param func The callback function.
+ * @param data The data passed to @p func.
+ * @return @c EINA_TRUE on success, @c EINA_FALSE otherwise.
+ *
+ * The patterns are the ones edje_object_signal_callback_add() takes.
+ * A callback added from another callback of the table is called from
+ * the next signal on.
+ *
+ * @see edje_signal_table_callback_del()
+ */
+static inline Eina_Bool edje_signal_table_callback_add(Edje_Signal_Table *table, const char *emission, const char *source, Edje_Signal_Cb func, const void *data);
+
+/**
+ * @brief Remove a callback from a signal table.
+ *
+ * @param table The table.
+ * @param emission The emission given to edje_signal_table_callback_add().
+ * @param source The source given to edje_signal_table_callback_add().
+ * @param func The callback function.
+ * @param data The data given to edje_signal_table_callback_add().
+ * @return @p data, or @c NULL if no such callback was found.
+ */
+static inline void *edje_signal_table_callback_del(Edje_Signal_Table *table, const char *emission, const char *source, Edje_Signal_Cb func, const void *data);
+
+/**
+ * @brief Deliver the signals of an Edje object to a signal table.
+ *
+ * @param table The table.
+ * @param obj A handle to an Edje object.
+ * @return @c EINA_TRUE on success, @c EINA_FALSE otherwise.
+ *
+ * The object is detached on its own when it is deleted.
+ *
+ * @see edje_signal_table_detach()
+ */
+static inline Eina_Bool edje_signal_table_attach(Edje_Signal_Table *table, Evas_Object *obj);
+
+/**
+ * @brief Stop delivering the signals of an Edje object to a signal table.
+ *
+ * @param table The table.
+ * @param obj A handle to an Edje object given to edje_signal_table_attach().
+ */
+static inline void edje_signal_table_detach(Edje_Signal_Table *table, Evas_Object *obj);
+
 /**
  * @}
  */
@@ -333,6 +422,10 @@ EAPI void         edje_file_cache_flush           (void);
  * entries in memory. The collection cache size can be retrieved with
  * edje_collection_cache_get().
  *
+ * @note The cache is private to each process. A theme copied with
+ * eet_file_direct_pack() has its collections decoded in place from the
+ * mapping of the file all processes share, instead of inflated first.
+ *
  * @see edje_collection_cache_get()
  * @see edje_collection_cache_flush()
  *
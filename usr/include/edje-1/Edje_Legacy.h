@@ -287,5 +287,141 @@ Edje object
 EAPI Eina_Bool edje_object_mmap_set(Edje_Object *obj, const Eina_File *file, const char *group);
 
 
+/**
+ * @brief Counters kept for an Edje object by edje_object_batch_set().
+ */
+typedef struct _Edje_Recalc_Stats Edje_Recalc_Stats;
+
+struct _Edje_Recalc_Stats
+{
+   unsigned int recalcs; /**< Times the object recalculated its layout */
+   unsigned int changes; /**< Changes requested with the edje_object_batch functions */
+   unsigned int coalesced; /**< Changes replaced by a later one before being applied */
+   unsigned int skipped; /**< Changes dropped as they set the current value */
+   unsigned int applied; /**< Changes passed on to the object */
+   unsigned int flushes; /**< Times pending changes were applied */
+};
+
+/**
+ * @brief Batch the changes made to an Edje object until the next frame.
+ *
+ * @param obj A handle to an Edje object.
+ * @param batch @c EINA_TRUE to batch changes, @c EINA_FALSE to apply the
+ * pending ones and stop.
+ * @return @c EINA_TRUE on success, @c EINA_FALSE otherwise.
+ *
+ * Each text, color class or scale change invalidates the object, and
+ * code querying its geometry between two changes makes it recalculate
+ * several times in a frame. edje_object_freeze() and edje_object_thaw()
+ * avoid that only when every caller pairs them.
+ *
+ * With batching on, edje_object_batch_text_set(),
+ * edje_object_batch_color_class_set() and edje_object_batch_scale_set()
+ * only record the change, and the first one marks the object changed so
+ * the canvas renders a frame. A later change to the same part or class
+ * replaces it. Right before the canvas renders, the pending changes
+ * that would not set the current value are applied between a freeze and
+ * a thaw, so the object recalculates once. The object keeps counting
+ * its recalculations and the changes made to it, see
+ * edje_object_recalc_stats_get(), which helps spotting the themes and
+ * the code invalidating objects more than needed.
+ *
+ * @note Until they are applied, pending changes are not seen by the
+ * getters of the object, edje_object_batch_flush() applies them at once.
+ */
+static inline Eina_Bool edje_object_batch_set(Evas_Object *obj, Eina_Bool batch);
+
+/**
+ * @brief Tell whether changes to an Edje object are batched.
+ *
+ * @param obj A handle to an Edje object.
+ * @return @c EINA_TRUE if they are, @c EINA_FALSE otherwise.
+ *
+ * @see edje_object_batch_set()
+ */
+static inline Eina_Bool edje_object_batch_get(const Evas_Object *obj);
+
+/**
+ * @brief Set the text of a part, batched if the object batches changes.
+ *
+ * @param obj A handle to an Edje object.
+ * @param part The part name.
+ * @param text The text.
+ * @return @c EINA_TRUE on success, @c EINA_FALSE otherwise.
+ *
+ * @see edje_object_part_text_set()
+ * @see edje_object_batch_set()
+ */
+static inline Eina_Bool edje_object_batch_text_set(Evas_Object *obj, const char *part, const char *text);
+
+/**
+ * @brief Set a color class of an object, batched if the object batches
+ * changes.
+ *
+ * @param obj A handle to an Edje object.
+ * @param color_class The color class name.
+ * @param r Object Red value
+ * @param g Object Green value
+ * @param b Object Blue value
+ * @param a Object Alpha value
+ * @param r2 Outline Red value
+ * @param g2 Outline Green value
+ * @param b2 Outline Blue value
+ * @param a2 Outline Alpha value
+ * @param r3 Shadow Red value
+ * @param g3 Shadow Green value
+ * @param b3 Shadow Blue value
+ * @param a3 Shadow Alpha value
+ * @return @c EINA_TRUE on success, @c EINA_FALSE otherwise.
+ *
+ * @see edje_object_color_class_set()
+ * @see edje_object_batch_set()
+ */
+static inline Eina_Bool edje_object_batch_color_class_set(Evas_Object *obj, const char *color_class, int r, int g, int b, int a, int r2, int g2, int b2, int a2, int r3, int g3, int b3, int a3);
+
+/**
+ * @brief Set the scale of an object, batched if the object batches
+ * changes.
+ *
+ * @param obj A handle to an Edje object.
+ * @param scale The scaling factor, 0.0 to use the global one.
+ * @return @c EINA_TRUE on success, @c EINA_FALSE otherwise.
+ *
+ * @see edje_object_scale_set()
+ * @see edje_object_batch_set()
+ */
+static inline Eina_Bool edje_object_batch_scale_set(Evas_Object *obj, double scale);
+
+/**
+ * @brief Apply the pending changes of an Edje object now.
+ *
+ * @param obj A handle to an Edje object.
+ *
+ * @see edje_object_batch_set()
+ */
+static inline void edje_object_batch_flush(Evas_Object *obj);
+
+/**
+ * @brief Get the counters of an Edje object batching its changes.
+ *
+ * @param obj A handle to an Edje object.
+ * @param stats Where to copy the counters.
+ * @return @c EINA_TRUE on success, @c EINA_FALSE if the object does not
+ * batch its changes.
+ *
+ * @see edje_object_batch_set()
+ * @see edje_object_recalc_stats_reset()
+ */
+static inline Eina_Bool edje_object_recalc_stats_get(const Evas_Object *obj, Edje_Recalc_Stats *stats);
+
+/**
+ * @brief Reset the counters of an Edje object batching its changes.
+ *
+ * @param obj A handle to an Edje object.
+ */
+static inline void edje_object_recalc_stats_reset(Evas_Object *obj);
+
 #include "edje_object.eo.legacy.h"
 #include "edje_edit.eo.legacy.h"
+#include "edje_inline_signal.x"
+#include "edje_inline_batch.x"
@@ -0,0 +1,446 @@
+/* EDJE - EFL graphical design and layout library based on Evas
+ * Copyright (C) 2016 Samsung Electronics Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library;
+ * if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EDJE_INLINE_BATCH_X_
+#define EDJE_INLINE_BATCH_X_
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @cond LOCAL
+ */
+
+#define EDJE_BATCH_KEY "_edje_batch"
+
+typedef struct _Edje_Batch Edje_Batch;
+typedef struct _Edje_Batch_Text Edje_Batch_Text;
+typedef struct _Edje_Batch_Color_Class Edje_Batch_Color_Class;
+
+struct _Edje_Batch_Text
+{
+   Eina_Stringshare *text;
+};
+
+struct _Edje_Batch_Color_Class
+{
+   int c[12];
+};
+
+/* Pending changes are kept by part or class, so the last one wins, and
+ * applied together from the canvas render pre callback. */
+struct _Edje_Batch
+{
+   Evas_Object *obj;
+   Evas *evas;
+
+   Eina_Hash *texts;
+   Eina_Hash *color_classes;
+   double scale;
+
+   Edje_Recalc_Stats stats;
+
+   /* Every user of this header has its own copy of the callbacks, add and
+    * remove them through the ones of the batch. */
+   Evas_Event_Cb render_pre_cb;
+   Evas_Object_Event_Cb del_cb;
+   Evas_Smart_Cb recalc_cb;
+
+   Eina_Bool scale_set : 1;
+   Eina_Bool hooked : 1; // render pre callback is on the canvas
+   Eina_Bool flushing : 1;
+   Eina_Bool delete_me : 1;
+};
+
+static inline void
+_edje_batch_text_free(void *data)
+{
+   Edje_Batch_Text *t = (Edje_Batch_Text *)data;
+
+   eina_stringshare_del(t->text);
+   free(t);
+}
+
+static inline void _edje_batch_flush(Edje_Batch *b);
+
+static void
+_edje_batch_render_pre(void *data, Evas *e EINA_UNUSED,
+                       void *event_info EINA_UNUSED)
+{
+   _edje_batch_flush((Edje_Batch *)data);
+}
+
+static void
+_edje_batch_recalc(void *data, Evas_Object *obj EINA_UNUSED,
+                   void *event_info EINA_UNUSED)
+{
+   Edje_Batch *b = (Edje_Batch *)data;
+
+   b->stats.recalcs++;
+}
+
+static inline void
+_edje_batch_unhook(Edje_Batch *b)
+{
+   if (!b->hooked) return;
+   evas_event_callback_del_full(b->evas, EVAS_CALLBACK_RENDER_PRE,
+                                b->render_pre_cb, b);
+   b->hooked = EINA_FALSE;
+}
+
+/* Marking the object changed makes sure a frame comes, even when
+ * nothing else on the canvas changes. */
+static inline void
+_edje_batch_hook(Edje_Batch *b)
+{
+   evas_event_callback_add(b->evas, EVAS_CALLBACK_RENDER_PRE,
+                           b->render_pre_cb, b);
+   b->hooked = EINA_TRUE;
+   evas_object_smart_changed(b->obj);
+}
+
+static inline void
+_edje_batch_free(Edje_Batch *b)
+{
+   _edje_batch_unhook(b);
+   if (b->texts) eina_hash_free(b->texts);
+   if (b->color_classes) eina_hash_free(b->color_classes);
+   free(b);
+}
+
+static void
+_edje_batch_del(void *data, Evas *e EINA_UNUSED, Evas_Object *obj,
+                void *event_info EINA_UNUSED)
+{
+   Edje_Batch *b = (Edje_Batch *)data;
+
+   evas_object_data_del(obj, EDJE_BATCH_KEY);
+   if (b->flushing)
+     {
+        b->delete_me = EINA_TRUE;
+        return;
+     }
+   _edje_batch_free(b);
+}
+
+static inline Edje_Batch *
+_edje_batch_get(const Evas_Object *obj)
+{
+   return (Edje_Batch *)evas_object_data_get(obj, EDJE_BATCH_KEY);
+}
+
+static inline void
+_edje_batch_queued(Edje_Batch *b)
+{
+   b->stats.changes++;
+   if (b->hooked || b->flushing) return;
+   _edje_batch_hook(b);
+}
+
+static Eina_Bool
+_edje_batch_text_apply(const Eina_Hash *hash EINA_UNUSED, const void *key,
+                       void *data, void *fdata)
+{
+   Edje_Batch *b = (Edje_Batch *)fdata;
+   Edje_Batch_Text *t = (Edje_Batch_Text *)data;
+   const char *cur;
+
+   if (b->delete_me) return EINA_FALSE;
+
+   cur = edje_object_part_text_get(b->obj, (const char *)key);
+   if ((cur == t->text) || (cur && t->text && !strcmp(cur, t->text)))
+     {
+        b->stats.skipped++;
+        return EINA_TRUE;
+     }
+   edje_object_part_text_set(b->obj, (const char *)key, t->text);
+   b->stats.applied++;
+   return EINA_TRUE;
+}
+
+static Eina_Bool
+_edje_batch_color_class_apply(const Eina_Hash *hash EINA_UNUSED,
+                              const void *key, void *data, void *fdata)
+{
+   Edje_Batch *b = (Edje_Batch *)fdata;
+   Edje_Batch_Color_Class *cc = (Edje_Batch_Color_Class *)data;
+   int *c = cc->c;
+   int cur[12];
+
+   if (b->delete_me) return EINA_FALSE;
+
+   if (edje_object_color_class_get(b->obj, (const char *)key,
+                                   &cur[0], &cur[1], &cur[2], &cur[3],
+                                   &cur[4], &cur[5], &cur[6], &cur[7],
+                                   &cur[8], &cur[9], &cur[10], &cur[11]) &&
+       !memcmp(cur, c, sizeof (cur)))
+     {
+        b->stats.skipped++;
+        return EINA_TRUE;
+     }
+   edje_object_color_class_set(b->obj, (const char *)key, c[0], c[1], c[2], c[3],
+                               c[4], c[5], c[6], c[7],
+                               c[8], c[9], c[10], c[11]);
+   b->stats.applied++;
+   return EINA_TRUE;
+}
+
+static inline void
+_edje_batch_flush(Edje_Batch *b)
+{
+   Eina_Hash *texts, *color_classes;
+
+   _edje_batch_unhook(b);
+   if (b->flushing) return;
+   if (!b->texts && !b->color_classes && !b->scale_set) return;
+
+   /* Applying a change may run callbacks that queue more, they go to
+    * fresh tables and wait for the next frame. */
+   texts = b->texts;
+   color_classes = b->color_classes;
+   b->texts = NULL;
+   b->color_classes = NULL;
+   b->flushing = EINA_TRUE;
+   b->stats.flushes++;
+   eina_evlog_ring("+edje_batch_flush", b->obj, NULL);
+
+   edje_object_freeze(b->obj);
+   if (b->scale_set)
+     {
+        b->scale_set = EINA_FALSE;
+        if (edje_object_scale_get(b->obj) == b->scale)
+          b->stats.skipped++;
+        else
+          {
+             edje_object_scale_set(b->obj, b->scale);
+             b->stats.applied++;
+          }
+     }
+   if (color_classes)
+     eina_hash_foreach(color_classes, _edje_batch_color_class_apply, b);
+   if (texts)
+     eina_hash_foreach(texts, _edje_batch_text_apply, b);
+   if (!b->delete_me) edje_object_thaw(b->obj);
+
+   if (texts) eina_hash_free(texts);
+   if (color_classes) eina_hash_free(color_classes);
+   b->flushing = EINA_FALSE;
+   eina_evlog_ring("-edje_batch_flush", b->obj, NULL);
+
+   if (b->delete_me)
+     {
+        _edje_batch_free(b);
+        return;
+     }
+   if (b->texts || b->color_classes || b->scale_set)
+     _edje_batch_hook(b);
+}
+
+/**
+ * @endcond
+ */
+
+static inline Eina_Bool
+edje_object_batch_set(Evas_Object *obj, Eina_Bool batch)
+{
+   Edje_Batch *b;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(obj, EINA_FALSE);
+
+   b = _edje_batch_get(obj);
+   if (!batch)
+     {
+        if (!b) return EINA_TRUE;
+        _edje_batch_flush(b);
+        if (b->flushing) return EINA_FALSE;
+        evas_object_data_del(obj, EDJE_BATCH_KEY);
+        evas_object_event_callback_del_full(obj, EVAS_CALLBACK_DEL,
+                                            b->del_cb, b);
+        evas_object_smart_callback_del_full(obj, "recalc",
+                                            b->recalc_cb, b);
+        _edje_batch_free(b);
+        return EINA_TRUE;
+     }
+   if (b) return EINA_TRUE;
+
+   b = (Edje_Batch *)calloc(1, sizeof (Edje_Batch));
+   if (!b) return EINA_FALSE;
+   b->obj = obj;
+   b->evas = evas_object_evas_get(obj);
+   b->render_pre_cb = _edje_batch_render_pre;
+   b->del_cb = _edje_batch_del;
+   b->recalc_cb = _edje_batch_recalc;
+   evas_object_data_set(obj, EDJE_BATCH_KEY, b);
+   evas_object_event_callback_add(obj, EVAS_CALLBACK_DEL, b->del_cb, b);
+   evas_object_smart_callback_add(obj, "recalc", b->recalc_cb, b);
+   return EINA_TRUE;
+}
+
+static inline Eina_Bool
+edje_object_batch_get(const Evas_Object *obj)
+{
+   EINA_SAFETY_ON_NULL_RETURN_VAL(obj, EINA_FALSE);
+
+   return !!_edje_batch_get(obj);
+}
+
+static inline Eina_Bool
+edje_object_batch_text_set(Evas_Object *obj, const char *part, const char *text)
+{
+   Edje_Batch_Text *t;
+   Edje_Batch *b;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(obj, EINA_FALSE);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(part, EINA_FALSE);
+
+   b = _edje_batch_get(obj);
+   if (!b) return edje_object_part_text_set(obj, part, text);
+
+   if (!b->texts)
+     {
+        b->texts = eina_hash_string_superfast_new(_edje_batch_text_free);
+        if (!b->texts) return EINA_FALSE;
+     }
+   t = (Edje_Batch_Text *)eina_hash_find(b->texts, part);
+   if (t)
+     {
+        eina_stringshare_replace(&t->text, text);
+        b->stats.coalesced++;
+     }
+   else
+     {
+        t = (Edje_Batch_Text *)malloc(sizeof (Edje_Batch_Text));
+        if (!t) return EINA_FALSE;
+        t->text = eina_stringshare_add(text);
+        if (!eina_hash_add(b->texts, part, t))
+          {
+             _edje_batch_text_free(t);
+             return EINA_FALSE;
+          }
+     }
+   _edje_batch_queued(b);
+   return EINA_TRUE;
+}
+
+static inline Eina_Bool
+edje_object_batch_color_class_set(Evas_Object *obj, const char *color_class,
+                                  int r, int g, int b, int a,
+                                  int r2, int g2, int b2, int a2,
+                                  int r3, int g3, int b3, int a3)
+{
+   Edje_Batch_Color_Class *cc;
+   Edje_Batch *batch;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(obj, EINA_FALSE);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(color_class, EINA_FALSE);
+
+   batch = _edje_batch_get(obj);
+   if (!batch)
+     return edje_object_color_class_set(obj, color_class, r, g, b, a,
+                                        r2, g2, b2, a2, r3, g3, b3, a3);
+
+   if (!batch->color_classes)
+     {
+        batch->color_classes = eina_hash_string_superfast_new(free);
+        if (!batch->color_classes) return EINA_FALSE;
+     }
+   cc = (Edje_Batch_Color_Class *)eina_hash_find(batch->color_classes, color_class);
+   if (cc) batch->stats.coalesced++;
+   else
+     {
+        cc = (Edje_Batch_Color_Class *)malloc(sizeof (Edje_Batch_Color_Class));
+        if (!cc) return EINA_FALSE;
+        if (!eina_hash_add(batch->color_classes, color_class, cc))
+          {
+             free(cc);
+             return EINA_FALSE;
+          }
+     }
+   // Edje clamps the components to 0..255 as well
+#define CLAMP(v) ((v) < 0 ? 0 : (v) > 255 ? 255 : (v))
+   cc->c[0] = CLAMP(r);
+   cc->c[1] = CLAMP(g);
+   cc->c[2] = CLAMP(b);
+   cc->c[3] = CLAMP(a);
+   cc->c[4] = CLAMP(r2);
+   cc->c[5] = CLAMP(g2);
+   cc->c[6] = CLAMP(b2);
+   cc->c[7] = CLAMP(a2);
+   cc->c[8] = CLAMP(r3);
+   cc->c[9] = CLAMP(g3);
+   cc->c[10] = CLAMP(b3);
+   cc->c[11] = CLAMP(a3);
+#undef CLAMP
+   _edje_batch_queued(batch);
+   return EINA_TRUE;
+}
+
+static inline Eina_Bool
+edje_object_batch_scale_set(Evas_Object *obj, double scale)
+{
+   Edje_Batch *b;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(obj, EINA_FALSE);
+
+   b = _edje_batch_get(obj);
+   if (!b) return edje_object_scale_set(obj, scale);
+
+   if (b->scale_set) b->stats.coalesced++;
+   b->scale = scale;
+   b->scale_set = EINA_TRUE;
+   _edje_batch_queued(b);
+   return EINA_TRUE;
+}
+
+static inline void
+edje_object_batch_flush(Evas_Object *obj)
+{
+   Edje_Batch *b;
+
+   EINA_SAFETY_ON_NULL_RETURN(obj);
+
+   b = _edje_batch_get(obj);
+   if (b) _edje_batch_flush(b);
+}
+
+static inline Eina_Bool
+edje_object_recalc_stats_get(const Evas_Object *obj, Edje_Recalc_Stats *stats)
+{
+   Edje_Batch *b;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(obj, EINA_FALSE);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(stats, EINA_FALSE);
+
+   b = _edje_batch_get(obj);
+   if (!b) return EINA_FALSE;
+   *stats = b->stats;
+   return EINA_TRUE;
+}
+
+static inline void
+edje_object_recalc_stats_reset(Evas_Object *obj)
+{
+   Edje_Batch *b;
+
+   EINA_SAFETY_ON_NULL_RETURN(obj);
+
+   b = _edje_batch_get(obj);
+   if (b) memset(&b->stats, 0, sizeof (b->stats));
+}
+
+#endif
@@ -0,0 +1,438 @@
+/* EDJE - EFL graphical design and layout library based on Evas
+ * Copyright (C) 2016 Samsung Electronics Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library;
+ * if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EDJE_INLINE_SIGNAL_X_
+#define EDJE_INLINE_SIGNAL_X_
+
+#include <stdlib.h>
+#include <string.h>
+#include <fnmatch.h>
+
+/**
+ * @cond LOCAL
+ */
+
+#define EDJE_SIGNAL_TABLE_CACHE_MAX 1024
+#define EDJE_SIGNAL_TABLE_KEY_MAX 256
+
+typedef struct _Edje_Signal_Table_Entry Edje_Signal_Table_Entry;
+typedef struct _Edje_Signal_Table_Match Edje_Signal_Table_Match;
+
+/* A pattern is kept with the length of its literal head, so most
+ * emissions are turned down by a strncmp() before fnmatch() is tried. */
+struct _Edje_Signal_Table_Entry
+{
+   Eina_Stringshare *emission;
+   Eina_Stringshare *source;
+   Edje_Signal_Cb func;
+   void *data;
+   unsigned short emission_head;
+   unsigned short source_head;
+   Eina_Bool emission_glob : 1;
+   Eina_Bool source_glob : 1;
+   Eina_Bool delete_me : 1;
+};
+
+/* The callbacks an emission and source pair resolved to, in the order
+ * they were added. */
+struct _Edje_Signal_Table_Match
+{
+   unsigned int count;
+   Edje_Signal_Table_Entry *entries[];
+};
+
+struct _Edje_Signal_Table
+{
+   Edje_Signal_Table_Entry **entries;
+   unsigned int count;
+   unsigned int size;
+
+   Eina_Hash *cache; // "emission\037source" -> Edje_Signal_Table_Match
+   unsigned int cached;
+
+   Eina_List *objects;
+   /* Every user of this header has its own copy of the callbacks, add and
+    * remove them through the ones of the table. */
+   Edje_Signal_Cb dispatch_cb;
+   Evas_Object_Event_Cb del_cb;
+
+   int walking;
+   Eina_Bool dirty : 1; // entries changed while walking, cache is stale
+   Eina_Bool delete_me : 1;
+};
+
+static inline unsigned short
+_edje_signal_table_head(const char *pattern, Eina_Bool *glob)
+{
+   size_t head;
+
+   head = strcspn(pattern, "*?[\\");
+   *glob = !!pattern[head];
+   return head > 0xffff ? 0xffff : head;
+}
+
+static inline Eina_Bool
+_edje_signal_table_part_match(const char *pattern, unsigned short head,
+                              Eina_Bool glob, const char *str)
+{
+   if (!glob) return !strcmp(pattern, str);
+   if (strncmp(pattern, str, head)) return EINA_FALSE;
+   return !fnmatch(pattern + head, str + head, 0);
+}
+
+static inline Eina_Bool
+_edje_signal_table_entry_match(const Edje_Signal_Table_Entry *entry,
+                               const char *emission, const char *source)
+{
+   if (entry->delete_me) return EINA_FALSE;
+   return _edje_signal_table_part_match(entry->emission, entry->emission_head,
+                                        entry->emission_glob, emission) &&
+     _edje_signal_table_part_match(entry->source, entry->source_head,
+                                   entry->source_glob, source);
+}
+
+static inline void
+_edje_signal_table_cache_flush(Edje_Signal_Table *table)
+{
+   if (table->cached) eina_hash_free_buckets(table->cache);
+   table->cached = 0;
+}
+
+static inline void
+_edje_signal_table_free_internal(Edje_Signal_Table *table)
+{
+   unsigned int i;
+
+   for (i = 0; i < table->count; i++)
+     {
+        eina_stringshare_del(table->entries[i]->emission);
+        eina_stringshare_del(table->entries[i]->source);
+        free(table->entries[i]);
+     }
+   free(table->entries);
+   eina_hash_free(table->cache);
+   free(table);
+}
+
+/* Drops the entries deleted while callbacks ran, once none does. */
+static inline void
+_edje_signal_table_walk_end(Edje_Signal_Table *table)
+{
+   unsigned int i, j;
+
+   if (--table->walking) return;
+   if (table->delete_me)
+     {
+        _edje_signal_table_free_internal(table);
+        return;
+     }
+   if (!table->dirty) return;
+
+   for (i = 0, j = 0; i < table->count; i++)
+     {
+        Edje_Signal_Table_Entry *entry = table->entries[i];
+
+        if (entry->delete_me)
+          {
+             eina_stringshare_del(entry->emission);
+             eina_stringshare_del(entry->source);
+             free(entry);
+             continue;
+          }
+        table->entries[j++] = entry;
+     }
+   table->count = j;
+   table->dirty = EINA_FALSE;
+   _edje_signal_table_cache_flush(table);
+}
+
+static inline void
+_edje_signal_table_changed(Edje_Signal_Table *table)
+{
+   if (table->walking) table->dirty = EINA_TRUE;
+   else _edje_signal_table_cache_flush(table);
+}
+
+/* Builds the lookup key on the stack, NULL when it does not fit. */
+static inline const char *
+_edje_signal_table_key(char *buf, const char *emission, const char *source)
+{
+   size_t el, sl;
+
+   el = strlen(emission);
+   sl = strlen(source);
+   if (el + sl + 2 > EDJE_SIGNAL_TABLE_KEY_MAX) return NULL;
+   memcpy(buf, emission, el);
+   buf[el] = '\037';
+   memcpy(buf + el + 1, source, sl + 1);
+   return buf;
+}
+
+static inline Edje_Signal_Table_Match *
+_edje_signal_table_resolve(Edje_Signal_Table *table, const char *key,
+                           const char *emission, const char *source)
+{
+   Edje_Signal_Table_Match *match;
+   unsigned int i, count = 0;
+
+   for (i = 0; i < table->count; i++)
+     if (_edje_signal_table_entry_match(table->entries[i], emission, source))
+       count++;
+
+   match = (Edje_Signal_Table_Match *)malloc(sizeof (Edje_Signal_Table_Match) +
+                                             count * sizeof (Edje_Signal_Table_Entry *));
+   if (!match) return NULL;
+   match->count = 0;
+   for (i = 0; i < table->count; i++)
+     if (_edje_signal_table_entry_match(table->entries[i], emission, source))
+       match->entries[match->count++] = table->entries[i];
+
+   if (table->cached >= EDJE_SIGNAL_TABLE_CACHE_MAX)
+     _edje_signal_table_cache_flush(table);
+   if (!eina_hash_add(table->cache, key, match))
+     {
+        free(match);
+        return NULL;
+     }
+   table->cached++;
+   return match;
+}
+
+static void
+_edje_signal_table_dispatch(void *data, Evas_Object *obj,
+                            const char *emission, const char *source)
+{
+   Edje_Signal_Table *table = (Edje_Signal_Table *)data;
+   Edje_Signal_Table_Match *match = NULL;
+   char buf[EDJE_SIGNAL_TABLE_KEY_MAX];
+   const char *key = NULL;
+   unsigned int i;
+
+   if (table->delete_me || !emission) return;
+   if (!source) source = "";
+
+   table->walking++;
+
+   /* While callbacks are running the entries may have changed under the
+    * cached matches, so only a pass over the entries is exact. */
+   if (!table->dirty)
+     key = _edje_signal_table_key(buf, emission, source);
+   if (key)
+     {
+        match = (Edje_Signal_Table_Match *)eina_hash_find(table->cache, key);
+        /* Resolving may flush the cache, not under an outer dispatch. */
+        if (!match && table->walking == 1)
+          match = _edje_signal_table_resolve(table, key, emission, source);
+     }
+
+   if (match)
+     {
+        for (i = 0; i < match->count; i++)
+          {
+             Edje_Signal_Table_Entry *entry = match->entries[i];
+
+             if (entry->delete_me) continue;
+             entry->func(entry->data, obj, emission, source);
+             if (table->delete_me) break;
+          }
+     }
+   else
+     {
+        unsigned int count = table->count;
+
+        /* Entries added by a callback are not called for this signal. */
+        for (i = 0; i < count; i++)
+          {
+             Edje_Signal_Table_Entry *entry = table->entries[i];
+
+             if (!_edje_signal_table_entry_match(entry, emission, source))
+               continue;
+             entry->func(entry->data, obj, emission, source);
+             if (table->delete_me) break;
+          }
+     }
+
+   _edje_signal_table_walk_end(table);
+}
+
+static void
+_edje_signal_table_object_del(void *data, Evas *e EINA_UNUSED,
+                              Evas_Object *obj, void *event_info EINA_UNUSED)
+{
+   Edje_Signal_Table *table = (Edje_Signal_Table *)data;
+
+   table->objects = eina_list_remove(table->objects, obj);
+}
+
+/**
+ * @endcond
+ */
+
+static inline Edje_Signal_Table *
+edje_signal_table_new(void)
+{
+   Edje_Signal_Table *table;
+
+   table = (Edje_Signal_Table *)calloc(1, sizeof (Edje_Signal_Table));
+   if (!table) return NULL;
+   table->dispatch_cb = _edje_signal_table_dispatch;
+   table->del_cb = _edje_signal_table_object_del;
+   table->cache = eina_hash_string_superfast_new(free);
+   if (!table->cache)
+     {
+        free(table);
+        return NULL;
+     }
+   return table;
+}
+
+static inline void
+edje_signal_table_free(Edje_Signal_Table *table)
+{
+   Evas_Object *obj;
+
+   if (!table || table->delete_me) return;
+
+   while (table->objects)
+     {
+        obj = (Evas_Object *)eina_list_data_get(table->objects);
+        table->objects = eina_list_remove_list(table->objects, table->objects);
+        edje_object_signal_callback_del_full(obj, "*", "*",
+                                             table->dispatch_cb, table);
+        evas_object_event_callback_del_full(obj, EVAS_CALLBACK_DEL,
+                                            table->del_cb, table);
+     }
+
+   if (table->walking)
+     {
+        table->delete_me = EINA_TRUE;
+        return;
+     }
+   _edje_signal_table_free_internal(table);
+}
+
+static inline Eina_Bool
+edje_signal_table_callback_add(Edje_Signal_Table *table,
+                               const char *emission, const char *source,
+                               Edje_Signal_Cb func, const void *data)
+{
+   Edje_Signal_Table_Entry *entry;
+   Eina_Bool glob;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(table, EINA_FALSE);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(emission, EINA_FALSE);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(source, EINA_FALSE);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(func, EINA_FALSE);
+   EINA_SAFETY_ON_TRUE_RETURN_VAL(table->delete_me, EINA_FALSE);
+
+   if (table->count == table->size)
+     {
+        Edje_Signal_Table_Entry **tmp;
+        unsigned int size = table->size ? table->size * 2 : 8;
+
+        tmp = (Edje_Signal_Table_Entry **)realloc(table->entries,
+                                                  size * sizeof (Edje_Signal_Table_Entry *));
+        if (!tmp) return EINA_FALSE;
+        table->entries = tmp;
+        table->size = size;
+     }
+
+   entry = (Edje_Signal_Table_Entry *)calloc(1, sizeof (Edje_Signal_Table_Entry));
+   if (!entry) return EINA_FALSE;
+   entry->emission = eina_stringshare_add(emission);
+   entry->source = eina_stringshare_add(source);
+   entry->func = func;
+   entry->data = (void *)data;
+   entry->emission_head = _edje_signal_table_head(emission, &glob);
+   entry->emission_glob = glob;
+   entry->source_head = _edje_signal_table_head(source, &glob);
+   entry->source_glob = glob;
+
+   table->entries[table->count++] = entry;
+   _edje_signal_table_changed(table);
+   return EINA_TRUE;
+}
+
+static inline void *
+edje_signal_table_callback_del(Edje_Signal_Table *table,
+                               const char *emission, const char *source,
+                               Edje_Signal_Cb func, const void *data)
+{
+   unsigned int i;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(table, NULL);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(emission, NULL);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(source, NULL);
+
+   for (i = 0; i < table->count; i++)
+     {
+        Edje_Signal_Table_Entry *entry = table->entries[i];
+
+        if (entry->delete_me || entry->func != func || entry->data != data)
+          continue;
+        if (strcmp(entry->emission, emission) || strcmp(entry->source, source))
+          continue;
+
+        if (table->walking)
+          {
+             entry->delete_me = EINA_TRUE;
+             table->dirty = EINA_TRUE;
+             return entry->data;
+          }
+
+        eina_stringshare_del(entry->emission);
+        eina_stringshare_del(entry->source);
+        free(entry);
+        memmove(table->entries + i, table->entries + i + 1,
+                (table->count - i - 1) * sizeof (Edje_Signal_Table_Entry *));
+        table->count--;
+        _edje_signal_table_cache_flush(table);
+        return (void *)data;
+     }
+   return NULL;
+}
+
+static inline Eina_Bool
+edje_signal_table_attach(Edje_Signal_Table *table, Evas_Object *obj)
+{
+   EINA_SAFETY_ON_NULL_RETURN_VAL(table, EINA_FALSE);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(obj, EINA_FALSE);
+   EINA_SAFETY_ON_TRUE_RETURN_VAL(table->delete_me, EINA_FALSE);
+
+   if (eina_list_data_find(table->objects, obj)) return EINA_TRUE;
+
+   edje_object_signal_callback_add(obj, "*", "*", table->dispatch_cb, table);
+   evas_object_event_callback_add(obj, EVAS_CALLBACK_DEL, table->del_cb, table);
+   table->objects = eina_list_append(table->objects, obj);
+   return EINA_TRUE;
+}
+
+static inline void
+edje_signal_table_detach(Edje_Signal_Table *table, Evas_Object *obj)
+{
+   EINA_SAFETY_ON_NULL_RETURN(table);
+   EINA_SAFETY_ON_NULL_RETURN(obj);
+
+   if (!eina_list_data_find(table->objects, obj)) return;
+
+   edje_object_signal_callback_del_full(obj, "*", "*", table->dispatch_cb, table);
+   evas_object_event_callback_del_full(obj, EVAS_CALLBACK_DEL, table->del_cb, table);
+   table->objects = eina_list_remove(table->objects, obj);
+}
+
+#endif
@@ -1119,6 +1119,363 @@ eet_write_cipher(Eet_File *ef,
                  int compress,
                  const char *cipher_key);
 
+/**
+ * @typedef Eet_Write_Entry
+ * An entry to write with eet_write_batch().
+ *
+ * @ingroup Eet_File_Cipher_Group
+ */
+typedef struct _Eet_Write_Entry Eet_Write_Entry;
+
+/**
+ * @struct _Eet_Write_Entry
+ * An entry to write with eet_write_batch(), the arguments of
+ * eet_write_cipher() and its result.
+ *
+ * @ingroup Eet_File_Cipher_Group
+ */
+struct _Eet_Write_Entry
+{
+   const char *name; /**< Name of the entry */
+   const void *data; /**< Pointer to the data to be stored */
+   int size; /**< Length in bytes of the data */
+   int compress; /**< Compression mode, see #Eet_Compression */
+   const char *cipher_key; /**< The key to use as cipher, or NULL */
+   int written; /**< Set to what eet_write_cipher() returned for it */
+};
+
+/**
+ * Write many entries to an eet file handle.
+ * @param ef A valid eet file handle opened for writing.
+ * @param entries The entries to write.
+ * @param count The number of entries.
+ * @return The number of entries written, the others have their written
+ * field set to 0.
+ *
+ * Each entry is written with eet_write_cipher() by the calling thread.
+ * Eet compresses and ciphers with the file locked, and the compression
+ * of an entry is recorded in the directory of the file, so writing from
+ * several threads would not be any faster. Data that is compressed for
+ * something else than eet can be done in parallel with
+ * emile_compress_batch().
+ *
+ * The entries are stored by name, the order they are given in does not
+ * change what is read back, names must be unique within a batch.
+ *
+ * @see eet_write_cipher()
+ * @see emile_compress_batch()
+ *
+ * @ingroup Eet_File_Cipher_Group
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline unsigned int
+eet_write_batch(Eet_File *ef,
+                Eet_Write_Entry *entries,
+                unsigned int count);
+
+#include "eet_inline_file.x"
+
+/**
+ * @defgroup Eet_Kv_Group Persistent Key/Value Store
+ * @ingroup Eet
+ *
+ * A key/value store kept in an eet file plus a write-ahead log.
+ *
+ * Writing an entry with eet_write() and then eet_sync() rewrites the
+ * whole file every time, and anyone reading it has to reopen it. An
+ * #Eet_Kv instead appends each write or delete to a log next to the
+ * file (@c path.wal.N) and keeps the entries written since the last
+ * compaction in memory. eet_kv_compact() then folds file and log into
+ * a fresh eet file on a thread and renames it over the old one, so
+ * the file is only rewritten once per compaction instead of once per
+ * write.
+ *
+ * The file at @c path stays a plain eet file at all times: other
+ * processes may eet_open() or eet_mmap() it and keep their handle, they
+ * see the state of the last compaction for as long as they keep it
+ * open. Inside the process eet_kv_snapshot_new() gives the same kind
+ * of isolation including what is still only in the log.
+ *
+ * The log is flushed to disk according to eet_kv_sync_policy_set().
+ * A log cut short by a crash is replayed up to the last complete
+ * record on the next eet_kv_open().
+ *
+ * An #Eet_Kv and its snapshots are meant to be used from one thread.
+ * The entry named "eet-kv:generation" is reserved.
+ *
+ * @{
+ */
+
+/**
+ * @typedef Eet_Kv
+ * Opaque handle to a key/value store.
+ */
+typedef struct _Eet_Kv Eet_Kv;
+
+/**
+ * @typedef Eet_Kv_Snapshot
+ * Opaque handle to a frozen view of a key/value store.
+ */
+typedef struct _Eet_Kv_Snapshot Eet_Kv_Snapshot;
+
+/**
+ * @typedef Eet_Kv_Stats
+ * Counters of a key/value store, see eet_kv_stats_get().
+ */
+typedef struct _Eet_Kv_Stats Eet_Kv_Stats;
+
+/**
+ * @struct _Eet_Kv_Stats
+ * Counters of a key/value store since it was opened.
+ *
+ * The write amplification is (@c wal_bytes + @c compacted_bytes) /
+ * @c bytes, the same ratio for plain eet_write() and eet_sync() is the
+ * file size over the entry size at every sync.
+ */
+struct _Eet_Kv_Stats
+{
+   unsigned long long writes; /**< Entries written */
+   unsigned long long deletes; /**< Entries deleted */
+   unsigned long long bytes; /**< Bytes of key and data given to write */
+   unsigned long long wal_bytes; /**< Bytes appended to the log */
+   unsigned long long syncs; /**< Times the log was flushed to disk */
+   unsigned long long compactions; /**< Compactions installed */
+   unsigned long long compacted_bytes; /**< Bytes of the files compaction wrote */
+   unsigned long long wal_size; /**< Size of the current log */
+};
+
+/**
+ * Open a key/value store.
+ * @param path The eet file to keep it in.
+ * @param mode #EET_FILE_MODE_READ or #EET_FILE_MODE_READ_WRITE.
+ * @return A new store, or NULL on failure.
+ *
+ * The file is opened with eet_open() and the log is replayed on top of
+ * it. In #EET_FILE_MODE_READ_WRITE the file is created if missing and
+ * only one process should open it that way at a time, readers may use
+ * #EET_FILE_MODE_READ and eet_kv_refresh().
+ *
+ * @see eet_kv_close()
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eet_Kv *
+eet_kv_open(const char *path,
+            Eet_File_Mode mode);
+
+/**
+ * Close a key/value store.
+ * @param kv The store to close.
+ *
+ * Waits for a running compaction and flushes the log to disk.
+ * Snapshots taken from it stay valid until freed.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline void
+eet_kv_close(Eet_Kv *kv);
+
+/**
+ * Write an entry to a key/value store.
+ * @param kv A store opened for writing.
+ * @param key The name of the entry.
+ * @param data The data to store.
+ * @param size The length of @p data in bytes.
+ * @return @p size on success, 0 on failure.
+ *
+ * The entry is appended to the log, readers of the store see it
+ * straight away, it is on disk once the log is flushed.
+ *
+ * @see eet_kv_sync_policy_set()
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline int
+eet_kv_write(Eet_Kv *kv,
+             const char *key,
+             const void *data,
+             int size);
+
+/**
+ * Delete an entry from a key/value store.
+ * @param kv A store opened for writing.
+ * @param key The name of the entry.
+ * @return EINA_TRUE if the deletion was logged.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool
+eet_kv_delete(Eet_Kv *kv,
+              const char *key);
+
+/**
+ * Read an entry from a key/value store.
+ * @param kv A store.
+ * @param key The name of the entry.
+ * @param size_ret Where to put the size of the data, or NULL.
+ * @return A copy of the data to free(), or NULL if there is no such entry.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline void *
+eet_kv_read(Eet_Kv *kv,
+            const char *key,
+            int *size_ret);
+
+/**
+ * Flush the log of a key/value store to disk.
+ * @param kv A store opened for writing.
+ * @return EINA_TRUE on success.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool
+eet_kv_sync(Eet_Kv *kv);
+
+/**
+ * Set when the log of a key/value store is flushed to disk.
+ * @param kv A store opened for writing.
+ * @param max_writes Flush once this many writes are pending, 0 to not count.
+ * @param max_bytes Flush once this many bytes are pending, 0 to not count.
+ *
+ * The default flushes after every write. Batching flushes makes writes
+ * much cheaper, what was written since the last flush may be lost on a
+ * crash. With both at 0 the log is only flushed by eet_kv_sync(),
+ * compaction and eet_kv_close().
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline void
+eet_kv_sync_policy_set(Eet_Kv *kv,
+                       unsigned int max_writes,
+                       size_t max_bytes);
+
+/**
+ * Compact a key/value store into a fresh eet file.
+ * @param kv A store opened for writing.
+ * @param wait EINA_TRUE to return once the compaction is installed.
+ * @return EINA_TRUE if a compaction was started or is running.
+ *
+ * New writes go to a new log while a thread writes the file and the
+ * entries logged so far into @c path.compact and renames it over
+ * @c path. The store switches to the new file on its next call once
+ * the thread is done, the old logs are then removed.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool
+eet_kv_compact(Eet_Kv *kv,
+               Eina_Bool wait);
+
+/**
+ * Compact a key/value store automatically.
+ * @param kv A store opened for writing.
+ * @param wal_size Start a compaction once the log is this large, 0 to never.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline void
+eet_kv_compact_threshold_set(Eet_Kv *kv,
+                             size_t wal_size);
+
+/**
+ * Catch up with what the writer of a key/value store did.
+ * @param kv A store opened with #EET_FILE_MODE_READ.
+ * @return EINA_TRUE if something changed.
+ *
+ * Replays what was appended to the log since the last call, or reloads
+ * the store if it was compacted meanwhile.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool
+eet_kv_refresh(Eet_Kv *kv);
+
+/**
+ * Take a snapshot of a key/value store.
+ * @param kv A store.
+ * @return A snapshot to free with eet_kv_snapshot_free(), or NULL.
+ *
+ * Reading the snapshot returns what the store held when it was taken,
+ * whatever is written, deleted or compacted afterward. Taking one
+ * copies nothing.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eet_Kv_Snapshot *
+eet_kv_snapshot_new(Eet_Kv *kv);
+
+/**
+ * Read an entry from a snapshot.
+ * @param snap A snapshot.
+ * @param key The name of the entry.
+ * @param size_ret Where to put the size of the data, or NULL.
+ * @return A copy of the data to free(), or NULL if there is no such entry.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline void *
+eet_kv_snapshot_read(Eet_Kv_Snapshot *snap,
+                     const char *key,
+                     int *size_ret);
+
+/**
+ * Free a snapshot.
+ * @param snap The snapshot to free.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline void
+eet_kv_snapshot_free(Eet_Kv_Snapshot *snap);
+
+/**
+ * Get the counters of a key/value store.
+ * @param kv A store.
+ * @param stats Where to put them.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline void
+eet_kv_stats_get(const Eet_Kv *kv,
+                 Eet_Kv_Stats *stats);
+
+/**
+ * @}
+ */
+
+#include "eet_inline_kv.x"
+
 /**
  * @defgroup Eet_File_Image_Group Image Store and Load
  * @ingroup Eet
@@ -4106,6 +4463,271 @@ eet_data_descriptor_encode(Eet_Data_Descriptor *edd,
                                   0,                                          \
                                   NULL,                                       \
                                   NULL)
+
+/**
+ * @typedef Eet_Data_Lazy
+ * A view on an encoded data structure that decodes nothing up front.
+ *
+ * @see eet_data_lazy_read()
+ * @ingroup Eet_Data_Group
+ */
+typedef struct _Eet_Data_Lazy Eet_Data_Lazy;
+
+/**
+ * @typedef Eet_Data_Lazy_Node
+ * A position inside an #Eet_Data_Lazy, see eet_data_lazy_root_get().
+ *
+ * @ingroup Eet_Data_Group
+ */
+typedef struct _Eet_Data_Lazy_Node Eet_Data_Lazy_Node;
+
+/**
+ * @struct _Eet_Data_Lazy_Node
+ * A position inside an #Eet_Data_Lazy. It is filled by the lookup calls
+ * and points into the data of the view, it holds no memory of its own and
+ * can live on the stack.
+ *
+ * @ingroup Eet_Data_Group
+ */
+struct _Eet_Data_Lazy_Node
+{
+   const Eet_Data_Lazy *lazy; /**< The view this points into */
+   const char *name; /**< The member name, valid as long as the view */
+   int type; /**< The EET_T_* type of the value, #EET_T_UNKNOW for a struct */
+   int group_type; /**< The EET_G_* group the value is part of */
+
+   /* private */
+   const unsigned char *chunk; /**< The chunk holding a struct, for decoding */
+   const unsigned char *data; /**< The value, or the members of a struct */
+   const unsigned char *next; /**< The chunk following this one */
+   const unsigned char *end; /**< The end of the enclosing struct */
+   const char *key; /**< The key of a hash value */
+   int chunk_size;
+   int size;
+   int left; /**< The array elements following this one */
+};
+
+/**
+ * Open a lazy view on a data structure stored in an eet file.
+ * @param ef The eet file handle to read from.
+ * @param name The key the data is stored under in the eet file.
+ * @return A new view, or NULL on failure.
+ *
+ * eet_data_read() decodes the whole structure tree into allocated memory
+ * before returning, whatever part of it the caller then uses. A lazy view
+ * decodes nothing: the entry is used in place from the mapping of the
+ * file, eet_data_lazy_child_get() and friends walk it on demand and
+ * values, strings included, are read from where they are stored. Only
+ * the parts handed to eet_data_lazy_decode() are turned into structures.
+ *
+ * Compressed entries are uncompressed into one allocation, ciphered
+ * entries are not supported. The file must be opened read-only and stay
+ * open as long as the view is used. The strings of the dictionary are read
+ * from the mapping @p ef uses, NULL is returned if the file at its path is
+ * not that one anymore.
+ *
+ * @see eet_data_lazy_free()
+ * @see eet_data_lazy_root_get()
+ *
+ * @ingroup Eet_Data_Group
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eet_Data_Lazy *
+eet_data_lazy_read(Eet_File *ef,
+                   const char *name);
+
+/**
+ * Free a lazy view.
+ * @param lazy The view to free, its nodes become invalid.
+ *
+ * @ingroup Eet_Data_Group
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline void
+eet_data_lazy_free(Eet_Data_Lazy *lazy);
+
+/**
+ * Get the top level structure of a lazy view.
+ * @param lazy The view.
+ * @param node Where to store the position of the structure.
+ * @return EINA_TRUE on success, EINA_FALSE otherwise.
+ *
+ * @ingroup Eet_Data_Group
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool
+eet_data_lazy_root_get(const Eet_Data_Lazy *lazy,
+                       Eet_Data_Lazy_Node *node);
+
+/**
+ * Find a member of a structure.
+ * @param node The structure.
+ * @param name The name of the member, as given to the data descriptor.
+ * @param child Where to store the position of the member.
+ * @return EINA_TRUE if the member was found, EINA_FALSE otherwise.
+ *
+ * For a list, an array or a hash member, @p child is its first element,
+ * eet_data_lazy_next() moves to the following ones. @p node and @p child
+ * may be the same node.
+ *
+ * @ingroup Eet_Data_Group
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool
+eet_data_lazy_child_get(const Eet_Data_Lazy_Node *node,
+                        const char *name,
+                        Eet_Data_Lazy_Node *child);
+
+/**
+ * Move to the next element of a list, an array or a hash.
+ * @param node The element, updated in place.
+ * @return EINA_TRUE if there was one, EINA_FALSE at the end.
+ *
+ * @ingroup Eet_Data_Group
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool
+eet_data_lazy_next(Eet_Data_Lazy_Node *node);
+
+/**
+ * Count the elements of a member.
+ * @param node The structure.
+ * @param name The name of the member.
+ * @return The number of elements of a list, an array or a hash, 1 for a
+ * single value and 0 when there is no such member.
+ *
+ * Arrays store their size, lists and hashes are walked without decoding.
+ *
+ * @ingroup Eet_Data_Group
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline int
+eet_data_lazy_count(const Eet_Data_Lazy_Node *node,
+                    const char *name);
+
+/**
+ * Find a value of a hash member by its key.
+ * @param node The structure.
+ * @param name The name of the hash member.
+ * @param key The key to look for.
+ * @param value Where to store the position of the value.
+ * @return EINA_TRUE if the key was found, EINA_FALSE otherwise.
+ *
+ * @ingroup Eet_Data_Group
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool
+eet_data_lazy_hash_find(const Eet_Data_Lazy_Node *node,
+                        const char *name,
+                        const char *key,
+                        Eet_Data_Lazy_Node *value);
+
+/**
+ * Get the key of a hash value.
+ * @param node A value reached through a hash member.
+ * @return The key, NULL if @p node is not a hash value.
+ *
+ * @ingroup Eet_Data_Group
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline const char *
+eet_data_lazy_key_get(const Eet_Data_Lazy_Node *node);
+
+/**
+ * Read an integer value.
+ * @param node The value, of any integer type.
+ * @param value Where to store it.
+ * @return EINA_TRUE on success, EINA_FALSE if @p node is not an integer.
+ *
+ * @ingroup Eet_Data_Group
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool
+eet_data_lazy_long_long_get(const Eet_Data_Lazy_Node *node,
+                            long long *value);
+
+/**
+ * Read a floating point value.
+ * @param node The value, of a floating, fixed point or integer type.
+ * @param value Where to store it.
+ * @return EINA_TRUE on success, EINA_FALSE if @p node is not a number.
+ *
+ * @ingroup Eet_Data_Group
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool
+eet_data_lazy_double_get(const Eet_Data_Lazy_Node *node,
+                         double *value);
+
+/**
+ * Read a string value.
+ * @param node The value, of a string type.
+ * @return The string, NULL if @p node is not a string.
+ *
+ * The string is not copied, it points into the view and is valid as long
+ * as it is.
+ *
+ * @ingroup Eet_Data_Group
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline const char *
+eet_data_lazy_string_get(const Eet_Data_Lazy_Node *node);
+
+/**
+ * Decode a structure of a lazy view.
+ * @param node The structure, the root or any nested one.
+ * @param edd The data descriptor of the structure.
+ * @return The decoded structure, or NULL on failure.
+ *
+ * This materialises the part of the tree below @p node only, as
+ * eet_data_descriptor_decode() would. Structures holding unions or
+ * variants can not be decoded from files using a dictionary.
+ *
+ * @ingroup Eet_Data_Group
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline void *
+eet_data_lazy_decode(const Eet_Data_Lazy_Node *node,
+                     Eet_Data_Descriptor *edd);
+
+#include "eet_inline_data.x"
+
 /**
  * @defgroup Eet_Data_Cipher_Group Eet Data Serialization using A Ciphers
  *
@@ -5057,6 +5679,57 @@ eet_data_node_write_cipher(Eet_File *ef,
                            Eet_Node *node,
                            int compress);
 
+/**
+ * Copy an eet file so its data entries are decoded in place.
+ * @param file The eet file to copy.
+ * @param out The file to write, replaced once complete.
+ * @return EINA_TRUE on success, EINA_FALSE otherwise.
+ *
+ * eet_data_read() decodes an entry straight from the file mapping only
+ * when it is stored uncompressed. A compressed entry is first inflated
+ * into memory private to the process, so every process reading the
+ * same file, like all the applications loading the same Edje theme,
+ * spends time and memory inflating the same collections.
+ *
+ * This rewrites every entry encoded with a data descriptor uncompressed,
+ * against the dictionary of @p out, so the structures decoded from it
+ * point their strings into pages of the file all the processes share.
+ * Other entries, such as images, fonts or scripts, are copied as they
+ * are read, compressed again with several threads if they were
+ * compressed. Aliases are kept.
+ *
+ * @p out is written next to itself and renamed over, so processes which
+ * have it open keep their mapping of the previous file. It keeps its
+ * mode, or gets the one of @p file when it is new.
+ *
+ * @note Ciphered entries cannot be copied, the call fails on them.
+ *
+ * @see eet_file_direct_get()
+ * @see eet_data_node_read_cipher()
+ *
+ * @ingroup Eet_File_Group
+ */
+static inline Eina_Bool
+eet_file_direct_pack(const char *file,
+                     const char *out);
+
+/**
+ * Tell whether some entries of an eet file can be read in place.
+ * @param ef A valid eet file handle opened for reading.
+ * @param glob A shell glob of the entries to check, eg: "edje/collections/\*".
+ * @return EINA_TRUE if all the matching entries are stored uncompressed,
+ * EINA_FALSE otherwise or if none matches.
+ *
+ * @see eet_file_direct_pack()
+ *
+ * @ingroup Eet_File_Group
+ */
+static inline Eina_Bool
+eet_file_direct_get(Eet_File *ef,
+                    const char *glob);
+
+#include "eet_inline_pack.x"
+
 /* EXPERIMENTAL: THIS API MAY CHANGE IN THE FUTURE, USE IT ONLY IF YOU KNOW WHAT YOU ARE DOING. */
 
 /**
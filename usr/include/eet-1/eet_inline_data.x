@@ -0,0 +1,724 @@
+/* EET - E file chunk reading/writing library
+ * Copyright (C) 2016 Samsung Electronics Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library;
+ * if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EET_INLINE_DATA_X_
+#define EET_INLINE_DATA_X_
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @cond LOCAL
+ */
+
+/* What eet_lib.c writes at the start of a file: magic, directory entry
+ * count and dictionary entry count, then 6 ints per directory entry and 5
+ * per dictionary entry, all in network byte order. */
+#define EET_DATA_LAZY_MAGIC_FILE2 0x1ee70f42
+#define EET_DATA_LAZY_HEADER_SIZE (3 * 4)
+#define EET_DATA_LAZY_DIRECTORY_SIZE (6 * 4)
+#define EET_DATA_LAZY_DICTIONARY_SIZE (5 * 4)
+
+typedef struct _Eet_Data_Lazy_Buffer Eet_Data_Lazy_Buffer;
+
+struct _Eet_Data_Lazy
+{
+   Eina_File *file; // mapped to reach the dictionary strings
+   const unsigned char *map;
+   size_t map_size;
+   const unsigned char *dictionary; // NULL when strings are stored inline
+   unsigned int dictionary_count;
+   void *copy; // the uncompressed entry, when it had to be
+   const unsigned char *data;
+   int size;
+};
+
+struct _Eet_Data_Lazy_Buffer
+{
+   unsigned char *data;
+   size_t length;
+   size_t size;
+};
+
+/* Encoded data uses little endian, whatever the host. */
+static inline int
+_eet_data_lazy_int_get(const unsigned char *p)
+{
+   return (int)((unsigned int)p[0] | ((unsigned int)p[1] << 8) |
+                ((unsigned int)p[2] << 16) | ((unsigned int)p[3] << 24));
+}
+
+static inline unsigned int
+_eet_data_lazy_header_get(const unsigned char *p)
+{
+   return ((unsigned int)p[0] << 24) | ((unsigned int)p[1] << 16) |
+     ((unsigned int)p[2] << 8) | (unsigned int)p[3];
+}
+
+static inline const char *
+_eet_data_lazy_dictionary_get(const Eet_Data_Lazy *lazy, int idx)
+{
+   const unsigned char *e;
+   unsigned int offset, len;
+
+   if (idx < 0 || (unsigned int)idx >= lazy->dictionary_count) return NULL;
+   e = lazy->dictionary + idx * EET_DATA_LAZY_DICTIONARY_SIZE;
+   offset = _eet_data_lazy_header_get(e + 4);
+   len = _eet_data_lazy_header_get(e + 8);
+   if (!len || offset > lazy->map_size || len > lazy->map_size - offset) return NULL;
+   if (lazy->map[offset + len - 1]) return NULL;
+   return (const char *)lazy->map + offset;
+}
+
+/* Decodes an EET_T_STRING, a dictionary index or the string itself. */
+static inline const char *
+_eet_data_lazy_string_decode(const Eet_Data_Lazy *lazy, const unsigned char *p, int size, int *used)
+{
+   const unsigned char *z;
+
+   if (lazy->dictionary)
+     {
+        if (size < 4) return NULL;
+        if (used) *used = 4;
+        return _eet_data_lazy_dictionary_get(lazy, _eet_data_lazy_int_get(p));
+     }
+   z = (const unsigned char *)(size > 0 ? memchr(p, 0, size) : NULL);
+   if (!z) return NULL;
+   if (used) *used = z - p + 1;
+   return (const char *)p;
+}
+
+/* Parses the chunk at p, see eet_data_chunk_get(). */
+static inline Eina_Bool
+_eet_data_lazy_chunk_get(const Eet_Data_Lazy *lazy, const unsigned char *p, const unsigned char *end,
+                         Eet_Data_Lazy_Node *node)
+{
+   int size, used = 0, t;
+
+   if (end - p < 8 || p[0] != 'C' || p[1] != 'H') return EINA_FALSE;
+   if (p[2] == 'K')
+     {
+        t = p[3];
+        if (t >= EET_I_LIMIT)
+          {
+             node->group_type = ((t - EET_I_LIMIT) & 0xF) + EET_G_UNKNOWN;
+             switch ((t - EET_I_LIMIT) & 0xF0)
+               {
+                case 1 << 4: node->type = EET_T_STRING; break;
+                case 2 << 4: node->type = EET_T_INLINED_STRING; break;
+                case 3 << 4: node->type = EET_T_NULL; break;
+                default: return EINA_FALSE;
+               }
+          }
+        else if (t > EET_T_LAST)
+          {
+             node->group_type = t;
+             node->type = EET_T_UNKNOW;
+          }
+        else
+          {
+             node->group_type = EET_G_UNKNOWN;
+             node->type = t;
+          }
+        if (node->type >= EET_T_LAST || node->group_type >= EET_G_LAST)
+          {
+             node->type = EET_T_UNKNOW;
+             node->group_type = EET_G_UNKNOWN;
+          }
+     }
+   else if (p[2] == 'n' && p[3] == 'K')
+     {
+        node->type = EET_T_UNKNOW;
+        node->group_type = EET_G_UNKNOWN;
+     }
+   else
+     return EINA_FALSE;
+
+   size = _eet_data_lazy_int_get(p + 4);
+   if (size < 0 || size > end - p - 8) return EINA_FALSE;
+   node->name = _eet_data_lazy_string_decode(lazy, p + 8, size, &used);
+   if (!node->name) return EINA_FALSE;
+
+   node->lazy = lazy;
+   node->chunk = p;
+   node->chunk_size = size + 8;
+   node->data = p + 8 + used;
+   node->size = size - used;
+   node->next = p + 8 + size;
+   node->end = end;
+   node->key = NULL;
+   node->left = 0;
+   return EINA_TRUE;
+}
+
+/* A struct value holds the whole encoded struct, step into its members
+ * so that every struct node looks like the root one. */
+static inline Eina_Bool
+_eet_data_lazy_open(Eet_Data_Lazy_Node *node)
+{
+   Eet_Data_Lazy_Node inner;
+
+   if (node->type != EET_T_UNKNOW) return EINA_TRUE;
+   switch (node->group_type)
+     {
+      case EET_G_UNKNOWN:
+      case EET_G_UNKNOWN_NESTED:
+      case EET_G_ARRAY:
+      case EET_G_VAR_ARRAY:
+      case EET_G_LIST:
+      case EET_G_HASH:
+        break;
+      default:
+        return EINA_TRUE; // unions and variants stay opaque
+     }
+
+   if (!_eet_data_lazy_chunk_get(node->lazy, node->data, node->data + node->size, &inner))
+     return EINA_FALSE;
+   node->chunk = inner.chunk;
+   node->chunk_size = inner.chunk_size;
+   node->data = inner.data;
+   node->size = inner.size;
+   return EINA_TRUE;
+}
+
+/* Turns the first chunk of a member into its first element: arrays
+ * start with their size, hashes and unions with a key. */
+static inline Eina_Bool
+_eet_data_lazy_element(Eet_Data_Lazy_Node *node)
+{
+   const char *name = node->name;
+   const char *key;
+   int count, group = node->group_type;
+
+   switch (group)
+     {
+      case EET_G_ARRAY:
+      case EET_G_VAR_ARRAY:
+        if (node->size < 4) return EINA_FALSE;
+        count = _eet_data_lazy_int_get(node->data);
+        if (count <= 0) return EINA_FALSE;
+        if (!_eet_data_lazy_chunk_get(node->lazy, node->next, node->end, node)) return EINA_FALSE;
+        node->left = count - 1;
+        break;
+      case EET_G_HASH:
+      case EET_G_UNION:
+        key = _eet_data_lazy_string_decode(node->lazy, node->data, node->size, NULL);
+        if (!key) return EINA_FALSE;
+        if (!_eet_data_lazy_chunk_get(node->lazy, node->next, node->end, node)) return EINA_FALSE;
+        node->key = key;
+        break;
+      default:
+        return _eet_data_lazy_open(node);
+     }
+   if (node->group_type != group || strcmp(node->name, name)) return EINA_FALSE;
+   return _eet_data_lazy_open(node);
+}
+
+static inline Eina_Bool
+_eet_data_lazy_buffer_append(Eet_Data_Lazy_Buffer *b, const void *data, size_t length)
+{
+   unsigned char *tmp;
+   size_t size;
+
+   if (b->length + length > b->size)
+     {
+        size = b->size ? b->size : 4096;
+        while (size < b->length + length) size <<= 1;
+        tmp = (unsigned char *)realloc(b->data, size);
+        if (!tmp) return EINA_FALSE;
+        b->data = tmp;
+        b->size = size;
+     }
+   if (length) memcpy(b->data + b->length, data, length);
+   b->length += length;
+   return EINA_TRUE;
+}
+
+static inline Eina_Bool
+_eet_data_lazy_buffer_string(Eet_Data_Lazy_Buffer *b, const char *s)
+{
+   return _eet_data_lazy_buffer_append(b, s, strlen(s) + 1);
+}
+
+static inline Eina_Bool _eet_data_lazy_rewrite_members(const Eet_Data_Lazy *lazy, const unsigned char *p,
+                                                       const unsigned char *end, Eet_Data_Lazy_Buffer *b);
+
+/* Writes the chunk at p back with its name and payload, the size is
+ * patched once the payload is known. */
+static inline Eina_Bool
+_eet_data_lazy_rewrite_chunk(const Eet_Data_Lazy_Node *c, const void *payload, size_t length,
+                             Eet_Data_Lazy_Buffer *b, size_t *size_at)
+{
+   unsigned char zero[4] = { 0, 0, 0, 0 };
+
+   if (!_eet_data_lazy_buffer_append(b, c->chunk, 4)) return EINA_FALSE;
+   *size_at = b->length;
+   if (!_eet_data_lazy_buffer_append(b, zero, 4)) return EINA_FALSE;
+   if (!_eet_data_lazy_buffer_string(b, c->name)) return EINA_FALSE;
+   return _eet_data_lazy_buffer_append(b, payload, length);
+}
+
+static inline void
+_eet_data_lazy_rewrite_size(Eet_Data_Lazy_Buffer *b, size_t size_at)
+{
+   unsigned int s = b->length - size_at - 4;
+
+   b->data[size_at] = s & 0xff;
+   b->data[size_at + 1] = (s >> 8) & 0xff;
+   b->data[size_at + 2] = (s >> 16) & 0xff;
+   b->data[size_at + 3] = (s >> 24) & 0xff;
+}
+
+/* Rewrites a whole encoded struct, the chunk at p, with no reference to
+ * the dictionary left, as eet_data_descriptor_encode() would write it. */
+static inline Eina_Bool
+_eet_data_lazy_rewrite_struct(const Eet_Data_Lazy *lazy, const unsigned char *p,
+                              const unsigned char *end, Eet_Data_Lazy_Buffer *b)
+{
+   Eet_Data_Lazy_Node c;
+   size_t size_at;
+
+   if (!_eet_data_lazy_chunk_get(lazy, p, end, &c)) return EINA_FALSE;
+   if (!_eet_data_lazy_rewrite_chunk(&c, NULL, 0, b, &size_at)) return EINA_FALSE;
+   if (!_eet_data_lazy_rewrite_members(lazy, c.data, c.data + c.size, b)) return EINA_FALSE;
+   _eet_data_lazy_rewrite_size(b, size_at);
+   return EINA_TRUE;
+}
+
+static inline Eina_Bool
+_eet_data_lazy_rewrite_members(const Eet_Data_Lazy *lazy, const unsigned char *p,
+                               const unsigned char *end, Eet_Data_Lazy_Buffer *b)
+{
+   Eet_Data_Lazy_Node c;
+   const char *run = NULL, *s;
+   Eina_Bool raw, pair_value = EINA_FALSE;
+   size_t size_at;
+   int left = 0;
+
+   for (; p < end; p = c.next)
+     {
+        if (!_eet_data_lazy_chunk_get(lazy, p, end, &c)) return EINA_FALSE;
+        // Elements of one member follow each other with the same name
+        if (c.name != run)
+          {
+             run = c.name;
+             left = 0;
+             pair_value = EINA_FALSE;
+          }
+
+        raw = EINA_FALSE;
+        s = NULL;
+        switch (c.group_type)
+          {
+           case EET_G_ARRAY:
+           case EET_G_VAR_ARRAY:
+             if (left > 0)
+               left--;
+             else
+               {
+                  // The size of the array, whatever the element type
+                  if (c.size < 4) return EINA_FALSE;
+                  left = _eet_data_lazy_int_get(c.data);
+                  raw = EINA_TRUE;
+               }
+             break;
+           case EET_G_HASH:
+           case EET_G_UNION:
+             pair_value = !pair_value;
+             if (pair_value)
+               {
+                  s = _eet_data_lazy_string_decode(lazy, c.data, c.size, NULL);
+                  if (!s) return EINA_FALSE;
+               }
+             break;
+           case EET_G_VARIANT:
+             return EINA_FALSE;
+           default:
+             break;
+          }
+
+        if (raw || s)
+          ;
+        else if (c.type == EET_T_UNKNOW)
+          {
+             if (!_eet_data_lazy_rewrite_chunk(&c, NULL, 0, b, &size_at)) return EINA_FALSE;
+             if (c.size && !_eet_data_lazy_rewrite_struct(lazy, c.data, c.data + c.size, b))
+               return EINA_FALSE;
+             _eet_data_lazy_rewrite_size(b, size_at);
+             continue;
+          }
+        else
+          switch (c.type)
+            {
+             case EET_T_STRING:
+             case EET_T_FLOAT:
+             case EET_T_DOUBLE:
+             case EET_T_F32P32:
+             case EET_T_F16P16:
+             case EET_T_F8P24:
+               // Stored as the index of their text in the dictionary
+               if (c.size < 4) return EINA_FALSE;
+               s = _eet_data_lazy_string_decode(lazy, c.data, c.size, NULL);
+               if (!s) s = "";
+               break;
+             case EET_T_VALUE:
+               return EINA_FALSE;
+             default:
+               raw = EINA_TRUE;
+               break;
+            }
+
+        if (raw)
+          {
+             if (!_eet_data_lazy_rewrite_chunk(&c, c.data, c.size, b, &size_at)) return EINA_FALSE;
+          }
+        else
+          {
+             if (!_eet_data_lazy_rewrite_chunk(&c, s, strlen(s) + 1, b, &size_at)) return EINA_FALSE;
+          }
+        _eet_data_lazy_rewrite_size(b, size_at);
+     }
+   return EINA_TRUE;
+}
+
+/* The text form of floating and fixed point values, as eina_convert
+ * writes it. */
+static inline Eina_Bool
+_eet_data_lazy_text_to_double(const Eet_Data_Lazy_Node *node, double *value)
+{
+   const char *s;
+   long long m;
+   long e;
+   double r;
+
+   s = _eet_data_lazy_string_decode(node->lazy, node->data, node->size, NULL);
+   if (!s) return EINA_FALSE;
+   if (node->type == EET_T_FLOAT || node->type == EET_T_DOUBLE)
+     {
+        if (!eina_convert_atod(s, strlen(s), &m, &e)) return EINA_FALSE;
+        // ldexp() without pulling libm in every user
+        for (r = (double)m; e >= 62; e -= 62) r *= 4611686018427387904.0;
+        for (; e <= -62; e += 62) r /= 4611686018427387904.0;
+        if (e > 0) r *= (double)(1LL << e);
+        else if (e < 0) r /= (double)(1LL << -e);
+        *value = r;
+     }
+   else
+     {
+        Eina_F32p32 fp;
+
+        if (!eina_convert_atofp(s, strlen(s), &fp)) return EINA_FALSE;
+        *value = eina_f32p32_double_to(fp);
+     }
+   return EINA_TRUE;
+}
+/**
+ * @endcond
+ */
+
+static inline Eet_Data_Lazy *
+eet_data_lazy_read(Eet_File *ef,
+                   const char *name)
+{
+   Eet_Data_Lazy *lazy;
+   Eet_Dictionary *ed;
+   const char *path;
+   unsigned int ndir, ndic;
+   const void *data;
+   int size = 0;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(ef, NULL);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(name, NULL);
+   // A writable file may hold strings that are not in the mapping yet
+   if (eet_mode_get(ef) != EET_FILE_MODE_READ) return NULL;
+
+   lazy = (Eet_Data_Lazy *)calloc(1, sizeof (Eet_Data_Lazy));
+   if (!lazy) return NULL;
+
+   data = eet_read_direct(ef, name, &size);
+   if (!data)
+     {
+        lazy->copy = eet_read(ef, name, &size);
+        data = lazy->copy;
+     }
+   if (!data || size <= 0) goto on_error;
+   lazy->data = (const unsigned char *)data;
+   lazy->size = size;
+
+   ed = eet_dictionary_get(ef);
+   if (!ed || !eet_dictionary_count(ed)) return lazy;
+
+   path = eet_file_get(ef);
+   if (!path) goto on_error;
+   lazy->file = eina_file_open(path, EINA_FALSE);
+   if (!lazy->file) goto on_error;
+   lazy->map = (const unsigned char *)eina_file_map_all(lazy->file, EINA_FILE_RANDOM);
+   lazy->map_size = eina_file_size_get(lazy->file);
+   if (!lazy->map || lazy->map_size < EET_DATA_LAZY_HEADER_SIZE) goto on_error;
+
+   if (_eet_data_lazy_header_get(lazy->map) != EET_DATA_LAZY_MAGIC_FILE2) goto on_error;
+   ndir = _eet_data_lazy_header_get(lazy->map + 4);
+   ndic = _eet_data_lazy_header_get(lazy->map + 8);
+   if (ndic != (unsigned int)eet_dictionary_count(ed)) goto on_error;
+   if (ndir > (lazy->map_size - EET_DATA_LAZY_HEADER_SIZE) / EET_DATA_LAZY_DIRECTORY_SIZE)
+     goto on_error;
+   lazy->dictionary = lazy->map + EET_DATA_LAZY_HEADER_SIZE + ndir * EET_DATA_LAZY_DIRECTORY_SIZE;
+   if (ndic > (lazy->map_size - (lazy->dictionary - lazy->map)) / EET_DATA_LAZY_DICTIONARY_SIZE)
+     goto on_error;
+   lazy->dictionary_count = ndic;
+
+   /* The path may name another file by now. eina_file_open() gave us the
+    * mapping ef reads from only if the file is still the same one, then
+    * the strings of its dictionary and a direct entry point into it. */
+   if (ndic && !eet_dictionary_string_check(ed, _eet_data_lazy_dictionary_get(lazy, 0)))
+     goto on_error;
+   if (!lazy->copy &&
+       (lazy->data < lazy->map || lazy->data + lazy->size > lazy->map + lazy->map_size))
+     goto on_error;
+   return lazy;
+
+ on_error:
+   eet_data_lazy_free(lazy);
+   return NULL;
+}
+
+static inline void
+eet_data_lazy_free(Eet_Data_Lazy *lazy)
+{
+   if (!lazy) return;
+   if (lazy->map) eina_file_map_free(lazy->file, (void *)lazy->map);
+   if (lazy->file) eina_file_close(lazy->file);
+   free(lazy->copy);
+   free(lazy);
+}
+
+static inline Eina_Bool
+eet_data_lazy_root_get(const Eet_Data_Lazy *lazy,
+                       Eet_Data_Lazy_Node *node)
+{
+   EINA_SAFETY_ON_NULL_RETURN_VAL(lazy, EINA_FALSE);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(node, EINA_FALSE);
+
+   return _eet_data_lazy_chunk_get(lazy, lazy->data, lazy->data + lazy->size, node);
+}
+
+static inline Eina_Bool
+eet_data_lazy_child_get(const Eet_Data_Lazy_Node *node,
+                        const char *name,
+                        Eet_Data_Lazy_Node *child)
+{
+   const unsigned char *p, *end;
+   const Eet_Data_Lazy *lazy;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(node, EINA_FALSE);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(name, EINA_FALSE);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(child, EINA_FALSE);
+   if (node->type != EET_T_UNKNOW) return EINA_FALSE;
+
+   lazy = node->lazy;
+   p = node->data;
+   end = node->data + node->size;
+   while (p < end)
+     {
+        if (!_eet_data_lazy_chunk_get(lazy, p, end, child)) return EINA_FALSE;
+        if (!strcmp(child->name, name)) return _eet_data_lazy_element(child);
+        p = child->next;
+     }
+   return EINA_FALSE;
+}
+
+static inline Eina_Bool
+eet_data_lazy_next(Eet_Data_Lazy_Node *node)
+{
+   Eet_Data_Lazy_Node n;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(node, EINA_FALSE);
+
+   switch (node->group_type)
+     {
+      case EET_G_ARRAY:
+      case EET_G_VAR_ARRAY:
+        if (node->left <= 0) return EINA_FALSE;
+        if (!_eet_data_lazy_chunk_get(node->lazy, node->next, node->end, &n)) return EINA_FALSE;
+        n.left = node->left - 1;
+        break;
+      case EET_G_LIST:
+        if (!_eet_data_lazy_chunk_get(node->lazy, node->next, node->end, &n)) return EINA_FALSE;
+        break;
+      case EET_G_HASH:
+        // The next key, then its value
+        if (!_eet_data_lazy_chunk_get(node->lazy, node->next, node->end, &n)) return EINA_FALSE;
+        if (n.group_type != EET_G_HASH || strcmp(n.name, node->name)) return EINA_FALSE;
+        if (!_eet_data_lazy_element(&n)) return EINA_FALSE;
+        *node = n;
+        return EINA_TRUE;
+      default:
+        return EINA_FALSE;
+     }
+   if (n.group_type != node->group_type || strcmp(n.name, node->name)) return EINA_FALSE;
+   if (!_eet_data_lazy_open(&n)) return EINA_FALSE;
+   *node = n;
+   return EINA_TRUE;
+}
+
+static inline int
+eet_data_lazy_count(const Eet_Data_Lazy_Node *node,
+                    const char *name)
+{
+   Eet_Data_Lazy_Node n;
+   int count;
+
+   if (!eet_data_lazy_child_get(node, name, &n)) return 0;
+   if (n.group_type == EET_G_ARRAY || n.group_type == EET_G_VAR_ARRAY)
+     return n.left + 1;
+   if (n.group_type != EET_G_LIST && n.group_type != EET_G_HASH)
+     return 1;
+   for (count = 1; eet_data_lazy_next(&n); count++)
+     ;
+   return count;
+}
+
+static inline Eina_Bool
+eet_data_lazy_hash_find(const Eet_Data_Lazy_Node *node,
+                        const char *name,
+                        const char *key,
+                        Eet_Data_Lazy_Node *value)
+{
+   EINA_SAFETY_ON_NULL_RETURN_VAL(key, EINA_FALSE);
+
+   if (!eet_data_lazy_child_get(node, name, value)) return EINA_FALSE;
+   if (value->group_type != EET_G_HASH) return EINA_FALSE;
+   do
+     if (!strcmp(value->key, key)) return EINA_TRUE;
+   while (eet_data_lazy_next(value));
+   return EINA_FALSE;
+}
+
+static inline const char *
+eet_data_lazy_key_get(const Eet_Data_Lazy_Node *node)
+{
+   EINA_SAFETY_ON_NULL_RETURN_VAL(node, NULL);
+
+   return node->key;
+}
+
+static inline Eina_Bool
+eet_data_lazy_long_long_get(const Eet_Data_Lazy_Node *node,
+                            long long *value)
+{
+   const unsigned char *p;
+   unsigned long long v = 0;
+   int size, i;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(node, EINA_FALSE);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(value, EINA_FALSE);
+
+   switch (node->type)
+     {
+      case EET_T_CHAR: case EET_T_UCHAR: size = 1; break;
+      case EET_T_SHORT: case EET_T_USHORT: size = 2; break;
+      case EET_T_INT: case EET_T_UINT: size = 4; break;
+      case EET_T_LONG_LONG: case EET_T_ULONG_LONG: size = 8; break;
+      default: return EINA_FALSE;
+     }
+   if (node->size < size) return EINA_FALSE;
+
+   p = node->data;
+   for (i = size - 1; i >= 0; i--)
+     v = (v << 8) | p[i];
+   switch (node->type)
+     {
+      case EET_T_CHAR: *value = (signed char)v; break;
+      case EET_T_SHORT: *value = (short)v; break;
+      case EET_T_INT: *value = (int)v; break;
+      default: *value = (long long)v; break;
+     }
+   return EINA_TRUE;
+}
+
+static inline Eina_Bool
+eet_data_lazy_double_get(const Eet_Data_Lazy_Node *node,
+                         double *value)
+{
+   long long v;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(node, EINA_FALSE);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(value, EINA_FALSE);
+
+   switch (node->type)
+     {
+      case EET_T_FLOAT:
+      case EET_T_DOUBLE:
+      case EET_T_F32P32:
+      case EET_T_F16P16:
+      case EET_T_F8P24:
+        return _eet_data_lazy_text_to_double(node, value);
+      default:
+        if (!eet_data_lazy_long_long_get(node, &v)) return EINA_FALSE;
+        *value = node->type == EET_T_ULONG_LONG ? (double)(unsigned long long)v : (double)v;
+        return EINA_TRUE;
+     }
+}
+
+static inline const char *
+eet_data_lazy_string_get(const Eet_Data_Lazy_Node *node)
+{
+   const unsigned char *z;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(node, NULL);
+
+   switch (node->type)
+     {
+      case EET_T_STRING:
+        return _eet_data_lazy_string_decode(node->lazy, node->data, node->size, NULL);
+      case EET_T_INLINED_STRING:
+        // Never goes through the dictionary
+        z = (const unsigned char *)(node->size > 0 ? memchr(node->data, 0, node->size) : NULL);
+        return z ? (const char *)node->data : NULL;
+      default:
+        return NULL;
+     }
+}
+
+static inline void *
+eet_data_lazy_decode(const Eet_Data_Lazy_Node *node,
+                     Eet_Data_Descriptor *edd)
+{
+   Eet_Data_Lazy_Buffer b = { NULL, 0, 0 };
+   void *r = NULL;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(node, NULL);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(edd, NULL);
+   if (node->type != EET_T_UNKNOW) return NULL;
+
+   // Without a dictionary the encoded struct stands on its own
+   if (!node->lazy->dictionary)
+     return eet_data_descriptor_decode(edd, node->chunk, node->chunk_size);
+
+   if (_eet_data_lazy_rewrite_struct(node->lazy, node->chunk, node->chunk + node->chunk_size, &b))
+     r = eet_data_descriptor_decode(edd, b.data, b.length);
+   free(b.data);
+   return r;
+}
+
+#undef EET_DATA_LAZY_MAGIC_FILE2
+#undef EET_DATA_LAZY_HEADER_SIZE
+#undef EET_DATA_LAZY_DIRECTORY_SIZE
+#undef EET_DATA_LAZY_DICTIONARY_SIZE
+
+#endif
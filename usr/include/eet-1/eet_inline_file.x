@@ -0,0 +1,45 @@
+/* EET - E file chunk reading/writing library
+ * Copyright (C) 2016 Samsung Electronics Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library;
+ * if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EET_INLINE_FILE_X_
+#define EET_INLINE_FILE_X_
+
+static inline unsigned int
+eet_write_batch(Eet_File *ef,
+                Eet_Write_Entry *entries,
+                unsigned int count)
+{
+   unsigned int i, written = 0;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(ef, 0);
+   if (!count) return 0;
+   EINA_SAFETY_ON_NULL_RETURN_VAL(entries, 0);
+
+   for (i = 0; i < count; i++)
+     {
+        Eet_Write_Entry *e = entries + i;
+
+        e->written = eet_write_cipher(ef, e->name, e->data, e->size,
+                                      e->compress, e->cipher_key);
+        if (e->written > 0) written++;
+     }
+
+   return written;
+}
+
+#endif
@@ -0,0 +1,1006 @@
+/* EET - E file chunk reading/writing library
+ * Copyright (C) 2016 Samsung Electronics Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library;
+ * if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EET_INLINE_KV_X_
+#define EET_INLINE_KV_X_
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+/**
+ * @cond LOCAL
+ */
+
+/* The log of generation N holds what was written after the file of
+ * generation N was started, it is named path.wal.N and begins with
+ * EET_KV_WAL_MAGIC and N. Every record is three native endian words,
+ * key length, data length or EET_KV_DELETED and a checksum of the
+ * rest, followed by the key without its nul and the data.
+ *
+ * The file stores the generation of the first log it does not hold,
+ * so on open the logs from that one up are replayed and those below
+ * are leftovers of a compaction that got renamed but not cleaned up.
+ */
+#define EET_KV_WAL_MAGIC 0x57764b45
+#define EET_KV_DELETED 0xffffffff
+#define EET_KV_GENERATION "eet-kv:generation"
+
+typedef struct _Eet_Kv_Item Eet_Kv_Item;
+typedef struct _Eet_Kv_Layer Eet_Kv_Layer;
+typedef struct _Eet_Kv_Base Eet_Kv_Base;
+typedef struct _Eet_Kv_Compaction Eet_Kv_Compaction;
+
+struct _Eet_Kv_Item
+{
+   int size;
+   Eina_Bool deleted : 1;
+   unsigned char data[];
+};
+
+/* What was logged on top of the file, newest first. A layer is frozen
+ * once a snapshot or a compaction holds it, writes then go to a new
+ * one stacked on top. */
+struct _Eet_Kv_Layer
+{
+   Eet_Kv_Layer *older;
+   Eina_Hash *items;
+   int refs;
+};
+
+struct _Eet_Kv_Base
+{
+   Eet_File *ef;
+   unsigned int generation;
+   int refs;
+};
+
+struct _Eet_Kv_Compaction
+{
+   Eet_Kv_Base *base;
+   Eet_Kv_Layer *top;
+   char *path;
+   char *tmp;
+   unsigned int generation;
+   unsigned long long bytes;
+   Eina_Thread thread;
+   int done;
+   Eina_Bool ok : 1;
+};
+
+struct _Eet_Kv
+{
+   char *path;
+   Eet_File_Mode mode;
+   Eet_Kv_Base *base;
+   Eet_Kv_Layer *head;
+   Eet_Kv_Compaction *compaction;
+
+   int wal;
+   unsigned int wal_generation;
+   off_t wal_offset;
+   struct stat base_stat;
+
+   unsigned int sync_writes;
+   size_t sync_bytes;
+   unsigned int pending_writes;
+   size_t pending_bytes;
+   size_t compact_threshold;
+
+   Eet_Kv_Stats stats;
+
+   Eina_Bool head_frozen : 1;
+};
+
+struct _Eet_Kv_Snapshot
+{
+   Eet_Kv_Base *base;
+   Eet_Kv_Layer *head;
+};
+
+static inline unsigned int
+_eet_kv_sum(unsigned int klen, unsigned int vlen,
+            const void *key, const void *data)
+{
+   const unsigned char *p;
+   unsigned int h = 2166136261u;
+   unsigned int i;
+
+   h = (h ^ klen) * 16777619u;
+   h = (h ^ vlen) * 16777619u;
+   for (p = (const unsigned char *)key, i = 0; i < klen; i++)
+     h = (h ^ p[i]) * 16777619u;
+   if (vlen == EET_KV_DELETED) return h;
+   for (p = (const unsigned char *)data, i = 0; i < vlen; i++)
+     h = (h ^ p[i]) * 16777619u;
+   return h;
+}
+
+static inline void
+_eet_kv_wal_path(const Eet_Kv *kv, unsigned int generation,
+                 char *buf, size_t size)
+{
+   snprintf(buf, size, "%s.wal.%u", kv->path, generation);
+}
+
+static inline Eet_Kv_Layer *
+_eet_kv_layer_new(Eet_Kv_Layer *older)
+{
+   Eet_Kv_Layer *l;
+
+   l = (Eet_Kv_Layer *)calloc(1, sizeof (Eet_Kv_Layer));
+   if (!l) return NULL;
+   l->items = eina_hash_string_superfast_new(free);
+   if (!l->items)
+     {
+        free(l);
+        return NULL;
+     }
+   l->older = older;
+   l->refs = 1;
+   return l;
+}
+
+static inline void
+_eet_kv_layer_unref(Eet_Kv_Layer *l)
+{
+   while ((l) && (--l->refs == 0))
+     {
+        Eet_Kv_Layer *older = l->older;
+
+        eina_hash_free(l->items);
+        free(l);
+        l = older;
+     }
+}
+
+static inline Eet_Kv_Base *
+_eet_kv_base_open(const char *path)
+{
+   Eet_Kv_Base *b;
+   char *gen;
+   int size;
+
+   b = (Eet_Kv_Base *)calloc(1, sizeof (Eet_Kv_Base));
+   if (!b) return NULL;
+   b->refs = 1;
+   b->ef = eet_open(path, EET_FILE_MODE_READ);
+   if (!b->ef) return b;
+
+   gen = (char *)eet_read(b->ef, EET_KV_GENERATION, &size);
+   if ((gen) && (size > 0) && (!gen[size - 1]))
+     b->generation = strtoul(gen, NULL, 10);
+   free(gen);
+   return b;
+}
+
+static inline void
+_eet_kv_base_unref(Eet_Kv_Base *b)
+{
+   if ((!b) || (--b->refs > 0)) return;
+   if (b->ef) eet_close(b->ef);
+   free(b);
+}
+
+/* Make sure kv->head may be written to. */
+static inline Eina_Bool
+_eet_kv_head_thaw(Eet_Kv *kv)
+{
+   Eet_Kv_Layer *l;
+
+   if (!kv->head_frozen) return EINA_TRUE;
+   l = _eet_kv_layer_new(kv->head);
+   if (!l) return EINA_FALSE;
+   kv->head = l;
+   kv->head_frozen = EINA_FALSE;
+   return EINA_TRUE;
+}
+
+static inline Eina_Bool
+_eet_kv_item_set(Eet_Kv *kv, const char *key,
+                 const void *data, int size, Eina_Bool deleted)
+{
+   Eet_Kv_Item *it;
+
+   if (!_eet_kv_head_thaw(kv)) return EINA_FALSE;
+   it = (Eet_Kv_Item *)malloc(sizeof (Eet_Kv_Item) + (deleted ? 0 : size));
+   if (!it) return EINA_FALSE;
+   it->size = deleted ? 0 : size;
+   it->deleted = deleted;
+   if (it->size) memcpy(it->data, data, size);
+   free(eina_hash_set(kv->head->items, key, it));
+   return EINA_TRUE;
+}
+
+static inline const Eet_Kv_Item *
+_eet_kv_layers_find(const Eet_Kv_Layer *l, const char *key)
+{
+   for (; l; l = l->older)
+     {
+        const Eet_Kv_Item *it = (const Eet_Kv_Item *)eina_hash_find(l->items, key);
+
+        if (it) return it;
+     }
+   return NULL;
+}
+
+static inline void *
+_eet_kv_lookup(const Eet_Kv_Layer *head, const Eet_Kv_Base *base,
+               const char *key, int *size_ret)
+{
+   const Eet_Kv_Item *it;
+   void *r;
+
+   if (size_ret) *size_ret = 0;
+   it = _eet_kv_layers_find(head, key);
+   if (!it)
+     {
+        if (!base->ef) return NULL;
+        return eet_read(base->ef, key, size_ret);
+     }
+   if (it->deleted) return NULL;
+
+   r = malloc(it->size ? it->size : 1);
+   if (!r) return NULL;
+   memcpy(r, it->data, it->size);
+   if (size_ret) *size_ret = it->size;
+   return r;
+}
+
+/* Apply the records of a log to kv->head from offset on, returning
+ * where the last complete one ends or -1 if there is no such log. */
+static inline off_t
+_eet_kv_replay(Eet_Kv *kv, unsigned int generation, off_t offset)
+{
+   char path[PATH_MAX];
+   unsigned char *buf, *p, *end;
+   struct stat st;
+   unsigned int head[3];
+   off_t done = -1;
+   ssize_t n;
+   size_t got;
+   int fd;
+
+   _eet_kv_wal_path(kv, generation, path, sizeof (path));
+   fd = open(path, O_RDONLY | O_CLOEXEC);
+   if (fd < 0) return -1;
+   if ((fstat(fd, &st)) || (st.st_size < (off_t)sizeof (head[0]) * 2))
+     goto on_error;
+
+   if (offset == 0)
+     {
+        if (pread(fd, head, sizeof (head[0]) * 2, 0) != sizeof (head[0]) * 2)
+          goto on_error;
+        if ((head[0] != EET_KV_WAL_MAGIC) || (head[1] != generation))
+          goto on_error;
+        offset = sizeof (head[0]) * 2;
+     }
+   done = offset;
+   if (st.st_size <= offset) goto on_error;
+
+   buf = (unsigned char *)malloc(st.st_size - offset);
+   if (!buf) goto on_error;
+   for (got = 0; got < (size_t)(st.st_size - offset); got += n)
+     {
+        n = pread(fd, buf + got, st.st_size - offset - got, offset + got);
+        if ((n < 0) && (errno == EINTR)) n = 0;
+        else if (n <= 0) break;
+     }
+
+   for (p = buf, end = buf + got; p + sizeof (head) <= end;)
+     {
+        const char *key;
+        const unsigned char *data;
+        char name[PATH_MAX];
+        size_t len;
+
+        memcpy(head, p, sizeof (head));
+        if ((head[0] == 0) || (head[0] >= sizeof (name))) break;
+        len = sizeof (head) + head[0];
+        if ((size_t)(end - p) < len) break;
+        // Compared to what is left so a bogus size cannot wrap len around
+        if (head[1] != EET_KV_DELETED)
+          {
+             if (head[1] > (size_t)(end - p) - len) break;
+             len += head[1];
+          }
+
+        key = (const char *)p + sizeof (head);
+        data = p + sizeof (head) + head[0];
+        if (_eet_kv_sum(head[0], head[1], key, data) != head[2]) break;
+
+        memcpy(name, key, head[0]);
+        name[head[0]] = '\0';
+        if (!_eet_kv_item_set(kv, name, data,
+                              head[1] == EET_KV_DELETED ? 0 : (int)head[1],
+                              head[1] == EET_KV_DELETED))
+          break;
+        p += len;
+     }
+   done = offset + (p - buf);
+   free(buf);
+
+ on_error:
+   close(fd);
+   return done;
+}
+
+/* Load the file and every log on top of it into a fresh set of layers. */
+static inline Eina_Bool
+_eet_kv_load(Eet_Kv *kv)
+{
+   Eet_Kv_Base *base;
+   Eet_Kv_Layer *head;
+   unsigned int generation;
+   off_t offset;
+
+   base = _eet_kv_base_open(kv->path);
+   if (!base) return EINA_FALSE;
+   head = _eet_kv_layer_new(NULL);
+   if (!head)
+     {
+        _eet_kv_base_unref(base);
+        return EINA_FALSE;
+     }
+
+   _eet_kv_base_unref(kv->base);
+   _eet_kv_layer_unref(kv->head);
+   kv->base = base;
+   kv->head = head;
+   kv->head_frozen = EINA_FALSE;
+   if (stat(kv->path, &kv->base_stat))
+     memset(&kv->base_stat, 0, sizeof (kv->base_stat));
+
+   kv->wal_generation = base->generation;
+   kv->wal_offset = 0;
+   for (generation = base->generation; ; generation++)
+     {
+        offset = _eet_kv_replay(kv, generation, 0);
+        if (offset < 0) break;
+        kv->wal_generation = generation;
+        kv->wal_offset = offset;
+     }
+   return EINA_TRUE;
+}
+
+static inline Eina_Bool
+_eet_kv_wal_open(Eet_Kv *kv, unsigned int generation)
+{
+   char path[PATH_MAX];
+   unsigned int head[2] = { EET_KV_WAL_MAGIC, generation };
+   int fd;
+
+   _eet_kv_wal_path(kv, generation, path, sizeof (path));
+   fd = open(path, O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+   if (fd < 0) return EINA_FALSE;
+
+   /* Drop a record a crash cut short, or write the header of a new log. */
+   if (generation == kv->wal_generation && kv->wal_offset > 0)
+     {
+        if (ftruncate(fd, kv->wal_offset)) goto on_error;
+     }
+   else
+     {
+        if (ftruncate(fd, 0)) goto on_error;
+        if (write(fd, head, sizeof (head)) != sizeof (head)) goto on_error;
+        kv->wal_offset = sizeof (head);
+     }
+   if (lseek(fd, kv->wal_offset, SEEK_SET) < 0) goto on_error;
+
+   if (kv->wal >= 0) close(kv->wal);
+   kv->wal = fd;
+   kv->wal_generation = generation;
+   kv->stats.wal_size = kv->wal_offset;
+   return EINA_TRUE;
+
+ on_error:
+   close(fd);
+   return EINA_FALSE;
+}
+
+/* A rename is only on disk once its directory is synced. */
+static inline Eina_Bool
+_eet_kv_dir_sync(const char *path)
+{
+   char dir[PATH_MAX];
+   const char *slash;
+   int fd, ret;
+
+   slash = strrchr(path, '/');
+   if (!slash) strcpy(dir, ".");
+   else if (slash == path) strcpy(dir, "/");
+   else
+     {
+        if ((size_t)(slash - path) >= sizeof (dir)) return EINA_FALSE;
+        memcpy(dir, path, slash - path);
+        dir[slash - path] = '\0';
+     }
+
+   fd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+   if (fd < 0) return EINA_FALSE;
+   ret = fsync(fd);
+   close(fd);
+   return !ret;
+}
+
+/* The logs below generation are in the file renamed in by a compaction,
+ * they can only go once that rename is on disk. */
+static inline void
+_eet_kv_wal_unlink_below(Eet_Kv *kv, unsigned int generation, Eina_Bool synced)
+{
+   char path[PATH_MAX];
+
+   if (!generation) return;
+   _eet_kv_wal_path(kv, generation - 1, path, sizeof (path));
+   if (access(path, F_OK)) return;
+   if ((!synced) && (!_eet_kv_dir_sync(kv->path))) return;
+
+   while (generation-- > 0)
+     {
+        _eet_kv_wal_path(kv, generation, path, sizeof (path));
+        if ((unlink(path)) && (errno == ENOENT)) break;
+     }
+}
+
+static inline Eina_Bool
+_eet_kv_compact_write_cb(const Eina_Hash *hash EINA_UNUSED, const void *key,
+                         void *data, void *fdata)
+{
+   Eet_Kv_Item *it = (Eet_Kv_Item *)data;
+   Eet_File *ef = (Eet_File *)fdata;
+
+   if (it->deleted) eet_delete(ef, (const char *)key);
+   else eet_write(ef, (const char *)key, it->data, it->size, EET_COMPRESSION_NONE);
+   return EINA_TRUE;
+}
+
+static inline void *
+_eet_kv_compact_worker(void *data, Eina_Thread t EINA_UNUSED)
+{
+   Eet_Kv_Compaction *c = (Eet_Kv_Compaction *)data;
+   Eet_Kv_Layer **stack = NULL, *l;
+   Eet_File *ef;
+   struct stat st;
+   char gen[16];
+   unsigned int n = 0, i;
+   int fd;
+
+   ef = eet_open(c->tmp, EET_FILE_MODE_WRITE);
+   if (!ef) goto on_done;
+
+   if (c->base->ef)
+     {
+        char **names;
+        int count = 0, j;
+
+        names = eet_list(c->base->ef, "*", &count);
+        for (j = 0; j < count; j++)
+          {
+             void *d;
+             int size;
+
+             if (!strcmp(names[j], EET_KV_GENERATION)) continue;
+             if (_eet_kv_layers_find(c->top, names[j])) continue;
+             d = eet_read(c->base->ef, names[j], &size);
+             if (!d) continue;
+             eet_write(ef, names[j], d, size, EET_COMPRESSION_NONE);
+             free(d);
+          }
+        free(names);
+     }
+
+   /* Oldest layer first so the newest value of a key is the one kept. */
+   for (l = c->top; l; l = l->older) n++;
+   stack = (Eet_Kv_Layer **)malloc(n * sizeof (Eet_Kv_Layer *));
+   if (!stack)
+     {
+        eet_close(ef);
+        goto on_done;
+     }
+   for (i = n, l = c->top; l; l = l->older) stack[--i] = l;
+   for (i = 0; i < n; i++)
+     eina_hash_foreach(stack[i]->items, _eet_kv_compact_write_cb, ef);
+   free(stack);
+
+   snprintf(gen, sizeof (gen), "%u", c->generation);
+   eet_write(ef, EET_KV_GENERATION, gen, strlen(gen) + 1, EET_COMPRESSION_NONE);
+   if (eet_close(ef) != EET_ERROR_NONE) goto on_done;
+
+   fd = open(c->tmp, O_RDONLY | O_CLOEXEC);
+   if (fd < 0) goto on_done;
+   if ((fsync(fd)) || (fstat(fd, &st)))
+     {
+        close(fd);
+        goto on_done;
+     }
+   close(fd);
+   c->bytes = st.st_size;
+
+   if ((!rename(c->tmp, c->path)) && (_eet_kv_dir_sync(c->path)))
+     c->ok = EINA_TRUE;
+
+ on_done:
+   __sync_lock_test_and_set(&c->done, 1);
+   return NULL;
+}
+
+static inline Eina_Bool
+_eet_kv_layer_copy_cb(const Eina_Hash *hash EINA_UNUSED, const void *key,
+                      void *data, void *fdata)
+{
+   Eet_Kv_Item *it = (Eet_Kv_Item *)data, *cp;
+   Eet_Kv_Layer *l = (Eet_Kv_Layer *)fdata;
+
+   cp = (Eet_Kv_Item *)malloc(sizeof (Eet_Kv_Item) + it->size);
+   if (!cp) return EINA_FALSE;
+   memcpy(cp, it, sizeof (Eet_Kv_Item) + it->size);
+   free(eina_hash_set(l->items, key, cp));
+   return EINA_TRUE;
+}
+
+/* Merge the layers from head down to, but not including, stop. */
+static inline Eet_Kv_Layer *
+_eet_kv_layer_flatten(Eet_Kv_Layer *head, Eet_Kv_Layer *stop)
+{
+   Eet_Kv_Layer *r, *l, **stack;
+   unsigned int n = 0, i;
+
+   for (l = head; l != stop; l = l->older) n++;
+   stack = (Eet_Kv_Layer **)malloc(n * sizeof (Eet_Kv_Layer *));
+   if (!stack) return NULL;
+   r = _eet_kv_layer_new(NULL);
+   if (!r)
+     {
+        free(stack);
+        return NULL;
+     }
+   for (i = n, l = head; l != stop; l = l->older) stack[--i] = l;
+   for (i = 0; i < n; i++)
+     eina_hash_foreach(stack[i]->items, _eet_kv_layer_copy_cb, r);
+   free(stack);
+   return r;
+}
+
+/* Install a finished compaction, or wait for it if asked to. */
+static inline void
+_eet_kv_compact_check(Eet_Kv *kv, Eina_Bool wait)
+{
+   Eet_Kv_Compaction *c = kv->compaction;
+   Eet_Kv_Base *base = NULL;
+   Eet_Kv_Layer *l;
+   Eina_Bool shared = EINA_FALSE;
+
+   if (!c) return;
+   if ((!wait) && (!__sync_fetch_and_add(&c->done, 0))) return;
+   eina_thread_join(c->thread);
+   kv->compaction = NULL;
+
+   if (c->ok)
+     {
+        base = _eet_kv_base_open(kv->path);
+        if ((base) && ((!base->ef) || (base->generation != c->generation)))
+          {
+             _eet_kv_base_unref(base);
+             base = NULL;
+          }
+     }
+
+   if (base)
+     {
+        /* The new file holds every layer from the top the compaction
+         * saw down, so cut them off the chain. Snapshots may share the
+         * layers above it, those get a flattened copy instead. */
+        for (l = kv->head; (l) && (l != c->top); l = l->older)
+          if (l->refs > 1) shared = EINA_TRUE;
+        if (shared)
+          {
+             l = _eet_kv_layer_flatten(kv->head, c->top);
+             if (l)
+               {
+                  _eet_kv_layer_unref(kv->head);
+                  kv->head = l;
+                  kv->head_frozen = EINA_FALSE;
+               }
+          }
+        else
+          {
+             for (l = kv->head; (l) && (l->older != c->top); l = l->older)
+               ;
+             if (l)
+               {
+                  l->older = NULL;
+                  _eet_kv_layer_unref(c->top);
+               }
+          }
+        _eet_kv_base_unref(kv->base);
+        kv->base = base;
+        if (stat(kv->path, &kv->base_stat))
+          memset(&kv->base_stat, 0, sizeof (kv->base_stat));
+        _eet_kv_wal_unlink_below(kv, c->generation, EINA_TRUE);
+        kv->stats.compactions++;
+        kv->stats.compacted_bytes += c->bytes;
+     }
+   else
+     {
+        unlink(c->tmp);
+        EINA_LOG_ERR("Compaction of '%s' failed, keeping its logs.", kv->path);
+     }
+
+   _eet_kv_layer_unref(c->top);
+   _eet_kv_base_unref(c->base);
+   free(c->tmp);
+   free(c);
+}
+
+static inline Eina_Bool
+_eet_kv_wal_append(Eet_Kv *kv, const char *key,
+                   const void *data, int size, Eina_Bool deleted)
+{
+   unsigned int head[3];
+   struct iovec iov[3];
+   size_t len, off = 0;
+   ssize_t n;
+   int i = 0;
+
+   head[0] = strlen(key);
+   head[1] = deleted ? EET_KV_DELETED : (unsigned int)size;
+   head[2] = _eet_kv_sum(head[0], head[1], key, data);
+   len = sizeof (head) + head[0] + (deleted ? 0 : size);
+
+   while (off < len)
+     {
+        size_t skip = off;
+        int cnt = 0;
+
+        iov[0].iov_base = head;
+        iov[0].iov_len = sizeof (head);
+        iov[1].iov_base = (void *)key;
+        iov[1].iov_len = head[0];
+        iov[2].iov_base = (void *)data;
+        iov[2].iov_len = deleted ? 0 : size;
+        for (i = 0; i < 3; i++)
+          {
+             if (skip >= iov[i].iov_len)
+               {
+                  skip -= iov[i].iov_len;
+                  continue;
+               }
+             iov[cnt].iov_base = (char *)iov[i].iov_base + skip;
+             iov[cnt].iov_len = iov[i].iov_len - skip;
+             skip = 0;
+             cnt++;
+          }
+        n = writev(kv->wal, iov, cnt);
+        if ((n < 0) && (errno == EINTR)) continue;
+        if (n <= 0) break;
+        off += n;
+     }
+
+   if (off < len)
+     {
+        /* Do not leave half a record for the next ones to follow. */
+        if (ftruncate(kv->wal, kv->wal_offset) == 0)
+          lseek(kv->wal, kv->wal_offset, SEEK_SET);
+        return EINA_FALSE;
+     }
+
+   kv->wal_offset += len;
+   kv->stats.wal_bytes += len;
+   kv->stats.wal_size = kv->wal_offset;
+   kv->pending_writes++;
+   kv->pending_bytes += len;
+   if (((kv->sync_writes) && (kv->pending_writes >= kv->sync_writes)) ||
+       ((kv->sync_bytes) && (kv->pending_bytes >= kv->sync_bytes)))
+     eet_kv_sync(kv);
+   return EINA_TRUE;
+}
+
+static inline Eina_Bool
+_eet_kv_log(Eet_Kv *kv, const char *key,
+            const void *data, int size, Eina_Bool deleted)
+{
+   _eet_kv_compact_check(kv, EINA_FALSE);
+   if (!_eet_kv_head_thaw(kv)) return EINA_FALSE;
+   if (!_eet_kv_wal_append(kv, key, data, size, deleted)) return EINA_FALSE;
+   if (!_eet_kv_item_set(kv, key, data, size, deleted))
+     {
+        EINA_LOG_ERR("Logged '%s' but could not keep it in memory.", key);
+        return EINA_FALSE;
+     }
+
+   if ((kv->compact_threshold) && (!kv->compaction) &&
+       ((size_t)kv->wal_offset >= kv->compact_threshold))
+     eet_kv_compact(kv, EINA_FALSE);
+   return EINA_TRUE;
+}
+
+/**
+ * @endcond
+ */
+
+static inline Eet_Kv *
+eet_kv_open(const char *path, Eet_File_Mode mode)
+{
+   Eet_Kv *kv;
+   size_t len;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(path, NULL);
+   EINA_SAFETY_ON_FALSE_RETURN_VAL((mode == EET_FILE_MODE_READ) ||
+                                   (mode == EET_FILE_MODE_READ_WRITE), NULL);
+
+   len = strlen(path);
+   kv = (Eet_Kv *)calloc(1, sizeof (Eet_Kv) + len + 1);
+   if (!kv) return NULL;
+   kv->path = (char *)(kv + 1);
+   memcpy(kv->path, path, len + 1);
+   kv->mode = mode;
+   kv->wal = -1;
+   kv->sync_writes = 1;
+
+   if (!_eet_kv_load(kv)) goto on_error;
+   if (mode == EET_FILE_MODE_READ) return kv;
+
+   if (!_eet_kv_wal_open(kv, kv->wal_generation)) goto on_error;
+   // A compaction of an earlier run may have been renamed in unsynced
+   _eet_kv_wal_unlink_below(kv, kv->base->generation, EINA_FALSE);
+   return kv;
+
+ on_error:
+   _eet_kv_layer_unref(kv->head);
+   _eet_kv_base_unref(kv->base);
+   free(kv);
+   return NULL;
+}
+
+static inline void
+eet_kv_close(Eet_Kv *kv)
+{
+   EINA_SAFETY_ON_NULL_RETURN(kv);
+
+   _eet_kv_compact_check(kv, EINA_TRUE);
+   if (kv->wal >= 0)
+     {
+        if (kv->pending_writes) eet_kv_sync(kv);
+        close(kv->wal);
+     }
+   _eet_kv_layer_unref(kv->head);
+   _eet_kv_base_unref(kv->base);
+   free(kv);
+}
+
+static inline int
+eet_kv_write(Eet_Kv *kv, const char *key, const void *data, int size)
+{
+   EINA_SAFETY_ON_NULL_RETURN_VAL(kv, 0);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(key, 0);
+   EINA_SAFETY_ON_FALSE_RETURN_VAL(kv->wal >= 0, 0);
+   EINA_SAFETY_ON_TRUE_RETURN_VAL((size <= 0) || (!data), 0);
+   EINA_SAFETY_ON_FALSE_RETURN_VAL((key[0]) && (strlen(key) < PATH_MAX), 0);
+
+   if (!_eet_kv_log(kv, key, data, size, EINA_FALSE)) return 0;
+   kv->stats.writes++;
+   kv->stats.bytes += strlen(key) + size;
+   return size;
+}
+
+static inline Eina_Bool
+eet_kv_delete(Eet_Kv *kv, const char *key)
+{
+   EINA_SAFETY_ON_NULL_RETURN_VAL(kv, EINA_FALSE);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(key, EINA_FALSE);
+   EINA_SAFETY_ON_FALSE_RETURN_VAL(kv->wal >= 0, EINA_FALSE);
+   EINA_SAFETY_ON_FALSE_RETURN_VAL((key[0]) && (strlen(key) < PATH_MAX),
+                                   EINA_FALSE);
+
+   if (!_eet_kv_log(kv, key, NULL, 0, EINA_TRUE)) return EINA_FALSE;
+   kv->stats.deletes++;
+   kv->stats.bytes += strlen(key);
+   return EINA_TRUE;
+}
+
+static inline void *
+eet_kv_read(Eet_Kv *kv, const char *key, int *size_ret)
+{
+   if (size_ret) *size_ret = 0;
+   EINA_SAFETY_ON_NULL_RETURN_VAL(kv, NULL);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(key, NULL);
+
+   _eet_kv_compact_check(kv, EINA_FALSE);
+   return _eet_kv_lookup(kv->head, kv->base, key, size_ret);
+}
+
+static inline Eina_Bool
+eet_kv_sync(Eet_Kv *kv)
+{
+   EINA_SAFETY_ON_NULL_RETURN_VAL(kv, EINA_FALSE);
+   EINA_SAFETY_ON_FALSE_RETURN_VAL(kv->wal >= 0, EINA_FALSE);
+
+   if (fdatasync(kv->wal)) return EINA_FALSE;
+   kv->pending_writes = 0;
+   kv->pending_bytes = 0;
+   kv->stats.syncs++;
+   return EINA_TRUE;
+}
+
+static inline void
+eet_kv_sync_policy_set(Eet_Kv *kv, unsigned int max_writes, size_t max_bytes)
+{
+   EINA_SAFETY_ON_NULL_RETURN(kv);
+
+   kv->sync_writes = max_writes;
+   kv->sync_bytes = max_bytes;
+}
+
+static inline Eina_Bool
+eet_kv_compact(Eet_Kv *kv, Eina_Bool wait)
+{
+   Eet_Kv_Compaction *c;
+   Eet_Kv_Layer *l;
+   size_t len;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(kv, EINA_FALSE);
+   EINA_SAFETY_ON_FALSE_RETURN_VAL(kv->wal >= 0, EINA_FALSE);
+
+   if (kv->compaction)
+     {
+        if (wait) _eet_kv_compact_check(kv, EINA_TRUE);
+        return EINA_TRUE;
+     }
+
+   len = strlen(kv->path);
+   c = (Eet_Kv_Compaction *)calloc(1, sizeof (Eet_Kv_Compaction));
+   if (!c) return EINA_FALSE;
+   c->path = kv->path;
+   c->tmp = (char *)malloc(len + sizeof (".compact"));
+   if (!c->tmp) goto on_error;
+   memcpy(c->tmp, kv->path, len);
+   memcpy(c->tmp + len, ".compact", sizeof (".compact"));
+   c->generation = kv->wal_generation + 1;
+
+   /* The current log must be on disk before the next one starts, the
+    * file that replaces both is only renamed in once complete. */
+   if ((kv->pending_writes) && (!eet_kv_sync(kv))) goto on_error;
+   l = _eet_kv_layer_new(kv->head);
+   if (!l) goto on_error;
+   if (!_eet_kv_wal_open(kv, c->generation))
+     {
+        l->older = NULL;
+        _eet_kv_layer_unref(l);
+        goto on_error;
+     }
+
+   c->top = kv->head;
+   c->top->refs++;
+   kv->head = l;
+   kv->head_frozen = EINA_FALSE;
+   c->base = kv->base;
+   c->base->refs++;
+
+   if (!eina_thread_create(&c->thread, EINA_THREAD_BACKGROUND, -1,
+                           _eet_kv_compact_worker, c))
+     {
+        /* Still consistent, the log of the new generation just starts
+         * on top of the old one. */
+        _eet_kv_layer_unref(c->top);
+        _eet_kv_base_unref(c->base);
+        goto on_error;
+     }
+   kv->compaction = c;
+
+   if (wait) _eet_kv_compact_check(kv, EINA_TRUE);
+   return EINA_TRUE;
+
+ on_error:
+   free(c->tmp);
+   free(c);
+   return EINA_FALSE;
+}
+
+static inline void
+eet_kv_compact_threshold_set(Eet_Kv *kv, size_t wal_size)
+{
+   EINA_SAFETY_ON_NULL_RETURN(kv);
+
+   kv->compact_threshold = wal_size;
+}
+
+static inline Eina_Bool
+eet_kv_refresh(Eet_Kv *kv)
+{
+   struct stat st;
+   off_t offset;
+   Eina_Bool changed = EINA_FALSE;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(kv, EINA_FALSE);
+   EINA_SAFETY_ON_FALSE_RETURN_VAL(kv->mode == EET_FILE_MODE_READ, EINA_FALSE);
+
+   if (stat(kv->path, &st)) memset(&st, 0, sizeof (st));
+   if ((st.st_ino != kv->base_stat.st_ino) ||
+       (st.st_dev != kv->base_stat.st_dev) ||
+       (st.st_size != kv->base_stat.st_size) ||
+       (st.st_mtime != kv->base_stat.st_mtime))
+     return _eet_kv_load(kv);
+
+   offset = _eet_kv_replay(kv, kv->wal_generation, kv->wal_offset);
+   if (offset > kv->wal_offset)
+     {
+        kv->wal_offset = offset;
+        changed = EINA_TRUE;
+     }
+   while ((offset = _eet_kv_replay(kv, kv->wal_generation + 1, 0)) >= 0)
+     {
+        kv->wal_generation++;
+        kv->wal_offset = offset;
+        changed = EINA_TRUE;
+     }
+   return changed;
+}
+
+static inline Eet_Kv_Snapshot *
+eet_kv_snapshot_new(Eet_Kv *kv)
+{
+   Eet_Kv_Snapshot *snap;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(kv, NULL);
+
+   _eet_kv_compact_check(kv, EINA_FALSE);
+   snap = (Eet_Kv_Snapshot *)malloc(sizeof (Eet_Kv_Snapshot));
+   if (!snap) return NULL;
+   snap->base = kv->base;
+   snap->base->refs++;
+   snap->head = kv->head;
+   snap->head->refs++;
+   kv->head_frozen = EINA_TRUE;
+   return snap;
+}
+
+static inline void *
+eet_kv_snapshot_read(Eet_Kv_Snapshot *snap, const char *key, int *size_ret)
+{
+   if (size_ret) *size_ret = 0;
+   EINA_SAFETY_ON_NULL_RETURN_VAL(snap, NULL);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(key, NULL);
+
+   return _eet_kv_lookup(snap->head, snap->base, key, size_ret);
+}
+
+static inline void
+eet_kv_snapshot_free(Eet_Kv_Snapshot *snap)
+{
+   EINA_SAFETY_ON_NULL_RETURN(snap);
+
+   _eet_kv_layer_unref(snap->head);
+   _eet_kv_base_unref(snap->base);
+   free(snap);
+}
+
+static inline void
+eet_kv_stats_get(const Eet_Kv *kv, Eet_Kv_Stats *stats)
+{
+   EINA_SAFETY_ON_NULL_RETURN(kv);
+   EINA_SAFETY_ON_NULL_RETURN(stats);
+
+   *stats = kv->stats;
+}
+
+#endif
@@ -0,0 +1,185 @@
+/* EET - E file chunk reading/writing library
+ * Copyright (C) 2016 Samsung Electronics Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library;
+ * if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EET_INLINE_PACK_X_
+#define EET_INLINE_PACK_X_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/**
+ * @cond LOCAL
+ */
+
+/* Writes the entries of src into dst, returns EINA_FALSE on the first
+ * one that cannot be read or written. */
+static inline Eina_Bool
+_eet_file_direct_pack_copy(Eet_File *src, Eet_File *dst)
+{
+   Eet_Write_Entry *raw = NULL;
+   char **names;
+   unsigned int nraw = 0, i;
+   Eina_Bool ret = EINA_FALSE;
+   int count = 0, n;
+
+   names = eet_list(src, "*", &count);
+   if (!names) return count == 0;
+
+   raw = (Eet_Write_Entry *)calloc(count, sizeof (Eet_Write_Entry));
+   if (!raw) goto end;
+
+   for (n = 0; n < count; n++)
+     {
+        const char *alias;
+        const void *data;
+        Eet_Node *node;
+        int size;
+
+        alias = eet_alias_get(src, names[n]);
+        if (alias)
+          {
+             if (!eet_alias(dst, names[n], alias, 0)) goto end;
+             continue;
+          }
+
+        node = eet_data_node_read_cipher(src, names[n], NULL);
+        if (node)
+          {
+             size = eet_data_node_write_cipher(dst, names[n], NULL, node, 0);
+             eet_node_del(node);
+             if (size <= 0) goto end;
+             continue;
+          }
+
+        raw[nraw].name = names[n];
+        raw[nraw].cipher_key = NULL;
+        data = eet_read_direct(src, names[n], &size);
+        if (data)
+          raw[nraw].compress = EET_COMPRESSION_NONE;
+        else
+          {
+             data = eet_read(src, names[n], &size);
+             if (!data) goto end;
+             raw[nraw].compress = EET_COMPRESSION_DEFAULT;
+          }
+        raw[nraw].data = data;
+        raw[nraw].size = size;
+        nraw++;
+        /* Images and raw blobs do not decode as nodes and are copied
+         * as is. Data descriptor encodings start with the chunk magic
+         * and their strings index the source dictionary: one that did
+         * not decode cannot be copied. */
+        if ((size >= 4) && (!memcmp(data, "CHnK", 4))) goto end;
+     }
+
+   ret = eet_write_batch(dst, raw, nraw) == nraw;
+
+ end:
+   if (raw)
+     {
+        for (i = 0; i < nraw; i++)
+          if (raw[i].compress != EET_COMPRESSION_NONE)
+            free((void *)raw[i].data);
+        free(raw);
+     }
+   free(names);
+   return ret;
+}
+
+/**
+ * @endcond
+ */
+
+static inline Eina_Bool
+eet_file_direct_pack(const char *file,
+                     const char *out)
+{
+   Eet_File *src, *dst;
+   Eet_Error err;
+   Eina_Bool ret;
+   struct stat st;
+   char *tmp;
+   size_t len;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(file, EINA_FALSE);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(out, EINA_FALSE);
+
+   len = strlen(out) + 32;
+   tmp = (char *)malloc(len);
+   if (!tmp) return EINA_FALSE;
+   snprintf(tmp, len, "%s.%u.tmp", out, (unsigned int)getpid());
+
+   src = eet_open(file, EET_FILE_MODE_READ);
+   if (!src) goto on_error;
+   dst = eet_open(tmp, EET_FILE_MODE_WRITE);
+   if (!dst)
+     {
+        eet_close(src);
+        goto on_error;
+     }
+
+   ret = _eet_file_direct_pack_copy(src, dst);
+   err = eet_close(dst);
+   eet_close(src);
+   if (!ret || err != EET_ERROR_NONE) goto on_unlink;
+
+   /* The new file gets the mode of the one it replaces, or of its
+    * source, not the one of a file eet creates. */
+   if ((stat(out, &st) == 0) || (stat(file, &st) == 0))
+     {
+        if (chmod(tmp, st.st_mode & 07777)) goto on_unlink;
+     }
+   if (rename(tmp, out)) goto on_unlink;
+   free(tmp);
+   return EINA_TRUE;
+
+ on_unlink:
+   unlink(tmp);
+ on_error:
+   free(tmp);
+   return EINA_FALSE;
+}
+
+static inline Eina_Bool
+eet_file_direct_get(Eet_File *ef,
+                    const char *glob)
+{
+   char **names;
+   int count = 0, size, n;
+   Eina_Bool ret;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(ef, EINA_FALSE);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(glob, EINA_FALSE);
+
+   names = eet_list(ef, glob, &count);
+   if (!names) return EINA_FALSE;
+
+   ret = count > 0;
+   for (n = 0; n < count && ret; n++)
+     {
+        if (eet_alias_get(ef, names[n])) continue;
+        if (!eet_read_direct(ef, names[n], &size)) ret = EINA_FALSE;
+     }
+   free(names);
+   return ret;
+}
+
+#endif
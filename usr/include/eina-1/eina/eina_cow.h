@@ -162,6 +162,196 @@ EAPI void eina_cow_memcpy(Eina_Cow *cow,
  */
 EAPI Eina_Bool eina_cow_gc(Eina_Cow *cow);
 
+/**
+ * @typedef Eina_Cow_Stats
+ * Counters of an Eina_Cow pool, see eina_cow_stats_enable().
+ */
+typedef struct _Eina_Cow_Stats Eina_Cow_Stats;
+
+/**
+ * @struct _Eina_Cow_Stats
+ * Counters of an Eina_Cow pool.
+ *
+ * The write counters are updated by EINA_COW_WRITE_BEGIN(),
+ * eina_cow_write_array() and eina_cow_gc_budget(), direct calls to
+ * eina_cow_write() and eina_cow_gc() are not seen. The sharing fields are
+ * only updated by eina_cow_stats_sharing_scan().
+ */
+struct _Eina_Cow_Stats
+{
+   unsigned long long writes; /**< Writable pointers requested */
+   unsigned long long copies; /**< Writes that had to copy a shared or default instance */
+   unsigned long long bytes_copied; /**< Bytes copied by those writes */
+   unsigned long long shares; /**< Writes avoided by eina_cow_write_array() by sharing a result */
+   unsigned long long gc_steps; /**< Entries handled by eina_cow_gc_budget() */
+   double gc_time; /**< Seconds spent in eina_cow_gc_budget() */
+
+   unsigned int refs; /**< References seen by the last scan */
+   unsigned int instances; /**< Distinct instances among them, the default one included */
+   unsigned int shared; /**< Instances referenced more than once */
+   unsigned int privates; /**< Instances referenced only once */
+   unsigned long long bytes_saved; /**< Bytes not allocated thanks to sharing */
+};
+
+/**
+ * @typedef Eina_Cow_Write_Cb
+ * Callback updating one writable instance in eina_cow_write_array().
+ *
+ * @param data The data given to eina_cow_write_array().
+ * @param index The index of the reference being updated.
+ * @param write The writable pointer.
+ */
+typedef void (*Eina_Cow_Write_Cb)(void *data, unsigned int index, void *write);
+
+/**
+ * @typedef Eina_Cow_Gc_Budget
+ * Pools to collect from an idle callback, see eina_cow_gc_budget_cb().
+ */
+typedef struct _Eina_Cow_Gc_Budget Eina_Cow_Gc_Budget;
+
+/**
+ * @struct _Eina_Cow_Gc_Budget
+ * Pools to collect from an idle callback.
+ */
+struct _Eina_Cow_Gc_Budget
+{
+   Eina_Cow **cows; /**< The pools to collect */
+   unsigned int count; /**< How many pools are in @c cows */
+   unsigned int next; /**< The pool to start with on the next call, private */
+   double budget; /**< Seconds that can be spent per call */
+};
+
+/**
+ * @brief Start counting the activity of an Eina_Cow pool.
+ *
+ * @param cow The pool.
+ * @param struct_size The size given to eina_cow_add() for this pool.
+ * @return #EINA_TRUE on success, #EINA_FALSE on allocation failure.
+ *
+ * The counters are kept until eina_cow_stats_disable() is called, which
+ * must be done before eina_cow_del(). Like the rest of Eina_Cow, this is
+ * not thread safe.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool eina_cow_stats_enable(Eina_Cow *cow, unsigned int struct_size);
+
+/**
+ * @brief Stop counting the activity of an Eina_Cow pool.
+ *
+ * @param cow The pool.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline void eina_cow_stats_disable(Eina_Cow *cow);
+
+/**
+ * @brief Get the counters of an Eina_Cow pool.
+ *
+ * @param cow The pool.
+ * @param stats Where to copy the counters.
+ * @return #EINA_TRUE on success, #EINA_FALSE if eina_cow_stats_enable()
+ *         was not called.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool eina_cow_stats_get(const Eina_Cow *cow, Eina_Cow_Stats *stats);
+
+/**
+ * @brief Reset the counters of an Eina_Cow pool to zero.
+ *
+ * @param cow The pool.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline void eina_cow_stats_reset(Eina_Cow *cow);
+
+/**
+ * @brief Count how the instances of an Eina_Cow pool are shared.
+ *
+ * @param cow The pool, eina_cow_stats_enable() must have been called.
+ * @param refs The read only pointers held by the users of the pool.
+ * @param count How many pointers are in @p refs.
+ * @return #EINA_TRUE on success, #EINA_FALSE on failure.
+ *
+ * The pool does not expose its reference counts, so the caller gives all
+ * the pointers it holds, Evas for example the state of each object. This
+ * fills the sharing fields of #Eina_Cow_Stats, counting every reference to
+ * an instance after the first one as one structure not allocated.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool eina_cow_stats_sharing_scan(Eina_Cow *cow, const Eina_Cow_Data * const *refs, unsigned int count);
+
+/**
+ * @brief Update many instances of an Eina_Cow pool in one pass.
+ *
+ * @param cow The pool the pointers come from.
+ * @param refs The addresses of the read only pointers to update.
+ * @param count How many addresses are in @p refs.
+ * @param cb Called with a writable pointer for each reference.
+ * @param data Passed to @p cb.
+ * @param same_change #EINA_TRUE if @p cb makes the same change to every
+ *        instance, whatever its index.
+ * @param needed_gc Does this pool need to be garbage collected?
+ *
+ * This is EINA_COW_WRITE_BEGIN() and EINA_COW_WRITE_END() around @p cb for
+ * each reference. When @p same_change is set, references that pointed to
+ * the same instance are only written once: the first one is copied and
+ * updated, the others are made to share the result with eina_cow_memcpy().
+ * Updating many objects still on the default state then allocates one
+ * instance instead of one per object.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline void eina_cow_write_array(Eina_Cow *cow, const Eina_Cow_Data **refs[], unsigned int count, Eina_Cow_Write_Cb cb, void *data, Eina_Bool same_change, Eina_Bool needed_gc);
+
+/**
+ * @brief Run the garbage collector of an Eina_Cow pool for a given time.
+ *
+ * @param cow The pool to compact.
+ * @param budget How many seconds can be spent, 0 for a single step.
+ * @return #EINA_TRUE if entries are left to collect, #EINA_FALSE otherwise.
+ *
+ * Every eina_cow_gc() call handles a single entry. This calls it until
+ * nothing is left or the budget is spent, so the collection can be spread
+ * over several main loop iterations.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool eina_cow_gc_budget(Eina_Cow *cow, double budget);
+
+/**
+ * @brief Run the garbage collector of several pools for a given time.
+ *
+ * @param data An #Eina_Cow_Gc_Budget.
+ * @return Always #EINA_TRUE.
+ *
+ * The budget is shared by the pools, starting with the pool that ran out
+ * of time on the previous call. The prototype
+ * matches Ecore_Task_Cb, so it can be given to ecore_idle_enterer_add()
+ * and stays registered until deleted.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool eina_cow_gc_budget_cb(void *data);
+
 /**
  * @def EINA_COW_WRITE_BEGIN
  * @brief This macro setup a writable pointer from a const one.
@@ -179,7 +369,7 @@ EAPI Eina_Bool eina_cow_gc(Eina_Cow *cow);
     {									\
       Write_Type *Write;						\
       									\
-      Write = eina_cow_write(Cow, ((const Eina_Cow_Data**)&(Read)));
+      Write = _eina_cow_stats_write(Cow, ((const Eina_Cow_Data**)&(Read)));
 
 /**
  * @def EINA_COW_WRITE_END
@@ -197,6 +387,8 @@ EAPI Eina_Bool eina_cow_gc(Eina_Cow *cow);
     }									\
   while (0);
 
+#include "eina_inline_cow.x"
+
 /**
  * @}
  */
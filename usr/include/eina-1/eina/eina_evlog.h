@@ -156,7 +156,156 @@ eina_evlog_start(void);
 EAPI void
 eina_evlog_stop(void);
 
+/**
+ * @typedef Eina_Evlog_Ring
+ * A per-thread ring keeping the most recent events, see
+ * eina_evlog_ring_enable().
+ */
+typedef struct _Eina_Evlog_Ring Eina_Evlog_Ring;
+
+/**
+ * @brief Turn on the always-on ring event log
+ *
+ * Unlike eina_evlog(), which appends to a growing buffer that has to be
+ * stolen regularly, eina_evlog_ring() overwrites the oldest event of a
+ * fixed size ring owned by the calling thread. Recording takes no lock
+ * and allocates nothing once the thread has its ring, so it can be left
+ * on in production and read only when something went wrong, with
+ * eina_evlog_ring_dump() or a signal set by
+ * eina_evlog_ring_dump_signal_set().
+ *
+ * Rings of threads that exit are kept with their events and handed over
+ * to the next new thread, so memory stays bounded by the peak number of
+ * threads.
+ *
+ * This should be called before the threads that log are created and the
+ * size can not be changed afterwards.
+ *
+ * @param items How many events each thread keeps, rounded up to a power
+ *        of two. 0 selects 8192.
+ * @param window Only events of the last @p window seconds are dumped, 0
+ *        dumps whatever is still in the rings.
+ * @return EINA_TRUE on success, EINA_FALSE if already enabled with a
+ *         different size or on allocation failure.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool
+eina_evlog_ring_enable(unsigned int items, double window);
+
+/**
+ * @brief Pause the ring event log
+ *
+ * eina_evlog_ring() becomes a NOOP again, recorded events stay available
+ * for dumping.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline void
+eina_evlog_ring_disable(void);
+
+/**
+ * @brief Log an event in the ring of the calling thread
+ *
+ * The @p event string has the same format as for eina_evlog() and, as it
+ * is only referenced, must stay valid for the whole process life (a string
+ * literal). The @p detail string is copied, truncated to a few dozens of
+ * bytes.
+ *
+ * @param event The event string - see eina_evlog()
+ * @param obj An optional object "pointer" to associate
+ * @param detail An optional event detail string with more info
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline void
+eina_evlog_ring(const char *event, const void *obj, const char *detail);
+
+/**
+ * @brief Import the events logged by EFL through eina_evlog()
+ *
+ * The EFL libraries already log the main loop (wake ups, timers, idlers,
+ * fd handlers, animators, events) and the Evas render stages through
+ * eina_evlog(). While eina_evlog() is on (see eina_evlog_start(), this
+ * function does not change it), every call steals the buffer it filled and
+ * replays the events into rings of their own, one per source thread, so
+ * they are dumped together with the events from eina_evlog_ring(). Event
+ * names are copied into the rings. Call it regularly from a single thread,
+ * for instance from a timer of the main loop.
+ *
+ * @return How many events were imported.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline unsigned int
+eina_evlog_ring_import(void);
+
+/**
+ * @brief Write the content of the rings as Chrome trace JSON
+ *
+ * The output can be loaded in chrome://tracing or in the Perfetto UI.
+ * Begin ("+") and end ("-") events become duration events, states (">"
+ * and "<") become async events and everything else instant events.
+ *
+ * The rings keep recording while they are dumped, events overwritten in
+ * the meantime are skipped. This function only uses async-signal-safe
+ * calls, so it can be called from a signal handler.
+ *
+ * @param fd The file descriptor to write to.
+ * @return EINA_TRUE on success, EINA_FALSE on write error.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool
+eina_evlog_ring_dump_fd(int fd);
+
+/**
+ * @brief Write the content of the rings as Chrome trace JSON to a file
+ *
+ * @param path The file to create or truncate.
+ * @return EINA_TRUE on success, EINA_FALSE on error.
+ *
+ * @see eina_evlog_ring_dump_fd()
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool
+eina_evlog_ring_dump(const char *path);
+
+/**
+ * @brief Dump the rings to a file whenever a signal is received
+ *
+ * Typically used with SIGUSR2, so the last seconds before a jank can be
+ * captured from outside with kill(1).
+ *
+ * @param sig The signal number, e.g. SIGUSR2.
+ * @param path The file to write to, each dump overwrites the previous.
+ * @return EINA_TRUE on success, EINA_FALSE if the handler could not be
+ *         installed.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool
+eina_evlog_ring_dump_signal_set(int sig, const char *path);
+
 /**
  * @}
  */
+
+#include "eina_inline_evlog.x"
+
 #endif
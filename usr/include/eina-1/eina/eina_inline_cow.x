@@ -0,0 +1,333 @@
+/* EINA - EFL data type library
+ * Copyright (C) 2016 Samsung Electronics Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library;
+ * if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EINA_INLINE_COW_X_
+#define EINA_INLINE_COW_X_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "eina_types.h"
+#include "eina_safety_checks.h"
+
+/**
+ * @cond LOCAL
+ */
+
+/* The pools are shared by the whole process while this code is compiled
+ * in every user, let the linker merge the registries. */
+#define EINA_COW_STATS_SHARED __attribute__ ((weak))
+
+typedef struct _Eina_Cow_Stats_Entry Eina_Cow_Stats_Entry;
+typedef struct _Eina_Cow_Write_Memo Eina_Cow_Write_Memo;
+
+struct _Eina_Cow_Stats_Entry
+{
+   const Eina_Cow *cow;
+   unsigned int struct_size;
+   Eina_Cow_Stats stats;
+};
+
+struct _Eina_Cow_Write_Memo
+{
+   const Eina_Cow_Data *key; // instance before the write
+   const Eina_Cow_Data *result; // instance after it
+};
+
+EINA_COW_STATS_SHARED Eina_Cow_Stats_Entry *_eina_cow_stats_entries = NULL;
+EINA_COW_STATS_SHARED unsigned int _eina_cow_stats_count = 0;
+
+static inline double
+_eina_cow_time(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+static inline Eina_Cow_Stats_Entry *
+_eina_cow_stats_find(const Eina_Cow *cow)
+{
+   unsigned int i;
+
+   for (i = 0; i < _eina_cow_stats_count; i++)
+     if (_eina_cow_stats_entries[i].cow == cow)
+       return _eina_cow_stats_entries + i;
+   return NULL;
+}
+
+static inline void *
+_eina_cow_stats_write(Eina_Cow *cow, const Eina_Cow_Data * const *src)
+{
+   Eina_Cow_Stats_Entry *e;
+   const Eina_Cow_Data *old;
+   void *w;
+
+   // Keep the common case a single test when nobody is counting
+   if (!_eina_cow_stats_count) return eina_cow_write(cow, src);
+
+   old = *src;
+   w = eina_cow_write(cow, src);
+   e = _eina_cow_stats_find(cow);
+   if (e && w)
+     {
+        e->stats.writes++;
+        // A private instance is handed back as is, anything else is copied
+        if (w != old)
+          {
+             e->stats.copies++;
+             e->stats.bytes_copied += e->struct_size;
+          }
+     }
+   return w;
+}
+
+static inline int
+_eina_cow_stats_ptr_cmp(const void *a, const void *b)
+{
+   uintptr_t pa = (uintptr_t)*(const Eina_Cow_Data * const *)a;
+   uintptr_t pb = (uintptr_t)*(const Eina_Cow_Data * const *)b;
+
+   return (pa > pb) - (pa < pb);
+}
+/**
+ * @endcond
+ */
+
+static inline Eina_Bool
+eina_cow_stats_enable(Eina_Cow *cow, unsigned int struct_size)
+{
+   Eina_Cow_Stats_Entry *entries;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(cow, EINA_FALSE);
+
+   if (_eina_cow_stats_find(cow)) return EINA_TRUE;
+
+   entries = (Eina_Cow_Stats_Entry *)realloc(_eina_cow_stats_entries,
+                     (_eina_cow_stats_count + 1) * sizeof (Eina_Cow_Stats_Entry));
+   if (!entries) return EINA_FALSE;
+   _eina_cow_stats_entries = entries;
+
+   entries += _eina_cow_stats_count;
+   memset(entries, 0, sizeof (Eina_Cow_Stats_Entry));
+   entries->cow = cow;
+   entries->struct_size = struct_size;
+   _eina_cow_stats_count++;
+   return EINA_TRUE;
+}
+
+static inline void
+eina_cow_stats_disable(Eina_Cow *cow)
+{
+   Eina_Cow_Stats_Entry *e;
+
+   e = _eina_cow_stats_find(cow);
+   if (!e) return;
+
+   *e = _eina_cow_stats_entries[--_eina_cow_stats_count];
+   if (!_eina_cow_stats_count)
+     {
+        free(_eina_cow_stats_entries);
+        _eina_cow_stats_entries = NULL;
+     }
+}
+
+static inline Eina_Bool
+eina_cow_stats_get(const Eina_Cow *cow, Eina_Cow_Stats *stats)
+{
+   Eina_Cow_Stats_Entry *e;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(stats, EINA_FALSE);
+
+   e = _eina_cow_stats_find(cow);
+   if (!e) return EINA_FALSE;
+   *stats = e->stats;
+   return EINA_TRUE;
+}
+
+static inline void
+eina_cow_stats_reset(Eina_Cow *cow)
+{
+   Eina_Cow_Stats_Entry *e;
+
+   e = _eina_cow_stats_find(cow);
+   if (e) memset(&e->stats, 0, sizeof (Eina_Cow_Stats));
+}
+
+static inline Eina_Bool
+eina_cow_stats_sharing_scan(Eina_Cow *cow, const Eina_Cow_Data * const *refs, unsigned int count)
+{
+   Eina_Cow_Stats_Entry *e;
+   const Eina_Cow_Data **sorted;
+   unsigned int i, run;
+
+   e = _eina_cow_stats_find(cow);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(e, EINA_FALSE);
+
+   e->stats.refs = count;
+   e->stats.instances = 0;
+   e->stats.shared = 0;
+   e->stats.privates = 0;
+   e->stats.bytes_saved = 0;
+   if (!count) return EINA_TRUE;
+   EINA_SAFETY_ON_NULL_RETURN_VAL(refs, EINA_FALSE);
+
+   sorted = (const Eina_Cow_Data **)malloc(count * sizeof (const Eina_Cow_Data *));
+   if (!sorted) return EINA_FALSE;
+   memcpy(sorted, refs, count * sizeof (const Eina_Cow_Data *));
+   qsort(sorted, count, sizeof (const Eina_Cow_Data *), _eina_cow_stats_ptr_cmp);
+
+   for (i = 0; i < count; i += run)
+     {
+        for (run = 1; i + run < count && sorted[i + run] == sorted[i]; run++)
+          ;
+        e->stats.instances++;
+        if (run > 1) e->stats.shared++;
+        else e->stats.privates++;
+     }
+   e->stats.bytes_saved = (unsigned long long)(count - e->stats.instances) * e->struct_size;
+
+   free(sorted);
+   return EINA_TRUE;
+}
+
+static inline void
+eina_cow_write_array(Eina_Cow *cow, const Eina_Cow_Data **refs[], unsigned int count,
+                     Eina_Cow_Write_Cb cb, void *data,
+                     Eina_Bool same_change, Eina_Bool needed_gc)
+{
+   Eina_Cow_Write_Memo *memo = NULL;
+   unsigned int mask = 0;
+   unsigned int i;
+
+   EINA_SAFETY_ON_NULL_RETURN(cb);
+   if (!count) return;
+   EINA_SAFETY_ON_NULL_RETURN(refs);
+
+   if (same_change && count > 1)
+     {
+        unsigned int size = 16;
+
+        while (size < count * 2) size <<= 1;
+        memo = (Eina_Cow_Write_Memo *)calloc(size, sizeof (Eina_Cow_Write_Memo));
+        // Without the table every reference is simply written on its own
+        if (memo) mask = size - 1;
+     }
+   for (i = 0; i < count; i++)
+     {
+        const Eina_Cow_Data *old = *refs[i];
+        unsigned int h = 0;
+        void *w;
+
+        if (memo)
+          {
+             h = (unsigned int)(((uintptr_t)old >> 4) * 2654435761u) & mask;
+             while (memo[h].key && memo[h].key != old)
+               h = (h + 1) & mask;
+             if (memo[h].key)
+               {
+                  Eina_Cow_Stats_Entry *e;
+
+                  eina_cow_memcpy(cow, refs[i], memo[h].result);
+                  e = _eina_cow_stats_count ? _eina_cow_stats_find(cow) : NULL;
+                  if (e) e->stats.shares++;
+                  continue;
+               }
+          }
+
+        w = _eina_cow_stats_write(cow, refs[i]);
+        if (!w) continue;
+        cb(data, i, w);
+        eina_cow_done(cow, refs[i], w, needed_gc);
+
+        if (memo)
+          {
+             memo[h].key = old;
+             memo[h].result = *refs[i];
+          }
+     }
+
+   free(memo);
+}
+
+static inline Eina_Bool
+eina_cow_gc_budget(Eina_Cow *cow, double budget)
+{
+   Eina_Cow_Stats_Entry *e;
+   unsigned long long steps = 0;
+   double start, now;
+   Eina_Bool more;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(cow, EINA_FALSE);
+
+   start = now = _eina_cow_time();
+   while ((more = eina_cow_gc(cow)))
+     {
+        steps++;
+        if (budget <= 0.0) break;
+        now = _eina_cow_time();
+        if (now - start >= budget) break;
+     }
+
+   e = _eina_cow_stats_count ? _eina_cow_stats_find(cow) : NULL;
+   if (e)
+     {
+        if (budget <= 0.0 || !more) now = _eina_cow_time();
+        e->stats.gc_steps += steps;
+        e->stats.gc_time += now - start;
+     }
+   return more;
+}
+
+static inline Eina_Bool
+eina_cow_gc_budget_cb(void *data)
+{
+   Eina_Cow_Gc_Budget *b = (Eina_Cow_Gc_Budget *)data;
+   double end, left;
+   unsigned int n, i;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(b, EINA_TRUE);
+   if (!b->count || !b->cows) return EINA_TRUE;
+
+   end = _eina_cow_time() + b->budget;
+   for (n = 0; n < b->count; n++)
+     {
+        i = (b->next + n) % b->count;
+        left = end - _eina_cow_time();
+        // The first pool always gets a step, so a tiny budget still progresses
+        if (n && left <= 0.0)
+          {
+             b->next = i;
+             return EINA_TRUE;
+          }
+        if (eina_cow_gc_budget(b->cows[i], left > 0.0 ? left : 0.0))
+          {
+             b->next = i;
+             return EINA_TRUE;
+          }
+     }
+   b->next = 0;
+   return EINA_TRUE;
+}
+
+#undef EINA_COW_STATS_SHARED
+
+#endif
@@ -0,0 +1,478 @@
+/* EINA - EFL data type library
+ * Copyright (C) 2016 Samsung Electronics Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library;
+ * if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EINA_INLINE_EVLOG_X_
+#define EINA_INLINE_EVLOG_X_
+
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "eina_types.h"
+#include "eina_thread.h"
+
+/**
+ * @cond LOCAL
+ */
+
+/* The ring registry has to be unique in the process while this code is
+ * compiled in every user, let the linker merge the copies. */
+#define EINA_EVLOG_RING_SHARED __attribute__ ((weak))
+
+#define EINA_EVLOG_RING_DETAIL_SIZE 32
+#define EINA_EVLOG_RING_EVENT_SIZE 48
+
+typedef struct _Eina_Evlog_Ring_Item Eina_Evlog_Ring_Item;
+typedef struct _Eina_Evlog_Ring_Registry Eina_Evlog_Ring_Registry;
+
+struct _Eina_Evlog_Ring_Item
+{
+   double tim;
+   unsigned long long thread; // rings outlive their threads
+   const char *event; // static string, or a slot of the ring's names
+   const void *obj;
+   char detail[EINA_EVLOG_RING_DETAIL_SIZE];
+};
+
+struct _Eina_Evlog_Ring
+{
+   Eina_Evlog_Ring *next; // registry list, rings are never unlinked
+   Eina_Evlog_Ring_Item *items;
+   char (*names)[EINA_EVLOG_RING_EVENT_SIZE]; // event copies, imported only
+   unsigned int mask;
+   unsigned int head; // how many events were ever written
+   unsigned long long thread;
+   int owned; // a live thread writes to it
+   Eina_Bool imported : 1; // filled by eina_evlog_ring_import()
+};
+
+struct _Eina_Evlog_Ring_Registry
+{
+   Eina_Evlog_Ring *rings;
+   unsigned int size;
+   double window;
+   int enabled;
+   Eina_Bool key_set : 1;
+   pthread_key_t key;
+   char signal_path[PATH_MAX];
+};
+
+EINA_EVLOG_RING_SHARED Eina_Evlog_Ring_Registry _eina_evlog_ring_registry;
+EINA_EVLOG_RING_SHARED __thread Eina_Evlog_Ring *_eina_evlog_ring_self;
+
+/**
+ * @endcond
+ */
+
+static inline double
+_eina_evlog_ring_time(void)
+{
+   struct timespec t;
+
+   clock_gettime(CLOCK_MONOTONIC, &t);
+   return (double)t.tv_sec + (((double)t.tv_nsec) / 1000000000.0);
+}
+
+static inline void
+_eina_evlog_ring_thread_exit(void *data)
+{
+   Eina_Evlog_Ring *r = (Eina_Evlog_Ring *)data;
+
+   /* keep the events around, the next new thread takes the ring over */
+   __atomic_store_n(&r->owned, 0, __ATOMIC_RELEASE);
+}
+
+static inline Eina_Evlog_Ring *
+_eina_evlog_ring_new(unsigned long long thread, int owned, Eina_Bool imported)
+{
+   Eina_Evlog_Ring_Registry *reg = &_eina_evlog_ring_registry;
+   Eina_Evlog_Ring *r;
+
+   r = (Eina_Evlog_Ring *)calloc(1, sizeof (Eina_Evlog_Ring));
+   if (!r) return NULL;
+   r->items = (Eina_Evlog_Ring_Item *)calloc(reg->size, sizeof (Eina_Evlog_Ring_Item));
+   if (imported)
+     r->names = (char (*)[EINA_EVLOG_RING_EVENT_SIZE])calloc(reg->size, EINA_EVLOG_RING_EVENT_SIZE);
+   if ((!r->items) || ((imported) && (!r->names)))
+     {
+        free(r->items);
+        free(r);
+        return NULL;
+     }
+   r->mask = reg->size - 1;
+   r->thread = thread;
+   r->owned = owned;
+   r->imported = !!imported;
+
+   r->next = __atomic_load_n(&reg->rings, __ATOMIC_ACQUIRE);
+   while (!__atomic_compare_exchange_n(&reg->rings, &r->next, r, EINA_TRUE,
+                                       __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+     ;
+   return r;
+}
+
+static inline Eina_Evlog_Ring *
+_eina_evlog_ring_attach(void)
+{
+   Eina_Evlog_Ring_Registry *reg = &_eina_evlog_ring_registry;
+   unsigned long long self = (unsigned long long)eina_thread_self();
+   Eina_Evlog_Ring *r;
+
+   for (r = __atomic_load_n(&reg->rings, __ATOMIC_ACQUIRE); r; r = r->next)
+     {
+        int expected = 0;
+
+        if (r->imported) continue;
+        if (__atomic_compare_exchange_n(&r->owned, &expected, 1, EINA_FALSE,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+          {
+             r->thread = self;
+             break;
+          }
+     }
+
+   if (!r) r = _eina_evlog_ring_new(self, 1, EINA_FALSE);
+   if (!r) return NULL;
+
+   if (reg->key_set) pthread_setspecific(reg->key, r);
+   _eina_evlog_ring_self = r;
+   return r;
+}
+
+static inline void
+_eina_evlog_ring_push(Eina_Evlog_Ring *r, double tim, const char *event, const void *obj, const char *detail)
+{
+   unsigned int h = r->head;
+   Eina_Evlog_Ring_Item *it = &r->items[h & r->mask];
+
+   it->tim = tim;
+   it->thread = r->thread;
+   it->event = event;
+   it->obj = obj;
+   if (detail)
+     {
+        strncpy(it->detail, detail, EINA_EVLOG_RING_DETAIL_SIZE - 1);
+        it->detail[EINA_EVLOG_RING_DETAIL_SIZE - 1] = '\0';
+     }
+   else
+     it->detail[0] = '\0';
+   __atomic_store_n(&r->head, h + 1, __ATOMIC_RELEASE);
+}
+
+static inline Eina_Bool
+eina_evlog_ring_enable(unsigned int items, double window)
+{
+   Eina_Evlog_Ring_Registry *reg = &_eina_evlog_ring_registry;
+   unsigned int size = 1;
+
+   if (!items) items = 8192;
+   while (size < items) size <<= 1;
+
+   if (reg->size && (reg->size != size)) return EINA_FALSE;
+   if (!reg->key_set)
+     {
+        if (pthread_key_create(&reg->key, _eina_evlog_ring_thread_exit))
+          return EINA_FALSE;
+        reg->key_set = EINA_TRUE;
+     }
+
+   reg->size = size;
+   reg->window = window;
+   __atomic_store_n(&reg->enabled, 1, __ATOMIC_RELEASE);
+   return EINA_TRUE;
+}
+
+static inline void
+eina_evlog_ring_disable(void)
+{
+   __atomic_store_n(&_eina_evlog_ring_registry.enabled, 0, __ATOMIC_RELEASE);
+}
+
+static inline void
+eina_evlog_ring(const char *event, const void *obj, const char *detail)
+{
+   Eina_Evlog_Ring *r;
+
+   if (EINA_LIKELY(!__atomic_load_n(&_eina_evlog_ring_registry.enabled,
+                                    __ATOMIC_RELAXED)))
+     return;
+
+   r = _eina_evlog_ring_self;
+   if (EINA_UNLIKELY(!r))
+     {
+        r = _eina_evlog_ring_attach();
+        if (!r) return;
+     }
+
+   _eina_evlog_ring_push(r, _eina_evlog_ring_time(), event, obj, detail);
+}
+
+static inline unsigned int
+eina_evlog_ring_import(void)
+{
+   Eina_Evlog_Ring_Registry *reg = &_eina_evlog_ring_registry;
+   Eina_Evlog_Buf *buf;
+   unsigned int pos, count = 0;
+
+   if (!reg->size) return 0;
+   if (!reg->key_set) return 0;
+
+   buf = eina_evlog_steal();
+   if ((!buf) || (!buf->buf)) return 0;
+
+   for (pos = 0; pos + sizeof (Eina_Evlog_Item) <= buf->top; )
+     {
+        Eina_Evlog_Item *item = (Eina_Evlog_Item *)(void *)(buf->buf + pos);
+        const char *detail = NULL;
+        const char *event;
+        Eina_Evlog_Ring *r;
+
+        if (!item->event_next) break;
+        event = (const char *)item + item->event_offset;
+        if (item->detail_offset)
+          detail = (const char *)item + item->detail_offset;
+
+        for (r = __atomic_load_n(&reg->rings, __ATOMIC_ACQUIRE); r; r = r->next)
+          if ((r->imported) && (r->thread == item->thread)) break;
+        if (!r) r = _eina_evlog_ring_new(item->thread, 0, EINA_TRUE);
+
+        /* the stolen buffer is reused, the ring keeps its own copy of the
+         * event name next to the item it belongs to */
+        if (r)
+          {
+             char *name = r->names[r->head & r->mask];
+
+             strncpy(name, event, EINA_EVLOG_RING_EVENT_SIZE - 1);
+             name[EINA_EVLOG_RING_EVENT_SIZE - 1] = '\0';
+             _eina_evlog_ring_push(r, item->tim, name,
+                                   (const void *)(uintptr_t)item->obj, detail);
+             count++;
+          }
+        pos += item->event_next;
+     }
+
+   return count;
+}
+
+static inline Eina_Bool
+_eina_evlog_ring_write(int fd, const char *s, size_t len)
+{
+   while (len > 0)
+     {
+        ssize_t w = write(fd, s, len);
+
+        if (w < 0) return EINA_FALSE;
+        s += w;
+        len -= w;
+     }
+   return EINA_TRUE;
+}
+
+/* snprintf() is not async-signal-safe, format by hand */
+static inline char *
+_eina_evlog_ring_fmt_ull(char *p, unsigned long long v)
+{
+   char tmp[24];
+   int n = 0;
+
+   do
+     {
+        tmp[n++] = '0' + (v % 10);
+        v /= 10;
+     }
+   while (v);
+   while (n) *p++ = tmp[--n];
+   return p;
+}
+
+static inline char *
+_eina_evlog_ring_fmt_str(char *p, const char *end, const char *s)
+{
+   for (; *s && (p + 2 < end); s++)
+     {
+        unsigned char c = *s;
+
+        if ((c == '"') || (c == '\\'))
+          {
+             *p++ = '\\';
+             *p++ = c;
+          }
+        else if (c < 0x20)
+          *p++ = ' ';
+        else
+          *p++ = c;
+     }
+   return p;
+}
+
+static inline char *
+_eina_evlog_ring_fmt_lit(char *p, const char *s)
+{
+   while (*s) *p++ = *s++;
+   return p;
+}
+
+static inline Eina_Bool
+eina_evlog_ring_dump_fd(int fd)
+{
+   Eina_Evlog_Ring_Registry *reg = &_eina_evlog_ring_registry;
+   Eina_Evlog_Ring *r;
+   double since = 0.0;
+   unsigned long long pid = (unsigned long long)getpid();
+   Eina_Bool first = EINA_TRUE;
+   char line[512];
+
+   if (reg->window > 0.0) since = _eina_evlog_ring_time() - reg->window;
+
+   if (!_eina_evlog_ring_write(fd, "{\"traceEvents\":[\n", 17))
+     return EINA_FALSE;
+
+   for (r = __atomic_load_n(&reg->rings, __ATOMIC_ACQUIRE); r; r = r->next)
+     {
+        unsigned int h = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+        unsigned int i = (h > r->mask) ? h - r->mask - 1 : 0;
+
+        for (; i != h; i++)
+          {
+             Eina_Evlog_Ring_Item it = r->items[i & r->mask];
+             const char *ph, *name;
+             char *p = line, *end = line + sizeof (line) - 64;
+             char ev[EINA_EVLOG_RING_EVENT_SIZE];
+             unsigned long long us;
+
+             if (r->names)
+               {
+                  memcpy(ev, r->names[i & r->mask], sizeof (ev));
+                  ev[sizeof (ev) - 1] = '\0';
+                  it.event = ev;
+               }
+             /* overwritten by the owner while we were copying it */
+             if (__atomic_load_n(&r->head, __ATOMIC_ACQUIRE) - i > r->mask)
+               continue;
+             if ((!it.event) || (!it.event[0])) continue;
+             if (it.tim < since) continue;
+
+             switch (it.event[0])
+               {
+                case '+': ph = "B"; name = it.event + 1; break;
+                case '-': ph = "E"; name = it.event + 1; break;
+                case '>': ph = "b"; name = it.event + 1; break;
+                case '<': ph = "e"; name = it.event + 1; break;
+                case '!': ph = "i"; name = it.event + 1; break;
+                case '*': continue;
+                default: ph = "i"; name = it.event; break;
+               }
+
+             if (!first) *p++ = ',';
+             first = EINA_FALSE;
+             p = _eina_evlog_ring_fmt_lit(p, "{\"name\":\"");
+             p = _eina_evlog_ring_fmt_str(p, end - 128, name);
+             p = _eina_evlog_ring_fmt_lit(p, "\",\"ph\":\"");
+             p = _eina_evlog_ring_fmt_lit(p, ph);
+             p = _eina_evlog_ring_fmt_lit(p, "\",\"pid\":");
+             p = _eina_evlog_ring_fmt_ull(p, pid);
+             p = _eina_evlog_ring_fmt_lit(p, ",\"tid\":");
+             p = _eina_evlog_ring_fmt_ull(p, it.thread);
+             us = (unsigned long long)(it.tim * 1000000.0);
+             p = _eina_evlog_ring_fmt_lit(p, ",\"ts\":");
+             p = _eina_evlog_ring_fmt_ull(p, us);
+             if (ph[0] == 'i')
+               p = _eina_evlog_ring_fmt_lit(p, ",\"s\":\"t\"");
+             else if ((ph[0] == 'b') || (ph[0] == 'e'))
+               {
+                  /* states are global and matched by name */
+                  unsigned long long id = 5381;
+                  const char *s;
+
+                  for (s = name; *s; s++) id = (id * 33) ^ (unsigned char)*s;
+                  p = _eina_evlog_ring_fmt_lit(p, ",\"cat\":\"state\",\"id\":");
+                  p = _eina_evlog_ring_fmt_ull(p, id & 0xffffffffULL);
+               }
+             p = _eina_evlog_ring_fmt_lit(p, ",\"args\":{\"obj\":");
+             p = _eina_evlog_ring_fmt_ull(p, (unsigned long long)(uintptr_t)it.obj);
+             if (it.detail[0])
+               {
+                  it.detail[EINA_EVLOG_RING_DETAIL_SIZE - 1] = '\0';
+                  p = _eina_evlog_ring_fmt_lit(p, ",\"detail\":\"");
+                  p = _eina_evlog_ring_fmt_str(p, end, it.detail);
+                  *p++ = '"';
+               }
+             p = _eina_evlog_ring_fmt_lit(p, "}}\n");
+
+             if (!_eina_evlog_ring_write(fd, line, p - line))
+               return EINA_FALSE;
+          }
+     }
+
+   return _eina_evlog_ring_write(fd, "]}\n", 3);
+}
+
+static inline Eina_Bool
+eina_evlog_ring_dump(const char *path)
+{
+   Eina_Bool r;
+   int fd;
+
+   if (!path) return EINA_FALSE;
+
+   fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+   if (fd < 0) return EINA_FALSE;
+   r = eina_evlog_ring_dump_fd(fd);
+   if (close(fd)) r = EINA_FALSE;
+   return r;
+}
+
+static inline void
+_eina_evlog_ring_signal(int sig EINA_UNUSED)
+{
+   int errno_saved = errno;
+
+   eina_evlog_ring_dump(_eina_evlog_ring_registry.signal_path);
+   errno = errno_saved;
+}
+
+static inline Eina_Bool
+eina_evlog_ring_dump_signal_set(int sig, const char *path)
+{
+   Eina_Evlog_Ring_Registry *reg = &_eina_evlog_ring_registry;
+   struct sigaction sa;
+   size_t len;
+
+   if (!path) return EINA_FALSE;
+   len = strlen(path);
+   if (len >= PATH_MAX) return EINA_FALSE;
+   memcpy(reg->signal_path, path, len + 1);
+
+   memset(&sa, 0, sizeof (sa));
+   sa.sa_handler = _eina_evlog_ring_signal;
+   sa.sa_flags = SA_RESTART;
+   sigemptyset(&sa.sa_mask);
+   return sigaction(sig, &sa, NULL) == 0;
+}
+
+#undef EINA_EVLOG_RING_DETAIL_SIZE
+#undef EINA_EVLOG_RING_SHARED
+
+#endif
@@ -0,0 +1,472 @@
+/* EINA - EFL data type library
+ * Copyright (C) 2016 Samsung Electronics Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library;
+ * if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EINA_INLINE_QUADTREE_X_
+#define EINA_INLINE_QUADTREE_X_
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "eina_safety_checks.h"
+
+/**
+ * @cond LOCAL
+ */
+
+#define EINA_QUADTREE_SOA_LEAF 16
+#define EINA_QUADTREE_SOA_DEPTH 16
+
+typedef struct _Eina_QuadTree_Soa_Node Eina_QuadTree_Soa_Node;
+
+struct _Eina_QuadTree_Soa_Node
+{
+   int x1, y1, x2, y2; // bounding box of every object below
+   unsigned int first; // objects of this node first, then the children ones
+   unsigned int own;
+   unsigned int child[4]; // 0 when empty, the root is never a child
+};
+
+struct _Eina_QuadTree_Soa
+{
+   int w, h;
+
+   /* geometry by id, x2 and y2 excluded */
+   unsigned int count, size;
+   int *x1, *y1, *x2, *y2;
+   const void **objects; // NULL once deleted
+
+   /* the same, reordered by node at the last rebuild */
+   unsigned int built;
+   int *bx1, *by1, *bx2, *by2;
+   const void **bobjects;
+
+   Eina_QuadTree_Soa_Node *nodes;
+   unsigned int nodes_count, nodes_size;
+
+   unsigned int *order, *tmp;
+
+   Eina_Bool dirty : 1;
+};
+
+/**
+ * @endcond
+ */
+
+static inline unsigned int
+eina_quadtree_add_array(Eina_QuadTree *q, const void **objects, unsigned int count, Eina_QuadTree_Item **items)
+{
+   unsigned int i, r = 0;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(q, 0);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(items, 0);
+   if (!count) return 0;
+   EINA_SAFETY_ON_NULL_RETURN_VAL(objects, 0);
+
+   for (i = 0; i < count; i++)
+     {
+        items[i] = eina_quadtree_add(q, objects[i]);
+        if (items[i]) r++;
+     }
+   return r;
+}
+
+static inline unsigned int
+eina_quadtree_change_array(Eina_QuadTree_Item **items, unsigned int count)
+{
+   unsigned int i, r = 0;
+
+   if (!count) return 0;
+   EINA_SAFETY_ON_NULL_RETURN_VAL(items, 0);
+
+   for (i = 0; i < count; i++)
+     if ((items[i]) && (eina_quadtree_change(items[i]))) r++;
+   return r;
+}
+
+static inline unsigned int
+eina_quadtree_collide_array(Eina_QuadTree *q, const Eina_Rectangle *queries, unsigned int count, void **results, unsigned int max, unsigned int *offsets)
+{
+   unsigned int i, total = 0;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(q, 0);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(offsets, 0);
+   if (!count) return 0;
+   EINA_SAFETY_ON_NULL_RETURN_VAL(queries, 0);
+   if (max) EINA_SAFETY_ON_NULL_RETURN_VAL(results, 0);
+
+   for (i = 0; i < count; i++)
+     {
+        Eina_Inlist *l;
+
+        offsets[i] = total;
+        l = eina_quadtree_collide(q, queries[i].x, queries[i].y,
+                                  queries[i].w, queries[i].h);
+        for (; l; l = l->next, total++)
+          if (total < max) results[total] = eina_quadtree_object(l);
+     }
+   offsets[count] = total;
+   return total;
+}
+
+static inline Eina_QuadTree_Soa *
+eina_quadtree_soa_new(int w, int h)
+{
+   Eina_QuadTree_Soa *q;
+
+   EINA_SAFETY_ON_TRUE_RETURN_VAL((w <= 0) || (h <= 0), NULL);
+
+   q = (Eina_QuadTree_Soa *)calloc(1, sizeof (Eina_QuadTree_Soa));
+   if (!q) return NULL;
+   q->w = w;
+   q->h = h;
+   return q;
+}
+
+static inline void
+_eina_quadtree_soa_built_free(Eina_QuadTree_Soa *q)
+{
+   free(q->bx1);
+   free(q->by1);
+   free(q->bx2);
+   free(q->by2);
+   free(q->bobjects);
+   q->bx1 = q->by1 = q->bx2 = q->by2 = NULL;
+   q->bobjects = NULL;
+   q->built = 0;
+   q->nodes_count = 0;
+}
+
+static inline void
+eina_quadtree_soa_free(Eina_QuadTree_Soa *q)
+{
+   if (!q) return;
+
+   _eina_quadtree_soa_built_free(q);
+   free(q->x1);
+   free(q->y1);
+   free(q->x2);
+   free(q->y2);
+   free(q->objects);
+   free(q->nodes);
+   free(q->order);
+   free(q->tmp);
+   free(q);
+}
+
+static inline unsigned int
+eina_quadtree_soa_count(const Eina_QuadTree_Soa *q)
+{
+   EINA_SAFETY_ON_NULL_RETURN_VAL(q, 0);
+   return q->count;
+}
+
+static inline Eina_Bool
+_eina_quadtree_soa_grow(Eina_QuadTree_Soa *q, unsigned int count)
+{
+   unsigned int size = q->size ? q->size : 256;
+   void *tmp;
+
+   if (count <= q->size) return EINA_TRUE;
+   while (size < count) size *= 2;
+
+#define GROW(Member)                                            \
+   tmp = realloc(q->Member, size * sizeof (q->Member[0]));     \
+   if (!tmp) return EINA_FALSE;                                 \
+   q->Member = (__typeof__(q->Member))tmp;
+
+   GROW(x1);
+   GROW(y1);
+   GROW(x2);
+   GROW(y2);
+   GROW(objects);
+#undef GROW
+
+   q->size = size;
+   return EINA_TRUE;
+}
+
+static inline void
+_eina_quadtree_soa_set(Eina_QuadTree_Soa *q, unsigned int id, const Eina_Rectangle *r)
+{
+   q->x1[id] = r->x;
+   q->y1[id] = r->y;
+   q->x2[id] = r->x + r->w;
+   q->y2[id] = r->y + r->h;
+}
+
+static inline int
+eina_quadtree_soa_add_array(Eina_QuadTree_Soa *q, const Eina_Rectangle *geometry, const void **objects, unsigned int count)
+{
+   unsigned int i, first;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(q, -1);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(geometry, -1);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(objects, -1);
+
+   if (!_eina_quadtree_soa_grow(q, q->count + count)) return -1;
+
+   first = q->count;
+   for (i = 0; i < count; i++)
+     {
+        _eina_quadtree_soa_set(q, first + i, geometry + i);
+        q->objects[first + i] = objects[i];
+     }
+   q->count += count;
+   q->dirty = EINA_TRUE;
+   return first;
+}
+
+static inline void
+eina_quadtree_soa_change_array(Eina_QuadTree_Soa *q, const unsigned int *ids, const Eina_Rectangle *geometry, unsigned int count)
+{
+   unsigned int i;
+
+   EINA_SAFETY_ON_NULL_RETURN(q);
+   if (!count) return;
+   EINA_SAFETY_ON_NULL_RETURN(ids);
+   EINA_SAFETY_ON_NULL_RETURN(geometry);
+
+   for (i = 0; i < count; i++)
+     if (ids[i] < q->count)
+       _eina_quadtree_soa_set(q, ids[i], geometry + i);
+   q->dirty = EINA_TRUE;
+}
+
+static inline void
+eina_quadtree_soa_del(Eina_QuadTree_Soa *q, unsigned int id)
+{
+   EINA_SAFETY_ON_NULL_RETURN(q);
+   EINA_SAFETY_ON_TRUE_RETURN(id >= q->count);
+
+   q->objects[id] = NULL;
+   q->dirty = EINA_TRUE;
+}
+
+static inline int
+_eina_quadtree_soa_node_new(Eina_QuadTree_Soa *q)
+{
+   if (q->nodes_count == q->nodes_size)
+     {
+        unsigned int size = q->nodes_size ? q->nodes_size * 2 : 64;
+        Eina_QuadTree_Soa_Node *tmp;
+
+        tmp = (Eina_QuadTree_Soa_Node *)realloc(q->nodes, size * sizeof (Eina_QuadTree_Soa_Node));
+        if (!tmp) return -1;
+        q->nodes = tmp;
+        q->nodes_size = size;
+     }
+   memset(q->nodes + q->nodes_count, 0, sizeof (Eina_QuadTree_Soa_Node));
+   return q->nodes_count++;
+}
+
+static inline unsigned int
+_eina_quadtree_soa_slot(const Eina_QuadTree_Soa *q, unsigned int id, int mx, int my)
+{
+   int qx, qy;
+
+   qx = (q->x2[id] <= mx) ? 0 : (q->x1[id] >= mx) ? 1 : -1;
+   qy = (q->y2[id] <= my) ? 0 : (q->y1[id] >= my) ? 1 : -1;
+   if ((qx < 0) || (qy < 0)) return 4;
+   return qx + 2 * qy;
+}
+
+/* Objects order[a..b) lie in region (rx1, ry1) - (rx2, ry2). Those crossing
+ * the middle lines stay in the node, the others go to the quadrant holding
+ * them, as in Eina_QuadTree. */
+static inline int
+_eina_quadtree_soa_build(Eina_QuadTree_Soa *q, int rx1, int ry1, int rx2, int ry2, unsigned int a, unsigned int b, unsigned int depth)
+{
+   Eina_QuadTree_Soa_Node *n;
+   unsigned int cnt[5] = { 0, 0, 0, 0, 0 };
+   unsigned int pos[5];
+   unsigned int i, k, start;
+   int idx, mx, my;
+   int x1 = q->x1[q->order[a]], y1 = q->y1[q->order[a]];
+   int x2 = q->x2[q->order[a]], y2 = q->y2[q->order[a]];
+
+   idx = _eina_quadtree_soa_node_new(q);
+   if (idx < 0) return -1;
+
+   for (i = a + 1; i < b; i++)
+     {
+        unsigned int id = q->order[i];
+
+        if (q->x1[id] < x1) x1 = q->x1[id];
+        if (q->y1[id] < y1) y1 = q->y1[id];
+        if (q->x2[id] > x2) x2 = q->x2[id];
+        if (q->y2[id] > y2) y2 = q->y2[id];
+     }
+   n = q->nodes + idx;
+   n->x1 = x1;
+   n->y1 = y1;
+   n->x2 = x2;
+   n->y2 = y2;
+   n->first = a;
+
+   if ((b - a <= EINA_QUADTREE_SOA_LEAF) || (depth >= EINA_QUADTREE_SOA_DEPTH) ||
+       (rx2 - rx1 < 2) || (ry2 - ry1 < 2))
+     {
+        n->own = b - a;
+        return idx;
+     }
+
+   mx = rx1 + (rx2 - rx1) / 2;
+   my = ry1 + (ry2 - ry1) / 2;
+
+   /* counting sort, crossing objects (slot 4) first */
+   for (i = a; i < b; i++)
+     cnt[_eina_quadtree_soa_slot(q, q->order[i], mx, my)]++;
+   pos[4] = a;
+   pos[0] = a + cnt[4];
+   for (k = 1; k < 4; k++) pos[k] = pos[k - 1] + cnt[k - 1];
+   for (i = a; i < b; i++)
+     {
+        unsigned int id = q->order[i];
+
+        q->tmp[pos[_eina_quadtree_soa_slot(q, id, mx, my)]++] = id;
+     }
+   memcpy(q->order + a, q->tmp + a, (b - a) * sizeof (unsigned int));
+
+   q->nodes[idx].own = cnt[4];
+
+   start = a + cnt[4];
+   for (k = 0; k < 4; k++)
+     {
+        int c;
+
+        if (!cnt[k]) continue;
+        c = _eina_quadtree_soa_build(q,
+                                     (k & 1) ? mx : rx1, (k & 2) ? my : ry1,
+                                     (k & 1) ? rx2 : mx, (k & 2) ? ry2 : my,
+                                     start, start + cnt[k], depth + 1);
+        if (c < 0) return -1;
+        q->nodes[idx].child[k] = c;
+        start += cnt[k];
+     }
+
+   return idx;
+}
+
+static inline void
+eina_quadtree_soa_cycle(Eina_QuadTree_Soa *q)
+{
+   unsigned int i, n = 0;
+   void *tmp;
+
+   EINA_SAFETY_ON_NULL_RETURN(q);
+   if (!q->dirty) return;
+
+   _eina_quadtree_soa_built_free(q);
+   q->dirty = EINA_FALSE;
+
+   tmp = realloc(q->order, (q->count ? q->count : 1) * sizeof (unsigned int));
+   if (!tmp) goto on_error;
+   q->order = (unsigned int *)tmp;
+   tmp = realloc(q->tmp, (q->count ? q->count : 1) * sizeof (unsigned int));
+   if (!tmp) goto on_error;
+   q->tmp = (unsigned int *)tmp;
+
+   for (i = 0; i < q->count; i++)
+     if ((q->objects[i]) && (q->x2[i] > q->x1[i]) && (q->y2[i] > q->y1[i]))
+       q->order[n++] = i;
+   if (!n) return;
+
+   if (_eina_quadtree_soa_build(q, 0, 0, q->w, q->h, 0, n, 0) < 0)
+     goto on_error;
+
+   q->bx1 = (int *)malloc(n * sizeof (int));
+   q->by1 = (int *)malloc(n * sizeof (int));
+   q->bx2 = (int *)malloc(n * sizeof (int));
+   q->by2 = (int *)malloc(n * sizeof (int));
+   q->bobjects = (const void **)malloc(n * sizeof (void *));
+   if ((!q->bx1) || (!q->by1) || (!q->bx2) || (!q->by2) || (!q->bobjects))
+     goto on_error;
+
+   for (i = 0; i < n; i++)
+     {
+        unsigned int id = q->order[i];
+
+        q->bx1[i] = q->x1[id];
+        q->by1[i] = q->y1[id];
+        q->bx2[i] = q->x2[id];
+        q->by2[i] = q->y2[id];
+        q->bobjects[i] = q->objects[id];
+     }
+   q->built = n;
+   return;
+
+ on_error:
+   _eina_quadtree_soa_built_free(q);
+   q->dirty = EINA_TRUE;
+}
+
+static inline unsigned int
+eina_quadtree_soa_collide_array(Eina_QuadTree_Soa *q, const Eina_Rectangle *queries, unsigned int count, void **results, unsigned int max, unsigned int *offsets)
+{
+   unsigned int stack[EINA_QUADTREE_SOA_DEPTH * 3 + 4];
+   unsigned int i, total = 0;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(q, 0);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(offsets, 0);
+   if (!count) return 0;
+   EINA_SAFETY_ON_NULL_RETURN_VAL(queries, 0);
+   if (max) EINA_SAFETY_ON_NULL_RETURN_VAL(results, 0);
+
+   eina_quadtree_soa_cycle(q);
+
+   for (i = 0; i < count; i++)
+     {
+        int qx1 = queries[i].x, qy1 = queries[i].y;
+        int qx2 = qx1 + (queries[i].w > 0 ? queries[i].w : 1);
+        int qy2 = qy1 + (queries[i].h > 0 ? queries[i].h : 1);
+        unsigned int sp = 0;
+
+        offsets[i] = total;
+        if (!q->built) continue;
+
+        stack[sp++] = 0;
+        while (sp)
+          {
+             const Eina_QuadTree_Soa_Node *n = q->nodes + stack[--sp];
+             unsigned int j, end, k;
+
+             if ((n->x1 >= qx2) || (n->x2 <= qx1) ||
+                 (n->y1 >= qy2) || (n->y2 <= qy1))
+               continue;
+
+             end = n->first + n->own;
+             for (j = n->first; j < end; j++)
+               if ((q->bx1[j] < qx2) && (q->bx2[j] > qx1) &&
+                   (q->by1[j] < qy2) && (q->by2[j] > qy1))
+                 {
+                    if (total < max) results[total] = (void *)q->bobjects[j];
+                    total++;
+                 }
+
+             for (k = 0; k < 4; k++)
+               if (n->child[k]) stack[sp++] = n->child[k];
+          }
+     }
+   offsets[count] = total;
+   return total;
+}
+
+#undef EINA_QUADTREE_SOA_DEPTH
+#undef EINA_QUADTREE_SOA_LEAF
+
+#endif
@@ -0,0 +1,831 @@
+/* EINA - EFL data type library
+ * Copyright (C) 2016 Samsung Electronics Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library;
+ * if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EINA_INLINE_SIMPLE_XML_PARSER_X_
+#define EINA_INLINE_SIMPLE_XML_PARSER_X_
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "eina_safety_checks.h"
+
+#if defined(__GNUC__) && defined(__SSE2__)
+# include <emmintrin.h>
+# define EINA_SIMPLE_XML_SCAN_SSE2 1
+#elif defined(__GNUC__) && (defined(__ARM_NEON__) || defined(__ARM_NEON))
+# include <arm_neon.h>
+# define EINA_SIMPLE_XML_SCAN_NEON 1
+#endif
+
+/**
+ * @cond LOCAL
+ */
+
+typedef enum _Eina_Simple_XML_Stream_Token
+{
+   EINA_SIMPLE_XML_STREAM_TOKEN_NONE = 0,
+   EINA_SIMPLE_XML_STREAM_TOKEN_TAG, /* <tag ...>, <?pi ...>, '>' outside quotes */
+   EINA_SIMPLE_XML_STREAM_TOKEN_DECL, /* <!DOCTYPE ... [ ... ]>, nested brackets */
+   EINA_SIMPLE_XML_STREAM_TOKEN_COMMENT, /* <!-- ... --> */
+   EINA_SIMPLE_XML_STREAM_TOKEN_CDATA /* <![CDATA[ ... ]]> */
+} Eina_Simple_XML_Stream_Token;
+
+struct _Eina_Simple_XML_Stream
+{
+   Eina_Simple_XML_Cb func;
+   const void *data;
+
+   char *buf; // bytes not yet given to eina_simple_xml_parse()
+   size_t len, size;
+   size_t consumed; // stream offset of buf[0]
+
+   size_t scan; // where to look for the next '<'
+   struct {
+      size_t start; // offset of the '<' of the incomplete token
+      size_t pos; // how far it was scanned
+      Eina_Simple_XML_Stream_Token type;
+      char quote;
+      int depth;
+   } token;
+
+   Eina_Bool strip : 1;
+   Eina_Bool failed : 1;
+};
+
+typedef struct _Eina_Simple_XML_Arena Eina_Simple_XML_Arena;
+typedef struct _Eina_Simple_XML_Arena_Load Eina_Simple_XML_Arena_Load;
+
+struct _Eina_Simple_XML_Arena
+{
+   Eina_Simple_XML_Arena *next; // blocks chained after this one
+   Eina_Simple_XML_Arena *current; // block we allocate from, head only
+   size_t size;
+   size_t used;
+};
+
+struct _Eina_Simple_XML_Arena_Load
+{
+   Eina_Simple_XML_Arena *arena;
+   Eina_Simple_XML_Node_Tag *current;
+   Eina_Simple_XML_Node_Tag *attr_parent;
+#ifdef EINA_MAGIC_DEBUG
+   Eina_Magic magic_tag, magic_data, magic_attribute;
+#endif
+};
+
+#define EINA_SIMPLE_XML_ARENA_ALIGN(n) (((n) + 7) & ~((size_t)7))
+#define EINA_SIMPLE_XML_ARENA_HEADER EINA_SIMPLE_XML_ARENA_ALIGN(sizeof(Eina_Simple_XML_Arena))
+
+/**
+ * @endcond
+ */
+
+static inline Eina_Bool
+_eina_simple_xml_scan_match(char c, Eina_Simple_XML_Scan what)
+{
+   switch (c)
+     {
+      case '<': return !!(what & EINA_SIMPLE_XML_SCAN_LT);
+      case '>': return !!(what & EINA_SIMPLE_XML_SCAN_GT);
+      case '&': return !!(what & EINA_SIMPLE_XML_SCAN_AMP);
+      case '"':
+      case '\'': return !!(what & EINA_SIMPLE_XML_SCAN_QUOTE);
+      default: return EINA_FALSE;
+     }
+}
+
+static inline const char *
+eina_simple_xml_scan(const char *itr, const char *itr_end, Eina_Simple_XML_Scan what)
+{
+   if (itr >= itr_end) return itr_end;
+
+   /* libc already has a vectorized single character search */
+   if (what == EINA_SIMPLE_XML_SCAN_LT)
+     {
+        const char *r = (const char *)memchr(itr, '<', itr_end - itr);
+        return r ? r : itr_end;
+     }
+
+#if defined(EINA_SIMPLE_XML_SCAN_SSE2) || defined(EINA_SIMPLE_XML_SCAN_NEON)
+   if (what & EINA_SIMPLE_XML_SCAN_ALL)
+     {
+        char c0, lt, gt, amp, quot, apos;
+
+        /* Characters we are not looking for are replaced by one we are
+         * looking for, so the loop always compares against 5 values. */
+        c0 = (what & EINA_SIMPLE_XML_SCAN_LT) ? '<' :
+          (what & EINA_SIMPLE_XML_SCAN_GT) ? '>' :
+          (what & EINA_SIMPLE_XML_SCAN_AMP) ? '&' : '"';
+        lt = (what & EINA_SIMPLE_XML_SCAN_LT) ? '<' : c0;
+        gt = (what & EINA_SIMPLE_XML_SCAN_GT) ? '>' : c0;
+        amp = (what & EINA_SIMPLE_XML_SCAN_AMP) ? '&' : c0;
+        quot = (what & EINA_SIMPLE_XML_SCAN_QUOTE) ? '"' : c0;
+        apos = (what & EINA_SIMPLE_XML_SCAN_QUOTE) ? '\'' : c0;
+
+# ifdef EINA_SIMPLE_XML_SCAN_SSE2
+        {
+           const __m128i vlt = _mm_set1_epi8(lt);
+           const __m128i vgt = _mm_set1_epi8(gt);
+           const __m128i vamp = _mm_set1_epi8(amp);
+           const __m128i vquot = _mm_set1_epi8(quot);
+           const __m128i vapos = _mm_set1_epi8(apos);
+
+           for (; itr_end - itr >= 16; itr += 16)
+             {
+                __m128i v = _mm_loadu_si128((const __m128i *)(const void *)itr);
+                __m128i m;
+                int bits;
+
+                m = _mm_or_si128(_mm_cmpeq_epi8(v, vlt), _mm_cmpeq_epi8(v, vgt));
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(v, vamp));
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(v, vquot));
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(v, vapos));
+                bits = _mm_movemask_epi8(m);
+                if (bits) return itr + __builtin_ctz(bits);
+             }
+        }
+# else
+        {
+           const uint8x16_t vlt = vdupq_n_u8((uint8_t)lt);
+           const uint8x16_t vgt = vdupq_n_u8((uint8_t)gt);
+           const uint8x16_t vamp = vdupq_n_u8((uint8_t)amp);
+           const uint8x16_t vquot = vdupq_n_u8((uint8_t)quot);
+           const uint8x16_t vapos = vdupq_n_u8((uint8_t)apos);
+
+           for (; itr_end - itr >= 16; itr += 16)
+             {
+                uint8x16_t v = vld1q_u8((const uint8_t *)itr);
+                uint8x16_t m;
+                uint64x2_t m64;
+
+                m = vorrq_u8(vceqq_u8(v, vlt), vceqq_u8(v, vgt));
+                m = vorrq_u8(m, vceqq_u8(v, vamp));
+                m = vorrq_u8(m, vceqq_u8(v, vquot));
+                m = vorrq_u8(m, vceqq_u8(v, vapos));
+                m64 = vreinterpretq_u64_u8(m);
+                /* NEON has no movemask, locate the byte in scalar code */
+                if (vgetq_lane_u64(m64, 0) | vgetq_lane_u64(m64, 1))
+                  break;
+             }
+        }
+# endif
+     }
+#endif
+
+   for (; itr < itr_end; itr++)
+     if (_eina_simple_xml_scan_match(*itr, what))
+       return itr;
+   return itr_end;
+}
+
+static inline const char *
+_eina_simple_xml_stream_mem_find(const char *itr, const char *itr_end, const char *needle, size_t needle_len)
+{
+   while ((size_t)(itr_end - itr) >= needle_len)
+     {
+        itr = (const char *)memchr(itr, needle[0], (itr_end - itr) - needle_len + 1);
+        if (!itr) return NULL;
+        if (!memcmp(itr, needle, needle_len)) return itr;
+        itr++;
+     }
+   return NULL;
+}
+
+/* Return the offset right after the token starting at s->buf[start] (a '<')
+ * or 0 if it is not complete yet. The scan state is kept in s->token, so
+ * a large comment or CDATA section spread over many chunks is scanned only
+ * once. */
+static inline size_t
+_eina_simple_xml_stream_token_end(Eina_Simple_XML_Stream *s, size_t start)
+{
+   const char *buf = s->buf;
+   const char *itr, *itr_end = s->buf + s->len;
+   size_t avail = s->len - start;
+
+   if ((s->token.type == EINA_SIMPLE_XML_STREAM_TOKEN_NONE) ||
+       (s->token.start != start))
+     {
+        const char *p = buf + start;
+
+        if (avail < 2) return 0;
+        if (p[1] != '!')
+          {
+             s->token.type = EINA_SIMPLE_XML_STREAM_TOKEN_TAG;
+             s->token.pos = start + 1;
+          }
+        else if ((avail >= 3) && (p[2] != '-') && (p[2] != '['))
+          {
+             s->token.type = EINA_SIMPLE_XML_STREAM_TOKEN_DECL;
+             s->token.pos = start + 2;
+          }
+        else if (avail < 4)
+          return 0;
+        else if (!memcmp(p, "<!--", 4))
+          {
+             s->token.type = EINA_SIMPLE_XML_STREAM_TOKEN_COMMENT;
+             s->token.pos = start + 4;
+          }
+        else if (p[2] == '[')
+          {
+             if (avail < sizeof("<![CDATA[") - 1) return 0;
+             if (!memcmp(p, "<![CDATA[", sizeof("<![CDATA[") - 1))
+               {
+                  s->token.type = EINA_SIMPLE_XML_STREAM_TOKEN_CDATA;
+                  s->token.pos = start + sizeof("<![CDATA[") - 1;
+               }
+             else
+               {
+                  s->token.type = EINA_SIMPLE_XML_STREAM_TOKEN_DECL;
+                  s->token.pos = start + 2;
+               }
+          }
+        else
+          {
+             s->token.type = EINA_SIMPLE_XML_STREAM_TOKEN_DECL;
+             s->token.pos = start + 2;
+          }
+        s->token.start = start;
+        s->token.quote = 0;
+        s->token.depth = 0;
+     }
+
+   itr = buf + s->token.pos;
+   switch (s->token.type)
+     {
+      case EINA_SIMPLE_XML_STREAM_TOKEN_COMMENT:
+      case EINA_SIMPLE_XML_STREAM_TOKEN_CDATA:
+        {
+           const char *needle;
+           const char *r;
+
+           needle = (s->token.type == EINA_SIMPLE_XML_STREAM_TOKEN_COMMENT) ?
+             "-->" : "]]>";
+           r = _eina_simple_xml_stream_mem_find(itr, itr_end, needle, 3);
+           if (r) return (r + 3) - buf;
+           /* the terminator may straddle this chunk and the next one */
+           if (itr_end - itr > 2) s->token.pos = (itr_end - 2) - buf;
+           return 0;
+        }
+
+      case EINA_SIMPLE_XML_STREAM_TOKEN_TAG:
+         while (itr < itr_end)
+           {
+              if (s->token.quote)
+                {
+                   const char *q = (const char *)memchr(itr, s->token.quote, itr_end - itr);
+
+                   if (!q)
+                     {
+                        itr = itr_end;
+                        break;
+                     }
+                   s->token.quote = 0;
+                   itr = q + 1;
+                   continue;
+                }
+
+              itr = eina_simple_xml_scan(itr, itr_end,
+                                         (Eina_Simple_XML_Scan)
+                                         (EINA_SIMPLE_XML_SCAN_LT |
+                                          EINA_SIMPLE_XML_SCAN_GT |
+                                          EINA_SIMPLE_XML_SCAN_QUOTE));
+              if (itr == itr_end) break;
+              if (*itr == '>') return (itr + 1) - buf;
+              /* '<' inside a tag, eina_simple_xml_parse() reports the
+               * broken tag and starts over there, so can we */
+              if (*itr == '<') return itr - buf;
+              s->token.quote = *itr++;
+           }
+         s->token.pos = itr - buf;
+         return 0;
+
+      case EINA_SIMPLE_XML_STREAM_TOKEN_DECL:
+         /* declarations are short, but may carry an internal subset */
+         for (; itr < itr_end; itr++)
+           {
+              if (s->token.quote)
+                {
+                   if (*itr == s->token.quote) s->token.quote = 0;
+                }
+              else if ((*itr == '"') || (*itr == '\''))
+                s->token.quote = *itr;
+              else if (*itr == '[')
+                s->token.depth++;
+              else if ((*itr == ']') && (s->token.depth > 0))
+                s->token.depth--;
+              else if ((*itr == '>') && (s->token.depth == 0))
+                return (itr + 1) - buf;
+           }
+         s->token.pos = itr - buf;
+         return 0;
+
+      default:
+         return 0;
+     }
+}
+
+static inline Eina_Bool
+_eina_simple_xml_stream_cb(void *data, Eina_Simple_XML_Type type, const char *content, unsigned offset, unsigned length)
+{
+   Eina_Simple_XML_Stream *s = (Eina_Simple_XML_Stream *)data;
+
+   return s->func((void *)s->data, type, content,
+                  (unsigned)(s->consumed + offset), length);
+}
+
+static inline Eina_Bool
+_eina_simple_xml_stream_flush(Eina_Simple_XML_Stream *s, size_t cut)
+{
+   if (!cut) return EINA_TRUE;
+
+   if (!eina_simple_xml_parse(s->buf, cut, s->strip,
+                              _eina_simple_xml_stream_cb, s))
+     {
+        s->failed = EINA_TRUE;
+        return EINA_FALSE;
+     }
+
+   s->consumed += cut;
+   s->len -= cut;
+   if (s->len) memmove(s->buf, s->buf + cut, s->len);
+   s->scan -= cut;
+   if (s->token.type != EINA_SIMPLE_XML_STREAM_TOKEN_NONE)
+     {
+        s->token.start -= cut;
+        s->token.pos -= cut;
+     }
+   return EINA_TRUE;
+}
+
+/* Find the end of the last complete token in s->buf. Text after it is kept
+ * too, as the parser would report a text node split in two otherwise. */
+static inline size_t
+_eina_simple_xml_stream_cut(Eina_Simple_XML_Stream *s)
+{
+   size_t cut = 0;
+
+   while (s->scan < s->len)
+     {
+        const char *lt;
+        size_t end;
+
+        lt = eina_simple_xml_scan(s->buf + s->scan, s->buf + s->len,
+                                  EINA_SIMPLE_XML_SCAN_LT);
+        if (lt == s->buf + s->len)
+          {
+             s->scan = s->len;
+             break;
+          }
+
+        s->scan = lt - s->buf;
+        end = _eina_simple_xml_stream_token_end(s, s->scan);
+        if (!end) break;
+
+        s->token.type = EINA_SIMPLE_XML_STREAM_TOKEN_NONE;
+        s->scan = end;
+        cut = end;
+     }
+
+   return cut;
+}
+
+static inline Eina_Simple_XML_Stream *
+eina_simple_xml_stream_new(Eina_Bool strip, Eina_Simple_XML_Cb func, const void *data)
+{
+   Eina_Simple_XML_Stream *s;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(func, NULL);
+
+   s = (Eina_Simple_XML_Stream *)calloc(1, sizeof (Eina_Simple_XML_Stream));
+   if (!s) return NULL;
+
+   s->func = func;
+   s->data = data;
+   s->strip = !!strip;
+   return s;
+}
+
+static inline void
+eina_simple_xml_stream_free(Eina_Simple_XML_Stream *s)
+{
+   if (!s) return;
+   free(s->buf);
+   free(s);
+}
+
+static inline Eina_Bool
+_eina_simple_xml_stream_append(Eina_Simple_XML_Stream *s, const char *chunk, size_t len)
+{
+   if (s->len + len > s->size)
+     {
+        size_t size = s->size ? s->size : 4096;
+        char *tmp;
+
+        while (size < s->len + len) size *= 2;
+        tmp = (char *)realloc(s->buf, size);
+        if (!tmp)
+          {
+             s->failed = EINA_TRUE;
+             return EINA_FALSE;
+          }
+        s->buf = tmp;
+        s->size = size;
+     }
+   memcpy(s->buf + s->len, chunk, len);
+   s->len += len;
+   return EINA_TRUE;
+}
+
+static inline Eina_Bool
+eina_simple_xml_stream_feed(Eina_Simple_XML_Stream *s, const char *chunk, size_t len)
+{
+   EINA_SAFETY_ON_NULL_RETURN_VAL(s, EINA_FALSE);
+   if (s->failed) return EINA_FALSE;
+   if (!len) return EINA_TRUE;
+   EINA_SAFETY_ON_NULL_RETURN_VAL(chunk, EINA_FALSE);
+
+   if (!s->len)
+     {
+        /* Nothing pending, complete tokens are parsed straight from the
+         * chunk and only the incomplete tail is copied. */
+        char *buf = s->buf;
+        size_t cut;
+
+        s->buf = (char *)chunk;
+        s->len = len;
+        cut = _eina_simple_xml_stream_cut(s);
+        s->buf = buf;
+        s->len = 0;
+
+        if (cut)
+          {
+             if (!eina_simple_xml_parse(chunk, cut, s->strip,
+                                        _eina_simple_xml_stream_cb, s))
+               {
+                  s->failed = EINA_TRUE;
+                  return EINA_FALSE;
+               }
+             s->consumed += cut;
+             s->scan -= cut;
+             if (s->token.type != EINA_SIMPLE_XML_STREAM_TOKEN_NONE)
+               {
+                  s->token.start -= cut;
+                  s->token.pos -= cut;
+               }
+          }
+
+        return _eina_simple_xml_stream_append(s, chunk + cut, len - cut);
+     }
+
+   if (!_eina_simple_xml_stream_append(s, chunk, len)) return EINA_FALSE;
+   return _eina_simple_xml_stream_flush(s, _eina_simple_xml_stream_cut(s));
+}
+
+static inline Eina_Bool
+eina_simple_xml_stream_file_feed(Eina_Simple_XML_Stream *s, Eina_File *file, size_t window)
+{
+   size_t size, offset, page;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(s, EINA_FALSE);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(file, EINA_FALSE);
+
+   /* mapping offsets have to be page aligned */
+   page = (size_t)sysconf(_SC_PAGESIZE);
+   if (!window) window = 1024 * 1024;
+   window = ((window + page - 1) / page) * page;
+
+   size = eina_file_size_get(file);
+   for (offset = 0; offset < size; offset += window)
+     {
+        size_t len = (size - offset < window) ? size - offset : window;
+        const char *map;
+        Eina_Bool r;
+
+        map = (const char *)eina_file_map_new(file, EINA_FILE_SEQUENTIAL, offset, len);
+        if (!map) return EINA_FALSE;
+
+        r = eina_simple_xml_stream_feed(s, map, len);
+        if (r && eina_file_map_faulted(file, (void *)map)) r = EINA_FALSE;
+        eina_file_map_free(file, (void *)map);
+        if (!r) return EINA_FALSE;
+     }
+
+   return EINA_TRUE;
+}
+
+static inline Eina_Bool
+eina_simple_xml_stream_end(Eina_Simple_XML_Stream *s)
+{
+   EINA_SAFETY_ON_NULL_RETURN_VAL(s, EINA_FALSE);
+   if (s->failed) return EINA_FALSE;
+
+   s->token.type = EINA_SIMPLE_XML_STREAM_TOKEN_NONE;
+   return _eina_simple_xml_stream_flush(s, s->len);
+}
+
+static inline void *
+_eina_simple_xml_arena_alloc(Eina_Simple_XML_Arena *head, size_t size)
+{
+   Eina_Simple_XML_Arena *a = head->current;
+   void *r;
+
+   size = EINA_SIMPLE_XML_ARENA_ALIGN(size);
+   if (a->used + size > a->size)
+     {
+        size_t bsize = a->size * 2;
+
+        if (bsize < size) bsize = size;
+        a = (Eina_Simple_XML_Arena *)malloc(EINA_SIMPLE_XML_ARENA_HEADER + bsize);
+        if (!a) return NULL;
+        a->next = head->next;
+        a->current = NULL;
+        a->size = bsize;
+        a->used = 0;
+        head->next = a;
+        head->current = a;
+     }
+
+   r = ((unsigned char *)a) + EINA_SIMPLE_XML_ARENA_HEADER + a->used;
+   a->used += size;
+   return r;
+}
+
+static inline const char *
+_eina_simple_xml_arena_strndup(Eina_Simple_XML_Arena *head, const char *str, size_t len)
+{
+   char *r = (char *)_eina_simple_xml_arena_alloc(head, len + 1);
+
+   if (!r) return NULL;
+   memcpy(r, str, len);
+   r[len] = '\0';
+   return r;
+}
+
+static inline Eina_Bool
+_eina_simple_xml_arena_attr_cb(void *data, const char *key, const char *value)
+{
+   Eina_Simple_XML_Arena_Load *ctx = (Eina_Simple_XML_Arena_Load *)data;
+   Eina_Simple_XML_Attribute *attr;
+
+   attr = (Eina_Simple_XML_Attribute *)_eina_simple_xml_arena_alloc(ctx->arena, sizeof (Eina_Simple_XML_Attribute));
+   if (!attr) return EINA_FALSE;
+   memset(attr, 0, sizeof (Eina_Simple_XML_Attribute));
+#ifdef EINA_MAGIC_DEBUG
+   EINA_MAGIC_SET(attr, ctx->magic_attribute);
+#endif
+   attr->parent = ctx->attr_parent;
+   attr->key = _eina_simple_xml_arena_strndup(ctx->arena, key, strlen(key));
+   attr->value = _eina_simple_xml_arena_strndup(ctx->arena, value, strlen(value));
+   if ((!attr->key) || (!attr->value)) return EINA_FALSE;
+
+   ctx->attr_parent->attributes =
+     eina_inlist_append(ctx->attr_parent->attributes, EINA_INLIST_GET(attr));
+   return EINA_TRUE;
+}
+
+static inline Eina_Simple_XML_Node_Tag *
+_eina_simple_xml_arena_tag_new(Eina_Simple_XML_Arena_Load *ctx, Eina_Simple_XML_Node_Tag *parent, const char *name, size_t len)
+{
+   Eina_Simple_XML_Node_Tag *n;
+
+   n = (Eina_Simple_XML_Node_Tag *)_eina_simple_xml_arena_alloc(ctx->arena, sizeof (Eina_Simple_XML_Node_Tag));
+   if (!n) return NULL;
+   memset(n, 0, sizeof (Eina_Simple_XML_Node_Tag));
+#ifdef EINA_MAGIC_DEBUG
+   EINA_MAGIC_SET(&n->base, ctx->magic_tag);
+#endif
+   n->name = _eina_simple_xml_arena_strndup(ctx->arena, name, len);
+   if (!n->name) return NULL;
+
+   n->base.parent = parent;
+   if (parent)
+     {
+        n->base.type = EINA_SIMPLE_XML_NODE_TAG;
+        parent->children = eina_inlist_append(parent->children, EINA_INLIST_GET(&n->base));
+     }
+   else
+     n->base.type = EINA_SIMPLE_XML_NODE_ROOT;
+   return n;
+}
+
+static inline Eina_Bool
+_eina_simple_xml_arena_node_cb(void *data, Eina_Simple_XML_Type type, const char *content, unsigned offset EINA_UNUSED, unsigned length)
+{
+   Eina_Simple_XML_Arena_Load *ctx = (Eina_Simple_XML_Arena_Load *)data;
+   Eina_Simple_XML_Node_Type node_type;
+   Eina_Simple_XML_Node_Data *n;
+
+   switch (type)
+     {
+      case EINA_SIMPLE_XML_OPEN:
+      case EINA_SIMPLE_XML_OPEN_EMPTY:
+        {
+           Eina_Simple_XML_Node_Tag *tag;
+           const char *attrs, *name_end;
+
+           attrs = eina_simple_xml_tag_attributes_find(content, length);
+           name_end = attrs ? attrs : content + length;
+           while ((name_end > content) &&
+                  ((name_end[-1] == ' ') || (name_end[-1] == '\t') ||
+                   (name_end[-1] == '\n') || (name_end[-1] == '\r')))
+             name_end--;
+
+           tag = _eina_simple_xml_arena_tag_new(ctx, ctx->current, content, name_end - content);
+           if (!tag) return EINA_FALSE;
+
+           if (attrs)
+             {
+                ctx->attr_parent = tag;
+                eina_simple_xml_attributes_parse(attrs, length - (attrs - content),
+                                                 _eina_simple_xml_arena_attr_cb, ctx);
+             }
+
+           if (type == EINA_SIMPLE_XML_OPEN)
+             ctx->current = tag;
+           return EINA_TRUE;
+        }
+
+      case EINA_SIMPLE_XML_CLOSE:
+        {
+           const char *end = content + length;
+           size_t len;
+
+           if (!ctx->current->base.parent) return EINA_TRUE;
+           while ((end > content) &&
+                  ((end[-1] == ' ') || (end[-1] == '\t') ||
+                   (end[-1] == '\n') || (end[-1] == '\r')))
+             end--;
+           len = end - content;
+           /* same rule as eina_simple_xml_node_load(), mismatches are
+            * ignored and </> closes whatever is open */
+           if ((len == 0) ||
+               ((strlen(ctx->current->name) == len) &&
+                (!memcmp(ctx->current->name, content, len))))
+             ctx->current = ctx->current->base.parent;
+           return EINA_TRUE;
+        }
+
+      case EINA_SIMPLE_XML_DATA: node_type = EINA_SIMPLE_XML_NODE_DATA; break;
+      case EINA_SIMPLE_XML_CDATA: node_type = EINA_SIMPLE_XML_NODE_CDATA; break;
+      case EINA_SIMPLE_XML_PROCESSING: node_type = EINA_SIMPLE_XML_NODE_PROCESSING; break;
+      case EINA_SIMPLE_XML_DOCTYPE: node_type = EINA_SIMPLE_XML_NODE_DOCTYPE; break;
+      case EINA_SIMPLE_XML_DOCTYPE_CHILD: node_type = EINA_SIMPLE_XML_NODE_DOCTYPE_CHILD; break;
+      case EINA_SIMPLE_XML_COMMENT: node_type = EINA_SIMPLE_XML_NODE_COMMENT; break;
+
+      case EINA_SIMPLE_XML_ERROR:
+      case EINA_SIMPLE_XML_IGNORED:
+      default:
+         return EINA_TRUE;
+     }
+
+   n = (Eina_Simple_XML_Node_Data *)_eina_simple_xml_arena_alloc(ctx->arena, sizeof (Eina_Simple_XML_Node_Data) + length + 1);
+   if (!n) return EINA_FALSE;
+   memset(n, 0, sizeof (Eina_Simple_XML_Node_Data));
+#ifdef EINA_MAGIC_DEBUG
+   EINA_MAGIC_SET(&n->base, ctx->magic_data);
+#endif
+   n->base.parent = ctx->current;
+   n->base.type = node_type;
+   n->length = length;
+   memcpy(n->data, content, length);
+   n->data[length] = '\0';
+   ctx->current->children = eina_inlist_append(ctx->current->children, EINA_INLIST_GET(&n->base));
+   return EINA_TRUE;
+}
+
+static inline Eina_Simple_XML_Arena_Load *
+_eina_simple_xml_arena_load_new(size_t size_hint)
+{
+   Eina_Simple_XML_Arena_Load *ctx;
+   Eina_Simple_XML_Arena *arena;
+   size_t size;
+
+   /* Nodes plus copied text take about twice the document, untouched
+    * pages of a large block are never made resident anyway. */
+   size = size_hint * 2 + 4096;
+   arena = (Eina_Simple_XML_Arena *)malloc(EINA_SIMPLE_XML_ARENA_HEADER + size);
+   if (!arena) return NULL;
+   arena->next = NULL;
+   arena->current = arena;
+   arena->size = size;
+   arena->used = 0;
+
+   ctx = (Eina_Simple_XML_Arena_Load *)_eina_simple_xml_arena_alloc(arena, sizeof (Eina_Simple_XML_Arena_Load));
+   memset(ctx, 0, sizeof (Eina_Simple_XML_Arena_Load));
+   ctx->arena = arena;
+
+#ifdef EINA_MAGIC_DEBUG
+   {
+      /* Borrow the magic numbers from regular nodes so the tree passes
+       * the checks done by eina_simple_xml_node_dump(). */
+      Eina_Simple_XML_Node_Tag *t;
+      Eina_Simple_XML_Node_Data *d;
+      Eina_Simple_XML_Attribute *a;
+
+      t = eina_simple_xml_node_tag_new(NULL, "");
+      if (!t) goto on_error;
+      d = eina_simple_xml_node_data_new(t, "", 0);
+      a = eina_simple_xml_attribute_new(t, "", "");
+      ctx->magic_tag = t->base.__magic;
+      if (d) ctx->magic_data = d->base.__magic;
+      if (a) ctx->magic_attribute = a->__magic;
+      eina_simple_xml_node_tag_free(t);
+   }
+#endif
+
+   ctx->current = _eina_simple_xml_arena_tag_new(ctx, NULL, "?xml", 4);
+   if (!ctx->current) goto on_error;
+   return ctx;
+
+ on_error:
+   free(arena);
+   return NULL;
+}
+
+static inline Eina_Simple_XML_Arena *
+_eina_simple_xml_arena_from_root(Eina_Simple_XML_Node_Root *root)
+{
+   /* the root tag always directly follows the load context in the first
+    * block, see _eina_simple_xml_arena_load_new() */
+   return (Eina_Simple_XML_Arena *)
+     (((unsigned char *)root) -
+      EINA_SIMPLE_XML_ARENA_ALIGN(sizeof (Eina_Simple_XML_Arena_Load)) -
+      EINA_SIMPLE_XML_ARENA_HEADER);
+}
+
+static inline Eina_Simple_XML_Node_Root *
+eina_simple_xml_node_arena_load(const char *buf, unsigned buflen, Eina_Bool strip)
+{
+   Eina_Simple_XML_Arena_Load *ctx;
+   Eina_Simple_XML_Node_Root *root;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(buf, NULL);
+
+   ctx = _eina_simple_xml_arena_load_new(buflen);
+   if (!ctx) return NULL;
+
+   root = ctx->current;
+   eina_simple_xml_parse(buf, buflen, strip, _eina_simple_xml_arena_node_cb, ctx);
+   return root;
+}
+
+static inline Eina_Simple_XML_Stream *
+eina_simple_xml_node_arena_stream_new(Eina_Bool strip, size_t size_hint, Eina_Simple_XML_Node_Root **root)
+{
+   Eina_Simple_XML_Arena_Load *ctx;
+   Eina_Simple_XML_Stream *s;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(root, NULL);
+
+   ctx = _eina_simple_xml_arena_load_new(size_hint);
+   if (!ctx) return NULL;
+
+   s = eina_simple_xml_stream_new(strip, _eina_simple_xml_arena_node_cb, ctx);
+   if (!s)
+     {
+        eina_simple_xml_node_arena_free(ctx->current);
+        return NULL;
+     }
+
+   *root = ctx->current;
+   return s;
+}
+
+static inline void
+eina_simple_xml_node_arena_free(Eina_Simple_XML_Node_Root *root)
+{
+   Eina_Simple_XML_Arena *arena, *next;
+
+   if (!root) return;
+
+   arena = _eina_simple_xml_arena_from_root(root);
+   for (next = arena->next; next; )
+     {
+        Eina_Simple_XML_Arena *a = next;
+
+        next = a->next;
+        free(a);
+     }
+   free(arena);
+}
+
+#undef EINA_SIMPLE_XML_ARENA_HEADER
+#undef EINA_SIMPLE_XML_ARENA_ALIGN
+
+#endif
@@ -0,0 +1,214 @@
+/* EINA - EFL data type library
+ * Copyright (C) 2016 Samsung Electronics Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library;
+ * if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EINA_INLINE_THREAD_X_
+#define EINA_INLINE_THREAD_X_
+
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "eina_safety_checks.h"
+#include "eina_cpu.h"
+
+/**
+ * @cond LOCAL
+ */
+
+/* The helpers have to be unique in the process while this code is
+ * compiled in every user, let the linker merge the copies. */
+#define EINA_THREAD_PARALLEL_SHARED __attribute__ ((weak))
+
+typedef struct _Eina_Thread_Parallel_Job Eina_Thread_Parallel_Job;
+typedef struct _Eina_Thread_Parallel_Pool Eina_Thread_Parallel_Pool;
+
+struct _Eina_Thread_Parallel_Job
+{
+   Eina_Thread_Parallel_Job *next; // jobs with indexes nobody took yet
+   Eina_Thread_Parallel_Cb func;
+   void *data;
+   unsigned int count;
+   unsigned int taken;
+   unsigned int finished;
+   pthread_cond_t done;
+};
+
+struct _Eina_Thread_Parallel_Pool
+{
+   pthread_mutex_t lock;
+   pthread_cond_t wake;
+   Eina_Thread_Parallel_Job *jobs;
+   Eina_Thread *tids; // helpers started, they run until the shutdown
+   unsigned int threads;
+   unsigned int quit; // shutdowns in progress
+};
+
+EINA_THREAD_PARALLEL_SHARED Eina_Thread_Parallel_Pool _eina_thread_parallel_pool =
+  { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL, NULL, 0, 0 };
+
+/* Take the next index of the first job that has one left, with the pool
+ * locked. A job leaves the list once its last index is taken, its owner
+ * waits for it to finish before the job goes out of scope. */
+static inline Eina_Thread_Parallel_Job *
+_eina_thread_parallel_take(Eina_Thread_Parallel_Pool *pool, unsigned int *index)
+{
+   Eina_Thread_Parallel_Job *job = pool->jobs;
+
+   if (!job) return NULL;
+   *index = job->taken++;
+   if (job->taken == job->count) pool->jobs = job->next;
+   return job;
+}
+
+static inline void
+_eina_thread_parallel_finish(Eina_Thread_Parallel_Job *job)
+{
+   if (++job->finished == job->count) pthread_cond_signal(&job->done);
+}
+
+static inline void *
+_eina_thread_parallel_helper(void *data, Eina_Thread t EINA_UNUSED)
+{
+   Eina_Thread_Parallel_Pool *pool = (Eina_Thread_Parallel_Pool *)data;
+   Eina_Thread_Parallel_Job *job;
+   unsigned int index;
+
+   pthread_mutex_lock(&pool->lock);
+   for (;;)
+     {
+        job = _eina_thread_parallel_take(pool, &index);
+        if (!job)
+          {
+             if (pool->quit) break;
+             pthread_cond_wait(&pool->wake, &pool->lock);
+             continue;
+          }
+        pthread_mutex_unlock(&pool->lock);
+        job->func(job->data, index);
+        pthread_mutex_lock(&pool->lock);
+        _eina_thread_parallel_finish(job);
+     }
+   pthread_mutex_unlock(&pool->lock);
+   return NULL;
+}
+
+/**
+ * @endcond
+ */
+
+static inline void
+eina_thread_parallel_run(unsigned int count, Eina_Thread_Parallel_Cb func, void *data)
+{
+   Eina_Thread_Parallel_Pool *pool = &_eina_thread_parallel_pool;
+   Eina_Thread_Parallel_Job job;
+   Eina_Thread_Parallel_Job **last;
+   unsigned int index, want;
+   int cpus;
+
+   EINA_SAFETY_ON_NULL_RETURN(func);
+   if (!count) return;
+   if (count == 1)
+     {
+        func(data, 0);
+        return;
+     }
+
+   job.next = NULL;
+   job.func = func;
+   job.data = data;
+   job.count = count;
+   job.taken = 0;
+   job.finished = 0;
+   pthread_cond_init(&job.done, NULL);
+
+   cpus = eina_cpu_count();
+   want = cpus > 1 ? (unsigned int)cpus - 1 : 0;
+   if (want > count - 1) want = count - 1;
+
+   pthread_mutex_lock(&pool->lock);
+   // A failed spawn only means fewer helpers, the caller runs the rest
+   if ((pool->threads < want) && (!pool->quit))
+     {
+        Eina_Thread *tids;
+
+        tids = (Eina_Thread *)realloc(pool->tids, want * sizeof (Eina_Thread));
+        if (tids) pool->tids = tids;
+        while ((tids) && (pool->threads < want))
+          {
+             if (!eina_thread_create(&tids[pool->threads], EINA_THREAD_NORMAL,
+                                     -1, _eina_thread_parallel_helper, pool))
+               break;
+             pool->threads++;
+          }
+     }
+   for (last = &pool->jobs; *last; last = &(*last)->next)
+     ;
+   *last = &job;
+   pthread_cond_broadcast(&pool->wake);
+
+   /* the calling thread works on its own job until all indexes are taken */
+   while (job.taken < job.count)
+     {
+        index = job.taken++;
+        if (job.taken == job.count)
+          {
+             for (last = &pool->jobs; *last != &job; last = &(*last)->next)
+               ;
+             *last = job.next;
+          }
+        pthread_mutex_unlock(&pool->lock);
+        func(data, index);
+        pthread_mutex_lock(&pool->lock);
+        _eina_thread_parallel_finish(&job);
+     }
+   while (job.finished < job.count)
+     pthread_cond_wait(&job.done, &pool->lock);
+   pthread_mutex_unlock(&pool->lock);
+
+   pthread_cond_destroy(&job.done);
+}
+
+static inline void
+eina_thread_parallel_shutdown(void)
+{
+   Eina_Thread_Parallel_Pool *pool = &_eina_thread_parallel_pool;
+   Eina_Thread *tids;
+   unsigned int i, threads;
+
+   /* Helpers finish the jobs still queued before leaving, none is
+    * started until the last shutdown is done. */
+   pthread_mutex_lock(&pool->lock);
+   pool->quit++;
+   pthread_cond_broadcast(&pool->wake);
+   tids = pool->tids;
+   threads = pool->threads;
+   pool->tids = NULL;
+   pool->threads = 0;
+   pthread_mutex_unlock(&pool->lock);
+
+   for (i = 0; i < threads; i++)
+     eina_thread_join(tids[i]);
+   free(tids);
+
+   pthread_mutex_lock(&pool->lock);
+   pool->quit--;
+   pthread_mutex_unlock(&pool->lock);
+}
+
+#undef EINA_THREAD_PARALLEL_SHARED
+
+#endif
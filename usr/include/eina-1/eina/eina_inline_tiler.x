@@ -19,7 +19,19 @@
 #ifndef EINA_TILER_INLINE_H_
 #define EINA_TILER_INLINE_H_
 
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include "eina_safety_checks.h"
+#include "eina_alloca.h"
+#include "eina_cpu.h"
+
+#if defined(__SSE2__)
+# include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+# include <arm_neon.h>
+#endif
 
 /**
  * @cond LOCAL
@@ -148,4 +160,432 @@ eina_tile_grid_slicer_setup(Eina_Tile_Grid_Slicer *slc, int x, int y, int w, int
    return EINA_TRUE;
 }
 
+/**
+ * @cond LOCAL
+ */
+struct _Eina_Tiler_Bitmap
+{
+   uint64_t *bits; // rows * stride words, 16 bytes aligned
+   unsigned int stride; // words per tile row, always even
+   unsigned int cols, rows;
+   int w, h;
+   int tile_w, tile_h;
+};
+
+typedef struct _Eina_Tiler_Bitmap_Span
+{
+   unsigned int c1, c2; // tile columns [c1, c2)
+   unsigned int row; // first tile row
+} Eina_Tiler_Bitmap_Span;
+
+/* Less work than this for each band does not pay for waking a helper
+ * thread: rectangles to clip for rects_add(), bitmap words to walk for
+ * rects_get(). */
+#define EINA_TILER_BITMAP_BAND_RECTS 256
+#define EINA_TILER_BITMAP_BAND_WORDS 4096
+
+typedef struct _Eina_Tiler_Bitmap_Job
+{
+   Eina_Tiler_Bitmap *t;
+   unsigned int row1, row2; // tile rows [row1, row2) of this band
+   const Eina_Rectangle *rects;
+   unsigned int count;
+   Eina_Rectangle *out;
+   unsigned int out_count, out_size;
+   Eina_Bool failed;
+} Eina_Tiler_Bitmap_Job;
+/**
+ * @endcond
+ */
+
+static inline Eina_Tiler_Bitmap *
+eina_tiler_bitmap_new(int w, int h, int tile_w, int tile_h)
+{
+   Eina_Tiler_Bitmap *t;
+   void *bits;
+
+   if ((w <= 0) || (h <= 0) || (tile_w <= 0) || (tile_h <= 0)) return NULL;
+
+   t = (Eina_Tiler_Bitmap *)calloc(1, sizeof (Eina_Tiler_Bitmap));
+   if (!t) return NULL;
+
+   t->w = w;
+   t->h = h;
+   t->tile_w = tile_w;
+   t->tile_h = tile_h;
+   t->cols = (w + tile_w - 1) / tile_w;
+   t->rows = (h + tile_h - 1) / tile_h;
+   t->stride = ((t->cols + 127) / 128) * 2;
+
+   if (posix_memalign(&bits, 16, (size_t)t->stride * t->rows * sizeof (uint64_t)))
+     {
+        free(t);
+        return NULL;
+     }
+   t->bits = (uint64_t *)bits;
+   eina_tiler_bitmap_clear(t);
+   return t;
+}
+
+static inline void
+eina_tiler_bitmap_free(Eina_Tiler_Bitmap *t)
+{
+   if (!t) return;
+   free(t->bits);
+   free(t);
+}
+
+static inline void
+eina_tiler_bitmap_clear(Eina_Tiler_Bitmap *t)
+{
+   EINA_SAFETY_ON_NULL_RETURN(t);
+   memset(t->bits, 0, (size_t)t->stride * t->rows * sizeof (uint64_t));
+}
+
+static inline Eina_Bool
+eina_tiler_bitmap_empty(const Eina_Tiler_Bitmap *t)
+{
+   const uint64_t *itr, *end;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(t, EINA_TRUE);
+
+   itr = t->bits;
+   end = itr + (size_t)t->stride * t->rows;
+#if defined(__SSE2__)
+   {
+      __m128i acc = _mm_setzero_si128();
+
+      for (; itr < end; itr += 2)
+        acc = _mm_or_si128(acc, _mm_load_si128((const __m128i *)(const void *)itr));
+      return _mm_movemask_epi8(_mm_cmpeq_epi8(acc, _mm_setzero_si128())) == 0xffff;
+   }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+   {
+      uint64x2_t acc = vdupq_n_u64(0);
+
+      for (; itr < end; itr += 2)
+        acc = vorrq_u64(acc, vld1q_u64(itr));
+      return (vgetq_lane_u64(acc, 0) | vgetq_lane_u64(acc, 1)) == 0;
+   }
+#else
+   for (; itr < end; itr++)
+     if (*itr) return EINA_FALSE;
+   return EINA_TRUE;
+#endif
+}
+
+/* Set tiles [c1, c2] of rows [r1, r2], a word at a time. */
+static inline void
+_eina_tiler_bitmap_fill(Eina_Tiler_Bitmap *t, unsigned int c1, unsigned int c2, unsigned int r1, unsigned int r2)
+{
+   unsigned int w1 = c1 >> 6, w2 = c2 >> 6;
+   uint64_t m1 = ~0ULL << (c1 & 63);
+   uint64_t m2 = ~0ULL >> (63 - (c2 & 63));
+   unsigned int r, i;
+
+   for (r = r1; r <= r2; r++)
+     {
+        uint64_t *row = t->bits + (size_t)r * t->stride;
+
+        if (w1 == w2)
+          {
+             row[w1] |= m1 & m2;
+             continue;
+          }
+        row[w1] |= m1;
+        for (i = w1 + 1; i < w2; i++) row[i] = ~0ULL;
+        row[w2] |= m2;
+     }
+}
+
+/* Clip @p r to the bitmap and to tile rows [row1, row2), then fill it. */
+static inline Eina_Bool
+_eina_tiler_bitmap_rect_fill(Eina_Tiler_Bitmap *t, const Eina_Rectangle *r, unsigned int row1, unsigned int row2)
+{
+   int x1, y1, x2, y2;
+   unsigned int r1, r2;
+
+   if ((r->w <= 0) || (r->h <= 0)) return EINA_FALSE;
+
+   x1 = r->x < 0 ? 0 : r->x;
+   y1 = r->y < 0 ? 0 : r->y;
+   x2 = r->x + r->w > t->w ? t->w : r->x + r->w;
+   y2 = r->y + r->h > t->h ? t->h : r->y + r->h;
+   if ((x1 >= x2) || (y1 >= y2)) return EINA_FALSE;
+
+   r1 = y1 / t->tile_h;
+   r2 = (y2 - 1) / t->tile_h;
+   if (r1 < row1) r1 = row1;
+   if (r2 >= row2) r2 = row2 - 1;
+   if (r1 > r2) return EINA_FALSE;
+
+   _eina_tiler_bitmap_fill(t, x1 / t->tile_w, (x2 - 1) / t->tile_w, r1, r2);
+   return EINA_TRUE;
+}
+
+static inline Eina_Bool
+eina_tiler_bitmap_rect_add(Eina_Tiler_Bitmap *t, const Eina_Rectangle *r)
+{
+   EINA_SAFETY_ON_NULL_RETURN_VAL(t, EINA_FALSE);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(r, EINA_FALSE);
+
+   return _eina_tiler_bitmap_rect_fill(t, r, 0, t->rows);
+}
+
+/* How many bands to cut the bitmap in for @p work units of work, so that
+ * each band gets at least @p band_work of them. */
+static inline unsigned int
+_eina_tiler_bitmap_bands(const Eina_Tiler_Bitmap *t, unsigned int threads, size_t work, size_t band_work)
+{
+   size_t most = work / band_work;
+
+   if (!threads) threads = eina_cpu_count();
+   if (threads > most) threads = most;
+   if (threads > t->rows) threads = t->rows;
+   if (threads < 1) threads = 1;
+   return threads;
+}
+
+static inline void
+_eina_tiler_bitmap_add_job(void *data, unsigned int index)
+{
+   Eina_Tiler_Bitmap_Job *job = (Eina_Tiler_Bitmap_Job *)data + index;
+   unsigned int i;
+
+   for (i = 0; i < job->count; i++)
+     _eina_tiler_bitmap_rect_fill(job->t, job->rects + i, job->row1, job->row2);
+}
+
+static inline void
+_eina_tiler_bitmap_jobs_setup(Eina_Tiler_Bitmap *t, Eina_Tiler_Bitmap_Job *jobs, unsigned int count)
+{
+   unsigned int i, rows = (t->rows + count - 1) / count;
+
+   memset(jobs, 0, count * sizeof (Eina_Tiler_Bitmap_Job));
+   for (i = 0; i < count; i++)
+     {
+        jobs[i].t = t;
+        jobs[i].row1 = i * rows;
+        jobs[i].row2 = (i + 1) * rows > t->rows ? t->rows : (i + 1) * rows;
+     }
+}
+
+static inline void
+eina_tiler_bitmap_rects_add(Eina_Tiler_Bitmap *t, const Eina_Rectangle *rects, unsigned int count, unsigned int threads)
+{
+   Eina_Tiler_Bitmap_Job *jobs;
+   unsigned int i, bands;
+
+   EINA_SAFETY_ON_NULL_RETURN(t);
+   if (!count) return;
+   EINA_SAFETY_ON_NULL_RETURN(rects);
+
+   bands = _eina_tiler_bitmap_bands(t, threads, count, EINA_TILER_BITMAP_BAND_RECTS);
+   jobs = (Eina_Tiler_Bitmap_Job *)alloca(bands * sizeof (Eina_Tiler_Bitmap_Job));
+   _eina_tiler_bitmap_jobs_setup(t, jobs, bands);
+   for (i = 0; i < bands; i++)
+     {
+        jobs[i].rects = rects;
+        jobs[i].count = count;
+     }
+   eina_thread_parallel_run(bands, _eina_tiler_bitmap_add_job, jobs);
+}
+
+static inline Eina_Bool
+eina_tiler_bitmap_union(Eina_Tiler_Bitmap *dst, const Eina_Tiler_Bitmap *src)
+{
+   uint64_t *d, *end;
+   const uint64_t *s;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(dst, EINA_FALSE);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(src, EINA_FALSE);
+   if ((dst->w != src->w) || (dst->h != src->h) ||
+       (dst->tile_w != src->tile_w) || (dst->tile_h != src->tile_h))
+     return EINA_FALSE;
+
+   d = dst->bits;
+   s = src->bits;
+   end = d + (size_t)dst->stride * dst->rows;
+#if defined(__SSE2__)
+   for (; d < end; d += 2, s += 2)
+     _mm_store_si128((__m128i *)(void *)d,
+                     _mm_or_si128(_mm_load_si128((const __m128i *)(const void *)d),
+                                  _mm_load_si128((const __m128i *)(const void *)s)));
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+   for (; d < end; d += 2, s += 2)
+     vst1q_u64(d, vorrq_u64(vld1q_u64(d), vld1q_u64(s)));
+#else
+   for (; d < end; d++, s++)
+     *d |= *s;
+#endif
+   return EINA_TRUE;
+}
+
+/* First tile >= c whose bit equals @p set, or t->cols. Padding bits are
+ * never set, so looking for a clear bit always stops at t->cols. */
+static inline unsigned int
+_eina_tiler_bitmap_next(const Eina_Tiler_Bitmap *t, const uint64_t *row, unsigned int c, Eina_Bool set)
+{
+   unsigned int i = c >> 6;
+   uint64_t w;
+
+   if (c >= t->cols) return t->cols;
+   w = (set ? row[i] : ~row[i]) & (~0ULL << (c & 63));
+   while (!w)
+     {
+        if (++i >= t->stride) return t->cols;
+        w = set ? row[i] : ~row[i];
+     }
+   c = (i << 6) + __builtin_ctzll(w);
+   return c > t->cols ? t->cols : c;
+}
+
+static inline Eina_Bool
+_eina_tiler_bitmap_emit(Eina_Tiler_Bitmap_Job *job, const Eina_Tiler_Bitmap_Span *sp, unsigned int row_end)
+{
+   const Eina_Tiler_Bitmap *t = job->t;
+   Eina_Rectangle *r;
+   int x2, y2;
+
+   if (job->out_count == job->out_size)
+     {
+        unsigned int size = job->out_size ? job->out_size * 2 : 64;
+        Eina_Rectangle *tmp = (Eina_Rectangle *)realloc(job->out, size * sizeof (Eina_Rectangle));
+
+        if (!tmp) return EINA_FALSE;
+        job->out = tmp;
+        job->out_size = size;
+     }
+
+   r = job->out + job->out_count++;
+   r->x = sp->c1 * t->tile_w;
+   r->y = sp->row * t->tile_h;
+   x2 = sp->c2 * t->tile_w;
+   y2 = row_end * t->tile_h;
+   r->w = (x2 > t->w ? t->w : x2) - r->x;
+   r->h = (y2 > t->h ? t->h : y2) - r->y;
+   return EINA_TRUE;
+}
+
+static inline int
+_eina_tiler_bitmap_rect_cmp(const void *a, const void *b)
+{
+   const Eina_Rectangle *ra = (const Eina_Rectangle *)a;
+   const Eina_Rectangle *rb = (const Eina_Rectangle *)b;
+
+   if (ra->y != rb->y) return ra->y < rb->y ? -1 : 1;
+   if (ra->x != rb->x) return ra->x < rb->x ? -1 : 1;
+   return 0;
+}
+
+static inline void
+_eina_tiler_bitmap_merge_job(void *data, unsigned int index)
+{
+   Eina_Tiler_Bitmap_Job *job = (Eina_Tiler_Bitmap_Job *)data + index;
+   const Eina_Tiler_Bitmap *t = job->t;
+   Eina_Tiler_Bitmap_Span *prev, *cur, *tmp;
+   unsigned int prev_count = 0, r, i;
+   size_t spans = t->cols / 2 + 1;
+
+   prev = (Eina_Tiler_Bitmap_Span *)malloc(2 * spans * sizeof (Eina_Tiler_Bitmap_Span));
+   if (!prev)
+     {
+        job->failed = EINA_TRUE;
+        return;
+     }
+   cur = prev + spans;
+
+   for (r = job->row1; r < job->row2; r++)
+     {
+        const uint64_t *row = t->bits + (size_t)r * t->stride;
+        unsigned int cur_count = 0, p = 0, c = 0;
+
+        for (;;)
+          {
+             unsigned int c1, c2;
+
+             c1 = _eina_tiler_bitmap_next(t, row, c, EINA_TRUE);
+             if (c1 >= t->cols) break;
+             c2 = _eina_tiler_bitmap_next(t, row, c1, EINA_FALSE);
+             c = c2;
+
+             /* spans of the previous row left of this run are finished */
+             while ((p < prev_count) && (prev[p].c1 < c1))
+               if (!_eina_tiler_bitmap_emit(job, &prev[p++], r)) goto on_error;
+
+             cur[cur_count].c1 = c1;
+             cur[cur_count].c2 = c2;
+             if ((p < prev_count) && (prev[p].c1 == c1) && (prev[p].c2 == c2))
+               cur[cur_count].row = prev[p++].row;
+             else
+               cur[cur_count].row = r;
+             cur_count++;
+          }
+        for (; p < prev_count; p++)
+          if (!_eina_tiler_bitmap_emit(job, &prev[p], r)) goto on_error;
+
+        tmp = prev;
+        prev = cur;
+        cur = tmp;
+        prev_count = cur_count;
+     }
+   for (i = 0; i < prev_count; i++)
+     if (!_eina_tiler_bitmap_emit(job, &prev[i], job->row2)) goto on_error;
+
+   free(prev < cur ? prev : cur);
+   if (job->out_count > 1)
+     qsort(job->out, job->out_count, sizeof (Eina_Rectangle), _eina_tiler_bitmap_rect_cmp);
+   return;
+
+ on_error:
+   free(prev < cur ? prev : cur);
+   job->failed = EINA_TRUE;
+}
+
+static inline Eina_Rectangle *
+eina_tiler_bitmap_rects_get(const Eina_Tiler_Bitmap *t, unsigned int threads, unsigned int *count)
+{
+   Eina_Tiler_Bitmap_Job *jobs;
+   Eina_Rectangle *r = NULL;
+   unsigned int i, bands, total = 0;
+   Eina_Bool failed = EINA_FALSE;
+
+   if (count) *count = 0;
+   EINA_SAFETY_ON_NULL_RETURN_VAL(t, NULL);
+
+   bands = _eina_tiler_bitmap_bands(t, threads, (size_t)t->stride * t->rows,
+                                    EINA_TILER_BITMAP_BAND_WORDS);
+   jobs = (Eina_Tiler_Bitmap_Job *)alloca(bands * sizeof (Eina_Tiler_Bitmap_Job));
+   _eina_tiler_bitmap_jobs_setup((Eina_Tiler_Bitmap *)t, jobs, bands);
+   eina_thread_parallel_run(bands, _eina_tiler_bitmap_merge_job, jobs);
+
+   for (i = 0; i < bands; i++)
+     {
+        failed |= jobs[i].failed;
+        total += jobs[i].out_count;
+     }
+
+   if ((!failed) && (total))
+     {
+        /* band 0 already holds the first rectangles, grow it in place */
+        r = (Eina_Rectangle *)realloc(jobs[0].out, total * sizeof (Eina_Rectangle));
+        if (r)
+          {
+             jobs[0].out = NULL;
+             total = jobs[0].out_count;
+             for (i = 1; i < bands; i++)
+               {
+                  if (jobs[i].out_count)
+                    memcpy(r + total, jobs[i].out, jobs[i].out_count * sizeof (Eina_Rectangle));
+                  total += jobs[i].out_count;
+               }
+             if (count) *count = total;
+          }
+     }
+
+   for (i = 0; i < bands; i++)
+     free(jobs[i].out);
+   return r;
+}
+
 #endif
@@ -22,6 +22,7 @@
 #include "eina_config.h"
 
 #include "eina_inlist.h"
+#include "eina_rectangle.h"
 
 typedef struct _Eina_QuadTree      Eina_QuadTree;
 typedef struct _Eina_QuadTree_Item Eina_QuadTree_Item;
@@ -50,4 +51,41 @@ EAPI Eina_Bool           eina_quadtree_show(Eina_QuadTree_Item *object);
 EAPI Eina_Inlist        *eina_quadtree_collide(Eina_QuadTree *q, int x, int y, int w, int h);
 EAPI void               *eina_quadtree_object(Eina_Inlist *list);
 
+/*
+ * Bulk helpers, each call replaces a loop over the functions above.
+ *
+ * eina_quadtree_collide_array() runs @p count queries and stores the objects
+ * found by query i in results[offsets[i]] to results[offsets[i + 1] - 1], so
+ * @p offsets must hold @p count + 1 entries. At most @p max objects are
+ * stored, the return value is the number of objects found, when it is
+ * bigger than @p max the caller can grow @p results and ask again.
+ */
+static inline unsigned int eina_quadtree_add_array(Eina_QuadTree *q, const void **objects, unsigned int count, Eina_QuadTree_Item **items);
+static inline unsigned int eina_quadtree_change_array(Eina_QuadTree_Item **items, unsigned int count);
+static inline unsigned int eina_quadtree_collide_array(Eina_QuadTree *q, const Eina_Rectangle *queries, unsigned int count, void **results, unsigned int max, unsigned int *offsets);
+
+/*
+ * Eina_QuadTree_Soa is a quadtree for large sets of objects whose geometry
+ * is pushed in arrays rather than asked through callbacks. Geometry is kept
+ * as structure of arrays and, when the tree is rebuilt, reordered so the
+ * objects of a node are contiguous and a query scans plain int arrays.
+ *
+ * Objects are identified by the index returned when they were added.
+ * Adding, changing and deleting only mark the tree dirty, it is rebuilt
+ * by the next query or by eina_quadtree_soa_cycle(). Queries work like
+ * eina_quadtree_collide_array().
+ */
+typedef struct _Eina_QuadTree_Soa Eina_QuadTree_Soa;
+
+static inline Eina_QuadTree_Soa *eina_quadtree_soa_new(int w, int h);
+static inline void               eina_quadtree_soa_free(Eina_QuadTree_Soa *q);
+static inline unsigned int       eina_quadtree_soa_count(const Eina_QuadTree_Soa *q);
+static inline int                eina_quadtree_soa_add_array(Eina_QuadTree_Soa *q, const Eina_Rectangle *geometry, const void **objects, unsigned int count);
+static inline void               eina_quadtree_soa_change_array(Eina_QuadTree_Soa *q, const unsigned int *ids, const Eina_Rectangle *geometry, unsigned int count);
+static inline void               eina_quadtree_soa_del(Eina_QuadTree_Soa *q, unsigned int id);
+static inline void               eina_quadtree_soa_cycle(Eina_QuadTree_Soa *q);
+static inline unsigned int       eina_quadtree_soa_collide_array(Eina_QuadTree_Soa *q, const Eina_Rectangle *queries, unsigned int count, void **results, unsigned int max, unsigned int *offsets);
+
+#include "eina_inline_quadtree.x"
+
 #endif
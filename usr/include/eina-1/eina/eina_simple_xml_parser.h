@@ -25,6 +25,7 @@
 #include "eina_types.h"
 #include "eina_magic.h"
 #include "eina_inlist.h"
+#include "eina_file.h"
 
 /**
  * @page eina_simple_xml_parser_example_01_page
@@ -597,6 +598,192 @@ EAPI void eina_simple_xml_node_root_free(Eina_Simple_XML_Node_Root *root);
  */
 EAPI char * eina_simple_xml_node_dump(Eina_Simple_XML_Node *node, const char *indent);
 
+/**
+ * @typedef Eina_Simple_XML_Scan
+ * Set of special characters looked up by eina_simple_xml_scan().
+ */
+typedef enum _Eina_Simple_XML_Scan
+{
+  EINA_SIMPLE_XML_SCAN_LT = (1 << 0), /*!< '\<' tag start */
+  EINA_SIMPLE_XML_SCAN_GT = (1 << 1), /*!< '\>' tag end */
+  EINA_SIMPLE_XML_SCAN_AMP = (1 << 2), /*!< '&' entity start */
+  EINA_SIMPLE_XML_SCAN_QUOTE = (1 << 3), /*!< '"' and '\'' attribute quotes */
+  EINA_SIMPLE_XML_SCAN_ALL = 0xf /*!< all of the above */
+} Eina_Simple_XML_Scan;
+
+/**
+ * @typedef Eina_Simple_XML_Stream
+ * Incremental parser context, see eina_simple_xml_stream_new().
+ */
+typedef struct _Eina_Simple_XML_Stream Eina_Simple_XML_Stream;
+
+/**
+ * Find the first XML special character in a buffer.
+ *
+ * @param itr start of the buffer to scan.
+ * @param itr_end end of the buffer (one past the last byte).
+ * @param what which characters to look for.
+ * @return pointer to the first matching character, or @a itr_end if none
+ *         was found.
+ *
+ * The buffer is compared 16 bytes at a time using SSE2 or NEON when the
+ * compiler targets them, and byte per byte otherwise.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline const char *eina_simple_xml_scan(const char *itr, const char *itr_end, Eina_Simple_XML_Scan what);
+
+/**
+ * Create an incremental parser that accepts the document in chunks.
+ *
+ * @param strip same as in eina_simple_xml_parse().
+ * @param func what to call back while parsing, same as in
+ *        eina_simple_xml_parse(). The offset given to @a func is relative
+ *        to the start of the whole stream, but @a content is only valid
+ *        during the call.
+ * @param data what to give as context to @a func.
+ * @return a new stream, or @c NULL on allocation failure.
+ *
+ * Chunks can be split anywhere, including in the middle of a tag or a
+ * comment. Only the bytes of the last incomplete token are kept between
+ * two calls to eina_simple_xml_stream_feed(), complete tokens are handed to
+ * eina_simple_xml_parse() straight away, so the callbacks are exactly the
+ * ones a single call on the whole document would produce.
+ *
+ * @see eina_simple_xml_stream_feed()
+ * @see eina_simple_xml_stream_end()
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Simple_XML_Stream *eina_simple_xml_stream_new(Eina_Bool strip, Eina_Simple_XML_Cb func, const void *data);
+
+/**
+ * Free a stream created by eina_simple_xml_stream_new().
+ *
+ * @param s stream to free. Pending bytes are discarded, call
+ *        eina_simple_xml_stream_end() first to get them parsed.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline void eina_simple_xml_stream_free(Eina_Simple_XML_Stream *s);
+
+/**
+ * Give the next chunk of the document to the stream.
+ *
+ * @param s the stream.
+ * @param chunk the bytes. When no incomplete token is pending, complete
+ *        tokens are parsed straight from @a chunk and only its incomplete
+ *        tail is copied, otherwise @a chunk is appended to the pending
+ *        bytes.
+ * @param len how many bytes are in @a chunk.
+ * @return #EINA_TRUE on success or #EINA_FALSE if the parse was aborted by
+ *         the callback or memory is exhausted. Once it failed, a stream
+ *         keeps returning #EINA_FALSE.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool eina_simple_xml_stream_feed(Eina_Simple_XML_Stream *s, const char *chunk, size_t len);
+
+/**
+ * Feed the content of a file to the stream, one mapped window at a time.
+ *
+ * @param s the stream.
+ * @param file the file to read from.
+ * @param window how many bytes to map at once, rounded up to the page
+ *        size. @c 0 selects a 1MB window.
+ * @return #EINA_TRUE on success or #EINA_FALSE on mapping or parse errors.
+ *
+ * Only one window of @a file is mapped at any time, so documents larger
+ * than the address space that can be spared are fine too.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool eina_simple_xml_stream_file_feed(Eina_Simple_XML_Stream *s, Eina_File *file, size_t window);
+
+/**
+ * Tell the stream that no more data will come.
+ *
+ * @param s the stream.
+ * @return #EINA_TRUE on success or #EINA_FALSE if the parse was aborted.
+ *
+ * Whatever was pending is parsed, so trailing text and a truncated last
+ * tag are reported the way eina_simple_xml_parse() reports them.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool eina_simple_xml_stream_end(Eina_Simple_XML_Stream *s);
+
+/**
+ * Load a XML node tree allocated from a single arena.
+ *
+ * @param buf the input string. May not contain \0 terminator.
+ * @param buflen the input string size.
+ * @param strip whenever this parser should strip leading and trailing
+ *        whitespace.
+ * @return Document root with children tags, or @c NULL on errors.
+ *
+ * This builds the same tree as eina_simple_xml_node_load() but nodes,
+ * attributes and strings are carved out of one memory block sized after
+ * @a buflen (chained to another one if it ever runs out) instead of being
+ * allocated one by one. Tag names, attribute keys and values are plain
+ * strings stored in the arena, not stringshares.
+ *
+ * The tree can be walked and given to eina_simple_xml_node_dump(), but it
+ * must not be modified with the node and attribute functions above and it
+ * must be released with eina_simple_xml_node_arena_free(), never with
+ * eina_simple_xml_node_root_free().
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Simple_XML_Node_Root *eina_simple_xml_node_arena_load(const char *buf, unsigned buflen, Eina_Bool strip);
+
+/**
+ * Create a stream that builds an arena node tree from chunks.
+ *
+ * @param strip whenever this parser should strip leading and trailing
+ *        whitespace.
+ * @param size_hint expected document size, used to size the arena. @c 0
+ *        starts small and grows as needed.
+ * @param root where to store the document root. It is valid as soon as
+ *        the stream is created and is complete after
+ *        eina_simple_xml_stream_end(). It belongs to the caller and must
+ *        be released with eina_simple_xml_node_arena_free(), freeing the
+ *        stream does not release it.
+ * @return a new stream, or @c NULL on allocation failure.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Simple_XML_Stream *eina_simple_xml_node_arena_stream_new(Eina_Bool strip, size_t size_hint, Eina_Simple_XML_Node_Root **root);
+
+/**
+ * Release a tree loaded by eina_simple_xml_node_arena_load().
+ *
+ * @param root the document root.
+ *
+ * Every node goes away with the arena, so this costs one free() per arena
+ * block no matter how large the document was.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline void eina_simple_xml_node_arena_free(Eina_Simple_XML_Node_Root *root);
 
 /**
  * @}
@@ -606,4 +793,6 @@ EAPI char * eina_simple_xml_node_dump(Eina_Simple_XML_Node *node, const char *in
  * @}
  */
 
+#include "eina_inline_simple_xml_parser.x"
+
 #endif /* EINA_SIMPLE_XML_H_ */
@@ -151,6 +151,52 @@ EAPI void *eina_thread_join(Eina_Thread t);
  */
 EAPI Eina_Bool eina_thread_name_set(Eina_Thread t, const char *name);
 
+/**
+ * @typedef Eina_Thread_Parallel_Cb
+ * Type of the function run by eina_thread_parallel_run() for each index.
+ */
+typedef void (*Eina_Thread_Parallel_Cb)(void *data, unsigned int index);
+
+/**
+ * Run @p func once for each index in [0, @p count) and wait for all of
+ * them to finish.
+ *
+ * The calling thread runs indexes too, the others are taken by helper
+ * threads that are started on the first call, one less than there are
+ * cores, and then wait for more work instead of exiting. Calls from
+ * several threads share the helpers. Nothing guarantees that two indexes
+ * run at the same time, a busy or missing helper only means that the
+ * calling thread runs more of them.
+ *
+ * @warning The helpers run code of the module that started them, a module
+ * that may be unloaded must call eina_thread_parallel_shutdown() before
+ * it is. Every shared object built with hidden symbols has its own
+ * helpers.
+ *
+ * @param count how many times to call @p func.
+ * @param func the function to call, with @p data and the index.
+ * @param data what to give to @p func.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline void eina_thread_parallel_run(unsigned int count, Eina_Thread_Parallel_Cb func, void *data);
+
+/**
+ * Stop the helper threads of eina_thread_parallel_run()
+ *
+ * This waits for the helpers to finish the work already given to them
+ * and joins them, the next eina_thread_parallel_run() starts new ones.
+ * It has to be called before eina_shutdown(), and by a module that used
+ * eina_thread_parallel_run() before it gets unloaded.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline void eina_thread_parallel_shutdown(void);
+
 /**
  * @}
  */
@@ -159,4 +205,6 @@ EAPI Eina_Bool eina_thread_name_set(Eina_Thread t, const char *name);
  * @}
  */
 
+#include "eina_inline_thread.x"
+
 #endif
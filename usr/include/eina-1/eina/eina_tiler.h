@@ -22,6 +22,7 @@
 #include "eina_types.h"
 #include "eina_iterator.h"
 #include "eina_rectangle.h"
+#include "eina_thread.h"
 
 /**
  * @page eina_tiler_example_01
@@ -460,6 +461,140 @@ static inline Eina_Bool eina_tile_grid_slicer_next(Eina_Tile_Grid_Slicer *slc, c
  */
 static inline Eina_Bool eina_tile_grid_slicer_setup(Eina_Tile_Grid_Slicer *slc, int x, int y, int w, int h, int tile_w, int tile_h);
 
+/**
+ * @typedef Eina_Tiler_Bitmap
+ * Tile occupancy bitmap, a cheaper alternative to #Eina_Tiler for large
+ * numbers of small damage rectangles.
+ */
+typedef struct _Eina_Tiler_Bitmap Eina_Tiler_Bitmap;
+
+/**
+ * @brief Creates a new tile occupancy bitmap.
+ *
+ * @param w Width of the area.
+ * @param h Height of the area.
+ * @param tile_w Tile width, rectangles are rounded out to it.
+ * @param tile_h Tile height, rectangles are rounded out to it.
+ * @return The newly created bitmap, @c NULL on failure.
+ *
+ * Unlike #Eina_Tiler, which keeps a list of rectangles and merges every new
+ * one with them, this keeps one bit per tile. Adding a rectangle sets whole
+ * words of bits at once, so its cost does not depend on how much damage
+ * was already added, and merging the bits back into rectangles is done
+ * once, when they are needed. Each tile row is padded to 128 bits so rows
+ * can be combined with SSE2 or NEON.
+ *
+ * @see eina_tiler_bitmap_rects_add()
+ * @see eina_tiler_bitmap_rects_get()
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Tiler_Bitmap *eina_tiler_bitmap_new(int w, int h, int tile_w, int tile_h);
+
+/**
+ * @brief Frees a tile occupancy bitmap.
+ *
+ * @param t The bitmap to free.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline void eina_tiler_bitmap_free(Eina_Tiler_Bitmap *t);
+
+/**
+ * @brief Removes all tiles from a bitmap.
+ *
+ * @param t The bitmap.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline void eina_tiler_bitmap_clear(Eina_Tiler_Bitmap *t);
+
+/**
+ * @brief Tells if a bitmap has no tile set.
+ *
+ * @param t The bitmap.
+ * @return #EINA_TRUE if no tile is set, #EINA_FALSE otherwise.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool eina_tiler_bitmap_empty(const Eina_Tiler_Bitmap *t);
+
+/**
+ * @brief Adds a rectangle to a bitmap.
+ *
+ * @param t The bitmap.
+ * @param r The rectangle, clipped to the bitmap area.
+ * @return #EINA_TRUE if something was added, #EINA_FALSE otherwise.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool eina_tiler_bitmap_rect_add(Eina_Tiler_Bitmap *t, const Eina_Rectangle *r);
+
+/**
+ * @brief Adds an array of rectangles to a bitmap.
+ *
+ * @param t The bitmap.
+ * @param rects The rectangles.
+ * @param count How many rectangles are in @p rects.
+ * @param threads How many threads may be used, the area is split in
+ *        horizontal bands, one per thread, so no locking is needed. 0 uses
+ *        as many threads as there are cores, 1 stays on the calling
+ *        thread. Bands run through eina_thread_parallel_run() and each
+ *        takes a few hundred rectangles, smaller batches stay on the
+ *        calling thread.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline void eina_tiler_bitmap_rects_add(Eina_Tiler_Bitmap *t, const Eina_Rectangle *rects, unsigned int count, unsigned int threads);
+
+/**
+ * @brief Adds the tiles of a bitmap to another one.
+ *
+ * @param dst The bitmap to add to.
+ * @param src The bitmap to add, it must have the same geometry as @p dst.
+ * @return #EINA_TRUE on success, #EINA_FALSE if the geometries differ.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool eina_tiler_bitmap_union(Eina_Tiler_Bitmap *dst, const Eina_Tiler_Bitmap *src);
+
+/**
+ * @brief Merges the tiles of a bitmap into rectangles.
+ *
+ * @param t The bitmap.
+ * @param threads How many threads may be used, as in
+ *        eina_tiler_bitmap_rects_add().
+ * @param count Where to store the number of rectangles.
+ * @return A newly allocated array of @p count rectangles to free() after
+ *         use, @c NULL if the bitmap is empty or on allocation failure.
+ *
+ * Runs of tiles of each row are merged with the identical runs of the rows
+ * below. Large bitmaps are cut in bands of rows, each merged on its own
+ * thread, small ones are merged as a single band on the calling thread,
+ * and the rectangles come band after band, top to bottom, and inside a
+ * band by increasing y then x. Rendering them in that order walks the
+ * destination buffer the way it is laid out in memory.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Rectangle *eina_tiler_bitmap_rects_get(const Eina_Tiler_Bitmap *t, unsigned int threads, unsigned int *count);
+
 #include "eina_inline_tiler.x"
 
 /**
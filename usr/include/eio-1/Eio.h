@@ -442,6 +442,112 @@ EAPI Eio_File *eio_file_direct_stat(const char *path,
                                     Eio_Error_Cb error_cb,
                                     const void *data);
 
+/**
+ * @typedef Eio_Walk
+ * A recursive directory walk started by eio_dir_walk().
+ */
+typedef struct _Eio_Walk Eio_Walk;
+
+/**
+ * @typedef Eio_Walk_Entry
+ * A file found by eio_dir_walk().
+ */
+typedef struct _Eio_Walk_Entry Eio_Walk_Entry;
+
+/**
+ * @typedef Eio_Walk_Progress
+ * Overall progress of eio_dir_walk().
+ */
+typedef struct _Eio_Walk_Progress Eio_Walk_Progress;
+
+/**
+ * @struct _Eio_Walk_Entry
+ * @brief A file found by eio_dir_walk(), valid during the callback it is given to.
+ */
+struct _Eio_Walk_Entry
+{
+   const char *path; /**< The full path of the file */
+   const char *name; /**< The name of the file, within path */
+   Eina_File_Type type; /**< The type of the file, links are not followed */
+   Eina_Stat st; /**< The result of lstat() on the file */
+};
+
+/**
+ * @struct _Eio_Walk_Progress
+ * @brief Represents how far eio_dir_walk() got.
+ */
+struct _Eio_Walk_Progress
+{
+   unsigned long long files; /**< Files delivered so far */
+   unsigned long long bytes; /**< Size of the regular files delivered so far */
+   unsigned long long directories; /**< Directories listed so far */
+   unsigned long long directories_found; /**< Directories found so far, listed or not */
+};
+
+typedef Eina_Bool (*Eio_Walk_Filter_Cb)(void *data, Eio_Walk *walk, const Eio_Walk_Entry *entry);
+typedef void (*Eio_Walk_Batch_Cb)(void *data, Eio_Walk *walk, const Eio_Walk_Entry *entries, unsigned int count);
+typedef void (*Eio_Walk_Progress_Cb)(void *data, Eio_Walk *walk, const Eio_Walk_Progress *info);
+typedef void (*Eio_Walk_Done_Cb)(void *data, Eio_Walk *walk);
+typedef void (*Eio_Walk_Error_Cb)(void *data, Eio_Walk *walk, int error);
+
+/**
+ * @brief List the content of a directory and all its sub-content on several threads
+ * @param dir The directory to list.
+ * @param batch_size How many files to hand to batch_cb at most at once, 0 for 256.
+ * @param threads How many threads to list with, 0 for one per core.
+ * @param filter_cb Callback called from a walking thread to decide if a file will be passed to batch_cb, or NULL.
+ * @param batch_cb Callback called from the main loop with the accepted files.
+ * @param progress_cb Callback called from the main loop after each batch, or NULL.
+ * @param done_cb Callback called from the main loop after the contents of the directory has been listed.
+ * @param error_cb Callback called from the main loop when either the directory could not be opened or the walk has been canceled.
+ * @param data Unmodified user data passed to callbacks
+ * @return A reference to the walk, valid until done_cb or error_cb returned.
+ *
+ * eio_dir_stat_ls() lists a whole tree on one thread and hands every
+ * file to the main loop by itself. eio_dir_walk() instead shares the
+ * subdirectories between @p threads threads. Each lists a directory,
+ * sorts its entries by inode number and lstat() them in that order,
+ * which on most file systems reads the inode table sequentially
+ * instead of seeking for every file. Files are handed to the main loop
+ * @p batch_size at a time through
+ * ecore_main_loop_thread_safe_call_fast(), and the threads wait when
+ * the main loop falls behind instead of queueing without bound.
+ *
+ * A directory rejected by @p filter_cb is not walked into. Symbolic
+ * links are reported, not followed. Directories that can not be opened
+ * below @p dir are skipped. The order of the files is not defined.
+ *
+ * @see eio_dir_walk_cancel()
+ * @see eio_dir_stat_ls()
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eio_Walk *eio_dir_walk(const char *dir,
+                                     unsigned int batch_size,
+                                     unsigned int threads,
+                                     Eio_Walk_Filter_Cb filter_cb,
+                                     Eio_Walk_Batch_Cb batch_cb,
+                                     Eio_Walk_Progress_Cb progress_cb,
+                                     Eio_Walk_Done_Cb done_cb,
+                                     Eio_Walk_Error_Cb error_cb,
+                                     const void *data);
+
+/**
+ * @brief Cancel a walk started by eio_dir_walk().
+ * @param walk The walk to cancel.
+ * @return EINA_TRUE if it will be canceled, EINA_FALSE if it is already.
+ *
+ * No batch is delivered after this call. The error_cb of the walk is
+ * called with ECANCELED from the main loop once its threads are gone.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool eio_dir_walk_cancel(Eio_Walk *walk);
+
 /**
  * @}
  */
@@ -693,6 +799,123 @@ EAPI Eio_File *eio_dir_unlink(const char *path,
                               Eio_Done_Cb done_cb,
                               Eio_Error_Cb error_cb,
                               const void *data);
+
+/**
+ * @typedef Eio_Copy
+ * A set of files and directories copied or moved by eio_copy_start().
+ */
+typedef struct _Eio_Copy Eio_Copy;
+
+typedef void (*Eio_Copy_Progress_Cb)(void *data, Eio_Copy *copy, const Eio_Progress *info);
+typedef void (*Eio_Copy_Done_Cb)(void *data, Eio_Copy *copy);
+typedef void (*Eio_Copy_Error_Cb)(void *data, Eio_Copy *copy, int error);
+
+/**
+ * @brief Prepare a parallel copy or move.
+ * @param move EINA_TRUE to remove the sources once copied.
+ * @param threads How many threads to copy with, 0 for one per core.
+ * @param progress_cb Callback called from the main loop to know the progress of the copy, or NULL.
+ * @param done_cb Callback called from the main loop when everything is copied.
+ * @param error_cb Callback called from the main loop when something goes wrong or the copy has been canceled.
+ * @param data Unmodified user data passed to callbacks
+ * @return A copy to add paths to with eio_copy_add(), or NULL.
+ *
+ * eio_file_copy(), eio_dir_copy() and eio_dir_move() copy one file
+ * after the other with a read/write loop on one thread. An #Eio_Copy
+ * copies several files at once and lets the kernel do the work when it
+ * can: it tries to clone a file with the FICLONE ioctl first, which
+ * file systems supporting reflinks do without copying any data, then
+ * copy_file_range(), then splice() through a pipe, and falls back to
+ * read and write. Files larger than eio_copy_chunk_size_set() are
+ * split in ranges copied by several threads.
+ *
+ * A move first tries rename(), and only copies when source and
+ * destination are on different file systems. Access rights and
+ * modification times are kept. A source that gets shorter while it is
+ * copied is reported to @p error_cb with EIO.
+ *
+ * @see eio_copy_start()
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eio_Copy *eio_copy_new(Eina_Bool move,
+                                     unsigned int threads,
+                                     Eio_Copy_Progress_Cb progress_cb,
+                                     Eio_Copy_Done_Cb done_cb,
+                                     Eio_Copy_Error_Cb error_cb,
+                                     const void *data);
+
+/**
+ * @brief Add a file or a directory to a copy.
+ * @param copy A copy that was not started yet.
+ * @param source The file or directory to copy the data from.
+ * @param dest The path to copy it to.
+ * @return EINA_TRUE on success.
+ *
+ * A directory is copied with all its content, into @p dest which is
+ * created if it does not exist yet. An existing file is overwritten.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool eio_copy_add(Eio_Copy *copy,
+                                     const char *source,
+                                     const char *dest);
+
+/**
+ * @brief Set how often the progress of a copy is reported.
+ * @param copy A copy.
+ * @param interval The least time between two calls of progress_cb in seconds, 0.1 by default.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline void eio_copy_progress_interval_set(Eio_Copy *copy,
+                                                  double interval);
+
+/**
+ * @brief Set the size above which a file is copied by several threads.
+ * @param copy A copy that was not started yet.
+ * @param size The size of the ranges a large file is split in, 64MB by default, 0 to never split.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline void eio_copy_chunk_size_set(Eio_Copy *copy,
+                                           size_t size);
+
+/**
+ * @brief Start a copy.
+ * @param copy A copy with paths added to it.
+ * @return EINA_TRUE if it started, the copy is then freed after its
+ * done_cb or error_cb returned.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool eio_copy_start(Eio_Copy *copy);
+
+/**
+ * @brief Cancel a copy.
+ * @param copy The copy to cancel.
+ * @return EINA_TRUE if it will be canceled, EINA_FALSE if it is already.
+ *
+ * A started copy stops after the ranges being copied and calls its
+ * error_cb with ECANCELED from the main loop, the files already copied
+ * are left in place and no source is removed. A copy that was not
+ * started is freed right away without calling anything.
+ *
+ * @if MOBILE @since_tizen 3.0
+ * @elseif WEARABLE @since_tizen 3.0
+ * @endif
+ */
+static inline Eina_Bool eio_copy_cancel(Eio_Copy *copy);
 /**
  * @}
  */
@@ -1561,6 +1784,8 @@ EAPI const char *eio_monitor_path_get(Eio_Monitor *monitor);
  */
 
 #include "eio_inline_helper.x"
+#include "eio_inline_walk.x"
+#include "eio_inline_copy.x"
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,884 @@
+/* EIO - EFL data type library
+ * Copyright (C) 2016 Samsung Electronics Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library;
+ * if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EIO_INLINE_COPY_H__
+# define EIO_INLINE_COPY_H__
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+
+#include <Ecore.h>
+
+/**
+ * @cond LOCAL
+ */
+
+#ifndef FICLONE
+# define FICLONE _IOW(0x94, 9, int)
+#endif
+#ifndef SPLICE_F_MOVE
+# define SPLICE_F_MOVE 1
+#endif
+
+#define EIO_COPY_STEP (8 * 1024 * 1024)
+#define EIO_COPY_BUFFER (1024 * 1024)
+
+typedef enum _Eio_Copy_Method
+{
+  EIO_COPY_METHOD_RANGE, // copy_file_range()
+  EIO_COPY_METHOD_SPLICE,
+  EIO_COPY_METHOD_READ_WRITE
+} Eio_Copy_Method;
+
+typedef enum _Eio_Copy_Job_Type
+{
+  EIO_COPY_JOB_PATH, // whatever source is
+  EIO_COPY_JOB_RANGE // part of a file split across threads
+} Eio_Copy_Job_Type;
+
+typedef struct _Eio_Copy_Job Eio_Copy_Job;
+typedef struct _Eio_Copy_File Eio_Copy_File;
+typedef struct _Eio_Copy_Dir Eio_Copy_Dir;
+typedef struct _Eio_Copy_Progress Eio_Copy_Progress;
+
+/* A file being copied by several range jobs, the last one to finish
+ * sets the times and removes the source of a move. */
+struct _Eio_Copy_File
+{
+   char *source;
+   char *dest;
+   struct stat st;
+   int refs;
+};
+
+struct _Eio_Copy_Job
+{
+   Eio_Copy_Job *next;
+   Eio_Copy_Job_Type type;
+   Eina_Bool top : 1;
+   Eio_Copy_File *file;
+   off_t offset;
+   off_t length;
+   char *source;
+   char *dest;
+};
+
+/* Rights are given to a directory once its content is written, they
+ * may not allow writing to it. */
+struct _Eio_Copy_Dir
+{
+   Eio_Copy_Dir *next;
+   mode_t mode;
+   char *dest;
+   char source[];
+};
+
+struct _Eio_Copy_Progress
+{
+   Eio_Copy *copy;
+   char *source;
+   char *dest;
+};
+
+struct _Eio_Copy
+{
+   Eio_Copy_Progress_Cb progress_cb;
+   Eio_Copy_Done_Cb done_cb;
+   Eio_Copy_Error_Cb error_cb;
+   const void *data;
+   Eio_File_Op op;
+
+   Eina_Lock lock;
+   /* Only idle workers wait, for a job or the end of the copy. Anything
+    * else to wait for needs its own condition, or a push that signals a
+    * single thread could wake the wrong one. */
+   Eina_Condition work;
+   Eio_Copy_Job *queue;
+   Eio_Copy_Dir *dirs; // directories copied, newest first
+   unsigned int busy;
+   unsigned int running;
+   int error;
+   int cancel;
+
+   unsigned long long copied;
+   unsigned long long total;
+   long long progress_last;
+   long long progress_interval;
+   int progress_posted;
+
+   size_t chunk_size;
+   int methods; // lowest method known to work on this system
+   int no_clone;
+   Eina_Bool move : 1;
+   Eina_Bool started : 1;
+
+   unsigned int threads;
+   Eina_Thread tids[];
+};
+
+static inline long long
+_eio_copy_now(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static inline void
+_eio_copy_fail(Eio_Copy *c, int error)
+{
+   eina_lock_take(&c->lock);
+   if (!c->error) c->error = error;
+   c->cancel = EINA_TRUE;
+   eina_condition_broadcast(&c->work);
+   eina_lock_release(&c->lock);
+}
+
+static inline Eio_Copy_Job *
+_eio_copy_job_new(Eio_Copy_Job_Type type, const char *source, const char *dest)
+{
+   Eio_Copy_Job *j;
+   size_t sl = source ? strlen(source) + 1 : 0;
+   size_t dl = dest ? strlen(dest) + 1 : 0;
+
+   j = (Eio_Copy_Job *)calloc(1, sizeof (Eio_Copy_Job) + sl + dl);
+   if (!j) return NULL;
+   j->type = type;
+   if (source)
+     {
+        j->source = (char *)(j + 1);
+        memcpy(j->source, source, sl);
+     }
+   if (dest)
+     {
+        j->dest = (char *)(j + 1) + sl;
+        memcpy(j->dest, dest, dl);
+     }
+   return j;
+}
+
+static inline void
+_eio_copy_push(Eio_Copy *c, Eio_Copy_Job *j)
+{
+   eina_lock_take(&c->lock);
+   j->next = c->queue;
+   c->queue = j;
+   eina_condition_signal(&c->work);
+   eina_lock_release(&c->lock);
+}
+
+static inline void
+_eio_copy_progress_cb(void *data)
+{
+   Eio_Copy_Progress *p = (Eio_Copy_Progress *)data;
+   Eio_Copy *c = p->copy;
+   Eio_Progress info;
+
+   __sync_lock_release(&c->progress_posted);
+   if ((c->progress_cb) && (!__sync_fetch_and_add(&c->cancel, 0)))
+     {
+        info.op = c->op;
+        info.current = __sync_fetch_and_add(&c->copied, 0);
+        info.max = __sync_fetch_and_add(&c->total, 0);
+        if (info.max < info.current) info.max = info.current;
+        info.percent = info.max ? (float)info.current * 100.0 / info.max : 100.0;
+        info.source = p->source;
+        info.dest = p->dest;
+        c->progress_cb((void *)c->data, c, &info);
+     }
+   free(p);
+}
+
+/* Account copied bytes, posting progress at most once per interval and
+ * never with one already waiting in the main loop. */
+static inline void
+_eio_copy_progress(Eio_Copy *c, const char *source, const char *dest,
+                   unsigned long long bytes)
+{
+   Eio_Copy_Progress *p;
+   long long now, last;
+   size_t sl, dl;
+
+   __sync_fetch_and_add(&c->copied, bytes);
+   if (!c->progress_cb) return;
+
+   now = _eio_copy_now();
+   last = c->progress_last;
+   if (now - last < c->progress_interval) return;
+   if (!__sync_bool_compare_and_swap(&c->progress_last, last, now)) return;
+   if (__sync_lock_test_and_set(&c->progress_posted, 1)) return;
+
+   sl = strlen(source) + 1;
+   dl = strlen(dest) + 1;
+   p = (Eio_Copy_Progress *)malloc(sizeof (Eio_Copy_Progress) + sl + dl);
+   if (!p)
+     {
+        __sync_lock_release(&c->progress_posted);
+        return;
+     }
+   p->copy = c;
+   p->source = (char *)(p + 1);
+   p->dest = p->source + sl;
+   memcpy(p->source, source, sl);
+   memcpy(p->dest, dest, dl);
+   ecore_main_loop_thread_safe_call_fast(_eio_copy_progress_cb, p);
+}
+
+/* Copy [offset, offset + length) of an open file, starting with the
+ * fastest way the kernel offers and stepping down when it refuses. */
+static inline int
+_eio_copy_range(Eio_Copy *c, int sfd, int dfd, off_t offset, off_t length,
+                const char *source, const char *dest)
+{
+   Eio_Copy_Method method = (Eio_Copy_Method)__sync_fetch_and_add(&c->methods, 0);
+   Eina_Bool moved = EINA_FALSE;
+   char *buf = NULL;
+   int pipefd[2] = { -1, -1 };
+   int err = 0;
+
+   while ((length > 0) && (!__sync_fetch_and_add(&c->cancel, 0)))
+     {
+        size_t step = length > EIO_COPY_STEP ? EIO_COPY_STEP : (size_t)length;
+        ssize_t n = -1;
+
+        if (method == EIO_COPY_METHOD_RANGE)
+          {
+#ifdef __NR_copy_file_range
+             loff_t in = offset, out = offset;
+
+             n = syscall(__NR_copy_file_range, sfd, &in, dfd, &out, step, 0);
+#else
+             errno = ENOSYS;
+#endif
+          }
+        else if (method == EIO_COPY_METHOD_SPLICE)
+          {
+             loff_t in = offset, out = offset;
+             ssize_t got, put;
+
+             if ((pipefd[0] < 0) && (pipe(pipefd)))
+               {
+                  pipefd[0] = pipefd[1] = -1;
+                  errno = EINVAL;
+               }
+             else
+               {
+                  got = syscall(__NR_splice, sfd, &in, pipefd[1], NULL, step,
+                                SPLICE_F_MOVE);
+                  n = got;
+                  for (put = 0; (got > 0) && (put < got); put += n)
+                    {
+                       n = syscall(__NR_splice, pipefd[0], NULL, dfd, &out,
+                                   got - put, SPLICE_F_MOVE);
+                       if (n <= 0)
+                         {
+                            /* The pipe holds data that never made it. */
+                            if (n == 0) errno = EIO;
+                            n = -1;
+                            moved = EINA_TRUE;
+                            break;
+                         }
+                    }
+                  if (n > 0) n = got;
+               }
+          }
+        else
+          {
+             ssize_t got, put;
+
+             if (!buf) buf = (char *)malloc(EIO_COPY_BUFFER);
+             if (!buf)
+               {
+                  err = ENOMEM;
+                  break;
+               }
+             if (step > EIO_COPY_BUFFER) step = EIO_COPY_BUFFER;
+             got = pread(sfd, buf, step, offset);
+             n = got;
+             for (put = 0; (got > 0) && (put < got); put += n)
+               {
+                  n = pwrite(dfd, buf + put, got - put, offset + put);
+                  if (n <= 0)
+                    {
+                       if (n == 0) errno = EIO;
+                       n = -1;
+                       break;
+                    }
+               }
+             if (n > 0) n = got;
+          }
+
+        if (n > 0)
+          {
+             offset += n;
+             length -= n;
+             moved = EINA_TRUE;
+             _eio_copy_progress(c, source, dest, n);
+             continue;
+          }
+        if (n == 0)
+          {
+             // The source got shorter, the rest would be left zero-filled
+             err = EIO;
+             break;
+          }
+        if (errno == EINTR) continue;
+
+        /* Step down only if nothing went through this way yet, later
+         * failures are real ones. */
+        if ((!moved) && (method < EIO_COPY_METHOD_READ_WRITE) &&
+            ((errno == ENOSYS) || (errno == EXDEV) || (errno == EINVAL) ||
+             (errno == EOPNOTSUPP) || (errno == EBADF)))
+          {
+             /* Missing or not supported here at all, not just on this pair. */
+             if ((errno == ENOSYS) || (errno == EOPNOTSUPP))
+               __sync_bool_compare_and_swap(&c->methods, (int)method, (int)method + 1);
+             method = (Eio_Copy_Method)(method + 1);
+             continue;
+          }
+        err = errno;
+        break;
+     }
+
+   if (pipefd[0] >= 0)
+     {
+        close(pipefd[0]);
+        close(pipefd[1]);
+     }
+   free(buf);
+   return err;
+}
+
+/* The last user of a file finishes it. */
+static inline void
+_eio_copy_file_unref(Eio_Copy *c, Eio_Copy_File *f)
+{
+   if (__sync_sub_and_fetch(&f->refs, 1) > 0) return;
+
+   if (!__sync_fetch_and_add(&c->cancel, 0))
+     {
+        struct timespec times[2];
+
+        times[0] = f->st.st_atim;
+        times[1] = f->st.st_mtim;
+        utimensat(AT_FDCWD, f->dest, times, 0);
+        if ((c->move) && (unlink(f->source))) _eio_copy_fail(c, errno);
+     }
+   free(f);
+}
+
+static inline int
+_eio_copy_file(Eio_Copy *c, Eio_Copy_Job *j, const struct stat *st)
+{
+   Eio_Copy_File *f;
+   size_t sl, dl;
+   off_t chunk, first;
+   int sfd, dfd, err = 0;
+
+   sfd = open(j->source, O_RDONLY | O_CLOEXEC);
+   if (sfd < 0) return errno;
+   dfd = open(j->dest, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+   if (dfd < 0)
+     {
+        err = errno;
+        close(sfd);
+        return err;
+     }
+   fchmod(dfd, st->st_mode & 07777);
+
+   sl = strlen(j->source) + 1;
+   dl = strlen(j->dest) + 1;
+   f = (Eio_Copy_File *)malloc(sizeof (Eio_Copy_File) + sl + dl);
+   if (!f)
+     {
+        err = ENOMEM;
+        goto on_end;
+     }
+   f->source = (char *)(f + 1);
+   f->dest = f->source + sl;
+   memcpy(f->source, j->source, sl);
+   memcpy(f->dest, j->dest, dl);
+   f->st = *st;
+   f->refs = 1;
+
+   if ((st->st_size > 0) && (!__sync_fetch_and_add(&c->no_clone, 0)))
+     {
+        if (!ioctl(dfd, FICLONE, sfd))
+          {
+             _eio_copy_progress(c, j->source, j->dest, st->st_size);
+             goto on_end;
+          }
+        if ((errno == EOPNOTSUPP) || (errno == ENOTTY) || (errno == ENOSYS))
+          __sync_lock_test_and_set(&c->no_clone, 1);
+     }
+
+   /* Hand all ranges but the first to other threads. */
+   chunk = c->chunk_size;
+   first = st->st_size;
+   if ((chunk) && (c->threads > 1) && (st->st_size > chunk))
+     {
+        off_t offset;
+
+        if (ftruncate(dfd, st->st_size))
+          {
+             err = errno;
+             goto on_end;
+          }
+        first = chunk;
+        for (offset = chunk; offset < st->st_size; offset += chunk)
+          {
+             Eio_Copy_Job *r;
+
+             r = _eio_copy_job_new(EIO_COPY_JOB_RANGE, NULL, NULL);
+             if (!r)
+               {
+                  err = ENOMEM;
+                  goto on_end;
+               }
+             r->file = f;
+             r->offset = offset;
+             r->length = st->st_size - offset < chunk ?
+               st->st_size - offset : chunk;
+             __sync_fetch_and_add(&f->refs, 1);
+             _eio_copy_push(c, r);
+          }
+     }
+   err = _eio_copy_range(c, sfd, dfd, 0, first, j->source, j->dest);
+
+ on_end:
+   close(sfd);
+   if (close(dfd) && !err) err = errno;
+   if (err) _eio_copy_fail(c, err);
+   if (f) _eio_copy_file_unref(c, f);
+   return err;
+}
+
+static inline void
+_eio_copy_range_job(Eio_Copy *c, Eio_Copy_Job *j)
+{
+   Eio_Copy_File *f = j->file;
+   int sfd, dfd, err = 0;
+
+   sfd = open(f->source, O_RDONLY | O_CLOEXEC);
+   dfd = open(f->dest, O_WRONLY | O_CLOEXEC);
+   if ((sfd < 0) || (dfd < 0))
+     err = errno;
+   else
+     err = _eio_copy_range(c, sfd, dfd, j->offset, j->length,
+                           f->source, f->dest);
+   if (sfd >= 0) close(sfd);
+   if ((dfd >= 0) && (close(dfd)) && (!err)) err = errno;
+   if (err) _eio_copy_fail(c, err);
+   _eio_copy_file_unref(c, f);
+}
+
+static inline void
+_eio_copy_dir(Eio_Copy *c, Eio_Copy_Job *j, const struct stat *st)
+{
+   struct dirent *de;
+   DIR *dir;
+
+   if ((mkdir(j->dest, (st->st_mode & 07777) | S_IRWXU)) && (errno != EEXIST))
+     {
+        _eio_copy_fail(c, errno);
+        return;
+     }
+   dir = opendir(j->source);
+   if (!dir)
+     {
+        _eio_copy_fail(c, errno);
+        return;
+     }
+
+   {
+      Eio_Copy_Dir *d;
+      size_t sl = strlen(j->source) + 1;
+      size_t dl = strlen(j->dest) + 1;
+
+      d = (Eio_Copy_Dir *)malloc(sizeof (Eio_Copy_Dir) + sl + dl);
+      if (!d)
+        {
+           closedir(dir);
+           _eio_copy_fail(c, ENOMEM);
+           return;
+        }
+      d->mode = st->st_mode & 07777;
+      d->dest = d->source + sl;
+      memcpy(d->source, j->source, sl);
+      memcpy(d->dest, j->dest, dl);
+      eina_lock_take(&c->lock);
+      d->next = c->dirs;
+      c->dirs = d;
+      eina_lock_release(&c->lock);
+   }
+
+   while ((de = readdir(dir)) && (!__sync_fetch_and_add(&c->cancel, 0)))
+     {
+        Eina_Strbuf *s, *t;
+        Eio_Copy_Job *n;
+
+        if ((de->d_name[0] == '.') &&
+            ((!de->d_name[1]) ||
+             ((de->d_name[1] == '.') && (!de->d_name[2]))))
+          continue;
+
+        s = eina_strbuf_new();
+        t = eina_strbuf_new();
+        eina_strbuf_append_printf(s, "%s/%s", j->source, de->d_name);
+        eina_strbuf_append_printf(t, "%s/%s", j->dest, de->d_name);
+        n = _eio_copy_job_new(EIO_COPY_JOB_PATH,
+                              eina_strbuf_string_get(s),
+                              eina_strbuf_string_get(t));
+        eina_strbuf_free(s);
+        eina_strbuf_free(t);
+        if (!n)
+          {
+             _eio_copy_fail(c, ENOMEM);
+             break;
+          }
+        _eio_copy_push(c, n);
+     }
+   closedir(dir);
+}
+
+static inline void
+_eio_copy_path(Eio_Copy *c, Eio_Copy_Job *j)
+{
+   struct stat st;
+
+   if ((j->top) && (c->move))
+     {
+        if (!rename(j->source, j->dest)) return;
+        if (errno != EXDEV)
+          {
+             _eio_copy_fail(c, errno);
+             return;
+          }
+     }
+
+   if (lstat(j->source, &st))
+     {
+        _eio_copy_fail(c, errno);
+        return;
+     }
+
+   if (S_ISDIR(st.st_mode))
+     _eio_copy_dir(c, j, &st);
+   else if (S_ISREG(st.st_mode))
+     {
+        __sync_fetch_and_add(&c->total, st.st_size);
+        _eio_copy_file(c, j, &st);
+     }
+   else if (S_ISLNK(st.st_mode))
+     {
+        char target[PATH_MAX];
+        ssize_t len;
+
+        len = readlink(j->source, target, sizeof (target) - 1);
+        if (len < 0)
+          {
+             _eio_copy_fail(c, errno);
+             return;
+          }
+        target[len] = '\0';
+        unlink(j->dest);
+        if (symlink(target, j->dest)) _eio_copy_fail(c, errno);
+        else if ((c->move) && (unlink(j->source))) _eio_copy_fail(c, errno);
+     }
+   /* Devices, fifos and sockets are not copied, as with eio_dir_copy(). */
+}
+
+static inline void
+_eio_copy_end(void *data)
+{
+   Eio_Copy *c = (Eio_Copy *)data;
+   unsigned int i;
+
+   for (i = 0; i < c->threads; i++)
+     eina_thread_join(c->tids[i]);
+
+   if (c->error)
+     c->error_cb((void *)c->data, c, c->error);
+   else if (c->cancel)
+     c->error_cb((void *)c->data, c, ECANCELED);
+   else
+     {
+        if (c->progress_cb)
+          {
+             Eio_Progress info;
+
+             info.op = c->op;
+             info.current = c->copied;
+             info.max = c->copied;
+             info.percent = 100.0;
+             info.source = NULL;
+             info.dest = NULL;
+             c->progress_cb((void *)c->data, c, &info);
+          }
+        c->done_cb((void *)c->data, c);
+     }
+
+   while (c->queue)
+     {
+        Eio_Copy_Job *j = c->queue;
+
+        c->queue = j->next;
+        if ((j->file) && (--j->file->refs == 0)) free(j->file);
+        free(j);
+     }
+   while (c->dirs)
+     {
+        Eio_Copy_Dir *d = c->dirs;
+
+        c->dirs = d->next;
+        free(d);
+     }
+   eina_condition_free(&c->work);
+   eina_lock_free(&c->lock);
+   free(c);
+}
+
+static inline void *
+_eio_copy_worker(void *data, Eina_Thread t EINA_UNUSED)
+{
+   Eio_Copy *c = (Eio_Copy *)data;
+   Eio_Copy_Job *j;
+   Eina_Bool last;
+
+   for (;;)
+     {
+        eina_lock_take(&c->lock);
+        while ((!c->queue) && (c->busy) && (!c->cancel))
+          eina_condition_wait(&c->work);
+        if ((c->cancel) || (!c->queue))
+          {
+             eina_lock_release(&c->lock);
+             break;
+          }
+        /* Newest first, so the ranges of a split file go before more
+         * files get started. */
+        j = c->queue;
+        c->queue = j->next;
+        c->busy++;
+        eina_lock_release(&c->lock);
+
+        eina_evlog_ring("+eio_copy_job", c,
+                        j->file ? j->file->source : j->source);
+        if (j->type == EIO_COPY_JOB_RANGE) _eio_copy_range_job(c, j);
+        else _eio_copy_path(c, j);
+        eina_evlog_ring("-eio_copy_job", c, NULL);
+        free(j);
+
+        eina_lock_take(&c->lock);
+        if ((--c->busy == 0) && (!c->queue))
+          eina_condition_broadcast(&c->work);
+        eina_lock_release(&c->lock);
+     }
+
+   eina_lock_take(&c->lock);
+   last = --c->running == 0;
+   eina_lock_release(&c->lock);
+   if (!last) return NULL;
+
+   /* Everything is copied, children were recorded after their parent. */
+   if (!c->cancel)
+     {
+        Eio_Copy_Dir *d;
+
+        for (d = c->dirs; d; d = d->next)
+          {
+             chmod(d->dest, d->mode);
+             if ((c->move) && (rmdir(d->source)))
+               {
+                  c->error = errno;
+                  break;
+               }
+          }
+     }
+   ecore_main_loop_thread_safe_call_fast(_eio_copy_end, c);
+   return NULL;
+}
+
+/**
+ * @endcond
+ */
+
+static inline Eio_Copy *
+eio_copy_new(Eina_Bool move,
+             unsigned int threads,
+             Eio_Copy_Progress_Cb progress_cb,
+             Eio_Copy_Done_Cb done_cb,
+             Eio_Copy_Error_Cb error_cb,
+             const void *data)
+{
+   Eio_Copy *c;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(done_cb, NULL);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(error_cb, NULL);
+
+   if (!threads) threads = eina_cpu_count();
+   if (!threads) threads = 1;
+
+   c = (Eio_Copy *)calloc(1, sizeof (Eio_Copy) + threads * sizeof (Eina_Thread));
+   if (!c) return NULL;
+   if (!eina_lock_new(&c->lock)) goto on_error;
+   if (!eina_condition_new(&c->work, &c->lock))
+     {
+        eina_lock_free(&c->lock);
+        goto on_error;
+     }
+   c->progress_cb = progress_cb;
+   c->done_cb = done_cb;
+   c->error_cb = error_cb;
+   c->data = data;
+   c->move = !!move;
+   c->op = move ? EIO_FILE_MOVE : EIO_FILE_COPY;
+   c->threads = threads;
+   c->chunk_size = 64 * 1024 * 1024;
+   c->progress_interval = 100000000LL;
+   return c;
+
+ on_error:
+   free(c);
+   return NULL;
+}
+
+static inline Eina_Bool
+eio_copy_add(Eio_Copy *copy, const char *source, const char *dest)
+{
+   Eio_Copy_Job *j;
+   struct stat st;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(copy, EINA_FALSE);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(source, EINA_FALSE);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(dest, EINA_FALSE);
+   EINA_SAFETY_ON_TRUE_RETURN_VAL(copy->started, EINA_FALSE);
+
+   if (lstat(source, &st)) return EINA_FALSE;
+   j = _eio_copy_job_new(EIO_COPY_JOB_PATH, source, dest);
+   if (!j) return EINA_FALSE;
+   j->top = EINA_TRUE;
+   if (S_ISDIR(st.st_mode))
+     copy->op = copy->move ? EIO_DIR_MOVE : EIO_DIR_COPY;
+
+   /* Keep them in the order given, the queue is taken from its head. */
+   if (!copy->queue) copy->queue = j;
+   else
+     {
+        Eio_Copy_Job *l;
+
+        for (l = copy->queue; l->next; l = l->next)
+          ;
+        l->next = j;
+     }
+   return EINA_TRUE;
+}
+
+static inline void
+eio_copy_progress_interval_set(Eio_Copy *copy, double interval)
+{
+   EINA_SAFETY_ON_NULL_RETURN(copy);
+
+   if (interval < 0) interval = 0;
+   copy->progress_interval = interval * 1000000000.0;
+}
+
+static inline void
+eio_copy_chunk_size_set(Eio_Copy *copy, size_t size)
+{
+   EINA_SAFETY_ON_NULL_RETURN(copy);
+   EINA_SAFETY_ON_TRUE_RETURN(copy->started);
+
+   copy->chunk_size = size;
+}
+
+static inline Eina_Bool
+eio_copy_start(Eio_Copy *copy)
+{
+   unsigned int i, threads;
+   Eina_Bool last;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(copy, EINA_FALSE);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(copy->queue, EINA_FALSE);
+   EINA_SAFETY_ON_TRUE_RETURN_VAL(copy->started, EINA_FALSE);
+
+   copy->started = EINA_TRUE;
+   threads = copy->threads;
+   copy->running = threads;
+   for (i = 0; i < threads; i++)
+     {
+        if (!eina_thread_create(&copy->tids[i], EINA_THREAD_BACKGROUND, -1,
+                                _eio_copy_worker, copy))
+          break;
+     }
+   copy->threads = i;
+   if (i < threads)
+     {
+        eina_lock_take(&copy->lock);
+        copy->running -= threads - i;
+        last = copy->running == 0;
+        eina_lock_release(&copy->lock);
+        if (!i)
+          {
+             copy->started = EINA_FALSE;
+             copy->threads = threads;
+             return EINA_FALSE;
+          }
+        if (last) ecore_main_loop_thread_safe_call_fast(_eio_copy_end, copy);
+     }
+   return EINA_TRUE;
+}
+
+static inline Eina_Bool
+eio_copy_cancel(Eio_Copy *copy)
+{
+   Eina_Bool r;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(copy, EINA_FALSE);
+
+   if (!copy->started)
+     {
+        while (copy->queue)
+          {
+             Eio_Copy_Job *j = copy->queue;
+
+             copy->queue = j->next;
+             free(j);
+          }
+        eina_condition_free(&copy->work);
+        eina_lock_free(&copy->lock);
+        free(copy);
+        return EINA_TRUE;
+     }
+
+   eina_lock_take(&copy->lock);
+   r = !copy->cancel;
+   copy->cancel = EINA_TRUE;
+   eina_condition_broadcast(&copy->work);
+   eina_lock_release(&copy->lock);
+   return r;
+}
+
+#endif
@@ -0,0 +1,565 @@
+/* EIO - EFL data type library
+ * Copyright (C) 2016 Samsung Electronics Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library;
+ * if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EIO_INLINE_WALK_H__
+# define EIO_INLINE_WALK_H__
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+
+#include <Ecore.h>
+
+/**
+ * @cond LOCAL
+ */
+
+typedef struct _Eio_Walk_Dir Eio_Walk_Dir;
+typedef struct _Eio_Walk_Batch Eio_Walk_Batch;
+typedef struct _Eio_Walk_Name Eio_Walk_Name;
+
+struct _Eio_Walk_Dir
+{
+   Eio_Walk_Dir *next;
+   size_t len;
+   char path[];
+};
+
+/* Entries are filled with offsets into names, turned into pointers
+ * right before the batch goes to the main loop as names may move. */
+struct _Eio_Walk_Batch
+{
+   Eio_Walk *walk;
+   Eio_Walk_Entry *entries;
+   char *names;
+   size_t names_len;
+   size_t names_size;
+   unsigned int count;
+   unsigned long long bytes;
+};
+
+struct _Eio_Walk_Name
+{
+   ino_t ino;
+   size_t offset;
+};
+
+struct _Eio_Walk
+{
+   Eio_Walk_Filter_Cb filter_cb;
+   Eio_Walk_Batch_Cb batch_cb;
+   Eio_Walk_Progress_Cb progress_cb;
+   Eio_Walk_Done_Cb done_cb;
+   Eio_Walk_Error_Cb error_cb;
+   const void *data;
+
+   Eina_Lock lock;
+   Eina_Condition work; // idle threads wait for directories to list
+   Eina_Condition room; // threads with a full batch wait for in_flight to drop
+   Eio_Walk_Dir *queue;
+   unsigned int busy; // directories being listed
+   unsigned int running; // threads not done yet
+   unsigned int in_flight; // batches the main loop did not handle yet
+   unsigned int max_in_flight;
+   unsigned int batch_size;
+   int error;
+   Eina_Bool cancel;
+
+   unsigned long long listed;
+   unsigned long long found;
+   Eio_Walk_Progress progress;
+
+   unsigned int threads;
+   Eina_Thread tids[];
+};
+
+static inline Eina_File_Type
+_eio_walk_type(mode_t mode)
+{
+   if (S_ISREG(mode)) return EINA_FILE_REG;
+   if (S_ISDIR(mode)) return EINA_FILE_DIR;
+   if (S_ISLNK(mode)) return EINA_FILE_LNK;
+   if (S_ISFIFO(mode)) return EINA_FILE_FIFO;
+   if (S_ISCHR(mode)) return EINA_FILE_CHR;
+   if (S_ISBLK(mode)) return EINA_FILE_BLK;
+   if (S_ISSOCK(mode)) return EINA_FILE_SOCK;
+   return EINA_FILE_UNKNOWN;
+}
+
+static inline void
+_eio_walk_stat_fill(Eina_Stat *es, const struct stat *st)
+{
+   es->dev = st->st_dev;
+   es->ino = st->st_ino;
+   es->mode = st->st_mode;
+   es->nlink = st->st_nlink;
+   es->uid = st->st_uid;
+   es->gid = st->st_gid;
+   es->rdev = st->st_rdev;
+   es->size = st->st_size;
+   es->blksize = st->st_blksize;
+   es->blocks = st->st_blocks;
+   es->atime = st->st_atime;
+   es->mtime = st->st_mtime;
+   es->ctime = st->st_ctime;
+   es->atimensec = st->st_atim.tv_nsec;
+   es->mtimensec = st->st_mtim.tv_nsec;
+   es->ctimensec = st->st_ctim.tv_nsec;
+}
+
+static inline int
+_eio_walk_name_cmp(const void *a, const void *b)
+{
+   const Eio_Walk_Name *na = (const Eio_Walk_Name *)a, *nb = (const Eio_Walk_Name *)b;
+
+   if (na->ino < nb->ino) return -1;
+   return na->ino > nb->ino;
+}
+
+static inline void
+_eio_walk_batch_free(Eio_Walk_Batch *b)
+{
+   if (!b) return;
+   free(b->entries);
+   free(b->names);
+   free(b);
+}
+
+static inline void
+_eio_walk_batch_cb(void *data)
+{
+   Eio_Walk_Batch *b = (Eio_Walk_Batch *)data;
+   Eio_Walk *w = b->walk;
+   Eina_Bool cancel;
+
+   eina_lock_take(&w->lock);
+   cancel = w->cancel;
+   eina_lock_release(&w->lock);
+
+   if (!cancel)
+     {
+        w->progress.files += b->count;
+        w->progress.bytes += b->bytes;
+        w->progress.directories = __sync_fetch_and_add(&w->listed, 0);
+        w->progress.directories_found = __sync_fetch_and_add(&w->found, 0);
+        w->batch_cb((void *)w->data, w, b->entries, b->count);
+        if (w->progress_cb)
+          w->progress_cb((void *)w->data, w, &w->progress);
+     }
+
+   eina_lock_take(&w->lock);
+   w->in_flight--;
+   eina_condition_signal(&w->room);
+   eina_lock_release(&w->lock);
+   _eio_walk_batch_free(b);
+}
+
+/* Hand a batch to the main loop, waiting for room if it is behind. */
+static inline void
+_eio_walk_flush(Eio_Walk *w, Eio_Walk_Batch **batch)
+{
+   Eio_Walk_Batch *b = *batch;
+   unsigned int i;
+
+   if ((!b) || (!b->count)) return;
+   *batch = NULL;
+
+   eina_lock_take(&w->lock);
+   while ((w->in_flight >= w->max_in_flight) && (!w->cancel))
+     eina_condition_wait(&w->room);
+   if (w->cancel)
+     {
+        eina_lock_release(&w->lock);
+        _eio_walk_batch_free(b);
+        return;
+     }
+   w->in_flight++;
+   eina_lock_release(&w->lock);
+
+   for (i = 0; i < b->count; i++)
+     {
+        Eio_Walk_Entry *e = &b->entries[i];
+
+        e->path = b->names + (uintptr_t)e->path;
+        e->name = b->names + (uintptr_t)e->name;
+     }
+   ecore_main_loop_thread_safe_call_fast(_eio_walk_batch_cb, b);
+}
+
+/* Append path/name to the batch, returning the entry to fill. */
+static inline Eio_Walk_Entry *
+_eio_walk_batch_add(Eio_Walk *w, Eio_Walk_Batch **batch,
+                    const Eio_Walk_Dir *d, const char *name)
+{
+   Eio_Walk_Batch *b = *batch;
+   Eio_Walk_Entry *e;
+   size_t len = strlen(name);
+   size_t need = d->len + 1 + len + 1;
+
+   if (!b)
+     {
+        b = (Eio_Walk_Batch *)calloc(1, sizeof (Eio_Walk_Batch));
+        if (!b) return NULL;
+        b->walk = w;
+        b->entries = (Eio_Walk_Entry *)malloc(w->batch_size * sizeof (Eio_Walk_Entry));
+        if (!b->entries)
+          {
+             free(b);
+             return NULL;
+          }
+        *batch = b;
+     }
+   if (b->names_len + need > b->names_size)
+     {
+        size_t size = b->names_size ? b->names_size : w->batch_size * 64;
+        char *tmp;
+
+        while (size < b->names_len + need) size *= 2;
+        tmp = (char *)realloc(b->names, size);
+        if (!tmp) return NULL;
+        b->names = tmp;
+        b->names_size = size;
+     }
+
+   e = &b->entries[b->count];
+   e->path = (const char *)(uintptr_t)b->names_len;
+   memcpy(b->names + b->names_len, d->path, d->len);
+   b->names_len += d->len;
+   if ((!d->len) || (d->path[d->len - 1] != '/'))
+     b->names[b->names_len++] = '/';
+   e->name = (const char *)(uintptr_t)b->names_len;
+   memcpy(b->names + b->names_len, name, len + 1);
+   b->names_len += len + 1;
+   return e;
+}
+
+static inline void
+_eio_walk_push(Eio_Walk *w, const char *path, size_t len)
+{
+   Eio_Walk_Dir *d;
+
+   d = (Eio_Walk_Dir *)malloc(sizeof (Eio_Walk_Dir) + len + 1);
+   if (!d) return;
+   d->len = len;
+   memcpy(d->path, path, len + 1);
+
+   eina_lock_take(&w->lock);
+   d->next = w->queue;
+   w->queue = d;
+   eina_condition_signal(&w->work);
+   eina_lock_release(&w->lock);
+   __sync_fetch_and_add(&w->found, 1);
+}
+
+static inline void
+_eio_walk_dir(Eio_Walk *w, const Eio_Walk_Dir *d, Eina_Bool root,
+              Eio_Walk_Batch **batch)
+{
+   Eio_Walk_Name *names = NULL;
+   char *buf = NULL;
+   size_t buf_len = 0, buf_size = 0;
+   unsigned int count = 0, size = 0, i;
+   struct dirent *de;
+   DIR *dir;
+   int fd;
+
+   fd = open(d->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+   if ((fd < 0) || (!(dir = fdopendir(fd))))
+     {
+        if (root) w->error = errno;
+        if (fd >= 0) close(fd);
+        return;
+     }
+
+   /* Read the whole directory first, stat() in inode order after. */
+   while ((de = readdir(dir)))
+     {
+        size_t len;
+
+        if ((de->d_name[0] == '.') &&
+            ((!de->d_name[1]) ||
+             ((de->d_name[1] == '.') && (!de->d_name[2]))))
+          continue;
+
+        len = strlen(de->d_name) + 1;
+        if (count == size)
+          {
+             Eio_Walk_Name *tmp;
+
+             size = size ? size * 2 : 64;
+             tmp = (Eio_Walk_Name *)realloc(names, size * sizeof (Eio_Walk_Name));
+             if (!tmp) break;
+             names = tmp;
+          }
+        if (buf_len + len > buf_size)
+          {
+             char *tmp;
+
+             buf_size = buf_size ? buf_size * 2 : 4096;
+             while (buf_size < buf_len + len) buf_size *= 2;
+             tmp = (char *)realloc(buf, buf_size);
+             if (!tmp) break;
+             buf = tmp;
+          }
+        names[count].ino = de->d_ino;
+        names[count].offset = buf_len;
+        memcpy(buf + buf_len, de->d_name, len);
+        buf_len += len;
+        count++;
+     }
+   if (count) qsort(names, count, sizeof (Eio_Walk_Name), _eio_walk_name_cmp);
+
+   for (i = 0; (i < count) && (!w->cancel); i++)
+     {
+        const char *name = buf + names[i].offset;
+        Eio_Walk_Batch *b;
+        Eio_Walk_Entry *e;
+        struct stat st;
+        Eina_Bool is_dir;
+
+        if (fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW)) continue;
+        e = _eio_walk_batch_add(w, batch, d, name);
+        if (!e) break;
+        b = *batch;
+        e->type = _eio_walk_type(st.st_mode);
+        _eio_walk_stat_fill(&e->st, &st);
+        is_dir = e->type == EINA_FILE_DIR;
+
+        if (w->filter_cb)
+          {
+             Eio_Walk_Entry tmp = *e;
+
+             tmp.path = b->names + (uintptr_t)e->path;
+             tmp.name = b->names + (uintptr_t)e->name;
+             if (!w->filter_cb((void *)w->data, w, &tmp))
+               {
+                  b->names_len = (uintptr_t)e->path;
+                  continue;
+               }
+          }
+        if (is_dir)
+          _eio_walk_push(w, b->names + (uintptr_t)e->path,
+                         (uintptr_t)e->name + strlen(name) - (uintptr_t)e->path);
+        if (e->type == EINA_FILE_REG) b->bytes += st.st_size;
+        if (++b->count == w->batch_size) _eio_walk_flush(w, batch);
+     }
+
+   closedir(dir);
+   free(names);
+   free(buf);
+   __sync_fetch_and_add(&w->listed, 1);
+}
+
+static inline void
+_eio_walk_end(void *data)
+{
+   Eio_Walk *w = (Eio_Walk *)data;
+   unsigned int i;
+
+   for (i = 0; i < w->threads; i++)
+     eina_thread_join(w->tids[i]);
+
+   if (w->cancel)
+     {
+        if (w->error_cb) w->error_cb((void *)w->data, w, ECANCELED);
+     }
+   else if (w->error)
+     {
+        if (w->error_cb) w->error_cb((void *)w->data, w, w->error);
+     }
+   else if (w->done_cb)
+     w->done_cb((void *)w->data, w);
+
+   while (w->queue)
+     {
+        Eio_Walk_Dir *d = w->queue;
+
+        w->queue = d->next;
+        free(d);
+     }
+   eina_condition_free(&w->room);
+   eina_condition_free(&w->work);
+   eina_lock_free(&w->lock);
+   free(w);
+}
+
+static inline void *
+_eio_walk_worker(void *data, Eina_Thread t EINA_UNUSED)
+{
+   Eio_Walk *w = (Eio_Walk *)data;
+   Eio_Walk_Batch *batch = NULL;
+   Eio_Walk_Dir *d;
+   Eina_Bool last;
+
+   for (;;)
+     {
+        Eina_Bool root;
+
+        eina_lock_take(&w->lock);
+        while ((!w->queue) && (w->busy) && (!w->cancel))
+          {
+             /* Nothing to list right now, do not sit on a partial batch. */
+             if (batch)
+               {
+                  eina_lock_release(&w->lock);
+                  _eio_walk_flush(w, &batch);
+                  eina_lock_take(&w->lock);
+                  continue;
+               }
+             eina_condition_wait(&w->work);
+          }
+        if ((w->cancel) || (!w->queue))
+          {
+             eina_lock_release(&w->lock);
+             break;
+          }
+        d = w->queue;
+        w->queue = d->next;
+        root = !w->listed && !w->busy;
+        w->busy++;
+        eina_lock_release(&w->lock);
+
+        eina_evlog_ring("+eio_walk_dir", w, d->path);
+        _eio_walk_dir(w, d, root, &batch);
+        eina_evlog_ring("-eio_walk_dir", w, NULL);
+        free(d);
+
+        eina_lock_take(&w->lock);
+        if ((--w->busy == 0) && (!w->queue))
+          eina_condition_broadcast(&w->work);
+        eina_lock_release(&w->lock);
+     }
+
+   _eio_walk_flush(w, &batch);
+   _eio_walk_batch_free(batch);
+
+   eina_lock_take(&w->lock);
+   last = --w->running == 0;
+   eina_lock_release(&w->lock);
+
+   /* Goes through the same ring, so after every batch. */
+   if (last) ecore_main_loop_thread_safe_call_fast(_eio_walk_end, w);
+   return NULL;
+}
+
+/**
+ * @endcond
+ */
+
+static inline Eio_Walk *
+eio_dir_walk(const char *dir,
+             unsigned int batch_size,
+             unsigned int threads,
+             Eio_Walk_Filter_Cb filter_cb,
+             Eio_Walk_Batch_Cb batch_cb,
+             Eio_Walk_Progress_Cb progress_cb,
+             Eio_Walk_Done_Cb done_cb,
+             Eio_Walk_Error_Cb error_cb,
+             const void *data)
+{
+   Eio_Walk *w;
+   unsigned int i;
+   Eina_Bool last;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(dir, NULL);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(batch_cb, NULL);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(done_cb, NULL);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(error_cb, NULL);
+
+   if (!threads) threads = eina_cpu_count();
+   if (!threads) threads = 1;
+   if (!batch_size) batch_size = 256;
+
+   w = (Eio_Walk *)calloc(1, sizeof (Eio_Walk) + threads * sizeof (Eina_Thread));
+   if (!w) return NULL;
+   w->filter_cb = filter_cb;
+   w->batch_cb = batch_cb;
+   w->progress_cb = progress_cb;
+   w->done_cb = done_cb;
+   w->error_cb = error_cb;
+   w->data = data;
+   w->batch_size = batch_size;
+   w->max_in_flight = threads * 2 + 2;
+
+   if (!eina_lock_new(&w->lock)) goto on_error;
+   if (!eina_condition_new(&w->work, &w->lock))
+     {
+        eina_lock_free(&w->lock);
+        goto on_error;
+     }
+   if (!eina_condition_new(&w->room, &w->lock))
+     {
+        eina_condition_free(&w->work);
+        eina_lock_free(&w->lock);
+        goto on_error;
+     }
+
+   _eio_walk_push(w, dir, strlen(dir));
+   if (!w->queue) goto on_cond;
+
+   /* Count first, a thread may finish the walk before the others start. */
+   w->running = threads;
+   for (i = 0; i < threads; i++)
+     {
+        if (!eina_thread_create(&w->tids[i], EINA_THREAD_BACKGROUND, -1,
+                                _eio_walk_worker, w))
+          break;
+     }
+   w->threads = i;
+   if (i < threads)
+     {
+        eina_lock_take(&w->lock);
+        w->running -= threads - i;
+        last = w->running == 0;
+        eina_lock_release(&w->lock);
+        if (!i) goto on_queue;
+        if (last) ecore_main_loop_thread_safe_call_fast(_eio_walk_end, w);
+     }
+   return w;
+
+ on_queue:
+   free(w->queue);
+ on_cond:
+   eina_condition_free(&w->room);
+   eina_condition_free(&w->work);
+   eina_lock_free(&w->lock);
+ on_error:
+   free(w);
+   return NULL;
+}
+
+static inline Eina_Bool
+eio_dir_walk_cancel(Eio_Walk *walk)
+{
+   Eina_Bool r;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(walk, EINA_FALSE);
+
+   eina_lock_take(&walk->lock);
+   r = !walk->cancel;
+   walk->cancel = EINA_TRUE;
+   eina_condition_broadcast(&walk->work);
+   eina_condition_broadcast(&walk->room);
+   eina_lock_release(&walk->lock);
+   return r;
+}
+
+#endif
@@ -241,3 +241,179 @@ EINA_DEPRECATED EAPI void          elm_gengrid_page_bring_in(const Evas_Object *
 
 #include "elm_gengrid_item.eo.legacy.h"
 #include "elm_gengrid.eo.legacy.h"
+
+/**
+ * @addtogroup Gengrid
+ * @{
+ */
+
+/**
+ * @brief Counters kept for a gengrid by elm_gengrid_pool_set().
+ */
+typedef struct _Elm_Gengrid_Realize_Stats Elm_Gengrid_Realize_Stats;
+
+struct _Elm_Gengrid_Realize_Stats
+{
+   unsigned int frames; /**< Frames the canvas rendered */
+   unsigned int items; /**< Items realized */
+   unsigned int items_last; /**< Items realized in the last frame */
+   unsigned int items_peak; /**< Most items realized in a frame */
+   unsigned int contents; /**< Contents built through elm_gengrid_pool_content_get() */
+   unsigned int contents_last; /**< Contents built in the last frame */
+   unsigned int contents_peak; /**< Most contents built in a frame */
+   unsigned int created; /**< Contents built without a pooled one */
+   unsigned int reused; /**< Contents built reusing a pooled one */
+   unsigned int deferred; /**< Contents put off to a later frame by the budget */
+   unsigned int pending; /**< Contents still put off */
+   unsigned int pooled; /**< Contents kept for reuse */
+   unsigned int prefetched; /**< Items handed to the prefetch callback */
+};
+
+/**
+ * Prefetch function for items about to be scrolled in.
+ *
+ * @param data The data given to elm_gengrid_pool_prefetch_set()
+ * @param obj The gengrid object
+ * @param it The item
+ */
+typedef void (*Elm_Gengrid_Prefetch_Cb)(void *data, Evas_Object *obj, Elm_Object_Item *it);
+
+/**
+ * Keep the contents of unrealized items for the items realized next.
+ *
+ * @param obj The gengrid object
+ * @param max The most contents kept for each item style and part, 0 to
+ * stop pooling
+ * @return @c EINA_TRUE on success, @c EINA_FALSE otherwise
+ *
+ * The gengrid caches the edje objects of unrealized items, but their
+ * contents are deleted and the content_get function of the item class
+ * builds new ones for each item scrolled in. Fast scrolling through a
+ * grid of photos then spends its frames creating image objects.
+ *
+ * Item classes returning their contents through
+ * elm_gengrid_pool_content_get() have them kept when their items are
+ * unrealized, by item style and part, and given back for reuse to the
+ * next item of the same style. The pool also counts the items and the
+ * contents realized in each frame, see elm_gengrid_realize_stats_get(),
+ * can spread content creation over frames, see
+ * elm_gengrid_pool_frame_budget_set(), and can start preparing the
+ * items a scroll is bringing in, see elm_gengrid_pool_prefetch_set().
+ *
+ * Stopping the pool deletes the contents it keeps.
+ */
+static inline Eina_Bool elm_gengrid_pool_set(Evas_Object *obj, unsigned int max);
+
+/**
+ * Get the most contents kept for each item style and part.
+ *
+ * @param obj The gengrid object
+ * @return The most contents kept, 0 if the gengrid does not pool them
+ *
+ * @see elm_gengrid_pool_set()
+ */
+static inline unsigned int elm_gengrid_pool_get(const Evas_Object *obj);
+
+/**
+ * Build the content of an item part, reusing a pooled one if any.
+ *
+ * @param obj The gengrid object
+ * @param itc The item class, its item style selects the pooled contents
+ * @param data The data of the item
+ * @param part The part name of the swallow
+ * @param func The function building the content, given a pooled content
+ * to update in @p old, or @c NULL
+ * @return The object to swallow, or @c NULL
+ *
+ * Meant to be returned by the content_get function of @p itc:
+ *
+ * @code
+ * static Evas_Object *
+ * _content_get(void *data, Evas_Object *obj, const char *part)
+ * {
+ *    return elm_gengrid_pool_content_get(obj, itc, data, part, _photo_get);
+ * }
+ * @endcode
+ *
+ * The returned object holds the content built by @p func. When @p func
+ * does not return @p old, @p old is deleted. Without a pool @p func is
+ * called with no @p old and its content returned as is.
+ *
+ * @note @p func must not be the reusable_content_get function of
+ * @p itc, the gengrid would call it without going through the pool.
+ *
+ * @see elm_gengrid_pool_set()
+ */
+static inline Evas_Object *elm_gengrid_pool_content_get(Evas_Object *obj, const Elm_Gengrid_Item_Class *itc, void *data, const char *part, Elm_Gen_Item_Reusable_Content_Get_Cb func);
+
+/**
+ * Set the most contents built in a frame.
+ *
+ * @param obj The gengrid object
+ * @param budget The most contents built in a frame, 0 for no limit
+ *
+ * Past the budget, elm_gengrid_pool_content_get() returns an empty
+ * holder and builds its content on a later frame, in the order they
+ * were asked for. Contents of items unrealized before that are never
+ * built, which is most of them in a fling.
+ *
+ * The gengrid must pool contents, see elm_gengrid_pool_set().
+ */
+static inline void elm_gengrid_pool_frame_budget_set(Evas_Object *obj, unsigned int budget);
+
+/**
+ * Get the most contents built in a frame.
+ *
+ * @param obj The gengrid object
+ * @return The most contents built in a frame, 0 for no limit
+ *
+ * @see elm_gengrid_pool_frame_budget_set()
+ */
+static inline unsigned int elm_gengrid_pool_frame_budget_get(const Evas_Object *obj);
+
+/**
+ * Set a function called for the items a scroll is bringing in.
+ *
+ * @param obj The gengrid object
+ * @param ahead How far ahead to look, in seconds at the scroll speed, 0
+ * for the default of half a second
+ * @param func The function, or @c NULL to stop
+ * @param data The data passed to @p func
+ *
+ * On each scroll the speed is measured, and @p func is called once for
+ * each item that scrolling on at that speed brings in within @p ahead
+ * seconds, before the item is realized. It is meant to start the work
+ * not needing the main loop, image decoding with evas_object_image_preload()
+ * or evas_image_decode_request(), or text layout on an Ecore_Thread, so
+ * it is done when the content is built. Item positions come from the
+ * item size, as in a grid of items of the same size.
+ *
+ * The gengrid must pool contents, see elm_gengrid_pool_set().
+ */
+static inline void elm_gengrid_pool_prefetch_set(Evas_Object *obj, double ahead, Elm_Gengrid_Prefetch_Cb func, const void *data);
+
+/**
+ * Get the counters of a gengrid pooling its contents.
+ *
+ * @param obj The gengrid object
+ * @param stats Where to copy the counters
+ * @return @c EINA_TRUE on success, @c EINA_FALSE if the gengrid does not
+ * pool contents
+ *
+ * @see elm_gengrid_pool_set()
+ * @see elm_gengrid_realize_stats_reset()
+ */
+static inline Eina_Bool elm_gengrid_realize_stats_get(const Evas_Object *obj, Elm_Gengrid_Realize_Stats *stats);
+
+/**
+ * Reset the counters of a gengrid pooling its contents.
+ *
+ * @param obj The gengrid object
+ */
+static inline void elm_gengrid_realize_stats_reset(Evas_Object *obj);
+
+/**
+ * @}
+ */
+
+#include "elm_inline_gengrid.x"
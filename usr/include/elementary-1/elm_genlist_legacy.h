@@ -1252,3 +1252,172 @@ elm_genlist_filter_iterator_new(Evas_Object *obj);
 
 #include "elm_genlist_item.eo.legacy.h"
 #include "elm_genlist.eo.legacy.h"
+
+/**
+ * @addtogroup Genlist
+ * @{
+ */
+
+/**
+ * @typedef Elm_Genlist_Index
+ * The index of a genlist's items, see elm_genlist_index_add().
+ */
+typedef struct _Elm_Genlist_Index Elm_Genlist_Index;
+
+/**
+ * Create an index of the items of a genlist.
+ *
+ * @param obj The genlist object
+ * @param item_h The height of the items not given one of their own
+ * @return The index, or @c NULL on errors
+ *
+ * elm_genlist_item_index_get() and elm_genlist_nth_item_get() walk the
+ * items from the first one, and showing an item far down a list of
+ * items being queued waits for all the items before it to be sized.
+ * With a million items each of these takes milliseconds.
+ *
+ * An index keeps the items of a genlist in a balanced tree which knows
+ * how many items and how many pixels come before each of them, so the
+ * rank of an item, the item at a rank, the offset of an item and the
+ * item at an offset are found in O(log n). When no item has a height of
+ * its own, as in a homogeneous genlist, offsets are the rank times
+ * @p item_h.
+ *
+ * The index starts with the items the genlist already has. Items added
+ * to the genlist later must be given to elm_genlist_index_item_add(),
+ * or inserted with elm_genlist_index_item_sorted_insert(). Deleted items
+ * leave the index on their own.
+ *
+ * @see elm_genlist_index_free()
+ */
+static inline Elm_Genlist_Index *elm_genlist_index_add(Evas_Object *obj, Evas_Coord item_h);
+
+/**
+ * Free an index created with elm_genlist_index_add().
+ *
+ * @param idx The index
+ */
+static inline void elm_genlist_index_free(Elm_Genlist_Index *idx);
+
+/**
+ * Add an item of the genlist to its index.
+ *
+ * @param idx The index
+ * @param it An item, just added to the genlist
+ * @param h The height of the item, or 0 for the default height
+ * @return @c EINA_TRUE on success, @c EINA_FALSE otherwise
+ *
+ * The item takes its place after the closest item before it in the
+ * genlist which the index knows. Adding an item the index has already
+ * changes its height.
+ */
+static inline Eina_Bool elm_genlist_index_item_add(Elm_Genlist_Index *idx, Elm_Object_Item *it, Evas_Coord h);
+
+/**
+ * Change the height of an item in an index.
+ *
+ * @param idx The index
+ * @param it The item
+ * @param h The height of the item, or 0 for the default height
+ */
+static inline void elm_genlist_index_item_height_set(Elm_Genlist_Index *idx, Elm_Object_Item *it, Evas_Coord h);
+
+/**
+ * Change the height of the items of an index without one of their own.
+ *
+ * @param idx The index
+ * @param h The height
+ */
+static inline void elm_genlist_index_item_height_default_set(Elm_Genlist_Index *idx, Evas_Coord h);
+
+/**
+ * Get the number of items in an index.
+ *
+ * @param idx The index
+ * @return The number of items
+ */
+static inline unsigned int elm_genlist_index_count(const Elm_Genlist_Index *idx);
+
+/**
+ * Get the position of an item, in O(log n).
+ *
+ * @param idx The index
+ * @param it The item
+ * @return The position of the item, starting at 1 like
+ * elm_genlist_item_index_get(), or -1 if the index does not have it
+ */
+static inline int elm_genlist_index_item_index_get(const Elm_Genlist_Index *idx, const Elm_Object_Item *it);
+
+/**
+ * Get the item at a position, in O(log n).
+ *
+ * @param idx The index
+ * @param nth The position, starting at 0 like elm_genlist_nth_item_get()
+ * @return The item, or @c NULL if there are not as many
+ */
+static inline Elm_Object_Item *elm_genlist_index_nth_item_get(const Elm_Genlist_Index *idx, unsigned int nth);
+
+/**
+ * Get the offset of an item from the top of the list, in O(log n).
+ *
+ * @param idx The index
+ * @param it The item
+ * @return The offset, or -1 if the index does not have the item
+ */
+static inline Evas_Coord elm_genlist_index_item_y_get(const Elm_Genlist_Index *idx, const Elm_Object_Item *it);
+
+/**
+ * Get the item at an offset from the top of the list, in O(log n).
+ *
+ * @param idx The index
+ * @param y The offset
+ * @return The item, or @c NULL if the offset is past the last item
+ */
+static inline Elm_Object_Item *elm_genlist_index_at_y_get(const Elm_Genlist_Index *idx, Evas_Coord y);
+
+/**
+ * Get the height of all the items of an index.
+ *
+ * @param idx The index
+ * @return The height
+ */
+static inline Evas_Coord elm_genlist_index_height_get(const Elm_Genlist_Index *idx);
+
+/**
+ * Insert an item in a sorted genlist, in O(log n).
+ *
+ * @param idx The index
+ * @param itc The item class
+ * @param data The item data
+ * @param type Item type
+ * @param comp Compares the data of two items
+ * @param func Convenience function called when the item is selected
+ * @param func_data Data passed to @p func
+ * @return The item, or @c NULL on errors
+ *
+ * elm_genlist_item_sorted_insert() compares the new item to the items
+ * of the list in turn. This looks for its place in the index instead,
+ * and inserts it after the last item whose data @p comp does not find
+ * greater. It is meant for lists without tree items, the item is added
+ * at the top level.
+ */
+static inline Elm_Object_Item *elm_genlist_index_item_sorted_insert(Elm_Genlist_Index *idx, const Elm_Genlist_Item_Class *itc, const void *data, Elm_Genlist_Item_Type type, Eina_Compare_Cb comp, Evas_Smart_Cb func, const void *func_data);
+
+/**
+ * Show an item using its offset in the index.
+ *
+ * @param idx The index
+ * @param it The item
+ * @param type Where to position the item in the viewport
+ *
+ * Unlike elm_genlist_item_show(), this scrolls at once without waiting
+ * for the items before @p it to be sized, which is exact as long as the
+ * heights given to the index are the ones of the items.
+ */
+static inline void elm_genlist_index_item_show(const Elm_Genlist_Index *idx, const Elm_Object_Item *it, Elm_Genlist_Item_Scrollto_Type type);
+
+/**
+ * @}
+ */
+
+#include "elm_inline_genlist.x"
@@ -0,0 +1,698 @@
+/* ELEMENTARY - EFL widget toolkit
+ * Copyright (C) 2016 Samsung Electronics Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library;
+ * if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ELM_INLINE_GENGRID_X_
+#define ELM_INLINE_GENGRID_X_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @cond LOCAL
+ */
+
+#define ELM_GENGRID_POOL_KEY "_elm_gengrid_pool"
+
+typedef struct _Elm_Gengrid_Pool Elm_Gengrid_Pool;
+typedef struct _Elm_Gengrid_Pool_Spares Elm_Gengrid_Pool_Spares;
+typedef struct _Elm_Gengrid_Pool_Slot Elm_Gengrid_Pool_Slot;
+
+/* The contents kept for one item style and part. */
+struct _Elm_Gengrid_Pool_Spares
+{
+   Eina_Inlist *slots;
+   unsigned int count;
+   const char *part; // points in key
+   char key[]; // "style\037part"
+};
+
+/* A content handed to the widget is swallowed in a holder box, so when
+ * the widget deletes the holder the content can be taken out and kept.
+ * A slot is pending while the frame budget delays its content, active
+ * while its holder lives and spare once its content is pooled. */
+struct _Elm_Gengrid_Pool_Slot
+{
+   EINA_INLIST;
+   Elm_Gengrid_Pool *pool;
+   Elm_Gengrid_Pool_Spares *spares;
+   Evas_Object *holder;
+   Evas_Object *content;
+   Elm_Gen_Item_Reusable_Content_Get_Cb func;
+   void *data;
+   Eina_Bool pending : 1;
+};
+
+struct _Elm_Gengrid_Pool
+{
+   Evas_Object *obj;
+   Evas *evas;
+   Eina_Hash *spares; // "style\037part" -> Elm_Gengrid_Pool_Spares
+   Eina_Inlist *pending;
+   Eina_Inlist *active;
+   Ecore_Animator *animator;
+   unsigned int max;
+   unsigned int budget;
+   unsigned int npooled;
+
+   Elm_Gengrid_Prefetch_Cb prefetch_cb;
+   const void *prefetch_data;
+   double ahead;
+   double velocity; // pixels per second, along the scroll axis
+   double scroll_t;
+   Evas_Coord scroll_pos;
+   unsigned int prefetch_lo, prefetch_hi;
+
+   unsigned int frame_items;
+   unsigned int frame_contents;
+   Elm_Gengrid_Realize_Stats stats;
+
+   /* Every user of this header has its own copy of the callbacks, add and
+    * remove them through the ones of the pool. */
+   Evas_Object_Event_Cb content_del_cb;
+   Evas_Object_Event_Cb holder_del_cb;
+   Evas_Object_Event_Cb del_cb;
+   Evas_Event_Cb render_post_cb;
+   Evas_Smart_Cb realized_cb;
+   Evas_Smart_Cb scroll_cb;
+   Evas_Smart_Cb scroll_stop_cb;
+};
+
+static inline Elm_Gengrid_Pool *
+_elm_gengrid_pool_get(const Evas_Object *obj)
+{
+   return (Elm_Gengrid_Pool *)evas_object_data_get(obj, ELM_GENGRID_POOL_KEY);
+}
+
+static inline void
+_elm_gengrid_pool_slot_free(Elm_Gengrid_Pool_Slot *slot)
+{
+   if (slot->content)
+     evas_object_event_callback_del_full(slot->content, EVAS_CALLBACK_DEL,
+                                         slot->pool->content_del_cb, slot);
+   if (slot->holder)
+     evas_object_event_callback_del_full(slot->holder, EVAS_CALLBACK_DEL,
+                                         slot->pool->holder_del_cb, slot);
+   free(slot);
+}
+
+static inline void
+_elm_gengrid_pool_spare_del(Elm_Gengrid_Pool_Slot *slot)
+{
+   Evas_Object *content = slot->content;
+
+   slot->spares->slots = eina_inlist_remove(slot->spares->slots, EINA_INLIST_GET(slot));
+   slot->spares->count--;
+   slot->pool->npooled--;
+   _elm_gengrid_pool_slot_free(slot);
+   evas_object_del(content);
+}
+
+/* Takes the content last pooled for a style and part, NULL if none. */
+static inline Evas_Object *
+_elm_gengrid_pool_take(Elm_Gengrid_Pool_Spares *spares)
+{
+   Elm_Gengrid_Pool_Slot *slot;
+   Evas_Object *content;
+
+   if (!spares->slots) return NULL;
+   slot = EINA_INLIST_CONTAINER_GET(spares->slots, Elm_Gengrid_Pool_Slot);
+   spares->slots = eina_inlist_remove(spares->slots, spares->slots);
+   spares->count--;
+   slot->pool->npooled--;
+   content = slot->content;
+   _elm_gengrid_pool_slot_free(slot);
+   return content;
+}
+
+static void
+_elm_gengrid_pool_content_del(void *data, Evas *e EINA_UNUSED,
+                              Evas_Object *obj EINA_UNUSED,
+                              void *event_info EINA_UNUSED)
+{
+   Elm_Gengrid_Pool_Slot *slot = (Elm_Gengrid_Pool_Slot *)data;
+
+   // The holder box drops a deleted child on its own
+   if (slot->holder)
+     {
+        slot->content = NULL;
+        return;
+     }
+   slot->content = NULL;
+   slot->spares->slots = eina_inlist_remove(slot->spares->slots, EINA_INLIST_GET(slot));
+   slot->spares->count--;
+   slot->pool->npooled--;
+   free(slot);
+}
+
+static void
+_elm_gengrid_pool_holder_del(void *data, Evas *e EINA_UNUSED,
+                             Evas_Object *obj,
+                             void *event_info EINA_UNUSED)
+{
+   Elm_Gengrid_Pool_Slot *slot = (Elm_Gengrid_Pool_Slot *)data;
+   Elm_Gengrid_Pool *pool = slot->pool;
+   Elm_Gengrid_Pool_Spares *spares = slot->spares;
+
+   // Delete callbacks run before the box deletes its children
+   if (slot->pending)
+     pool->pending = eina_inlist_remove(pool->pending, EINA_INLIST_GET(slot));
+   else
+     pool->active = eina_inlist_remove(pool->active, EINA_INLIST_GET(slot));
+   slot->holder = NULL;
+
+   if ((!slot->content) || (spares->count >= pool->max))
+     {
+        _elm_gengrid_pool_slot_free(slot);
+        return;
+     }
+   evas_object_box_remove(obj, slot->content);
+   evas_object_hide(slot->content);
+   spares->slots = eina_inlist_prepend(spares->slots, EINA_INLIST_GET(slot));
+   spares->count++;
+   pool->npooled++;
+}
+
+static inline Elm_Gengrid_Pool_Spares *
+_elm_gengrid_pool_spares_get(Elm_Gengrid_Pool *pool, const char *style, const char *part)
+{
+   Elm_Gengrid_Pool_Spares *spares;
+   size_t slen, plen;
+   char key[256];
+
+   slen = strlen(style);
+   plen = strlen(part);
+   if (slen + plen + 2 > sizeof(key)) return NULL;
+   memcpy(key, style, slen);
+   key[slen] = '\037';
+   memcpy(key + slen + 1, part, plen + 1);
+
+   spares = (Elm_Gengrid_Pool_Spares *)eina_hash_find(pool->spares, key);
+   if (spares) return spares;
+   spares = (Elm_Gengrid_Pool_Spares *)calloc(1, sizeof(Elm_Gengrid_Pool_Spares) + slen + plen + 2);
+   if (!spares) return NULL;
+   memcpy(spares->key, key, slen + plen + 2);
+   spares->part = spares->key + slen + 1;
+   if (!eina_hash_add(pool->spares, key, spares))
+     {
+        free(spares);
+        return NULL;
+     }
+   return spares;
+}
+
+/* Builds the content of a slot, from a pooled one if there is any. */
+static inline void
+_elm_gengrid_pool_fill(Elm_Gengrid_Pool *pool, Elm_Gengrid_Pool_Slot *slot)
+{
+   Evas_Object *old, *content;
+
+   old = _elm_gengrid_pool_take(slot->spares);
+   content = slot->func(slot->data, pool->obj, slot->spares->part, old);
+   if (old && (content != old)) evas_object_del(old);
+   if (old && (content == old)) pool->stats.reused++;
+   else pool->stats.created++;
+   pool->stats.contents++;
+   pool->frame_contents++;
+   if (!content) return;
+
+   slot->content = content;
+   evas_object_event_callback_add(content, EVAS_CALLBACK_DEL,
+                                  pool->content_del_cb, slot);
+   evas_object_show(content);
+   evas_object_box_append(slot->holder, content);
+}
+
+static inline Eina_Bool
+_elm_gengrid_pool_budget_left(const Elm_Gengrid_Pool *pool)
+{
+   return (!pool->budget) || (pool->frame_contents < pool->budget);
+}
+
+/* Fills pending slots in the order they were asked for, all of them or
+ * what the budget of the frame leaves. */
+static inline void
+_elm_gengrid_pool_flush(Elm_Gengrid_Pool *pool, Eina_Bool all)
+{
+   Elm_Gengrid_Pool_Slot *slot;
+
+   while (pool->pending && (all || _elm_gengrid_pool_budget_left(pool)))
+     {
+        slot = EINA_INLIST_CONTAINER_GET(pool->pending, Elm_Gengrid_Pool_Slot);
+        pool->pending = eina_inlist_remove(pool->pending, pool->pending);
+        pool->active = eina_inlist_append(pool->active, EINA_INLIST_GET(slot));
+        slot->pending = EINA_FALSE;
+        _elm_gengrid_pool_fill(pool, slot);
+     }
+}
+
+static Eina_Bool
+_elm_gengrid_pool_animator(void *data)
+{
+   Elm_Gengrid_Pool *pool = (Elm_Gengrid_Pool *)data;
+
+   _elm_gengrid_pool_flush(pool, EINA_FALSE);
+   if (pool->pending) return ECORE_CALLBACK_RENEW;
+   pool->animator = NULL;
+   return ECORE_CALLBACK_CANCEL;
+}
+
+static void
+_elm_gengrid_pool_render_post(void *data, Evas *e EINA_UNUSED,
+                              void *event_info EINA_UNUSED)
+{
+   Elm_Gengrid_Pool *pool = (Elm_Gengrid_Pool *)data;
+
+   pool->stats.frames++;
+   pool->stats.items_last = pool->frame_items;
+   pool->stats.contents_last = pool->frame_contents;
+   if (pool->frame_items > pool->stats.items_peak)
+     pool->stats.items_peak = pool->frame_items;
+   if (pool->frame_contents > pool->stats.contents_peak)
+     pool->stats.contents_peak = pool->frame_contents;
+   pool->frame_items = 0;
+   pool->frame_contents = 0;
+}
+
+static void
+_elm_gengrid_pool_realized(void *data, Evas_Object *obj EINA_UNUSED,
+                           void *event_info EINA_UNUSED)
+{
+   Elm_Gengrid_Pool *pool = (Elm_Gengrid_Pool *)data;
+
+   pool->stats.items++;
+   pool->frame_items++;
+}
+
+/* The item at rank n, stepping from the nearest realized item: those
+ * are around the view, where prefetching starts, while
+ * elm_gengrid_nth_item_get() walks from the first item. */
+static inline Elm_Object_Item *
+_elm_gengrid_pool_nth_item_get(Elm_Gengrid_Pool *pool, unsigned int n)
+{
+   Elm_Object_Item *it, *near = NULL;
+   Eina_List *realized, *l;
+   unsigned int rank = 0, gap = n, r, d;
+   void *item;
+   int idx;
+
+   realized = elm_gengrid_realized_items_get(pool->obj);
+   EINA_LIST_FOREACH(realized, l, item)
+     {
+        // Indexes count from 1
+        idx = elm_gengrid_item_index_get((Elm_Object_Item *)item);
+        if (idx < 1) continue;
+        r = (unsigned int)idx - 1;
+        d = r > n ? r - n : n - r;
+        if (d >= gap) continue;
+        near = (Elm_Object_Item *)item;
+        rank = r;
+        gap = d;
+     }
+   eina_list_free(realized);
+   if (!near) return elm_gengrid_nth_item_get(pool->obj, n);
+
+   for (it = near; (it) && (rank < n); rank++)
+     it = elm_gengrid_item_next_get(it);
+   for (; (it) && (rank > n); rank--)
+     it = elm_gengrid_item_prev_get(it);
+   return it;
+}
+
+/* Hands the items a scroll at the current speed brings in within the
+ * look ahead time to the prefetch callback, each of them once. Item
+ * positions come from the item size, as in a homogeneous grid. */
+static inline void
+_elm_gengrid_pool_prefetch(Elm_Gengrid_Pool *pool, Eina_Bool horizontal,
+                           Evas_Coord pos, Evas_Coord view, Evas_Coord across)
+{
+   Elm_Object_Item *it;
+   Evas_Coord iw = 0, ih = 0, line, per_line;
+   double dist, from, to;
+   unsigned int count, lo, hi, i;
+
+   elm_gengrid_item_size_get(pool->obj, &iw, &ih);
+   line = horizontal ? iw : ih;
+   per_line = horizontal ? (ih > 0 ? across / ih : 0) : (iw > 0 ? across / iw : 0);
+   if ((line <= 0) || (view <= 0)) return;
+   if (per_line < 1) per_line = 1;
+
+   dist = pool->velocity * pool->ahead;
+   if (dist >= 1)
+     {
+        from = pos + view;
+        to = from + dist;
+     }
+   else if (dist <= -1)
+     {
+        to = pos;
+        from = to + dist;
+        if (from < 0) from = 0;
+     }
+   else return;
+   if (to <= from) return;
+
+   count = elm_gengrid_items_count(pool->obj);
+   lo = (unsigned int)(from / line) * per_line;
+   hi = ((unsigned int)((to - 1) / line) + 1) * per_line;
+   if (hi > count) hi = count;
+   if (lo >= hi) return;
+
+   it = NULL;
+   for (i = lo; i < hi; i++)
+     {
+        it = it ? elm_gengrid_item_next_get(it) : _elm_gengrid_pool_nth_item_get(pool, i);
+        if (!it) break;
+        if ((i >= pool->prefetch_lo) && (i < pool->prefetch_hi)) continue;
+        pool->stats.prefetched++;
+        pool->prefetch_cb((void *)pool->prefetch_data, pool->obj, it);
+     }
+   pool->prefetch_lo = lo;
+   pool->prefetch_hi = hi;
+}
+
+static void
+_elm_gengrid_pool_scroll(void *data, Evas_Object *obj,
+                         void *event_info EINA_UNUSED)
+{
+   Elm_Gengrid_Pool *pool = (Elm_Gengrid_Pool *)data;
+   Evas_Coord x, y, w, h, pos;
+   Eina_Bool horizontal;
+   double t;
+
+   if (!pool->prefetch_cb) return;
+
+   elm_scroller_region_get(obj, &x, &y, &w, &h);
+   horizontal = elm_gengrid_horizontal_get(obj);
+   pos = horizontal ? x : y;
+   t = ecore_loop_time_get();
+   // Smoothed, a single frame says little with uneven frame times
+   if ((pool->scroll_t > 0) && (t > pool->scroll_t))
+     pool->velocity = (pool->velocity +
+                       (pos - pool->scroll_pos) / (t - pool->scroll_t)) / 2;
+   pool->scroll_pos = pos;
+   pool->scroll_t = t;
+
+   if (horizontal)
+     _elm_gengrid_pool_prefetch(pool, horizontal, pos, w, h);
+   else
+     _elm_gengrid_pool_prefetch(pool, horizontal, pos, h, w);
+}
+
+static void
+_elm_gengrid_pool_scroll_stop(void *data, Evas_Object *obj EINA_UNUSED,
+                              void *event_info EINA_UNUSED)
+{
+   Elm_Gengrid_Pool *pool = (Elm_Gengrid_Pool *)data;
+
+   pool->velocity = 0;
+   pool->scroll_t = 0;
+}
+
+static Eina_Bool
+_elm_gengrid_pool_spares_free_cb(const Eina_Hash *hash EINA_UNUSED,
+                                 const void *key EINA_UNUSED,
+                                 void *data, void *fdata EINA_UNUSED)
+{
+   Elm_Gengrid_Pool_Spares *spares = (Elm_Gengrid_Pool_Spares *)data;
+
+   while (spares->slots)
+     _elm_gengrid_pool_spare_del(EINA_INLIST_CONTAINER_GET(spares->slots, Elm_Gengrid_Pool_Slot));
+   return EINA_TRUE;
+}
+
+/* Leaves the holders alive with what they have, the widget deletes
+ * them with their items. */
+static inline void
+_elm_gengrid_pool_free(Elm_Gengrid_Pool *pool)
+{
+   Elm_Gengrid_Pool_Slot *slot;
+
+   if (pool->animator) ecore_animator_del(pool->animator);
+   evas_event_callback_del_full(pool->evas, EVAS_CALLBACK_RENDER_POST,
+                                pool->render_post_cb, pool);
+   evas_object_event_callback_del_full(pool->obj, EVAS_CALLBACK_DEL,
+                                       pool->del_cb, pool);
+   evas_object_smart_callback_del_full(pool->obj, "realized",
+                                       pool->realized_cb, pool);
+   evas_object_smart_callback_del_full(pool->obj, "scroll",
+                                       pool->scroll_cb, pool);
+   evas_object_smart_callback_del_full(pool->obj, "scroll,anim,stop",
+                                       pool->scroll_stop_cb, pool);
+   evas_object_smart_callback_del_full(pool->obj, "scroll,drag,stop",
+                                       pool->scroll_stop_cb, pool);
+
+   while (pool->pending)
+     {
+        slot = EINA_INLIST_CONTAINER_GET(pool->pending, Elm_Gengrid_Pool_Slot);
+        pool->pending = eina_inlist_remove(pool->pending, pool->pending);
+        _elm_gengrid_pool_slot_free(slot);
+     }
+   while (pool->active)
+     {
+        slot = EINA_INLIST_CONTAINER_GET(pool->active, Elm_Gengrid_Pool_Slot);
+        pool->active = eina_inlist_remove(pool->active, pool->active);
+        _elm_gengrid_pool_slot_free(slot);
+     }
+   eina_hash_foreach(pool->spares, _elm_gengrid_pool_spares_free_cb, NULL);
+   eina_hash_free(pool->spares);
+   free(pool);
+}
+
+static void
+_elm_gengrid_pool_del(void *data, Evas *e EINA_UNUSED, Evas_Object *obj,
+                      void *event_info EINA_UNUSED)
+{
+   evas_object_data_del(obj, ELM_GENGRID_POOL_KEY);
+   _elm_gengrid_pool_free((Elm_Gengrid_Pool *)data);
+}
+
+/* Drops the contents pooled first above max. */
+static Eina_Bool
+_elm_gengrid_pool_trim_cb(const Eina_Hash *hash EINA_UNUSED,
+                          const void *key EINA_UNUSED,
+                          void *data, void *fdata)
+{
+   Elm_Gengrid_Pool_Spares *spares = (Elm_Gengrid_Pool_Spares *)data;
+   Elm_Gengrid_Pool *pool = (Elm_Gengrid_Pool *)fdata;
+
+   while (spares->count > pool->max)
+     _elm_gengrid_pool_spare_del(EINA_INLIST_CONTAINER_GET(spares->slots->last, Elm_Gengrid_Pool_Slot));
+   return EINA_TRUE;
+}
+
+/**
+ * @endcond
+ */
+
+static inline Eina_Bool
+elm_gengrid_pool_set(Evas_Object *obj, unsigned int max)
+{
+   Elm_Gengrid_Pool *pool;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(obj, EINA_FALSE);
+
+   pool = _elm_gengrid_pool_get(obj);
+   if (!max)
+     {
+        if (!pool) return EINA_TRUE;
+        // Items waiting for their contents get them before leaving
+        _elm_gengrid_pool_flush(pool, EINA_TRUE);
+        evas_object_data_del(obj, ELM_GENGRID_POOL_KEY);
+        _elm_gengrid_pool_free(pool);
+        return EINA_TRUE;
+     }
+   if (pool)
+     {
+        pool->max = max;
+        eina_hash_foreach(pool->spares, _elm_gengrid_pool_trim_cb, pool);
+        return EINA_TRUE;
+     }
+
+   pool = (Elm_Gengrid_Pool *)calloc(1, sizeof(Elm_Gengrid_Pool));
+   if (!pool) return EINA_FALSE;
+   pool->spares = eina_hash_string_small_new(free);
+   if (!pool->spares)
+     {
+        free(pool);
+        return EINA_FALSE;
+     }
+   pool->obj = obj;
+   pool->evas = evas_object_evas_get(obj);
+   pool->max = max;
+   pool->ahead = 0.5;
+   pool->content_del_cb = _elm_gengrid_pool_content_del;
+   pool->holder_del_cb = _elm_gengrid_pool_holder_del;
+   pool->del_cb = _elm_gengrid_pool_del;
+   pool->render_post_cb = _elm_gengrid_pool_render_post;
+   pool->realized_cb = _elm_gengrid_pool_realized;
+   pool->scroll_cb = _elm_gengrid_pool_scroll;
+   pool->scroll_stop_cb = _elm_gengrid_pool_scroll_stop;
+
+   evas_object_data_set(obj, ELM_GENGRID_POOL_KEY, pool);
+   evas_object_event_callback_add(obj, EVAS_CALLBACK_DEL,
+                                  pool->del_cb, pool);
+   evas_event_callback_add(pool->evas, EVAS_CALLBACK_RENDER_POST,
+                           pool->render_post_cb, pool);
+   evas_object_smart_callback_add(obj, "realized",
+                                  pool->realized_cb, pool);
+   evas_object_smart_callback_add(obj, "scroll",
+                                  pool->scroll_cb, pool);
+   evas_object_smart_callback_add(obj, "scroll,anim,stop",
+                                  pool->scroll_stop_cb, pool);
+   evas_object_smart_callback_add(obj, "scroll,drag,stop",
+                                  pool->scroll_stop_cb, pool);
+   return EINA_TRUE;
+}
+
+static inline unsigned int
+elm_gengrid_pool_get(const Evas_Object *obj)
+{
+   Elm_Gengrid_Pool *pool;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(obj, 0);
+
+   pool = _elm_gengrid_pool_get(obj);
+   return pool ? pool->max : 0;
+}
+
+static inline Evas_Object *
+elm_gengrid_pool_content_get(Evas_Object *obj,
+                             const Elm_Gengrid_Item_Class *itc,
+                             void *data,
+                             const char *part,
+                             Elm_Gen_Item_Reusable_Content_Get_Cb func)
+{
+   Elm_Gengrid_Pool *pool;
+   Elm_Gengrid_Pool_Spares *spares;
+   Elm_Gengrid_Pool_Slot *slot;
+   Evas_Object *holder;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(obj, NULL);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(itc, NULL);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(part, NULL);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(func, NULL);
+
+   pool = _elm_gengrid_pool_get(obj);
+   spares = pool ? _elm_gengrid_pool_spares_get(pool, itc->item_style ? itc->item_style : "default", part) : NULL;
+   if (!spares) return func(data, obj, part, NULL);
+
+   holder = evas_object_box_add(pool->evas);
+   if (!holder) return func(data, obj, part, NULL);
+   slot = (Elm_Gengrid_Pool_Slot *)calloc(1, sizeof(Elm_Gengrid_Pool_Slot));
+   if (!slot)
+     {
+        evas_object_del(holder);
+        return func(data, obj, part, NULL);
+     }
+   evas_object_box_layout_set(holder, evas_object_box_layout_stack, NULL, NULL);
+   slot->pool = pool;
+   slot->spares = spares;
+   slot->holder = holder;
+   slot->func = func;
+   slot->data = data;
+   evas_object_event_callback_add(holder, EVAS_CALLBACK_DEL,
+                                  pool->holder_del_cb, slot);
+
+   if (!_elm_gengrid_pool_budget_left(pool))
+     {
+        slot->pending = EINA_TRUE;
+        pool->pending = eina_inlist_append(pool->pending, EINA_INLIST_GET(slot));
+        pool->stats.deferred++;
+        if (!pool->animator)
+          pool->animator = ecore_animator_add(_elm_gengrid_pool_animator, pool);
+        return holder;
+     }
+
+   pool->active = eina_inlist_append(pool->active, EINA_INLIST_GET(slot));
+   _elm_gengrid_pool_fill(pool, slot);
+   if (slot->content) return holder;
+
+   // Nothing to show, the part stays empty as without the pool
+   evas_object_del(holder);
+   return NULL;
+}
+
+static inline void
+elm_gengrid_pool_frame_budget_set(Evas_Object *obj, unsigned int budget)
+{
+   Elm_Gengrid_Pool *pool;
+
+   EINA_SAFETY_ON_NULL_RETURN(obj);
+   pool = _elm_gengrid_pool_get(obj);
+   EINA_SAFETY_ON_NULL_RETURN(pool);
+
+   pool->budget = budget;
+   if (!budget) _elm_gengrid_pool_flush(pool, EINA_TRUE);
+}
+
+static inline unsigned int
+elm_gengrid_pool_frame_budget_get(const Evas_Object *obj)
+{
+   Elm_Gengrid_Pool *pool;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(obj, 0);
+
+   pool = _elm_gengrid_pool_get(obj);
+   return pool ? pool->budget : 0;
+}
+
+static inline void
+elm_gengrid_pool_prefetch_set(Evas_Object *obj, double ahead,
+                              Elm_Gengrid_Prefetch_Cb func, const void *data)
+{
+   Elm_Gengrid_Pool *pool;
+
+   EINA_SAFETY_ON_NULL_RETURN(obj);
+   pool = _elm_gengrid_pool_get(obj);
+   EINA_SAFETY_ON_NULL_RETURN(pool);
+
+   pool->prefetch_cb = func;
+   pool->prefetch_data = data;
+   pool->ahead = ahead > 0 ? ahead : 0.5;
+   pool->prefetch_lo = pool->prefetch_hi = 0;
+}
+
+static inline Eina_Bool
+elm_gengrid_realize_stats_get(const Evas_Object *obj, Elm_Gengrid_Realize_Stats *stats)
+{
+   Elm_Gengrid_Pool *pool;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(obj, EINA_FALSE);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(stats, EINA_FALSE);
+
+   pool = _elm_gengrid_pool_get(obj);
+   if (!pool) return EINA_FALSE;
+   *stats = pool->stats;
+   stats->pooled = pool->npooled;
+   stats->pending = eina_inlist_count(pool->pending);
+   return EINA_TRUE;
+}
+
+static inline void
+elm_gengrid_realize_stats_reset(Evas_Object *obj)
+{
+   Elm_Gengrid_Pool *pool;
+
+   EINA_SAFETY_ON_NULL_RETURN(obj);
+
+   pool = _elm_gengrid_pool_get(obj);
+   if (pool) memset(&pool->stats, 0, sizeof(pool->stats));
+}
+
+#endif
@@ -0,0 +1,530 @@
+/* ELEMENTARY - EFL widget toolkit
+ * Copyright (C) 2016 Samsung Electronics Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library;
+ * if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ELM_INLINE_GENLIST_X_
+#define ELM_INLINE_GENLIST_X_
+
+#include <stdlib.h>
+
+/**
+ * @cond LOCAL
+ */
+
+typedef struct _Elm_Genlist_Index_Node Elm_Genlist_Index_Node;
+
+/* A treap ordered like the genlist, each node summing its subtree so
+ * ranks and offsets are found walking up from a node. A height of 0
+ * stands for the default height, which can then change in O(1). */
+struct _Elm_Genlist_Index_Node
+{
+   Elm_Genlist_Index_Node *left, *right, *parent;
+   Elm_Object_Item *item;
+   unsigned int prio;
+   Evas_Coord h;
+
+   unsigned int count; // nodes in the subtree
+   unsigned int sized; // nodes with a height of their own in the subtree
+   long long sized_h; // sum of those heights
+};
+
+struct _Elm_Genlist_Index
+{
+   Evas_Object *obj;
+   Elm_Genlist_Index_Node *root;
+   Eina_Hash *nodes; // Elm_Object_Item -> Elm_Genlist_Index_Node
+   Evas_Coord item_h;
+   unsigned int seed;
+   /* Every user of this header has its own copy of the callback, add and
+    * remove it through the one of the index. */
+   Eo_Event_Cb item_del_cb;
+};
+
+static inline unsigned int
+_elm_genlist_index_count(const Elm_Genlist_Index_Node *n)
+{
+   return n ? n->count : 0;
+}
+
+static inline long long
+_elm_genlist_index_h(const Elm_Genlist_Index *idx, const Elm_Genlist_Index_Node *n)
+{
+   if (!n) return 0;
+   return n->sized_h + (long long)(n->count - n->sized) * idx->item_h;
+}
+
+static inline Evas_Coord
+_elm_genlist_index_node_h(const Elm_Genlist_Index *idx, const Elm_Genlist_Index_Node *n)
+{
+   return n->h ? n->h : idx->item_h;
+}
+
+static inline void
+_elm_genlist_index_update(Elm_Genlist_Index_Node *n)
+{
+   n->count = 1;
+   n->sized = !!n->h;
+   n->sized_h = n->h;
+   if (n->left)
+     {
+        n->count += n->left->count;
+        n->sized += n->left->sized;
+        n->sized_h += n->left->sized_h;
+     }
+   if (n->right)
+     {
+        n->count += n->right->count;
+        n->sized += n->right->sized;
+        n->sized_h += n->right->sized_h;
+     }
+}
+
+static inline void
+_elm_genlist_index_update_up(Elm_Genlist_Index_Node *n)
+{
+   for (; n; n = n->parent)
+     _elm_genlist_index_update(n);
+}
+
+/* Moves n above its parent, keeping the order. */
+static inline void
+_elm_genlist_index_rotate(Elm_Genlist_Index *idx, Elm_Genlist_Index_Node *n)
+{
+   Elm_Genlist_Index_Node *p = n->parent, *g = p->parent;
+
+   if (p->left == n)
+     {
+        p->left = n->right;
+        if (n->right) n->right->parent = p;
+        n->right = p;
+     }
+   else
+     {
+        p->right = n->left;
+        if (n->left) n->left->parent = p;
+        n->left = p;
+     }
+   p->parent = n;
+   n->parent = g;
+   if (!g) idx->root = n;
+   else if (g->left == p) g->left = n;
+   else g->right = n;
+
+   _elm_genlist_index_update(p);
+   _elm_genlist_index_update(n);
+}
+
+static inline unsigned int
+_elm_genlist_index_prio(Elm_Genlist_Index *idx)
+{
+   // xorshift32, the shape only needs to be unlikely to degenerate
+   idx->seed ^= idx->seed << 13;
+   idx->seed ^= idx->seed >> 17;
+   idx->seed ^= idx->seed << 5;
+   return idx->seed;
+}
+
+/* Links n right after prev, or first when prev is NULL. */
+static inline void
+_elm_genlist_index_link(Elm_Genlist_Index *idx, Elm_Genlist_Index_Node *prev,
+                        Elm_Genlist_Index_Node *n)
+{
+   Elm_Genlist_Index_Node *p;
+
+   if (!idx->root)
+     {
+        idx->root = n;
+        _elm_genlist_index_update(n);
+        return;
+     }
+
+   if (!prev)
+     {
+        for (p = idx->root; p->left; p = p->left) ;
+        p->left = n;
+     }
+   else if (!prev->right)
+     {
+        p = prev;
+        p->right = n;
+     }
+   else
+     {
+        for (p = prev->right; p->left; p = p->left) ;
+        p->left = n;
+     }
+   n->parent = p;
+   _elm_genlist_index_update_up(n);
+
+   while (n->parent && n->parent->prio < n->prio)
+     _elm_genlist_index_rotate(idx, n);
+}
+
+static inline void
+_elm_genlist_index_unlink(Elm_Genlist_Index *idx, Elm_Genlist_Index_Node *n)
+{
+   Elm_Genlist_Index_Node *p;
+
+   while (n->left || n->right)
+     {
+        if (!n->right ||
+            (n->left && n->left->prio > n->right->prio))
+          _elm_genlist_index_rotate(idx, n->left);
+        else
+          _elm_genlist_index_rotate(idx, n->right);
+     }
+
+   p = n->parent;
+   if (!p) idx->root = NULL;
+   else
+     {
+        if (p->left == n) p->left = NULL;
+        else p->right = NULL;
+        _elm_genlist_index_update_up(p);
+     }
+}
+
+static inline Elm_Genlist_Index_Node *
+_elm_genlist_index_node_get(const Elm_Genlist_Index *idx, const Elm_Object_Item *it)
+{
+   if (!it) return NULL;
+   return (Elm_Genlist_Index_Node *)eina_hash_find(idx->nodes, &it);
+}
+
+static inline void
+_elm_genlist_index_node_del(Elm_Genlist_Index *idx, Elm_Genlist_Index_Node *n)
+{
+   _elm_genlist_index_unlink(idx, n);
+   eina_hash_del_by_key(idx->nodes, &n->item);
+   free(n);
+}
+
+static Eina_Bool
+_elm_genlist_index_item_del(void *data, Eo *obj,
+                            const Eo_Event_Description2 *desc EINA_UNUSED,
+                            void *event_info EINA_UNUSED)
+{
+   Elm_Genlist_Index *idx = (Elm_Genlist_Index *)data;
+   Elm_Genlist_Index_Node *n;
+
+   n = _elm_genlist_index_node_get(idx, obj);
+   if (n) _elm_genlist_index_node_del(idx, n);
+   return EO_CALLBACK_CONTINUE;
+}
+
+static Eina_Bool
+_elm_genlist_index_free_cb(const Eina_Hash *hash EINA_UNUSED,
+                           const void *key EINA_UNUSED,
+                           void *data, void *fdata)
+{
+   Elm_Genlist_Index *idx = (Elm_Genlist_Index *)fdata;
+   Elm_Genlist_Index_Node *n = (Elm_Genlist_Index_Node *)data;
+
+   eo_do(n->item, eo_event_callback_del(EO_BASE_EVENT_DEL,
+                                        idx->item_del_cb, idx));
+   free(n);
+   return EINA_TRUE;
+}
+
+/**
+ * @endcond
+ */
+
+static inline Elm_Genlist_Index *
+elm_genlist_index_add(Evas_Object *obj, Evas_Coord item_h)
+{
+   Elm_Genlist_Index *idx;
+   Elm_Object_Item *it;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(obj, NULL);
+
+   idx = (Elm_Genlist_Index *)calloc(1, sizeof (Elm_Genlist_Index));
+   if (!idx) return NULL;
+   idx->obj = obj;
+   idx->item_del_cb = _elm_genlist_index_item_del;
+   idx->item_h = item_h;
+   idx->seed = 2463534242U;
+   idx->nodes = eina_hash_pointer_new(NULL);
+   if (!idx->nodes)
+     {
+        free(idx);
+        return NULL;
+     }
+
+   for (it = elm_genlist_first_item_get(obj); it; it = elm_genlist_item_next_get(it))
+     elm_genlist_index_item_add(idx, it, 0);
+   return idx;
+}
+
+static inline void
+elm_genlist_index_free(Elm_Genlist_Index *idx)
+{
+   if (!idx) return;
+
+   eina_hash_foreach(idx->nodes, _elm_genlist_index_free_cb, idx);
+   eina_hash_free(idx->nodes);
+   free(idx);
+}
+
+static inline Eina_Bool
+elm_genlist_index_item_add(Elm_Genlist_Index *idx, Elm_Object_Item *it, Evas_Coord h)
+{
+   Elm_Genlist_Index_Node *n, *prev = NULL;
+   Elm_Object_Item *p;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(idx, EINA_FALSE);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(it, EINA_FALSE);
+
+   n = _elm_genlist_index_node_get(idx, it);
+   if (n)
+     {
+        elm_genlist_index_item_height_set(idx, it, h);
+        return EINA_TRUE;
+     }
+
+   // Items the index does not know are skipped, they have no rank
+   for (p = elm_genlist_item_prev_get(it); p && !prev; p = elm_genlist_item_prev_get(p))
+     prev = _elm_genlist_index_node_get(idx, p);
+
+   n = (Elm_Genlist_Index_Node *)calloc(1, sizeof (Elm_Genlist_Index_Node));
+   if (!n) return EINA_FALSE;
+   n->item = it;
+   n->h = h > 0 ? h : 0;
+   n->prio = _elm_genlist_index_prio(idx);
+   if (!eina_hash_add(idx->nodes, &it, n))
+     {
+        free(n);
+        return EINA_FALSE;
+     }
+   _elm_genlist_index_link(idx, prev, n);
+   eo_do(it, eo_event_callback_add(EO_BASE_EVENT_DEL,
+                                   idx->item_del_cb, idx));
+   return EINA_TRUE;
+}
+
+static inline void
+elm_genlist_index_item_height_set(Elm_Genlist_Index *idx, Elm_Object_Item *it, Evas_Coord h)
+{
+   Elm_Genlist_Index_Node *n;
+
+   EINA_SAFETY_ON_NULL_RETURN(idx);
+
+   n = _elm_genlist_index_node_get(idx, it);
+   if (!n) return;
+   n->h = h > 0 ? h : 0;
+   _elm_genlist_index_update_up(n);
+}
+
+static inline void
+elm_genlist_index_item_height_default_set(Elm_Genlist_Index *idx, Evas_Coord h)
+{
+   EINA_SAFETY_ON_NULL_RETURN(idx);
+
+   idx->item_h = h;
+}
+
+static inline unsigned int
+elm_genlist_index_count(const Elm_Genlist_Index *idx)
+{
+   EINA_SAFETY_ON_NULL_RETURN_VAL(idx, 0);
+
+   return _elm_genlist_index_count(idx->root);
+}
+
+static inline int
+elm_genlist_index_item_index_get(const Elm_Genlist_Index *idx, const Elm_Object_Item *it)
+{
+   const Elm_Genlist_Index_Node *n;
+   unsigned int rank;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(idx, -1);
+
+   n = _elm_genlist_index_node_get(idx, it);
+   if (!n) return -1;
+
+   rank = _elm_genlist_index_count(n->left);
+   for (; n->parent; n = n->parent)
+     if (n->parent->right == n)
+       rank += _elm_genlist_index_count(n->parent->left) + 1;
+   return rank + 1;
+}
+
+static inline Elm_Object_Item *
+elm_genlist_index_nth_item_get(const Elm_Genlist_Index *idx, unsigned int nth)
+{
+   const Elm_Genlist_Index_Node *n;
+   unsigned int l;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(idx, NULL);
+
+   n = idx->root;
+   while (n)
+     {
+        l = _elm_genlist_index_count(n->left);
+        if (nth < l) n = n->left;
+        else if (nth == l) return n->item;
+        else
+          {
+             nth -= l + 1;
+             n = n->right;
+          }
+     }
+   return NULL;
+}
+
+static inline Evas_Coord
+elm_genlist_index_item_y_get(const Elm_Genlist_Index *idx, const Elm_Object_Item *it)
+{
+   const Elm_Genlist_Index_Node *n;
+   long long y;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(idx, -1);
+
+   n = _elm_genlist_index_node_get(idx, it);
+   if (!n) return -1;
+
+   // Same height for all, the offset is the rank times the height
+   if (!idx->root->sized)
+     return (elm_genlist_index_item_index_get(idx, it) - 1) * idx->item_h;
+
+   y = _elm_genlist_index_h(idx, n->left);
+   for (; n->parent; n = n->parent)
+     if (n->parent->right == n)
+       y += _elm_genlist_index_h(idx, n->parent->left) +
+         _elm_genlist_index_node_h(idx, n->parent);
+   return y;
+}
+
+static inline Elm_Object_Item *
+elm_genlist_index_at_y_get(const Elm_Genlist_Index *idx, Evas_Coord y)
+{
+   const Elm_Genlist_Index_Node *n;
+   long long off = y, lh, h;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(idx, NULL);
+
+   if ((y < 0) || !idx->root) return NULL;
+   if (!idx->root->sized)
+     return idx->item_h > 0 ?
+       elm_genlist_index_nth_item_get(idx, y / idx->item_h) : NULL;
+
+   n = idx->root;
+   while (n)
+     {
+        lh = _elm_genlist_index_h(idx, n->left);
+        if (off < lh)
+          {
+             n = n->left;
+             continue;
+          }
+        off -= lh;
+        h = _elm_genlist_index_node_h(idx, n);
+        if (off < h) return n->item;
+        off -= h;
+        n = n->right;
+     }
+   return NULL;
+}
+
+static inline Evas_Coord
+elm_genlist_index_height_get(const Elm_Genlist_Index *idx)
+{
+   EINA_SAFETY_ON_NULL_RETURN_VAL(idx, 0);
+
+   return _elm_genlist_index_h(idx, idx->root);
+}
+
+static inline Elm_Object_Item *
+elm_genlist_index_item_sorted_insert(Elm_Genlist_Index *idx,
+                                     const Elm_Genlist_Item_Class *itc,
+                                     const void *data,
+                                     Elm_Genlist_Item_Type type,
+                                     Eina_Compare_Cb comp,
+                                     Evas_Smart_Cb func,
+                                     const void *func_data)
+{
+   const Elm_Genlist_Index_Node *n, *after = NULL;
+   Elm_Object_Item *it;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(idx, NULL);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(comp, NULL);
+
+   // Goes after the last item not greater than data, equal ones keep
+   // the order they were inserted in
+   for (n = idx->root; n; )
+     {
+        if (comp(elm_object_item_data_get(n->item), data) <= 0)
+          {
+             after = n;
+             n = n->right;
+          }
+        else n = n->left;
+     }
+
+   if (after)
+     it = elm_genlist_item_insert_after(idx->obj, itc, data, NULL, after->item,
+                                        type, func, func_data);
+   else
+     it = elm_genlist_item_prepend(idx->obj, itc, data, NULL, type,
+                                   func, func_data);
+   if (it && !elm_genlist_index_item_add(idx, it, 0))
+     {
+        elm_object_item_del(it);
+        return NULL;
+     }
+   return it;
+}
+
+static inline void
+elm_genlist_index_item_show(const Elm_Genlist_Index *idx, const Elm_Object_Item *it,
+                            Elm_Genlist_Item_Scrollto_Type type)
+{
+   const Elm_Genlist_Index_Node *n;
+   Evas_Coord x, vy, vw, vh, y, h;
+
+   EINA_SAFETY_ON_NULL_RETURN(idx);
+
+   n = _elm_genlist_index_node_get(idx, it);
+   if (!n) return;
+
+   y = elm_genlist_index_item_y_get(idx, it);
+   h = _elm_genlist_index_node_h(idx, n);
+   elm_scroller_region_get(idx->obj, &x, &vy, &vw, &vh);
+
+   switch (type)
+     {
+      case ELM_GENLIST_ITEM_SCROLLTO_TOP:
+        break;
+      case ELM_GENLIST_ITEM_SCROLLTO_MIDDLE:
+        y -= (vh - h) / 2;
+        break;
+      case ELM_GENLIST_ITEM_SCROLLTO_BOTTOM:
+        y += h - vh;
+        break;
+      case ELM_GENLIST_ITEM_SCROLLTO_IN:
+        if (y < vy) break;
+        if (y + h <= vy + vh) return;
+        y += h - vh;
+        break;
+      default:
+        return;
+     }
+   if (y < 0) y = 0;
+   elm_scroller_region_show(idx->obj, x, y, vw, vh);
+}
+
+#endif
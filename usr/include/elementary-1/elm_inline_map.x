@@ -0,0 +1,982 @@
+/* ELEMENTARY - EFL widget toolkit
+ * Copyright (C) 2016 Samsung Electronics Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library;
+ * if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ELM_INLINE_MAP_X_
+#define ELM_INLINE_MAP_X_
+
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @cond LOCAL
+ */
+
+// Same as the widget, tiles are 256x256 and a map is 2^zoom tiles wide
+#define ELM_MAP_TILES_SIZE 256
+#define ELM_MAP_TILES_LRU "_lru"
+#define ELM_MAP_TILES_HIST 24
+
+#ifndef M_PI
+# define M_PI 3.14159265358979323846
+#endif
+
+typedef struct _Elm_Map_Tiles_Entry Elm_Map_Tiles_Entry;
+typedef struct _Elm_Map_Tiles_Job Elm_Map_Tiles_Job;
+typedef struct _Elm_Map_Tiles_Waiter Elm_Map_Tiles_Waiter;
+
+/* A tile in the disk cache, the LRU list has the oldest first. */
+struct _Elm_Map_Tiles_Entry
+{
+   EINA_INLIST;
+   size_t size;
+   Eina_Bool linked : 1;
+   char key[];
+};
+
+/* A request waiting for its tile to be fetched or decoded. */
+struct _Elm_Map_Tiles_Waiter
+{
+   Elm_Map_Tiles *tiles;
+   Elm_Map_Tiles_Cb func;
+   const void *data;
+   Evas_Object *img;
+   double requested;
+   int zoom, x, y;
+};
+
+/* A tile being read from the source, by HTTP through the pool or from
+ * a local file on a worker thread. */
+struct _Elm_Map_Tiles_Job
+{
+   Elm_Map_Tiles *tiles; // NULL once the tiles are freed under a worker
+   Ecore_Con_Url_Request *req;
+   Ecore_Thread *thread;
+   Eina_List *waiters;
+   char *path;
+   void *body;
+   size_t size;
+   double started;
+   int zoom, x, y;
+   Eina_Bool prefetch : 1;
+   char key[32];
+};
+
+struct _Elm_Map_Tiles
+{
+   Evas_Object *map;
+   Evas *evas;
+   char *url;
+   Ecore_Con_Url_Pool *pool;
+   Eina_Hash *jobs; // "z/x/y" -> Elm_Map_Tiles_Job
+   Eina_List *decoding; // Elm_Map_Tiles_Waiter
+   Eina_List *failed; // Elm_Map_Tiles_Waiter, told by failed_job
+   Ecore_Job *failed_job;
+
+   Eet_File *cache;
+   Eina_Hash *entries; // "z/x/y" -> Elm_Map_Tiles_Entry
+   Eina_Inlist *lru;
+   size_t cache_bytes;
+   size_t cache_max;
+
+   double ahead;
+   unsigned int prefetch_max;
+   unsigned int prefetching;
+   int zoom;
+   double px, py; // view center, in pixels at zoom
+   double vx, vy; // pixels per second
+   double scroll_t;
+
+   Elm_Map_Tiles_Stats stats;
+   double fetch_sum;
+   double ready_sum;
+   unsigned int ready_count;
+   unsigned int ready_hist[ELM_MAP_TILES_HIST]; // 1/4 ms << i
+   int walking;
+
+   /* Every user of this header has its own copy of the callbacks, add and
+    * remove them through the ones of the pipeline. */
+   Evas_Object_Event_Cb preloaded_cb;
+   Evas_Object_Event_Cb map_del_cb;
+   Evas_Smart_Cb follow_cb;
+   Evas_Smart_Cb follow_stop_cb;
+
+   Eina_Bool local : 1;
+   Eina_Bool dirty : 1;
+   Eina_Bool delete_me : 1;
+};
+
+static inline void
+_elm_map_tiles_key(char *key, size_t size, int zoom, int x, int y)
+{
+   snprintf(key, size, "%d/%d/%d", zoom, x, y);
+}
+
+static inline Eina_Bool
+_elm_map_tiles_valid(int zoom, int x, int y)
+{
+   if ((zoom < 0) || (zoom > 30)) return EINA_FALSE;
+   return (x >= 0) && (y >= 0) && (x < (1 << zoom)) && (y < (1 << zoom));
+}
+
+static inline char *
+_elm_map_tiles_url_get(const Elm_Map_Tiles *tiles, int zoom, int x, int y)
+{
+   Eina_Strbuf *buf;
+   char n[16];
+   char *url;
+
+   buf = eina_strbuf_new();
+   if (!buf) return NULL;
+   eina_strbuf_append(buf, tiles->url);
+   snprintf(n, sizeof(n), "%d", zoom);
+   eina_strbuf_replace_all(buf, "{z}", n);
+   snprintf(n, sizeof(n), "%d", x);
+   eina_strbuf_replace_all(buf, "{x}", n);
+   snprintf(n, sizeof(n), "%d", y);
+   eina_strbuf_replace_all(buf, "{y}", n);
+   url = eina_strbuf_string_steal(buf);
+   eina_strbuf_free(buf);
+   return url;
+}
+
+static inline void
+_elm_map_tiles_ready_add(Elm_Map_Tiles *tiles, double latency)
+{
+   double ms = 0.25;
+   unsigned int i;
+
+   tiles->ready_sum += latency;
+   tiles->ready_count++;
+   if (latency > tiles->stats.ready_max) tiles->stats.ready_max = latency;
+   for (i = 0; (i < ELM_MAP_TILES_HIST - 1) && (latency * 1000.0 > ms); i++)
+     ms *= 2;
+   tiles->ready_hist[i]++;
+}
+
+/* The upper bound of the bucket holding the given fraction of the
+ * latencies, in seconds. */
+static inline double
+_elm_map_tiles_ready_percentile(const Elm_Map_Tiles *tiles, double p)
+{
+   unsigned int i, seen = 0;
+   double ms = 0.25;
+
+   if (!tiles->ready_count) return 0;
+   for (i = 0; i < ELM_MAP_TILES_HIST; i++, ms *= 2)
+     {
+        seen += tiles->ready_hist[i];
+        if (seen >= tiles->ready_count * p) break;
+     }
+   if (ms / 1000.0 > tiles->stats.ready_max) return tiles->stats.ready_max;
+   return ms / 1000.0;
+}
+
+/* Disk cache */
+
+static inline void
+_elm_map_tiles_entry_del(Elm_Map_Tiles *tiles, Elm_Map_Tiles_Entry *e)
+{
+   if (e->linked)
+     {
+        tiles->lru = eina_inlist_remove(tiles->lru, EINA_INLIST_GET(e));
+        tiles->cache_bytes -= e->size;
+        tiles->stats.cached--;
+     }
+   eet_delete(tiles->cache, e->key);
+   tiles->dirty = EINA_TRUE;
+   eina_hash_del_by_key(tiles->entries, e->key);
+}
+
+static inline void
+_elm_map_tiles_entry_link(Elm_Map_Tiles *tiles, Elm_Map_Tiles_Entry *e, Eina_Bool newest)
+{
+   if (newest)
+     tiles->lru = eina_inlist_append(tiles->lru, EINA_INLIST_GET(e));
+   else
+     tiles->lru = eina_inlist_prepend(tiles->lru, EINA_INLIST_GET(e));
+   e->linked = EINA_TRUE;
+   tiles->cache_bytes += e->size;
+   tiles->stats.cached++;
+}
+
+static inline void
+_elm_map_tiles_evict(Elm_Map_Tiles *tiles)
+{
+   while (tiles->lru && (tiles->cache_bytes > tiles->cache_max))
+     {
+        _elm_map_tiles_entry_del(tiles, EINA_INLIST_CONTAINER_GET(tiles->lru, Elm_Map_Tiles_Entry));
+        tiles->stats.evictions++;
+     }
+}
+
+static inline Elm_Map_Tiles_Entry *
+_elm_map_tiles_entry_add(Elm_Map_Tiles *tiles, const char *key, size_t size)
+{
+   Elm_Map_Tiles_Entry *e;
+   size_t len = strlen(key);
+
+   e = (Elm_Map_Tiles_Entry *)calloc(1, sizeof(Elm_Map_Tiles_Entry) + len + 1);
+   if (!e) return NULL;
+   memcpy(e->key, key, len + 1);
+   e->size = size;
+   if (!eina_hash_add(tiles->entries, e->key, e))
+     {
+        free(e);
+        return NULL;
+     }
+   return e;
+}
+
+/* Indexes the tiles of an existing cache, in the order the last session
+ * used them, tiles it did not list count as the oldest. */
+static inline void
+_elm_map_tiles_cache_load(Elm_Map_Tiles *tiles)
+{
+   Elm_Map_Tiles_Entry *e;
+   Eina_Iterator *it;
+   char **names, *lru, *line, *next;
+   int count = 0, size, n;
+   const void *d;
+   void *copy, *data;
+
+   names = eet_list(tiles->cache, "*", &count);
+   for (n = 0; n < count; n++)
+     {
+        if (!strcmp(names[n], ELM_MAP_TILES_LRU)) continue;
+        d = eet_read_direct(tiles->cache, names[n], &size);
+        if (!d)
+          {
+             copy = eet_read(tiles->cache, names[n], &size);
+             if (!copy) continue;
+             free(copy);
+          }
+        _elm_map_tiles_entry_add(tiles, names[n], size);
+     }
+   free(names);
+
+   lru = (char *)eet_read(tiles->cache, ELM_MAP_TILES_LRU, &size);
+   if (lru && (size > 0) && (lru[size - 1] == '\0'))
+     for (line = lru; line && *line; line = next)
+       {
+          next = strchr(line, '\n');
+          if (next) *next++ = '\0';
+          e = (Elm_Map_Tiles_Entry *)eina_hash_find(tiles->entries, line);
+          if (e && !e->linked) _elm_map_tiles_entry_link(tiles, e, EINA_TRUE);
+       }
+   free(lru);
+
+   it = eina_hash_iterator_data_new(tiles->entries);
+   EINA_ITERATOR_FOREACH(it, data)
+     {
+        e = (Elm_Map_Tiles_Entry *)data;
+        if (!e->linked) _elm_map_tiles_entry_link(tiles, e, EINA_FALSE);
+     }
+   eina_iterator_free(it);
+
+   _elm_map_tiles_evict(tiles);
+}
+
+static inline void
+_elm_map_tiles_cache_store(Elm_Map_Tiles *tiles, const char *key, const void *body, size_t size)
+{
+   Elm_Map_Tiles_Entry *e;
+
+   if ((!tiles->cache) || (size > tiles->cache_max) || (size > INT_MAX)) return;
+   if (eina_hash_find(tiles->entries, key)) return;
+   // Tiles are PNG or JPEG already, compressing them again gains nothing
+   if (!eet_write(tiles->cache, key, body, size, EET_COMPRESSION_NONE)) return;
+   e = _elm_map_tiles_entry_add(tiles, key, size);
+   if (!e)
+     {
+        eet_delete(tiles->cache, key);
+        return;
+     }
+   _elm_map_tiles_entry_link(tiles, e, EINA_TRUE);
+   tiles->dirty = EINA_TRUE;
+   _elm_map_tiles_evict(tiles);
+}
+
+/* Failures */
+
+/* Callbacks may free the pipeline, which then waits for them to return. */
+static void
+_elm_map_tiles_failed_run(void *data)
+{
+   Elm_Map_Tiles *tiles = (Elm_Map_Tiles *)data;
+   Elm_Map_Tiles_Waiter *w;
+
+   tiles->failed_job = NULL;
+   tiles->walking++;
+   while ((tiles->failed) && (!tiles->delete_me))
+     {
+        w = (Elm_Map_Tiles_Waiter *)eina_list_data_get(tiles->failed);
+        tiles->failed = eina_list_remove_list(tiles->failed, tiles->failed);
+        w->func((void *)w->data, tiles, w->zoom, w->x, w->y, NULL);
+        free(w);
+     }
+   if ((--tiles->walking) || (!tiles->delete_me)) return;
+   free(tiles);
+}
+
+/* Tells the waiter from the main loop, never from under the caller
+ * asking for the tile. */
+static inline void
+_elm_map_tiles_fail(Elm_Map_Tiles_Waiter *w)
+{
+   Elm_Map_Tiles *tiles = w->tiles;
+
+   _elm_map_tiles_ready_add(tiles, ecore_time_get() - w->requested);
+   tiles->failed = eina_list_append(tiles->failed, w);
+   if (!tiles->failed_job)
+     tiles->failed_job = ecore_job_add(_elm_map_tiles_failed_run, tiles);
+}
+
+/* Decoding */
+
+static void
+_elm_map_tiles_preloaded(void *data, Evas *e EINA_UNUSED, Evas_Object *obj,
+                         void *event_info EINA_UNUSED)
+{
+   Elm_Map_Tiles_Waiter *w = (Elm_Map_Tiles_Waiter *)data;
+   Elm_Map_Tiles *tiles = w->tiles;
+
+   evas_object_event_callback_del_full(obj, EVAS_CALLBACK_IMAGE_PRELOADED,
+                                       tiles->preloaded_cb, w);
+   tiles->decoding = eina_list_remove(tiles->decoding, w);
+   _elm_map_tiles_ready_add(tiles, ecore_time_get() - w->requested);
+   if (evas_object_image_load_error_get(obj) != EVAS_LOAD_ERROR_NONE)
+     {
+        tiles->stats.failures++;
+        evas_object_del(obj);
+        obj = NULL;
+     }
+   else
+     tiles->stats.decodes++;
+   w->func((void *)w->data, tiles, w->zoom, w->x, w->y, obj);
+   free(w);
+}
+
+/* Hands the encoded tile to an image object, which decodes it on the
+ * Evas worker threads. */
+static inline void
+_elm_map_tiles_decode(Elm_Map_Tiles_Waiter *w, const void *body, size_t size)
+{
+   Elm_Map_Tiles *tiles = w->tiles;
+   Evas_Object *img;
+
+   img = size <= INT_MAX ? evas_object_image_add(tiles->evas) : NULL;
+   if (img) evas_object_image_memfile_set(img, (void *)body, size, NULL, NULL);
+   if ((!img) || (evas_object_image_load_error_get(img) != EVAS_LOAD_ERROR_NONE))
+     {
+        if (img) evas_object_del(img);
+        tiles->stats.failures++;
+        _elm_map_tiles_fail(w);
+        return;
+     }
+   w->img = img;
+   tiles->decoding = eina_list_append(tiles->decoding, w);
+   evas_object_event_callback_add(img, EVAS_CALLBACK_IMAGE_PRELOADED,
+                                  tiles->preloaded_cb, w);
+   evas_object_image_preload(img, EINA_FALSE);
+}
+
+static inline Eina_Bool
+_elm_map_tiles_cache_decode(Elm_Map_Tiles *tiles, Elm_Map_Tiles_Waiter *w, const char *key)
+{
+   Elm_Map_Tiles_Entry *e;
+   const void *d;
+   void *copy = NULL;
+   int size;
+
+   if (!tiles->cache) return EINA_FALSE;
+   e = (Elm_Map_Tiles_Entry *)eina_hash_find(tiles->entries, key);
+   if (!e) return EINA_FALSE;
+
+   d = eet_read_direct(tiles->cache, key, &size);
+   if (!d) d = copy = eet_read(tiles->cache, key, &size);
+   if (!d)
+     {
+        _elm_map_tiles_entry_del(tiles, e);
+        return EINA_FALSE;
+     }
+   tiles->lru = eina_inlist_demote(tiles->lru, EINA_INLIST_GET(e));
+   tiles->dirty = EINA_TRUE;
+   _elm_map_tiles_decode(w, d, size);
+   free(copy);
+   return EINA_TRUE;
+}
+
+/* Fetching */
+
+static inline void
+_elm_map_tiles_job_free(Elm_Map_Tiles_Job *job)
+{
+   while (job->waiters)
+     {
+        free(eina_list_data_get(job->waiters));
+        job->waiters = eina_list_remove_list(job->waiters, job->waiters);
+     }
+   free(job->path);
+   free(job->body);
+   free(job);
+}
+
+static inline void
+_elm_map_tiles_job_done(Elm_Map_Tiles_Job *job, const void *body, size_t size)
+{
+   Elm_Map_Tiles *tiles = job->tiles;
+   Elm_Map_Tiles_Waiter *w;
+   double latency;
+
+   eina_hash_del_by_key(tiles->jobs, job->key);
+   if (job->prefetch) tiles->prefetching--;
+
+   if (body && size)
+     {
+        latency = ecore_time_get() - job->started;
+        tiles->stats.fetches++;
+        tiles->fetch_sum += latency;
+        if (latency > tiles->stats.fetch_max) tiles->stats.fetch_max = latency;
+        _elm_map_tiles_cache_store(tiles, job->key, body, size);
+        while (job->waiters)
+          {
+             w = (Elm_Map_Tiles_Waiter *)eina_list_data_get(job->waiters);
+             job->waiters = eina_list_remove_list(job->waiters, job->waiters);
+             _elm_map_tiles_decode(w, body, size);
+          }
+     }
+   else
+     {
+        tiles->stats.failures++;
+        while (job->waiters)
+          {
+             w = (Elm_Map_Tiles_Waiter *)eina_list_data_get(job->waiters);
+             job->waiters = eina_list_remove_list(job->waiters, job->waiters);
+             _elm_map_tiles_fail(w);
+          }
+     }
+   _elm_map_tiles_job_free(job);
+}
+
+static void
+_elm_map_tiles_http_cb(void *data, Ecore_Con_Url_Request *req EINA_UNUSED,
+                       int status, const void *body, size_t size)
+{
+   Elm_Map_Tiles_Job *job = (Elm_Map_Tiles_Job *)data;
+
+   job->req = NULL;
+   if (status == 200) _elm_map_tiles_job_done(job, body, size);
+   else _elm_map_tiles_job_done(job, NULL, 0);
+}
+
+static void
+_elm_map_tiles_file_read(void *data, Ecore_Thread *thread EINA_UNUSED)
+{
+   Elm_Map_Tiles_Job *job = (Elm_Map_Tiles_Job *)data;
+   FILE *f;
+   long size;
+
+   f = fopen(job->path, "rb");
+   if (!f) return;
+   if ((!fseek(f, 0, SEEK_END)) && ((size = ftell(f)) > 0) && (!fseek(f, 0, SEEK_SET)))
+     {
+        job->body = malloc(size);
+        if (job->body && (fread(job->body, 1, size, f) == (size_t)size))
+          job->size = size;
+     }
+   fclose(f);
+}
+
+static void
+_elm_map_tiles_file_end(void *data, Ecore_Thread *thread EINA_UNUSED)
+{
+   Elm_Map_Tiles_Job *job = (Elm_Map_Tiles_Job *)data;
+
+   job->thread = NULL;
+   if (!job->tiles)
+     {
+        _elm_map_tiles_job_free(job);
+        return;
+     }
+   _elm_map_tiles_job_done(job, job->body, job->size);
+}
+
+static inline Elm_Map_Tiles_Job *
+_elm_map_tiles_job_new(Elm_Map_Tiles *tiles, const char *key, int zoom, int x, int y)
+{
+   Elm_Map_Tiles_Job *job;
+
+   job = (Elm_Map_Tiles_Job *)calloc(1, sizeof(Elm_Map_Tiles_Job));
+   if (!job) return NULL;
+   job->tiles = tiles;
+   job->zoom = zoom;
+   job->x = x;
+   job->y = y;
+   eina_strlcpy(job->key, key, sizeof(job->key));
+   if (!eina_hash_add(tiles->jobs, job->key, job))
+     {
+        free(job);
+        return NULL;
+     }
+   return job;
+}
+
+/* Once started, the job may end before this returns if the thread could
+ * not be created, so it must not be touched afterwards. */
+static inline Eina_Bool
+_elm_map_tiles_job_start(Elm_Map_Tiles_Job *job, Ecore_Con_Url_Priority priority)
+{
+   Elm_Map_Tiles *tiles = job->tiles;
+   Ecore_Thread *thread;
+   char key[sizeof(job->key)];
+   char *url;
+
+   url = _elm_map_tiles_url_get(tiles, job->zoom, job->x, job->y);
+   if (!url) goto on_error;
+   job->started = ecore_time_get();
+   if (!tiles->local)
+     {
+        job->req = ecore_con_url_pool_get(tiles->pool, url, priority,
+                                          _elm_map_tiles_http_cb, job);
+        free(url);
+        if (!job->req) goto on_error;
+        return EINA_TRUE;
+     }
+
+   if (!strncmp(url, "file://", 7)) memmove(url, url + 7, strlen(url + 7) + 1);
+   job->path = url;
+   memcpy(key, job->key, sizeof(key));
+   thread = ecore_thread_run(_elm_map_tiles_file_read, _elm_map_tiles_file_end,
+                             _elm_map_tiles_file_end, job);
+   if (thread && (eina_hash_find(tiles->jobs, key) == job))
+     job->thread = thread;
+   return EINA_TRUE;
+
+ on_error:
+   eina_hash_del_by_key(tiles->jobs, job->key);
+   _elm_map_tiles_job_free(job);
+   return EINA_FALSE;
+}
+
+/* Following the map */
+
+static inline void
+_elm_map_tiles_geo_to_px(double lon, double lat, int zoom, double *px, double *py)
+{
+   double size = (double)ELM_MAP_TILES_SIZE * (double)(1 << zoom);
+   double r;
+
+   if (lat > 85.0511) lat = 85.0511;
+   else if (lat < -85.0511) lat = -85.0511;
+   r = lat * M_PI / 180.0;
+   *px = (lon + 180.0) / 360.0 * size;
+   *py = (1.0 - log(tan(r) + 1.0 / cos(r)) / M_PI) / 2.0 * size;
+}
+
+/* Prefetches the tiles of a view centered on (cx, cy) at zoom, nearest
+ * to the center first by rings. */
+static inline void
+_elm_map_tiles_prefetch_view(Elm_Map_Tiles *tiles, int zoom, double cx, double cy,
+                             Evas_Coord w, Evas_Coord h)
+{
+   int n, tx, ty, x0, y0, x1, y1, r, rmax, x, y;
+
+   if ((zoom < 0) || (zoom > 30)) return;
+   n = 1 << zoom;
+   x0 = floor((cx - w / 2.0) / ELM_MAP_TILES_SIZE);
+   x1 = floor((cx + w / 2.0 - 1) / ELM_MAP_TILES_SIZE);
+   y0 = floor((cy - h / 2.0) / ELM_MAP_TILES_SIZE);
+   y1 = floor((cy + h / 2.0 - 1) / ELM_MAP_TILES_SIZE);
+   if (x0 < 0) x0 = 0;
+   if (y0 < 0) y0 = 0;
+   if (x1 >= n) x1 = n - 1;
+   if (y1 >= n) y1 = n - 1;
+   if ((x0 > x1) || (y0 > y1)) return;
+
+   tx = floor(cx / ELM_MAP_TILES_SIZE);
+   ty = floor(cy / ELM_MAP_TILES_SIZE);
+   rmax = 0;
+   if (tx - x0 > rmax) rmax = tx - x0;
+   if (x1 - tx > rmax) rmax = x1 - tx;
+   if (ty - y0 > rmax) rmax = ty - y0;
+   if (y1 - ty > rmax) rmax = y1 - ty;
+   for (r = 0; r <= rmax; r++)
+     for (y = ty - r; y <= ty + r; y++)
+       for (x = tx - r; x <= tx + r; x++)
+         {
+            if ((x < x0) || (x > x1) || (y < y0) || (y > y1)) continue;
+            if ((abs(x - tx) != r) && (abs(y - ty) != r)) continue;
+            if (tiles->prefetching >= tiles->prefetch_max) return;
+            elm_map_tiles_prefetch(tiles, zoom, x, y);
+         }
+}
+
+static void
+_elm_map_tiles_follow(void *data, Evas_Object *obj, void *event_info EINA_UNUSED)
+{
+   Elm_Map_Tiles *tiles = (Elm_Map_Tiles *)data;
+   Evas_Coord w = 0, h = 0;
+   double lon, lat, px, py, now, dt;
+   int zoom;
+
+   if (tiles->ahead <= 0) return;
+
+   zoom = elm_map_zoom_get(obj);
+   elm_map_region_get(obj, &lon, &lat);
+   evas_object_geometry_get(obj, NULL, NULL, &w, &h);
+   if ((zoom < 0) || (zoom > 30) || (w <= 0) || (h <= 0)) return;
+   _elm_map_tiles_geo_to_px(lon, lat, zoom, &px, &py);
+
+   now = ecore_loop_time_get();
+   dt = now - tiles->scroll_t;
+   if ((zoom == tiles->zoom) && (tiles->scroll_t > 0) && (dt > 0))
+     {
+        // Smoothed, a single frame says little with uneven frame times
+        tiles->vx = (tiles->vx + (px - tiles->px) / dt) / 2;
+        tiles->vy = (tiles->vy + (py - tiles->py) / dt) / 2;
+     }
+   else
+     tiles->vx = tiles->vy = 0;
+   tiles->zoom = zoom;
+   tiles->px = px;
+   tiles->py = py;
+   tiles->scroll_t = now;
+
+   _elm_map_tiles_prefetch_view(tiles, zoom, px + tiles->vx * tiles->ahead,
+                                py + tiles->vy * tiles->ahead, w, h);
+   if (zoom < elm_map_zoom_max_get(obj))
+     _elm_map_tiles_prefetch_view(tiles, zoom + 1, px * 2, py * 2, w, h);
+   if (zoom > elm_map_zoom_min_get(obj))
+     _elm_map_tiles_prefetch_view(tiles, zoom - 1, px / 2, py / 2, w, h);
+}
+
+static void
+_elm_map_tiles_follow_stop(void *data, Evas_Object *obj EINA_UNUSED,
+                           void *event_info EINA_UNUSED)
+{
+   Elm_Map_Tiles *tiles = (Elm_Map_Tiles *)data;
+
+   tiles->vx = tiles->vy = 0;
+   tiles->scroll_t = 0;
+}
+
+static inline void
+_elm_map_tiles_unfollow(Elm_Map_Tiles *tiles);
+
+static void
+_elm_map_tiles_map_del(void *data, Evas *e EINA_UNUSED, Evas_Object *obj EINA_UNUSED,
+                       void *event_info EINA_UNUSED)
+{
+   _elm_map_tiles_unfollow((Elm_Map_Tiles *)data);
+}
+
+static inline void
+_elm_map_tiles_unfollow(Elm_Map_Tiles *tiles)
+{
+   if (!tiles->map) return;
+   evas_object_smart_callback_del_full(tiles->map, "scroll",
+                                       tiles->follow_cb, tiles);
+   evas_object_smart_callback_del_full(tiles->map, "zoom,change",
+                                       tiles->follow_cb, tiles);
+   evas_object_smart_callback_del_full(tiles->map, "scroll,anim,stop",
+                                       tiles->follow_stop_cb, tiles);
+   evas_object_smart_callback_del_full(tiles->map, "scroll,drag,stop",
+                                       tiles->follow_stop_cb, tiles);
+   evas_object_event_callback_del_full(tiles->map, EVAS_CALLBACK_DEL,
+                                       tiles->map_del_cb, tiles);
+   tiles->map = NULL;
+}
+
+/**
+ * @endcond
+ */
+
+static inline Elm_Map_Tiles *
+elm_map_tiles_add(Evas_Object *map, const char *url, const char *cache, size_t cache_max)
+{
+   Elm_Map_Tiles *tiles;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(map, NULL);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(url, NULL);
+
+   tiles = (Elm_Map_Tiles *)calloc(1, sizeof(Elm_Map_Tiles));
+   if (!tiles) return NULL;
+   tiles->map = map;
+   tiles->preloaded_cb = _elm_map_tiles_preloaded;
+   tiles->map_del_cb = _elm_map_tiles_map_del;
+   tiles->follow_cb = _elm_map_tiles_follow;
+   tiles->follow_stop_cb = _elm_map_tiles_follow_stop;
+   tiles->evas = evas_object_evas_get(map);
+   tiles->url = strdup(url);
+   tiles->local = (url[0] == '/') || (!strncmp(url, "file://", 7));
+   tiles->jobs = eina_hash_string_superfast_new(NULL);
+   tiles->entries = eina_hash_string_superfast_new(free);
+   tiles->ahead = 0.5;
+   tiles->prefetch_max = 16;
+   tiles->zoom = -1;
+   if ((!tiles->url) || (!tiles->jobs) || (!tiles->entries)) goto on_error;
+   if (!tiles->local)
+     {
+        // Tile servers ask clients to keep to a few connections
+        tiles->pool = ecore_con_url_pool_new(8, 2);
+        if (!tiles->pool) goto on_error;
+     }
+
+   if (cache && cache_max)
+     {
+        tiles->cache = eet_open(cache, EET_FILE_MODE_READ_WRITE);
+        if (!tiles->cache) goto on_error;
+        tiles->cache_max = cache_max;
+        _elm_map_tiles_cache_load(tiles);
+     }
+
+   evas_object_smart_callback_add(map, "scroll", tiles->follow_cb, tiles);
+   evas_object_smart_callback_add(map, "zoom,change", tiles->follow_cb, tiles);
+   evas_object_smart_callback_add(map, "scroll,anim,stop", tiles->follow_stop_cb, tiles);
+   evas_object_smart_callback_add(map, "scroll,drag,stop", tiles->follow_stop_cb, tiles);
+   evas_object_event_callback_add(map, EVAS_CALLBACK_DEL, tiles->map_del_cb, tiles);
+   return tiles;
+
+ on_error:
+   if (tiles->pool) ecore_con_url_pool_free(tiles->pool);
+   if (tiles->entries) eina_hash_free(tiles->entries);
+   if (tiles->jobs) eina_hash_free(tiles->jobs);
+   free(tiles->url);
+   free(tiles);
+   return NULL;
+}
+
+static inline void
+elm_map_tiles_free(Elm_Map_Tiles *tiles)
+{
+   Elm_Map_Tiles_Waiter *w;
+   Elm_Map_Tiles_Job *job;
+   Eina_Iterator *it;
+   Eina_List *jobs = NULL;
+   void *data;
+
+   if (!tiles) return;
+
+   _elm_map_tiles_unfollow(tiles);
+
+   it = eina_hash_iterator_data_new(tiles->jobs);
+   EINA_ITERATOR_FOREACH(it, data)
+     jobs = eina_list_append(jobs, data);
+   eina_iterator_free(it);
+   // Dropped without their callbacks, as the jobs waiting on them
+   if (tiles->pool) ecore_con_url_pool_free(tiles->pool);
+   while (jobs)
+     {
+        job = (Elm_Map_Tiles_Job *)eina_list_data_get(jobs);
+        jobs = eina_list_remove_list(jobs, jobs);
+        // Workers cannot be stopped, their end callback frees the job
+        if (job->thread)
+          {
+             job->tiles = NULL;
+             ecore_thread_cancel(job->thread);
+          }
+        else
+          _elm_map_tiles_job_free(job);
+     }
+   eina_hash_free(tiles->jobs);
+
+   while (tiles->decoding)
+     {
+        w = (Elm_Map_Tiles_Waiter *)eina_list_data_get(tiles->decoding);
+        tiles->decoding = eina_list_remove_list(tiles->decoding, tiles->decoding);
+        evas_object_event_callback_del_full(w->img, EVAS_CALLBACK_IMAGE_PRELOADED,
+                                            tiles->preloaded_cb, w);
+        evas_object_del(w->img);
+        free(w);
+     }
+   while (tiles->failed)
+     {
+        free(eina_list_data_get(tiles->failed));
+        tiles->failed = eina_list_remove_list(tiles->failed, tiles->failed);
+     }
+   if (tiles->failed_job) ecore_job_del(tiles->failed_job);
+
+   if (tiles->cache)
+     {
+        elm_map_tiles_sync(tiles);
+        eet_close(tiles->cache);
+     }
+   eina_hash_free(tiles->entries);
+   free(tiles->url);
+   // A failure callback is freeing it, the walk ends with the free
+   if (tiles->walking)
+     {
+        tiles->delete_me = EINA_TRUE;
+        return;
+     }
+   free(tiles);
+}
+
+static inline Eina_Bool
+elm_map_tiles_request(Elm_Map_Tiles *tiles, int zoom, int x, int y,
+                      Elm_Map_Tiles_Cb func, const void *data)
+{
+   Elm_Map_Tiles_Waiter *w;
+   Elm_Map_Tiles_Job *job;
+   char key[32];
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(tiles, EINA_FALSE);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(func, EINA_FALSE);
+   if (!_elm_map_tiles_valid(zoom, x, y)) return EINA_FALSE;
+
+   w = (Elm_Map_Tiles_Waiter *)calloc(1, sizeof(Elm_Map_Tiles_Waiter));
+   if (!w) return EINA_FALSE;
+   w->tiles = tiles;
+   w->func = func;
+   w->data = data;
+   w->requested = ecore_time_get();
+   w->zoom = zoom;
+   w->x = x;
+   w->y = y;
+   tiles->stats.requests++;
+
+   _elm_map_tiles_key(key, sizeof(key), zoom, x, y);
+   if (_elm_map_tiles_cache_decode(tiles, w, key))
+     {
+        tiles->stats.hits++;
+        return EINA_TRUE;
+     }
+
+   job = (Elm_Map_Tiles_Job *)eina_hash_find(tiles->jobs, key);
+   if (job)
+     {
+        // Asked for now, no longer a prefetch
+        if (job->prefetch)
+          {
+             job->prefetch = EINA_FALSE;
+             tiles->prefetching--;
+             if (job->req)
+               ecore_con_url_pool_priority_set(job->req, ECORE_CON_URL_PRIORITY_HIGH);
+          }
+        job->waiters = eina_list_append(job->waiters, w);
+        return EINA_TRUE;
+     }
+
+   job = _elm_map_tiles_job_new(tiles, key, zoom, x, y);
+   if (!job)
+     {
+        free(w);
+        return EINA_FALSE;
+     }
+   job->waiters = eina_list_append(job->waiters, w);
+   return _elm_map_tiles_job_start(job, ECORE_CON_URL_PRIORITY_HIGH);
+}
+
+static inline Eina_Bool
+elm_map_tiles_prefetch(Elm_Map_Tiles *tiles, int zoom, int x, int y)
+{
+   Elm_Map_Tiles_Job *job;
+   char key[32];
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(tiles, EINA_FALSE);
+   if (!_elm_map_tiles_valid(zoom, x, y)) return EINA_FALSE;
+   // Without a disk cache a prefetched tile would have nowhere to go
+   if (!tiles->cache) return EINA_FALSE;
+
+   _elm_map_tiles_key(key, sizeof(key), zoom, x, y);
+   if (eina_hash_find(tiles->entries, key) || eina_hash_find(tiles->jobs, key))
+     return EINA_TRUE;
+   if (tiles->prefetching >= tiles->prefetch_max) return EINA_FALSE;
+
+   job = _elm_map_tiles_job_new(tiles, key, zoom, x, y);
+   if (!job) return EINA_FALSE;
+   job->prefetch = EINA_TRUE;
+   tiles->prefetching++;
+   tiles->stats.prefetches++;
+   return _elm_map_tiles_job_start(job, ECORE_CON_URL_PRIORITY_LOW);
+}
+
+static inline void
+elm_map_tiles_prefetch_set(Elm_Map_Tiles *tiles, double ahead, unsigned int max)
+{
+   EINA_SAFETY_ON_NULL_RETURN(tiles);
+
+   tiles->ahead = ahead > 0 ? ahead : 0;
+   tiles->prefetch_max = max;
+}
+
+static inline Eina_Bool
+elm_map_tiles_sync(Elm_Map_Tiles *tiles)
+{
+   Elm_Map_Tiles_Entry *e;
+   Eina_Strbuf *buf;
+   Eina_Bool ret;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(tiles, EINA_FALSE);
+
+   if (!tiles->cache) return EINA_FALSE;
+   if (!tiles->dirty) return EINA_TRUE;
+
+   buf = eina_strbuf_new();
+   if (!buf) return EINA_FALSE;
+   EINA_INLIST_FOREACH(tiles->lru, e)
+     {
+        eina_strbuf_append(buf, e->key);
+        eina_strbuf_append_char(buf, '\n');
+     }
+   ret = eet_write(tiles->cache, ELM_MAP_TILES_LRU, eina_strbuf_string_get(buf),
+                   eina_strbuf_length_get(buf) + 1, EET_COMPRESSION_DEFAULT) > 0;
+   eina_strbuf_free(buf);
+   ret &= eet_sync(tiles->cache) == EET_ERROR_NONE;
+   if (ret) tiles->dirty = EINA_FALSE;
+   return ret;
+}
+
+static inline void
+elm_map_tiles_stats_get(const Elm_Map_Tiles *tiles, Elm_Map_Tiles_Stats *stats)
+{
+   EINA_SAFETY_ON_NULL_RETURN(tiles);
+   EINA_SAFETY_ON_NULL_RETURN(stats);
+
+   *stats = tiles->stats;
+   stats->cached_bytes = tiles->cache_bytes;
+   stats->pending = eina_hash_population(tiles->jobs) + eina_list_count(tiles->decoding);
+   if (stats->fetches) stats->fetch_avg = tiles->fetch_sum / stats->fetches;
+   if (tiles->ready_count)
+     {
+        stats->ready_avg = tiles->ready_sum / tiles->ready_count;
+        stats->ready_p50 = _elm_map_tiles_ready_percentile(tiles, 0.5);
+        stats->ready_p95 = _elm_map_tiles_ready_percentile(tiles, 0.95);
+     }
+}
+
+static inline void
+elm_map_tiles_stats_reset(Elm_Map_Tiles *tiles)
+{
+   unsigned int cached;
+
+   EINA_SAFETY_ON_NULL_RETURN(tiles);
+
+   cached = tiles->stats.cached;
+   memset(&tiles->stats, 0, sizeof(tiles->stats));
+   memset(tiles->ready_hist, 0, sizeof(tiles->ready_hist));
+   tiles->stats.cached = cached;
+   tiles->fetch_sum = 0;
+   tiles->ready_sum = 0;
+   tiles->ready_count = 0;
+}
+
+#endif
@@ -15,3 +15,176 @@
 EAPI Evas_Object          *elm_map_add(Evas_Object *parent);
 
 #include "elm_map.eo.legacy.h"
+
+/**
+ * @addtogroup Map
+ * @{
+ */
+
+/**
+ * @typedef Elm_Map_Tiles
+ * A tile pipeline following a map, see elm_map_tiles_add().
+ */
+typedef struct _Elm_Map_Tiles Elm_Map_Tiles;
+
+/**
+ * Function receiving a tile asked for with elm_map_tiles_request().
+ *
+ * @param data The data given to elm_map_tiles_request()
+ * @param tiles The tile pipeline
+ * @param zoom The zoom level of the tile
+ * @param x The column of the tile
+ * @param y The row of the tile
+ * @param img The decoded tile, now owned by the callee, or @c NULL if it
+ * could not be fetched or decoded
+ */
+typedef void (*Elm_Map_Tiles_Cb)(void *data, Elm_Map_Tiles *tiles, int zoom, int x, int y, Evas_Object *img);
+
+/**
+ * Counters and latencies of an #Elm_Map_Tiles.
+ */
+typedef struct _Elm_Map_Tiles_Stats
+{
+   unsigned int requests; /**< Tiles asked for with elm_map_tiles_request() */
+   unsigned int hits; /**< Requests answered from the disk cache */
+   unsigned int prefetches; /**< Tiles fetched ahead of being asked for */
+   unsigned int fetches; /**< Tiles read from the source */
+   unsigned int failures; /**< Tiles the source or the decoder failed on */
+   unsigned int decodes; /**< Tiles decoded */
+   unsigned int evictions; /**< Tiles pushed out of the disk cache */
+   unsigned int cached; /**< Tiles in the disk cache */
+   unsigned int pending; /**< Tiles being fetched or decoded */
+   size_t cached_bytes; /**< Size of the tiles in the disk cache */
+   double fetch_avg; /**< Average seconds to read a tile from the source */
+   double fetch_max; /**< Most seconds to read a tile from the source */
+   double ready_avg; /**< Average seconds from a request to its tile */
+   double ready_p50; /**< Median seconds from a request to its tile */
+   double ready_p95; /**< 95th percentile of the seconds from a request to its tile */
+   double ready_max; /**< Most seconds from a request to its tile */
+} Elm_Map_Tiles_Stats;
+
+/**
+ * Create a tile pipeline following a map.
+ *
+ * @param map The map object
+ * @param url The tile URL, where @c {z}, @c {x} and @c {y} stand for the
+ * zoom level, column and row, like
+ * "http://localhost:8080/{z}/{x}/{y}.png". A path or a @c file:// URL
+ * reads tiles from local files.
+ * @param cache The Eet file keeping fetched tiles, or @c NULL
+ * @param cache_max The most bytes of tiles kept in @p cache
+ * @return The pipeline, or @c NULL on errors
+ *
+ * The map widget fetches the tiles of its view when it shows them and
+ * decodes them one by one, so panning and zooming show blank tiles for
+ * as long as the round trips take.
+ *
+ * A pipeline serves 256x256 tiles of the same numbering as the map
+ * sources. HTTP requests go through an #Ecore_Con_Url_Pool that keeps
+ * connections open, local files are read on a worker thread. Fetched
+ * tiles are kept in @p cache, the least recently used dropped past
+ * @p cache_max, and the cache is reused from one run to the next.
+ * Tiles are decoded on the Evas worker threads.
+ *
+ * While the map scrolls or zooms, the pipeline measures the speed of
+ * the pan and prefetches into the cache the tiles of the view it is
+ * heading to, then those of the next zoom levels in and out, see
+ * elm_map_tiles_prefetch_set(). elm_map_tiles_stats_get() reports hits,
+ * failures and the time tiles take to come.
+ *
+ * @see elm_map_tiles_request()
+ */
+static inline Elm_Map_Tiles *elm_map_tiles_add(Evas_Object *map, const char *url, const char *cache, size_t cache_max);
+
+/**
+ * Free a tile pipeline.
+ *
+ * @param tiles The pipeline
+ *
+ * Requests still waiting are dropped without calling their callbacks.
+ * The cache is written out with elm_map_tiles_sync() first, which
+ * rewrites the whole file on the calling thread when tiles were added
+ * or used since the last sync. To keep that off the main loop at a
+ * time it shows, sync when the map is idle, the free then has nothing
+ * left to write.
+ */
+static inline void elm_map_tiles_free(Elm_Map_Tiles *tiles);
+
+/**
+ * Ask for a tile.
+ *
+ * @param tiles The pipeline
+ * @param zoom The zoom level
+ * @param x The column
+ * @param y The row
+ * @param func The function receiving the decoded tile
+ * @param data The data passed to @p func
+ * @return @c EINA_TRUE if the tile was asked for, @c EINA_FALSE otherwise
+ *
+ * The tile comes from the cache when it has it, and is otherwise
+ * fetched before anything prefetched. @p func is called from the main
+ * loop once the tile is decoded or failed, never before this returns.
+ * It may free the pipeline.
+ */
+static inline Eina_Bool elm_map_tiles_request(Elm_Map_Tiles *tiles, int zoom, int x, int y, Elm_Map_Tiles_Cb func, const void *data);
+
+/**
+ * Fetch a tile into the cache.
+ *
+ * @param tiles The pipeline
+ * @param zoom The zoom level
+ * @param x The column
+ * @param y The row
+ * @return @c EINA_TRUE if the tile is cached or on its way, @c EINA_FALSE
+ * if there is no cache or the most prefetches are running
+ *
+ * Prefetches run after the requests, they are what the pipeline does on
+ * its own while following the map.
+ */
+static inline Eina_Bool elm_map_tiles_prefetch(Elm_Map_Tiles *tiles, int zoom, int x, int y);
+
+/**
+ * Set how far ahead of the map the pipeline prefetches.
+ *
+ * @param tiles The pipeline
+ * @param ahead How far ahead of the view to look, in seconds at the pan
+ * speed, 0 to stop following the map. The default is half a second.
+ * @param max The most prefetches running at once, 16 by default
+ */
+static inline void elm_map_tiles_prefetch_set(Elm_Map_Tiles *tiles, double ahead, unsigned int max);
+
+/**
+ * Write the cache of a pipeline to disk.
+ *
+ * @param tiles The pipeline
+ * @return @c EINA_TRUE on success, @c EINA_FALSE otherwise
+ *
+ * Eet writes the whole file, so this is best done when the map is idle
+ * rather than after each tile.
+ */
+static inline Eina_Bool elm_map_tiles_sync(Elm_Map_Tiles *tiles);
+
+/**
+ * Get the counters and latencies of a pipeline.
+ *
+ * @param tiles The pipeline
+ * @param stats Where to copy them
+ *
+ * Percentiles are rounded up to a power of two of a quarter millisecond.
+ *
+ * @see elm_map_tiles_stats_reset()
+ */
+static inline void elm_map_tiles_stats_get(const Elm_Map_Tiles *tiles, Elm_Map_Tiles_Stats *stats);
+
+/**
+ * Reset the counters and latencies of a pipeline.
+ *
+ * @param tiles The pipeline
+ */
+static inline void elm_map_tiles_stats_reset(Elm_Map_Tiles *tiles);
+
+/**
+ * @}
+ */
+
+#include "elm_inline_map.x"
@@ -85,6 +85,46 @@ EAPI Eina_Binbuf *emile_decompress(const Eina_Binbuf * in, Emile_Compressor_Type
  * could fill the out buffer.
  */
 EAPI Eina_Bool emile_expand(const Eina_Binbuf * in, Eina_Binbuf * out, Emile_Compressor_Type t);
+
+/**
+ * @brief Compress many buffers on several threads.
+ *
+ * @param in Buffers to compress.
+ * @param out Where to store the compressed buffers, @c NULL for the ones
+ * that failed.
+ * @param count Number of buffers.
+ * @param t Type of compression logic to use.
+ * @param level Level of compression to apply.
+ * @param threads How many threads to use, 0 for one per core.
+ *
+ * @return The number of buffers compressed.
+ *
+ * Each buffer is compressed with emile_compress(), the buffers are handed
+ * out to worker threads, the calling thread being one of them. The workers
+ * are the helpers of eina_thread_parallel_run(), started once and shared,
+ * and a batch of less than 64 KiB is done by the calling thread alone.
+ */
+static inline unsigned int emile_compress_batch(const Eina_Binbuf * const *in, Eina_Binbuf **out, unsigned int count, Emile_Compressor_Type t, Emile_Compressor_Level level, unsigned int threads);
+
+/**
+ * @brief Uncompress many buffers on several threads.
+ *
+ * @param in Buffers to uncompress.
+ * @param out Where to store the uncompressed buffers, @c NULL for the
+ * ones that failed.
+ * @param dest_lengths Expected length of each uncompressed buffer.
+ * @param count Number of buffers.
+ * @param t Type of compression logic to use.
+ * @param threads How many threads to use, 0 for one per core.
+ *
+ * @return The number of buffers uncompressed.
+ *
+ * @see emile_decompress()
+ */
+static inline unsigned int emile_decompress_batch(const Eina_Binbuf * const *in, Eina_Binbuf **out, const unsigned int *dest_lengths, unsigned int count, Emile_Compressor_Type t, unsigned int threads);
+
+#include "emile_inline_compress.x"
+
 /**
  * @}
  */
@@ -0,0 +1,114 @@
+/* EMILE - EFL serialization, compression and crypto library.
+ * Copyright (C) 2016 Samsung Electronics Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library;
+ * if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EMILE_INLINE_COMPRESS_X_
+#define EMILE_INLINE_COMPRESS_X_
+
+/**
+ * @cond LOCAL
+ */
+
+/* Below this many bytes in all, waking helpers costs more than it saves */
+#define EMILE_COMPRESS_BATCH_INLINE_BYTES (64 * 1024)
+
+typedef struct _Emile_Compress_Batch Emile_Compress_Batch;
+
+struct _Emile_Compress_Batch
+{
+   const Eina_Binbuf * const *in;
+   Eina_Binbuf **out;
+   const unsigned int *dest_lengths; // NULL when compressing
+   unsigned int count;
+   unsigned int next; // first buffer nobody took yet
+   unsigned int done;
+   Emile_Compressor_Type t;
+   Emile_Compressor_Level level;
+};
+
+static inline void
+_emile_compress_batch_worker(void *data, unsigned int index EINA_UNUSED)
+{
+   Emile_Compress_Batch *b = (Emile_Compress_Batch *)data;
+   unsigned int i;
+
+   while ((i = __sync_fetch_and_add(&b->next, 1)) < b->count)
+     {
+        if (!b->in[i])
+          b->out[i] = NULL;
+        else if (b->dest_lengths)
+          b->out[i] = emile_decompress(b->in[i], b->t, b->dest_lengths[i]);
+        else
+          b->out[i] = emile_compress(b->in[i], b->t, b->level);
+        if (b->out[i]) __sync_fetch_and_add(&b->done, 1);
+     }
+}
+
+static inline unsigned int
+_emile_compress_batch_run(Emile_Compress_Batch *b, unsigned int threads)
+{
+   unsigned int i;
+   size_t bytes = 0;
+
+   if (!threads) threads = eina_cpu_count();
+   if (threads > b->count) threads = b->count;
+   for (i = 0; i < b->count && bytes < EMILE_COMPRESS_BATCH_INLINE_BYTES; i++)
+     {
+        if (b->dest_lengths) bytes += b->dest_lengths[i];
+        else if (b->in[i]) bytes += eina_binbuf_length_get(b->in[i]);
+     }
+   if (bytes < EMILE_COMPRESS_BATCH_INLINE_BYTES) threads = 1;
+
+   // Each worker takes buffers until none is left, one runs inline
+   eina_thread_parallel_run(threads, _emile_compress_batch_worker, b);
+
+   return b->done;
+}
+/**
+ * @endcond
+ */
+
+static inline unsigned int
+emile_compress_batch(const Eina_Binbuf * const *in, Eina_Binbuf **out, unsigned int count,
+                     Emile_Compressor_Type t, Emile_Compressor_Level level, unsigned int threads)
+{
+   Emile_Compress_Batch b = { in, out, NULL, count, 0, 0, t, level };
+
+   if (!count) return 0;
+   EINA_SAFETY_ON_NULL_RETURN_VAL(in, 0);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(out, 0);
+
+   return _emile_compress_batch_run(&b, threads);
+}
+
+static inline unsigned int
+emile_decompress_batch(const Eina_Binbuf * const *in, Eina_Binbuf **out, const unsigned int *dest_lengths,
+                       unsigned int count, Emile_Compressor_Type t, unsigned int threads)
+{
+   Emile_Compress_Batch b = { in, out, dest_lengths, count, 0, 0, t, EMILE_COMPRESSOR_DEFAULT };
+
+   if (!count) return 0;
+   EINA_SAFETY_ON_NULL_RETURN_VAL(in, 0);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(out, 0);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(dest_lengths, 0);
+
+   return _emile_compress_batch_run(&b, threads);
+}
+
+#undef EMILE_COMPRESS_BATCH_INLINE_BYTES
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef _EVAS_ENGINE_BUFFER_H
 #define _EVAS_ENGINE_BUFFER_H
 
+#include <Evas_Pixel.h>
+
 #define EVAS_ENGINE_BUFFER_DEPTH_ARGB32 0
 #define EVAS_ENGINE_BUFFER_DEPTH_BGRA32 1
 #define EVAS_ENGINE_BUFFER_DEPTH_RGB24  2
@@ -38,6 +40,50 @@ struct _Evas_Engine_Info_Buffer
    /* non-blocking or blocking mode */
    Evas_Engine_Render_Mode render_mode;
 };
-#endif
 
+/**
+ * @typedef Evas_Engine_Buffer_Tiler
+ * Offloads the output of a buffer engine canvas to threads, see
+ * evas_engine_buffer_tiler_add().
+ */
+typedef struct _Evas_Engine_Buffer_Tiler Evas_Engine_Buffer_Tiler;
+
+/**
+ * Write the output of a buffer engine canvas on several threads.
+ * @param e A canvas using the buffer engine in blocking mode, with its
+ * engine info set.
+ * @param threads How many threads to use, 0 for one per core.
+ * @param tile_rows The height of the bands regions are split in, 0 for 32.
+ * @return The tiler, or NULL.
+ *
+ * The engine renders each update region and then converts it to
+ * depth_type and color key, and copies it to dest_buffer or the
+ * buffer given by new_update_region. This is done on the rendering
+ * thread one region after the other. The tiler has the engine render
+ * ARGB32 regions into buffers of its own. As soon as each region is
+ * done, it is split into bands that worker threads convert and copy
+ * out while the next region is rendered.
+ *
+ * The engine info keeps its layout. The functions given to
+ * new_update_region and free_update_region are still called, in the
+ * same order with the same arguments: a region is freed once it is
+ * written out and all the regions before it were freed, at the latest
+ * when evas_render() returns, and dest_buffer is complete by then. The
+ * info holds no dest_buffer while the tiler writes to it. The tiler
+ * takes over the info until
+ * evas_engine_buffer_tiler_del(), use evas_engine_info_get() and
+ * evas_engine_info_set() again only after it.
+ *
+ * At most 8 tilers exist in a process at a time.
+ */
+static inline Evas_Engine_Buffer_Tiler *evas_engine_buffer_tiler_add(Evas *e, unsigned int threads, int tile_rows);
 
+/**
+ * Stop offloading the output of a canvas and give its engine info back.
+ * @param tiler The tiler to delete.
+ */
+static inline void evas_engine_buffer_tiler_del(Evas_Engine_Buffer_Tiler *tiler);
+
+#include "evas_inline_buffer.x"
+
+#endif
@@ -3138,6 +3138,300 @@ EAPI void                          evas_object_image_native_surface_set(Evas_Obj
  */
 EAPI void                          evas_object_image_preload(Evas_Object *obj, Eina_Bool cancel) EINA_ARG_NONNULL(1);
 
+/**
+ * @typedef Evas_Image_Decode_Queue
+ * Schedules the background decode of image objects by priority, see
+ * evas_image_decode_queue_add().
+ */
+typedef struct _Evas_Image_Decode_Queue Evas_Image_Decode_Queue;
+
+/**
+ * @typedef Evas_Image_Decode_Stats
+ * Decode statistics of the images a queue handled, per loader.
+ */
+typedef struct _Evas_Image_Decode_Stats Evas_Image_Decode_Stats;
+
+/**
+ * @struct _Evas_Image_Decode_Stats
+ *
+ * Times are in seconds. Requests cancelled while decoding, also to
+ * make room for closer images, count in @c cancelled.
+ */
+struct _Evas_Image_Decode_Stats
+{
+   char loader[16]; /**< The loader, named after the file extension */
+   unsigned int decoded; /**< Images decoded */
+   unsigned int failed; /**< Images that failed to decode */
+   unsigned int cancelled; /**< Decodes cancelled */
+   unsigned long long pixels; /**< Pixels decoded */
+   double wait_total; /**< Time spent queued, from request to decode start */
+   double decode_total; /**< Time spent decoding */
+   double decode_max; /**< Longest decode */
+};
+
+/**
+ * @typedef Evas_Image_Decode_Cb
+ * Called on the main loop once an image is decoded.
+ */
+typedef void (*Evas_Image_Decode_Cb)(void *data, Evas_Object *obj, Evas_Load_Error error);
+
+/**
+ * Create a queue decoding image objects in the background.
+ * @param e The canvas of the images.
+ * @param max_running How many images to decode at the same time, 0 for
+ * one per core.
+ * @return The queue, or NULL.
+ *
+ * evas_object_image_preload() decodes in the order it is called, and
+ * setting a load region or scale down with
+ * evas_object_image_load_region_set() or
+ * evas_object_image_load_scale_down_set() then drawing the image
+ * decodes it during the render. A queue hands images to the preload
+ * threads a few at a time instead, with their load options, and picks
+ * the next one by visibility: first images shown inside the canvas
+ * viewport, then the ones within a margin of it, then the others. Among
+ * the same visibility the lowest priority goes first, then the oldest
+ * request. Visibility follows the objects as they are moved, resized,
+ * shown and hidden. A running decode whose image leaves the viewport
+ * and its margin is cancelled and queued again when a closer image
+ * waits.
+ *
+ * The decoded data goes to the evas image cache as with
+ * evas_object_image_preload().
+ */
+static inline Evas_Image_Decode_Queue *evas_image_decode_queue_add(Evas *e, unsigned int max_running);
+
+/**
+ * Delete a queue, cancelling the decodes it has.
+ * @param q The queue.
+ *
+ * The done callbacks are not called.
+ */
+static inline void evas_image_decode_queue_del(Evas_Image_Decode_Queue *q);
+
+/**
+ * Set how far around the canvas viewport images count as near.
+ * @param q The queue.
+ * @param margin The margin in canvas units, 0 by default.
+ */
+static inline void evas_image_decode_queue_margin_set(Evas_Image_Decode_Queue *q, Evas_Coord margin);
+
+/**
+ * Decode an image object in the background.
+ * @param q The queue.
+ * @param obj An image object, its file and load options set.
+ * @param priority The priority among images of the same visibility,
+ * lowest first.
+ * @param done_cb Called once decoded or failed, may be NULL.
+ * @param data Data given to @p done_cb.
+ * @return @c EINA_TRUE if queued.
+ *
+ * To decode a region or a scaled down image, set the load options on
+ * the object first. A new request for an object replaces its previous
+ * one, deleting the object cancels it.
+ */
+static inline Eina_Bool evas_image_decode_request(Evas_Image_Decode_Queue *q, Evas_Object *obj, int priority, Evas_Image_Decode_Cb done_cb, const void *data);
+
+/**
+ * Change the priority of a queued image.
+ * @param q The queue.
+ * @param obj The image object.
+ * @param priority The new priority.
+ */
+static inline void evas_image_decode_priority_set(Evas_Image_Decode_Queue *q, Evas_Object *obj, int priority);
+
+/**
+ * Cancel the decode of an image.
+ * @param q The queue.
+ * @param obj The image object.
+ * @return @c EINA_TRUE if it was queued or decoding.
+ *
+ * The done callback is not called.
+ */
+static inline Eina_Bool evas_image_decode_cancel(Evas_Image_Decode_Queue *q, Evas_Object *obj);
+
+/**
+ * Get how many images a queue has to decode.
+ * @param q The queue.
+ * @return The number of images waiting or decoding.
+ */
+static inline unsigned int evas_image_decode_queue_pending_count(const Evas_Image_Decode_Queue *q);
+
+/**
+ * Walk the decode statistics of a queue.
+ * @param q The queue.
+ * @return An iterator of Evas_Image_Decode_Stats, one per loader.
+ */
+static inline Eina_Iterator *evas_image_decode_queue_stats_iterator_new(const Evas_Image_Decode_Queue *q);
+
+/**
+ * @typedef Evas_Surface_Cache
+ * A cache of decoded images shared by image objects of any canvas, see
+ * evas_surface_cache_new().
+ */
+typedef struct _Evas_Surface_Cache Evas_Surface_Cache;
+
+/**
+ * @typedef Evas_Surface_Cache_Server
+ * Shares decoded images between the surface caches of several
+ * processes, see evas_surface_cache_server_add().
+ */
+typedef struct _Evas_Surface_Cache_Server Evas_Surface_Cache_Server;
+
+/**
+ * @typedef Evas_Surface_Cache_Stats
+ * Statistics of a surface cache, per loader.
+ */
+typedef struct _Evas_Surface_Cache_Stats Evas_Surface_Cache_Stats;
+
+/**
+ * @struct _Evas_Surface_Cache_Stats
+ */
+struct _Evas_Surface_Cache_Stats
+{
+   char loader[16]; /**< The loader, named after the file extension */
+   unsigned int hits; /**< Images found in the cache */
+   unsigned int shared_hits; /**< Images another process had decoded */
+   unsigned int misses; /**< Images decoded */
+   unsigned int evictions; /**< Images dropped from the cache */
+   unsigned long long bytes; /**< Bytes held in the cache */
+   double decode_time; /**< Seconds spent decoding */
+};
+
+/**
+ * @typedef Evas_Surface_Cache_Memory_State
+ * How short of memory the system is, see
+ * evas_surface_cache_memory_state_set().
+ */
+typedef enum _Evas_Surface_Cache_Memory_State
+{
+   EVAS_SURFACE_CACHE_MEMORY_NORMAL = 0, /**< Use the whole budget */
+   EVAS_SURFACE_CACHE_MEMORY_LOW, /**< Use half of the budget */
+   EVAS_SURFACE_CACHE_MEMORY_CRITICAL /**< Keep only the images in use */
+} Evas_Surface_Cache_Memory_State;
+
+/**
+ * Create a cache of decoded images.
+ * @param max_bytes The budget of the cache.
+ * @param server The socket of an Evas_Surface_Cache_Server to share
+ * images with, or NULL.
+ * @return The cache, or NULL.
+ *
+ * evas_image_cache_set() gives each canvas a byte budget, and the same
+ * file shown by two canvases or two processes is decoded and held
+ * twice. A surface cache holds decoded ARGB images for image objects of
+ * any number of canvases, which all show the same pixels.
+ *
+ * When it is over budget, the cache drops images no object shows, lowest
+ * priority first. Within a priority it weighs the time an image took
+ * to decode per byte against how long ago it was used: a big image
+ * that was cheap to decode goes first, and a small one that was slow to
+ * decode stays.
+ *
+ * Images are decoded into memfd memory when the kernel has it, sealed
+ * and mapped read only once decoded. When a server is given, the cache
+ * asks it for images it does not have, and hands it the ones it
+ * decodes, so each image is decoded once for all the processes. Only a
+ * server of the same user is used, and one that does not answer within
+ * 200 ms is dropped. The cache works alone if the server cannot be
+ * reached.
+ *
+ * The cache is not thread safe, use it from the main loop.
+ */
+static inline Evas_Surface_Cache *evas_surface_cache_new(size_t max_bytes, const char *server);
+
+/**
+ * Free a surface cache.
+ * @param c The cache.
+ *
+ * Objects showing images of the cache are left without pixels.
+ */
+static inline void evas_surface_cache_free(Evas_Surface_Cache *c);
+
+/**
+ * Show a file in an image object through the cache.
+ * @param c The cache.
+ * @param obj The image object, with its load options set.
+ * @param file The file.
+ * @param key The key in the file, or NULL.
+ * @param priority The priority to keep the image, the highest given for
+ * it counts.
+ * @return The load error.
+ *
+ * The load size, region, scale down, dpi and orientation of @p obj are
+ * part of what identifies the image. The object gets the decoded
+ * pixels with evas_object_image_data_set(), it must not write to them.
+ * It keeps them until evas_surface_cache_image_unset(), another call
+ * to this function or its deletion. Do not set a file on it in
+ * between.
+ */
+static inline Evas_Load_Error evas_surface_cache_image_set(Evas_Surface_Cache *c, Evas_Object *obj, const char *file, const char *key, int priority);
+
+/**
+ * Take the pixels of a cache away from an image object.
+ * @param c The cache.
+ * @param obj The image object.
+ */
+static inline void evas_surface_cache_image_unset(Evas_Surface_Cache *c, Evas_Object *obj);
+
+/**
+ * Change the budget of a surface cache.
+ * @param c The cache.
+ * @param max_bytes The new budget.
+ */
+static inline void evas_surface_cache_max_bytes_set(Evas_Surface_Cache *c, size_t max_bytes);
+
+/**
+ * Trim a surface cache to the memory the system has left.
+ * @param c The cache.
+ * @param state The memory state.
+ *
+ * Meant to be called from the low memory notification of the system,
+ * like ECORE_EVENT_MEMORY_STATE. The cache trims to half its budget
+ * when memory is low, to the images shown when it is critical, and
+ * goes back to its budget when memory is normal again. Low priority
+ * images go first.
+ */
+static inline void evas_surface_cache_memory_state_set(Evas_Surface_Cache *c, Evas_Surface_Cache_Memory_State state);
+
+/**
+ * Get how many bytes of images a surface cache holds.
+ * @param c The cache.
+ * @return The bytes held.
+ */
+static inline size_t evas_surface_cache_bytes_get(const Evas_Surface_Cache *c);
+
+/**
+ * Walk the statistics of a surface cache.
+ * @param c The cache.
+ * @return An iterator of Evas_Surface_Cache_Stats, one per loader.
+ */
+static inline Eina_Iterator *evas_surface_cache_stats_iterator_new(const Evas_Surface_Cache *c);
+
+/**
+ * Serve decoded images to the surface caches of other processes.
+ * @param path The unix socket to listen on, in a directory of the user
+ * that nobody else can enter, like $XDG_RUNTIME_DIR.
+ * @param max_bytes How many bytes of images to keep, least recently
+ * asked for go first.
+ * @return The server, or NULL.
+ *
+ * The server runs on a thread of its own. It only keeps the memfds of
+ * the images it is given, the pixels are freed once no process maps
+ * them anymore. The socket is only open to the user, processes of
+ * other users are turned away, and so are images that are not sealed
+ * against writes. An image is not served anymore once its file changes.
+ * It stands in for a system wide server in tests and for applications
+ * made of several processes.
+ */
+static inline Evas_Surface_Cache_Server *evas_surface_cache_server_add(const char *path, size_t max_bytes);
+
+/**
+ * Stop and free a surface cache server.
+ * @param srv The server.
+ */
+static inline void evas_surface_cache_server_del(Evas_Surface_Cache_Server *srv);
+
 /**
  * Clear the source object on a proxy image object.
  *
@@ -4647,3 +4941,6 @@ EAPI Evas_Out *evas_out_add(Evas *e);
 EAPI void evas_output_del(Evas_Out *evo);
 
 #include "canvas/evas_out.eo.legacy.h"
+
+#include "evas_inline_decode.x"
+#include "evas_inline_cache.x"
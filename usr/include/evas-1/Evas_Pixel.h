@@ -0,0 +1,102 @@
+#ifndef _EVAS_PIXEL_H
+#define _EVAS_PIXEL_H
+
+#include <Eina.h>
+
+/**
+ * @defgroup Evas_Pixel_Kernels Pixel Kernels
+ * @ingroup Evas_Utils
+ *
+ * Routines working on rows of premultiplied ARGB32 pixels, the same
+ * way the software engines do: blending, smooth scaling and conversion
+ * to the output formats. Several sets of them exist, plain C and ones
+ * using the vector units of the cpu, and the best one the cpu has is
+ * picked at run time. All the sets give the exact same results.
+ *
+ * The set can be forced with the EVAS_PIXEL_KERNELS environment
+ * variable, to one of "c", "sse4.1", "avx2" or "neon".
+ *
+ * The kernels are not part of Evas.h, include Evas_Pixel.h to use them.
+ *
+ * @{
+ */
+
+/**
+ * @typedef Evas_Pixel_Kernel_Set
+ * The instruction sets pixel kernels are written for.
+ */
+typedef enum _Evas_Pixel_Kernel_Set
+{
+   EVAS_PIXEL_KERNEL_SET_C = 0, /**< Plain C, the reference */
+   EVAS_PIXEL_KERNEL_SET_SSE41, /**< x86 SSE4.1 */
+   EVAS_PIXEL_KERNEL_SET_AVX2, /**< x86 AVX2 */
+   EVAS_PIXEL_KERNEL_SET_NEON /**< ARM NEON */
+} Evas_Pixel_Kernel_Set;
+
+/**
+ * @typedef Evas_Pixel_Kernels
+ * A set of pixel kernels.
+ */
+typedef struct _Evas_Pixel_Kernels Evas_Pixel_Kernels;
+
+/**
+ * @struct _Evas_Pixel_Kernels
+ *
+ * The kernels of a set. Pixels are premultiplied ARGB32 in the cpu
+ * byte order, rows may have any alignment, len is in pixels.
+ */
+struct _Evas_Pixel_Kernels
+{
+   Evas_Pixel_Kernel_Set set; /**< The instruction set */
+   const char *name; /**< Its name, as EVAS_PIXEL_KERNELS takes it */
+
+   /** Blend @p src over @p dst. */
+   void (*blend)(unsigned int *dst, const unsigned int *src, int len);
+   /** Multiply @p src by @p color, premultiplied ARGB, and blend it over @p dst. */
+   void (*blend_color)(unsigned int *dst, const unsigned int *src, unsigned int color, int len);
+   /** Multiply @p src by the alpha values of @p mask and blend it over @p dst. */
+   void (*blend_mask)(unsigned int *dst, const unsigned int *src, const unsigned char *mask, int len);
+   /**
+    * Fill @p dst with a row scaled from the source rows @p row0 and @p row1,
+    * @p sw pixels wide. Pixel i is taken at 16.16 fixed point position
+    * @p sx + i * @p step, with @p sx and @p step positive, and @p fy from
+    * 0 to 255 the weight of @p row1.
+    */
+   void (*scale_smooth)(unsigned int *dst, int len, const unsigned int *row0, const unsigned int *row1, int sw, int sx, int step, int fy);
+   /** Convert to 16 bit RGB 5:6:5. */
+   void (*to_rgb565)(unsigned short *dst, const unsigned int *src, int len);
+   /** Convert to bytes R, G, B. */
+   void (*to_rgb24)(unsigned char *dst, const unsigned int *src, int len);
+   /** Convert to bytes B, G, R. */
+   void (*to_bgr24)(unsigned char *dst, const unsigned int *src, int len);
+   /** Swap the bytes of each pixel, ARGB to BGRA. */
+   void (*to_bgra32)(unsigned int *dst, const unsigned int *src, int len);
+   /** Clear the alpha channel. */
+   void (*to_rgb32)(unsigned int *dst, const unsigned int *src, int len);
+};
+
+/**
+ * Get the best set of pixel kernels for this cpu.
+ * @return The kernels, never NULL.
+ *
+ * The choice is made on the first call and kept.
+ */
+static inline const Evas_Pixel_Kernels *evas_pixel_kernels_get(void);
+
+/**
+ * Get a given set of pixel kernels.
+ * @param set The instruction set.
+ * @return The kernels, or NULL if they were not compiled in or the cpu
+ * does not have the instructions.
+ *
+ * Useful to check a set against the plain C one, or to time them.
+ */
+static inline const Evas_Pixel_Kernels *evas_pixel_kernels_find(Evas_Pixel_Kernel_Set set);
+
+#include "evas_inline_pixel.x"
+
+/**
+ * @}
+ */
+
+#endif
@@ -0,0 +1,487 @@
+/* EVAS - EFL Scene Graph
+ * Copyright (C) 2016 Samsung Electronics Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library;
+ * if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EVAS_INLINE_BUFFER_X_
+#define EVAS_INLINE_BUFFER_X_
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @cond LOCAL
+ */
+
+/* new_update_region and free_update_region take no data pointer, so each
+ * tiler gets a slot and a pair of functions reading it. The slots have to
+ * be unique in the process while this code is compiled in every user, let
+ * the linker merge the copies. */
+#define EVAS_BUFFER_TILER_SHARED __attribute__ ((weak))
+#define EVAS_BUFFER_TILER_SLOTS 8
+
+typedef struct _Evas_Buffer_Region Evas_Buffer_Region;
+
+struct _Evas_Buffer_Region
+{
+   Evas_Buffer_Region *next; // in the frame, in the order of the engine
+   Evas_Buffer_Region *work_next; // while it has bands to hand out
+   unsigned int *pixels;
+   size_t size;
+   int x, y, w, h;
+   void *user;
+   int user_row_bytes;
+   int bands;
+   int band_next;
+   int bands_done;
+   Eina_Bool queued : 1; // its bands were handed out
+};
+
+struct _Evas_Engine_Buffer_Tiler
+{
+   Evas *evas;
+   Evas_Engine_Info_Buffer *info;
+   int slot;
+   int tile_rows;
+
+   /* What the application asked the engine for. */
+   int depth_type;
+   void *dest_buffer;
+   int dest_buffer_row_bytes;
+   Eina_Bool use_color_key;
+   int alpha_threshold;
+   unsigned char key[3];
+   void *(*new_update_region)(int x, int y, int w, int h, int *row_bytes);
+   void (*free_update_region)(int x, int y, int w, int h, void *data);
+
+   Eina_Lock lock;
+   Eina_Condition cond;
+   Evas_Buffer_Region *frame;
+   Evas_Buffer_Region *frame_last;
+   Evas_Buffer_Region *work;
+   Evas_Buffer_Region *work_last;
+   Evas_Buffer_Region *spare;
+   Eina_Bool quit;
+
+   /* This copy of the code may not be the one that adds the callback */
+   Evas_Event_Cb flush_post;
+
+   unsigned int threads;
+   Eina_Thread tids[];
+};
+
+EVAS_BUFFER_TILER_SHARED Evas_Engine_Buffer_Tiler *_evas_buffer_tilers[EVAS_BUFFER_TILER_SLOTS] = { NULL };
+
+static inline void
+_evas_buffer_tiler_convert(const Evas_Engine_Buffer_Tiler *t,
+                           const Evas_Buffer_Region *r, int row, int rows)
+{
+   const Evas_Pixel_Kernels *k = evas_pixel_kernels_get();
+   unsigned int *src = r->pixels + (size_t)row * r->w;
+   unsigned char *dst;
+   int rb, bpp, i, j;
+
+   bpp = ((t->depth_type == EVAS_ENGINE_BUFFER_DEPTH_RGB24) ||
+          (t->depth_type == EVAS_ENGINE_BUFFER_DEPTH_BGR24)) ? 3 : 4;
+   if (t->new_update_region)
+     {
+        if (!r->user) return;
+        dst = (unsigned char *)r->user + (size_t)row * r->user_row_bytes;
+        rb = r->user_row_bytes;
+     }
+   else
+     {
+        if (!t->dest_buffer) return;
+        rb = t->dest_buffer_row_bytes;
+        dst = (unsigned char *)t->dest_buffer +
+          (size_t)(r->y + row) * rb + (size_t)r->x * bpp;
+     }
+
+   for (j = 0; j < rows; j++, src += r->w, dst += rb)
+     {
+        if (t->depth_type == EVAS_ENGINE_BUFFER_DEPTH_ARGB32)
+          {
+             memcpy(dst, src, (size_t)r->w * 4);
+             continue;
+          }
+        /* The band is ours, key it in place before converting. */
+        if (t->use_color_key)
+          {
+             unsigned int key = ((unsigned int)t->key[0] << 16) |
+               (t->key[1] << 8) | t->key[2];
+
+             for (i = 0; i < r->w; i++)
+               if ((int)(src[i] >> 24) < t->alpha_threshold)
+                 src[i] = (src[i] & 0xff000000) | key;
+          }
+        switch (t->depth_type)
+          {
+           case EVAS_ENGINE_BUFFER_DEPTH_BGRA32:
+             k->to_bgra32((unsigned int *)dst, src, r->w);
+             break;
+           case EVAS_ENGINE_BUFFER_DEPTH_RGB32:
+             k->to_rgb32((unsigned int *)dst, src, r->w);
+             break;
+           case EVAS_ENGINE_BUFFER_DEPTH_RGB24:
+             k->to_rgb24(dst, src, r->w);
+             break;
+           case EVAS_ENGINE_BUFFER_DEPTH_BGR24:
+             k->to_bgr24(dst, src, r->w);
+             break;
+          }
+     }
+}
+
+/* Take a band to write out and do it, the lock held on entry and exit. */
+static inline Eina_Bool
+_evas_buffer_tiler_band_run(Evas_Engine_Buffer_Tiler *t)
+{
+   Evas_Buffer_Region *r = t->work;
+   int band, row, rows;
+
+   if (!r) return EINA_FALSE;
+   band = r->band_next++;
+   if (r->band_next == r->bands)
+     {
+        t->work = r->work_next;
+        if (!t->work) t->work_last = NULL;
+     }
+   eina_lock_release(&t->lock);
+
+   row = band * t->tile_rows;
+   rows = r->h - row < t->tile_rows ? r->h - row : t->tile_rows;
+   _evas_buffer_tiler_convert(t, r, row, rows);
+
+   eina_lock_take(&t->lock);
+   if (++r->bands_done == r->bands) eina_condition_broadcast(&t->cond);
+   return EINA_TRUE;
+}
+
+static inline void *
+_evas_buffer_tiler_worker(void *data, Eina_Thread th EINA_UNUSED)
+{
+   Evas_Engine_Buffer_Tiler *t = (Evas_Engine_Buffer_Tiler *)data;
+
+   eina_lock_take(&t->lock);
+   while (!t->quit)
+     {
+        if (!_evas_buffer_tiler_band_run(t))
+          eina_condition_wait(&t->cond);
+     }
+   eina_lock_release(&t->lock);
+   return NULL;
+}
+
+/* Give the application back the regions at the head of the frame whose
+ * bands are all written, so it gets them in the order they came. With
+ * all, wait for the bands of every region handed out. */
+static inline void
+_evas_buffer_tiler_release(Evas_Engine_Buffer_Tiler *t, Eina_Bool all)
+{
+   Evas_Buffer_Region *r;
+
+   while ((r = t->frame))
+     {
+        eina_lock_take(&t->lock);
+        if ((all) && (r->queued))
+          {
+             while (r->bands_done < r->bands)
+               {
+                  if (!_evas_buffer_tiler_band_run(t))
+                    eina_condition_wait(&t->cond);
+               }
+          }
+        if ((!all) && ((!r->queued) || (r->bands_done < r->bands)))
+          {
+             eina_lock_release(&t->lock);
+             return;
+          }
+        eina_lock_release(&t->lock);
+
+        t->frame = r->next;
+        if (!t->frame) t->frame_last = NULL;
+        if ((t->free_update_region) && (r->user))
+          t->free_update_region(r->x, r->y, r->w, r->h, r->user);
+        r->next = t->spare;
+        t->spare = r;
+     }
+}
+
+static inline void *
+_evas_buffer_tiler_region_new(Evas_Engine_Buffer_Tiler *t,
+                              int x, int y, int w, int h, int *row_bytes)
+{
+   Evas_Buffer_Region *r, **p;
+   size_t size = (size_t)w * h;
+
+   /* Reuse a spare buffer that fits, regions are mostly the same size. */
+   for (p = &t->spare; *p; p = &(*p)->next)
+     if ((*p)->size >= size) break;
+   r = *p;
+   if (r) *p = r->next;
+   else
+     {
+        r = (Evas_Buffer_Region *)calloc(1, sizeof (Evas_Buffer_Region));
+        if (!r) return NULL;
+        r->pixels = (unsigned int *)malloc(size * 4);
+        if (!r->pixels)
+          {
+             free(r);
+             return NULL;
+          }
+        r->size = size;
+     }
+
+   r->next = NULL;
+   r->work_next = NULL;
+   r->x = x;
+   r->y = y;
+   r->w = w;
+   r->h = h;
+   r->user = NULL;
+   r->user_row_bytes = 0;
+   r->band_next = 0;
+   r->bands_done = 0;
+   r->queued = EINA_FALSE;
+   r->bands = (h + t->tile_rows - 1) / t->tile_rows;
+   if (t->new_update_region)
+     r->user = t->new_update_region(x, y, w, h, &r->user_row_bytes);
+
+   if (t->frame_last) t->frame_last->next = r;
+   else t->frame = r;
+   t->frame_last = r;
+
+   *row_bytes = w * 4;
+   return r->pixels;
+}
+
+static inline void
+_evas_buffer_tiler_region_done(Evas_Engine_Buffer_Tiler *t,
+                               int x EINA_UNUSED, int y EINA_UNUSED,
+                               int w EINA_UNUSED, int h EINA_UNUSED,
+                               void *data)
+{
+   Evas_Buffer_Region *r;
+
+   for (r = t->frame; r; r = r->next)
+     if (r->pixels == data) break;
+   if ((!r) || (r->queued)) return;
+
+   r->queued = EINA_TRUE;
+   if (r->bands > 0)
+     {
+        eina_lock_take(&t->lock);
+        if (t->work_last) t->work_last->work_next = r;
+        else t->work = r;
+        t->work_last = r;
+        eina_condition_broadcast(&t->cond);
+        eina_lock_release(&t->lock);
+     }
+   _evas_buffer_tiler_release(t, EINA_FALSE);
+}
+
+#define EVAS_BUFFER_TILER_SLOT(N)                                       \
+static inline void *                                                    \
+_evas_buffer_tiler_new_##N(int x, int y, int w, int h, int *row_bytes)  \
+{                                                                       \
+   return _evas_buffer_tiler_region_new(_evas_buffer_tilers[N],         \
+                                        x, y, w, h, row_bytes);         \
+}                                                                       \
+static inline void                                                      \
+_evas_buffer_tiler_free_##N(int x, int y, int w, int h, void *data)     \
+{                                                                       \
+   _evas_buffer_tiler_region_done(_evas_buffer_tilers[N],               \
+                                  x, y, w, h, data);                    \
+}
+
+EVAS_BUFFER_TILER_SLOT(0)
+EVAS_BUFFER_TILER_SLOT(1)
+EVAS_BUFFER_TILER_SLOT(2)
+EVAS_BUFFER_TILER_SLOT(3)
+EVAS_BUFFER_TILER_SLOT(4)
+EVAS_BUFFER_TILER_SLOT(5)
+EVAS_BUFFER_TILER_SLOT(6)
+EVAS_BUFFER_TILER_SLOT(7)
+
+#undef EVAS_BUFFER_TILER_SLOT
+
+static void *(* const _evas_buffer_tiler_new_fns[EVAS_BUFFER_TILER_SLOTS])(int, int, int, int, int *) = {
+  _evas_buffer_tiler_new_0, _evas_buffer_tiler_new_1,
+  _evas_buffer_tiler_new_2, _evas_buffer_tiler_new_3,
+  _evas_buffer_tiler_new_4, _evas_buffer_tiler_new_5,
+  _evas_buffer_tiler_new_6, _evas_buffer_tiler_new_7
+};
+
+static void (* const _evas_buffer_tiler_free_fns[EVAS_BUFFER_TILER_SLOTS])(int, int, int, int, void *) = {
+  _evas_buffer_tiler_free_0, _evas_buffer_tiler_free_1,
+  _evas_buffer_tiler_free_2, _evas_buffer_tiler_free_3,
+  _evas_buffer_tiler_free_4, _evas_buffer_tiler_free_5,
+  _evas_buffer_tiler_free_6, _evas_buffer_tiler_free_7
+};
+
+/* Every region of the frame was handed over, help with what is left and
+ * give the application the rest of its regions back. */
+static inline void
+_evas_buffer_tiler_flush_post(void *data, Evas *e EINA_UNUSED,
+                              void *event_info EINA_UNUSED)
+{
+   _evas_buffer_tiler_release((Evas_Engine_Buffer_Tiler *)data, EINA_TRUE);
+}
+
+static inline void
+_evas_buffer_tiler_info_restore(Evas_Engine_Buffer_Tiler *t)
+{
+   Evas_Engine_Info_Buffer *info = t->info;
+
+   info->info.depth_type = t->depth_type;
+   info->info.dest_buffer = t->dest_buffer;
+   info->info.func.new_update_region = t->new_update_region;
+   info->info.func.free_update_region = t->free_update_region;
+}
+
+/**
+ * @endcond
+ */
+
+static inline Evas_Engine_Buffer_Tiler *
+evas_engine_buffer_tiler_add(Evas *e, unsigned int threads, int tile_rows)
+{
+   Evas_Engine_Buffer_Tiler *t;
+   Evas_Engine_Info_Buffer *info;
+   unsigned int i;
+   int slot;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(e, NULL);
+   EINA_SAFETY_ON_FALSE_RETURN_VAL
+     (evas_output_method_get(e) == evas_render_method_lookup("buffer"), NULL);
+
+   info = (Evas_Engine_Info_Buffer *)evas_engine_info_get(e);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(info, NULL);
+   EINA_SAFETY_ON_FALSE_RETURN_VAL
+     (info->render_mode == EVAS_RENDER_MODE_BLOCKING, NULL);
+
+   if (!threads) threads = eina_cpu_count();
+   if (!threads) threads = 1;
+   if (tile_rows <= 0) tile_rows = 32;
+
+   t = (Evas_Engine_Buffer_Tiler *)calloc(1, sizeof (Evas_Engine_Buffer_Tiler) + threads * sizeof (Eina_Thread));
+   if (!t) return NULL;
+   for (slot = 0; slot < EVAS_BUFFER_TILER_SLOTS; slot++)
+     if (__sync_bool_compare_and_swap(&_evas_buffer_tilers[slot], NULL, t))
+       break;
+   if (slot == EVAS_BUFFER_TILER_SLOTS)
+     {
+        EINA_LOG_ERR("All %i buffer engine tilers are in use.",
+                     EVAS_BUFFER_TILER_SLOTS);
+        free(t);
+        return NULL;
+     }
+
+   t->evas = e;
+   t->info = info;
+   t->slot = slot;
+   t->tile_rows = tile_rows;
+   t->depth_type = info->info.depth_type;
+   t->dest_buffer = info->info.dest_buffer;
+   t->dest_buffer_row_bytes = info->info.dest_buffer_row_bytes;
+   t->use_color_key = info->info.use_color_key;
+   t->alpha_threshold = info->info.alpha_threshold;
+   t->key[0] = info->info.color_key_r;
+   t->key[1] = info->info.color_key_g;
+   t->key[2] = info->info.color_key_b;
+   t->new_update_region = info->info.func.new_update_region;
+   t->free_update_region = info->info.func.free_update_region;
+
+   if (!eina_lock_new(&t->lock)) goto on_slot;
+   if (!eina_condition_new(&t->cond, &t->lock)) goto on_lock;
+
+   for (i = 0; i < threads; i++)
+     if (!eina_thread_create(&t->tids[i], EINA_THREAD_URGENT, -1,
+                             _evas_buffer_tiler_worker, t))
+       break;
+   t->threads = i;
+   if (!i) goto on_cond;
+
+   // The engine writes only to our regions, dest_buffer is ours to fill
+   info->info.depth_type = EVAS_ENGINE_BUFFER_DEPTH_ARGB32;
+   info->info.dest_buffer = NULL;
+   info->info.func.new_update_region = _evas_buffer_tiler_new_fns[slot];
+   info->info.func.free_update_region = _evas_buffer_tiler_free_fns[slot];
+   if (!evas_engine_info_set(e, (Evas_Engine_Info *)info))
+     {
+        _evas_buffer_tiler_info_restore(t);
+        goto on_threads;
+     }
+   t->flush_post = _evas_buffer_tiler_flush_post;
+   evas_event_callback_add(e, EVAS_CALLBACK_RENDER_FLUSH_POST,
+                           t->flush_post, t);
+   return t;
+
+ on_threads:
+   eina_lock_take(&t->lock);
+   t->quit = EINA_TRUE;
+   eina_condition_broadcast(&t->cond);
+   eina_lock_release(&t->lock);
+   for (i = 0; i < t->threads; i++)
+     eina_thread_join(t->tids[i]);
+ on_cond:
+   eina_condition_free(&t->cond);
+ on_lock:
+   eina_lock_free(&t->lock);
+ on_slot:
+   _evas_buffer_tilers[slot] = NULL;
+   free(t);
+   return NULL;
+}
+
+static inline void
+evas_engine_buffer_tiler_del(Evas_Engine_Buffer_Tiler *tiler)
+{
+   Evas_Buffer_Region *r;
+   unsigned int i;
+
+   EINA_SAFETY_ON_NULL_RETURN(tiler);
+
+   evas_event_callback_del_full(tiler->evas, EVAS_CALLBACK_RENDER_FLUSH_POST,
+                                tiler->flush_post, tiler);
+   _evas_buffer_tiler_release(tiler, EINA_TRUE);
+
+   _evas_buffer_tiler_info_restore(tiler);
+   evas_engine_info_set(tiler->evas, (Evas_Engine_Info *)tiler->info);
+
+   eina_lock_take(&tiler->lock);
+   tiler->quit = EINA_TRUE;
+   eina_condition_broadcast(&tiler->cond);
+   eina_lock_release(&tiler->lock);
+   for (i = 0; i < tiler->threads; i++)
+     eina_thread_join(tiler->tids[i]);
+   eina_condition_free(&tiler->cond);
+   eina_lock_free(&tiler->lock);
+
+   while ((r = tiler->spare))
+     {
+        tiler->spare = r->next;
+        free(r->pixels);
+        free(r);
+     }
+   _evas_buffer_tilers[tiler->slot] = NULL;
+   free(tiler);
+}
+
+#undef EVAS_BUFFER_TILER_SLOTS
+#undef EVAS_BUFFER_TILER_SHARED
+
+#endif
@@ -0,0 +1,1017 @@
+/* EVAS - EFL Scene Graph
+ * Copyright (C) 2016 Samsung Electronics Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library;
+ * if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EVAS_INLINE_CACHE_X_
+#define EVAS_INLINE_CACHE_X_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+/**
+ * @cond LOCAL
+ */
+
+#define EVAS_SURFACE_CACHE_KEY "_evas_surface_cache"
+#define EVAS_SURFACE_CACHE_KEY_MAX 4096
+#define EVAS_SURFACE_CACHE_SIZE_MAX 32768
+#define EVAS_SURFACE_CACHE_TIMEOUT_MS 200
+
+#ifndef MFD_CLOEXEC
+# define MFD_CLOEXEC 0x0001U
+#endif
+#ifndef MFD_ALLOW_SEALING
+# define MFD_ALLOW_SEALING 0x0002U
+#endif
+/* The seals are only declared with _GNU_SOURCE. */
+#ifndef F_ADD_SEALS
+# define F_ADD_SEALS 1033
+# define F_GET_SEALS 1034
+# define F_SEAL_SEAL 0x0001
+# define F_SEAL_SHRINK 0x0002
+# define F_SEAL_GROW 0x0004
+# define F_SEAL_WRITE 0x0008
+#endif
+
+typedef struct _Evas_Surface_Cache_Entry Evas_Surface_Cache_Entry;
+typedef struct _Evas_Surface_Cache_Msg Evas_Surface_Cache_Msg;
+typedef struct _Evas_Surface_Cache_Server_Entry Evas_Surface_Cache_Server_Entry;
+
+/* What goes on the socket, followed by the key. Surfaces travel as a
+ * file descriptor next to the message. */
+enum
+{
+   EVAS_SURFACE_CACHE_GET = 1,
+   EVAS_SURFACE_CACHE_PUT,
+   EVAS_SURFACE_CACHE_HIT,
+   EVAS_SURFACE_CACHE_MISS
+};
+
+struct _Evas_Surface_Cache_Msg
+{
+   unsigned int op;
+   unsigned int w, h;
+   unsigned int alpha;
+   unsigned int cost_us;
+   unsigned int key_len;
+};
+
+struct _Evas_Surface_Cache_Entry
+{
+   Evas_Surface_Cache *cache;
+   char *key;
+   Evas_Surface_Cache_Stats *stats;
+   Eina_List *objs;
+   unsigned int *pixels;
+   size_t size;
+   int w, h;
+   Eina_Bool alpha;
+   int priority;
+   double cost;
+   double score;
+};
+
+struct _Evas_Surface_Cache
+{
+   Eina_Hash *entries;
+   Eina_Hash *stats;
+   size_t max_bytes;
+   size_t limit;
+   size_t bytes;
+   double clock;
+   int server;
+   /* Every user of this header has its own copy of the callbacks, add and
+    * remove them through the one of the cache. */
+   Evas_Object_Event_Cb del_cb;
+};
+
+struct _Evas_Surface_Cache_Server_Entry
+{
+   EINA_INLIST;
+   char *key;
+   int fd;
+   size_t size;
+   Evas_Surface_Cache_Msg msg;
+};
+
+struct _Evas_Surface_Cache_Server
+{
+   Eina_Thread thread;
+   int fd;
+   int quit[2];
+   char *path;
+   Eina_Hash *entries;
+   Eina_Inlist *lru;
+   size_t max_bytes;
+   size_t bytes;
+};
+
+static inline Eina_Bool
+_evas_surface_cache_send(int s, const Evas_Surface_Cache_Msg *m, const char *key, int fd)
+{
+   char buf[sizeof(Evas_Surface_Cache_Msg) + EVAS_SURFACE_CACHE_KEY_MAX];
+   union {
+      struct cmsghdr h;
+      char b[CMSG_SPACE(sizeof(int))];
+   } ctl;
+   struct iovec iov;
+   struct msghdr msg;
+
+   if (m->key_len > EVAS_SURFACE_CACHE_KEY_MAX) return EINA_FALSE;
+   memcpy(buf, m, sizeof(*m));
+   if (m->key_len) memcpy(buf + sizeof(*m), key, m->key_len);
+   iov.iov_base = buf;
+   iov.iov_len = sizeof(*m) + m->key_len;
+   memset(&msg, 0, sizeof(msg));
+   msg.msg_iov = &iov;
+   msg.msg_iovlen = 1;
+   if (fd >= 0)
+     {
+        struct cmsghdr *c;
+
+        memset(&ctl, 0, sizeof(ctl));
+        msg.msg_control = ctl.b;
+        msg.msg_controllen = sizeof(ctl.b);
+        c = CMSG_FIRSTHDR(&msg);
+        c->cmsg_level = SOL_SOCKET;
+        c->cmsg_type = SCM_RIGHTS;
+        c->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(c), &fd, sizeof(int));
+     }
+   return sendmsg(s, &msg, MSG_NOSIGNAL) == (ssize_t)iov.iov_len;
+}
+
+/* Only processes of the same user share images. struct ucred needs
+ * _GNU_SOURCE, which users of this header may not define, this is its
+ * layout. */
+static inline Eina_Bool
+_evas_surface_cache_peer_check(int s)
+{
+   struct {
+      pid_t pid;
+      uid_t uid;
+      gid_t gid;
+   } cred;
+   socklen_t len = sizeof(cred);
+
+   if ((getsockopt(s, SOL_SOCKET, SO_PEERCRED, &cred, &len) < 0) ||
+       (len != sizeof(cred)))
+     return EINA_FALSE;
+   return cred.uid == geteuid();
+}
+
+/* The key starts with the file and its date, an image of a file that
+ * changed since is stale. */
+static inline Eina_Bool
+_evas_surface_cache_key_fresh(const char *key)
+{
+   char file[EVAS_SURFACE_CACHE_KEY_MAX + 1];
+   const char *sep, *date;
+   long long mtime, size;
+   struct stat st;
+
+   sep = strchr(key, '\x1f');
+   if ((!sep) || ((size_t)(sep - key) >= sizeof(file))) return EINA_FALSE;
+   date = strchr(sep + 1, '\x1f');
+   if ((!date) || (sscanf(date + 1, "%lld.%lld", &mtime, &size) != 2))
+     return EINA_FALSE;
+   memcpy(file, key, sep - key);
+   file[sep - key] = '\0';
+   return (stat(file, &st) == 0) &&
+     ((long long)st.st_mtime == mtime) && ((long long)st.st_size == size);
+}
+
+/* Returns 1 for a message, 0 when the peer went away and -1 for a bad
+ * one. key gets EVAS_SURFACE_CACHE_KEY_MAX + 1 bytes. */
+static inline int
+_evas_surface_cache_recv(int s, Evas_Surface_Cache_Msg *m, char *key, int *fd)
+{
+   char buf[sizeof(Evas_Surface_Cache_Msg) + EVAS_SURFACE_CACHE_KEY_MAX];
+   union {
+      struct cmsghdr h;
+      char b[CMSG_SPACE(sizeof(int))];
+   } ctl;
+   struct iovec iov;
+   struct msghdr msg;
+   struct cmsghdr *c;
+   ssize_t n;
+
+   *fd = -1;
+   iov.iov_base = buf;
+   iov.iov_len = sizeof(buf);
+   memset(&msg, 0, sizeof(msg));
+   msg.msg_iov = &iov;
+   msg.msg_iovlen = 1;
+   msg.msg_control = ctl.b;
+   msg.msg_controllen = sizeof(ctl.b);
+   do
+     n = recvmsg(s, &msg, MSG_CMSG_CLOEXEC);
+   while ((n < 0) && (errno == EINTR));
+   if (n <= 0) return 0;
+
+   for (c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c))
+     if ((c->cmsg_level == SOL_SOCKET) && (c->cmsg_type == SCM_RIGHTS) &&
+         (c->cmsg_len >= CMSG_LEN(sizeof(int))))
+       memcpy(fd, CMSG_DATA(c), sizeof(int));
+
+   if ((msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) ||
+       ((size_t)n < sizeof(*m)))
+     goto bad;
+   memcpy(m, buf, sizeof(*m));
+   if (m->key_len != (size_t)n - sizeof(*m)) goto bad;
+   memcpy(key, buf + sizeof(*m), m->key_len);
+   key[m->key_len] = '\0';
+   return 1;
+
+ bad:
+   if (*fd >= 0) close(*fd);
+   *fd = -1;
+   return -1;
+}
+
+/* A memfd when the kernel has them, so the pixels can be handed to
+ * other processes, anonymous memory otherwise. The map is writable
+ * until _evas_surface_cache_pixels_seal(). */
+static inline unsigned int *
+_evas_surface_cache_pixels_new(size_t size, int *fd_ret)
+{
+   void *p;
+   int fd = -1;
+
+#ifdef __NR_memfd_create
+   fd = syscall(__NR_memfd_create, "evas-surface-cache", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+#endif
+   if (fd >= 0)
+     {
+        if (ftruncate(fd, size) < 0)
+          {
+             close(fd);
+             fd = -1;
+          }
+        else
+          fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW);
+     }
+   if (fd >= 0)
+     p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   else
+     p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   if (p == MAP_FAILED)
+     {
+        if (fd >= 0) close(fd);
+        return NULL;
+     }
+   *fd_ret = fd;
+   return (unsigned int *)p;
+}
+
+/* Once filled, nobody writes the pixels anymore: the memfd is sealed
+ * against writes, which needs its writable maps gone, and mapped again
+ * read only. */
+static inline unsigned int *
+_evas_surface_cache_pixels_seal(unsigned int *pixels, size_t size, int fd)
+{
+   void *p;
+
+   if (fd < 0)
+     {
+        mprotect(pixels, size, PROT_READ);
+        return pixels;
+     }
+   munmap(pixels, size);
+   /* Unsealed pixels still work here, the server refuses them. */
+   fcntl(fd, F_ADD_SEALS, F_SEAL_WRITE | F_SEAL_SEAL);
+   p = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+   return p == MAP_FAILED ? NULL : (unsigned int *)p;
+}
+
+/* Only memfds nobody can write to anymore are shared. */
+static inline Eina_Bool
+_evas_surface_cache_pixels_sealed(int fd)
+{
+   int seals = fcntl(fd, F_GET_SEALS);
+
+   return (seals >= 0) &&
+     ((seals & (F_SEAL_WRITE | F_SEAL_SHRINK)) == (F_SEAL_WRITE | F_SEAL_SHRINK));
+}
+
+/* Pixels of other processes are sealed, they are mapped read only. */
+static inline unsigned int *
+_evas_surface_cache_pixels_map(int fd, const Evas_Surface_Cache_Msg *m, size_t *size)
+{
+   struct stat st;
+   void *p;
+
+   if ((!m->w) || (!m->h) ||
+       (m->w > EVAS_SURFACE_CACHE_SIZE_MAX) || (m->h > EVAS_SURFACE_CACHE_SIZE_MAX))
+     return NULL;
+   *size = (size_t)m->w * m->h * 4;
+   if ((fstat(fd, &st) < 0) || ((size_t)st.st_size < *size) ||
+       (!_evas_surface_cache_pixels_sealed(fd)))
+     return NULL;
+   p = mmap(NULL, *size, PROT_READ, MAP_SHARED, fd, 0);
+   return p == MAP_FAILED ? NULL : (unsigned int *)p;
+}
+
+/* Greedy dual size: an entry is worth its decode time per byte on top
+ * of the clock when it was last used, the clock moving up to the worth
+ * of each entry evicted. Cheap big images go first, expensive small
+ * ones stay, and anything unused long enough ends up behind. */
+static inline void
+_evas_surface_cache_entry_touch(Evas_Surface_Cache_Entry *e)
+{
+   e->score = e->cache->clock + e->cost * 1000000000.0 / (double)e->size;
+}
+
+static inline Evas_Surface_Cache_Stats *
+_evas_surface_cache_stats_find(Evas_Surface_Cache *c, const char *file)
+{
+   Evas_Surface_Cache_Stats *st;
+   char name[sizeof(st->loader)];
+
+   _evas_image_loader_name_get(file, name, sizeof(name));
+   st = (Evas_Surface_Cache_Stats *)eina_hash_find(c->stats, name);
+   if (st) return st;
+   st = (Evas_Surface_Cache_Stats *)calloc(1, sizeof(Evas_Surface_Cache_Stats));
+   if (!st) return NULL;
+   strcpy(st->loader, name);
+   eina_hash_add(c->stats, name, st);
+   return st;
+}
+
+static inline void
+_evas_surface_cache_entry_free(void *data)
+{
+   Evas_Surface_Cache_Entry *e = (Evas_Surface_Cache_Entry *)data;
+
+   if (e->stats) e->stats->bytes -= e->size;
+   e->cache->bytes -= e->size;
+   munmap(e->pixels, e->size);
+   free(e->key);
+   free(e);
+}
+
+static inline void
+_evas_surface_cache_trim(Evas_Surface_Cache *c, size_t limit)
+{
+   while (c->bytes > limit)
+     {
+        Evas_Surface_Cache_Entry *e, *victim = NULL;
+        Eina_Iterator *it;
+        void *d;
+
+        it = eina_hash_iterator_data_new(c->entries);
+        EINA_ITERATOR_FOREACH(it, d)
+          {
+             e = (Evas_Surface_Cache_Entry *)d;
+             if (e->objs) continue;
+             if ((!victim) || (e->priority < victim->priority) ||
+                 ((e->priority == victim->priority) && (e->score < victim->score)))
+               victim = e;
+          }
+        eina_iterator_free(it);
+        if (!victim) break;
+
+        if (victim->score > c->clock) c->clock = victim->score;
+        if (victim->stats) victim->stats->evictions++;
+        eina_hash_del_by_key(c->entries, victim->key);
+     }
+}
+
+static inline void
+_evas_surface_cache_unbind(Evas_Surface_Cache_Entry *e, Evas_Object *obj)
+{
+   evas_object_event_callback_del_full(obj, EVAS_CALLBACK_DEL, e->cache->del_cb, e);
+   evas_object_data_del(obj, EVAS_SURFACE_CACHE_KEY);
+   e->objs = eina_list_remove(e->objs, obj);
+}
+
+static void
+_evas_surface_cache_del_cb(void *data, Evas *evas EINA_UNUSED, Evas_Object *obj, void *event_info EINA_UNUSED)
+{
+   Evas_Surface_Cache_Entry *e = (Evas_Surface_Cache_Entry *)data;
+
+   _evas_surface_cache_unbind(e, obj);
+   if (!e->objs) _evas_surface_cache_trim(e->cache, e->cache->limit);
+}
+
+static inline void
+_evas_surface_cache_bind(Evas_Surface_Cache_Entry *e, Evas_Object *obj)
+{
+   evas_object_image_colorspace_set(obj, EVAS_COLORSPACE_ARGB8888);
+   evas_object_image_alpha_set(obj, e->alpha);
+   evas_object_image_size_set(obj, e->w, e->h);
+   evas_object_image_data_set(obj, e->pixels);
+   evas_object_image_data_update_add(obj, 0, 0, e->w, e->h);
+   evas_object_data_set(obj, EVAS_SURFACE_CACHE_KEY, e);
+   evas_object_event_callback_add(obj, EVAS_CALLBACK_DEL, e->cache->del_cb, e);
+   e->objs = eina_list_append(e->objs, obj);
+}
+
+static inline Evas_Surface_Cache_Entry *
+_evas_surface_cache_entry_new(Evas_Surface_Cache *c, const char *key, unsigned int *pixels,
+                              int w, int h, Eina_Bool alpha, double cost)
+{
+   Evas_Surface_Cache_Entry *e;
+
+   e = (Evas_Surface_Cache_Entry *)calloc(1, sizeof(Evas_Surface_Cache_Entry));
+   if (!e) return NULL;
+   e->key = strdup(key);
+   if (!e->key)
+     {
+        free(e);
+        return NULL;
+     }
+   e->cache = c;
+   e->pixels = pixels;
+   e->size = (size_t)w * h * 4;
+   e->w = w;
+   e->h = h;
+   e->alpha = alpha;
+   e->cost = cost;
+   return e;
+}
+
+static inline Evas_Surface_Cache_Entry *
+_evas_surface_cache_remote_get(Evas_Surface_Cache *c, const char *key)
+{
+   Evas_Surface_Cache_Msg m = { EVAS_SURFACE_CACHE_GET, 0, 0, 0, 0, 0 };
+   char rkey[EVAS_SURFACE_CACHE_KEY_MAX + 1];
+   Evas_Surface_Cache_Entry *e;
+   unsigned int *pixels;
+   size_t size;
+   int fd, r;
+
+   if (c->server < 0) return NULL;
+   m.key_len = strlen(key);
+   if (!_evas_surface_cache_send(c->server, &m, key, -1)) goto lost;
+   r = _evas_surface_cache_recv(c->server, &m, rkey, &fd);
+   if (r == 0) goto lost;
+   if ((r < 0) || (m.op != EVAS_SURFACE_CACHE_HIT) || (fd < 0))
+     {
+        if (fd >= 0) close(fd);
+        return NULL;
+     }
+   pixels = _evas_surface_cache_pixels_map(fd, &m, &size);
+   close(fd);
+   if (!pixels) return NULL;
+   e = _evas_surface_cache_entry_new(c, key, pixels, m.w, m.h, !!m.alpha,
+                                     (double)m.cost_us / 1000000.0);
+   if (!e) munmap(pixels, size);
+   return e;
+
+ lost:
+   close(c->server);
+   c->server = -1;
+   return NULL;
+}
+
+static inline Evas_Load_Error
+_evas_surface_cache_decode(Evas_Surface_Cache *c, Evas_Object *obj,
+                           const char *file, const char *key, const char *ckey,
+                           Evas_Surface_Cache_Entry **ret)
+{
+   Evas_Object *tmp;
+   Evas_Load_Error err;
+   const unsigned char *src;
+   unsigned int *pixels;
+   double t;
+   int w = 0, h = 0, x, y, lw, lh, stride, fd = -1;
+
+   tmp = evas_object_image_add(evas_object_evas_get(obj));
+   if (!tmp) return EVAS_LOAD_ERROR_RESOURCE_ALLOCATION_FAILED;
+   evas_object_image_load_size_get(obj, &lw, &lh);
+   evas_object_image_load_size_set(tmp, lw, lh);
+   evas_object_image_load_region_get(obj, &x, &y, &w, &h);
+   evas_object_image_load_region_set(tmp, x, y, w, h);
+   evas_object_image_load_scale_down_set(tmp, evas_object_image_load_scale_down_get(obj));
+   evas_object_image_load_dpi_set(tmp, evas_object_image_load_dpi_get(obj));
+   evas_object_image_load_orientation_set(tmp, evas_object_image_load_orientation_get(obj));
+
+   t = _evas_image_time_get();
+   evas_object_image_file_set(tmp, file, key);
+   err = evas_object_image_load_error_get(tmp);
+   if (err != EVAS_LOAD_ERROR_NONE) goto end;
+   err = EVAS_LOAD_ERROR_GENERIC;
+   if (evas_object_image_colorspace_get(tmp) != EVAS_COLORSPACE_ARGB8888) goto end;
+   evas_object_image_size_get(tmp, &w, &h);
+   if ((w <= 0) || (h <= 0) ||
+       (w > EVAS_SURFACE_CACHE_SIZE_MAX) || (h > EVAS_SURFACE_CACHE_SIZE_MAX))
+     goto end;
+   src = (const unsigned char *)evas_object_image_data_get(tmp, EINA_FALSE);
+   if (!src) goto end;
+   t = _evas_image_time_get() - t;
+   stride = evas_object_image_stride_get(tmp);
+   if (stride < w * 4) goto end;
+
+   err = EVAS_LOAD_ERROR_RESOURCE_ALLOCATION_FAILED;
+   pixels = _evas_surface_cache_pixels_new((size_t)w * h * 4, &fd);
+   if (!pixels) goto end;
+   for (y = 0; y < h; y++)
+     memcpy(pixels + (size_t)y * w, src + (size_t)y * stride, (size_t)w * 4);
+   pixels = _evas_surface_cache_pixels_seal(pixels, (size_t)w * h * 4, fd);
+   if (!pixels) goto end;
+   *ret = _evas_surface_cache_entry_new(c, ckey, pixels, w, h,
+                                        evas_object_image_alpha_get(tmp), t);
+   if (!*ret)
+     {
+        munmap(pixels, (size_t)w * h * 4);
+        goto end;
+     }
+   err = EVAS_LOAD_ERROR_NONE;
+
+   if ((fd >= 0) && (c->server >= 0))
+     {
+        Evas_Surface_Cache_Msg m = { EVAS_SURFACE_CACHE_PUT, 0, 0, 0, 0, 0 };
+
+        m.w = w;
+        m.h = h;
+        m.alpha = (*ret)->alpha;
+        m.cost_us = t * 1000000.0;
+        m.key_len = strlen(ckey);
+        if (!_evas_surface_cache_send(c->server, &m, ckey, fd))
+          {
+             close(c->server);
+             c->server = -1;
+          }
+     }
+
+ end:
+   if (fd >= 0) close(fd);
+   evas_object_del(tmp);
+   return err;
+}
+
+/* The load options and the file date are part of the key, so another
+ * process never gets an old version or a different region. */
+static inline Eina_Bool
+_evas_surface_cache_key_get(Evas_Object *obj, const char *file, const char *key,
+                            char *buf, size_t size)
+{
+   struct stat st;
+   int lw, lh, x, y, w, h, n;
+
+   if (stat(file, &st) < 0) return EINA_FALSE;
+   evas_object_image_load_size_get(obj, &lw, &lh);
+   evas_object_image_load_region_get(obj, &x, &y, &w, &h);
+   n = snprintf(buf, size, "%s\x1f%s\x1f%lld.%lld\x1f%d %d %d %d %d %d %d %g %d",
+                file, key ? key : "", (long long)st.st_mtime, (long long)st.st_size,
+                lw, lh, x, y, w, h,
+                evas_object_image_load_scale_down_get(obj),
+                evas_object_image_load_dpi_get(obj),
+                evas_object_image_load_orientation_get(obj));
+   return (n > 0) && ((size_t)n < size);
+}
+
+static inline void
+_evas_surface_cache_server_entry_del(Evas_Surface_Cache_Server *srv, Evas_Surface_Cache_Server_Entry *se)
+{
+   srv->lru = eina_inlist_remove(srv->lru, EINA_INLIST_GET(se));
+   eina_hash_del_by_key(srv->entries, se->key);
+   srv->bytes -= se->size;
+   close(se->fd);
+   free(se->key);
+   free(se);
+}
+
+static void *
+_evas_surface_cache_server_run(void *data, Eina_Thread t EINA_UNUSED)
+{
+   Evas_Surface_Cache_Server *srv = (Evas_Surface_Cache_Server *)data;
+   struct pollfd *pfd = NULL;
+   char key[EVAS_SURFACE_CACHE_KEY_MAX + 1];
+   unsigned int n = 2, i;
+
+   pfd = (struct pollfd *)calloc(n, sizeof(struct pollfd));
+   if (!pfd) return NULL;
+   pfd[0].fd = srv->quit[0];
+   pfd[0].events = POLLIN;
+   pfd[1].fd = srv->fd;
+   pfd[1].events = POLLIN;
+
+   for (;;)
+     {
+        if (poll(pfd, n, -1) < 0)
+          {
+             if (errno == EINTR) continue;
+             break;
+          }
+        if (pfd[0].revents) break;
+
+        if (pfd[1].revents & POLLIN)
+          {
+             int s = accept(srv->fd, NULL, NULL);
+
+             if ((s >= 0) && (!_evas_surface_cache_peer_check(s)))
+               {
+                  close(s);
+                  s = -1;
+               }
+             if (s >= 0)
+               {
+                  struct pollfd *tmp;
+
+                  tmp = (struct pollfd *)realloc(pfd, (n + 1) * sizeof(struct pollfd));
+                  if (tmp)
+                    {
+                       pfd = tmp;
+                       fcntl(s, F_SETFD, FD_CLOEXEC);
+                       pfd[n].fd = s;
+                       pfd[n].events = POLLIN;
+                       pfd[n].revents = 0;
+                       n++;
+                    }
+                  else
+                    close(s);
+               }
+          }
+
+        for (i = 2; i < n; i++)
+          {
+             Evas_Surface_Cache_Server_Entry *se;
+             Evas_Surface_Cache_Msg m;
+             int fd, r;
+
+             if (!pfd[i].revents) continue;
+             r = _evas_surface_cache_recv(pfd[i].fd, &m, key, &fd);
+             if (r == 0)
+               {
+                  close(pfd[i].fd);
+                  pfd[i--] = pfd[--n];
+                  continue;
+               }
+             if (r < 0) continue;
+
+             se = (Evas_Surface_Cache_Server_Entry *)eina_hash_find(srv->entries, key);
+             if ((se) && (!_evas_surface_cache_key_fresh(key)))
+               {
+                  _evas_surface_cache_server_entry_del(srv, se);
+                  se = NULL;
+               }
+             if (m.op == EVAS_SURFACE_CACHE_GET)
+               {
+                  if (se)
+                    {
+                       srv->lru = eina_inlist_demote(srv->lru, EINA_INLIST_GET(se));
+                       m = se->msg;
+                       m.op = EVAS_SURFACE_CACHE_HIT;
+                    }
+                  else
+                    m.op = EVAS_SURFACE_CACHE_MISS;
+                  m.key_len = 0;
+                  _evas_surface_cache_send(pfd[i].fd, &m, NULL, se ? se->fd : -1);
+               }
+             else if ((m.op == EVAS_SURFACE_CACHE_PUT) && (fd >= 0) && (!se))
+               {
+                  struct stat st;
+
+                  se = (Evas_Surface_Cache_Server_Entry *)calloc(1, sizeof(Evas_Surface_Cache_Server_Entry));
+                  if ((se) && (fstat(fd, &st) == 0) && (m.w) && (m.h) &&
+                      (_evas_surface_cache_pixels_sealed(fd)) &&
+                      (_evas_surface_cache_key_fresh(key)) &&
+                      (m.w <= EVAS_SURFACE_CACHE_SIZE_MAX) &&
+                      (m.h <= EVAS_SURFACE_CACHE_SIZE_MAX) &&
+                      ((size_t)st.st_size >= (size_t)m.w * m.h * 4) &&
+                      ((se->key = strdup(key))))
+                    {
+                       se->fd = fd;
+                       se->size = st.st_size;
+                       se->msg = m;
+                       fd = -1;
+                       eina_hash_add(srv->entries, se->key, se);
+                       srv->lru = eina_inlist_append(srv->lru, EINA_INLIST_GET(se));
+                       srv->bytes += se->size;
+                    }
+                  else
+                    free(se);
+
+                  while ((srv->bytes > srv->max_bytes) && (srv->lru) &&
+                         (srv->lru->next))
+                    _evas_surface_cache_server_entry_del
+                      (srv, EINA_INLIST_CONTAINER_GET(srv->lru, Evas_Surface_Cache_Server_Entry));
+               }
+             if (fd >= 0) close(fd);
+          }
+     }
+
+   for (i = 2; i < n; i++)
+     close(pfd[i].fd);
+   free(pfd);
+   return NULL;
+}
+
+/* The socket lives in a directory of the user nobody else can enter,
+ * like $XDG_RUNTIME_DIR. */
+static inline Eina_Bool
+_evas_surface_cache_dir_check(const char *path)
+{
+   char dir[sizeof(((struct sockaddr_un *)0)->sun_path)];
+   const char *slash;
+   struct stat st;
+
+   slash = strrchr(path, '/');
+   if (!slash) strcpy(dir, ".");
+   else if (slash == path) strcpy(dir, "/");
+   else
+     {
+        memcpy(dir, path, slash - path);
+        dir[slash - path] = '\0';
+     }
+   return (stat(dir, &st) == 0) && (S_ISDIR(st.st_mode)) &&
+     (st.st_uid == geteuid()) && (!(st.st_mode & 077));
+}
+
+/**
+ * @endcond
+ */
+
+static inline Evas_Surface_Cache *
+evas_surface_cache_new(size_t max_bytes, const char *server)
+{
+   Evas_Surface_Cache *c;
+
+   c = (Evas_Surface_Cache *)calloc(1, sizeof(Evas_Surface_Cache));
+   if (!c) return NULL;
+   c->entries = eina_hash_string_superfast_new(_evas_surface_cache_entry_free);
+   c->stats = eina_hash_string_small_new(free);
+   if ((!c->entries) || (!c->stats))
+     {
+        if (c->entries) eina_hash_free(c->entries);
+        if (c->stats) eina_hash_free(c->stats);
+        free(c);
+        return NULL;
+     }
+   c->max_bytes = c->limit = max_bytes;
+   c->server = -1;
+   c->del_cb = _evas_surface_cache_del_cb;
+
+   if ((server) && (strlen(server) < sizeof(((struct sockaddr_un *)0)->sun_path)))
+     {
+        struct sockaddr_un sa;
+        struct timeval tv;
+
+        memset(&sa, 0, sizeof(sa));
+        sa.sun_family = AF_UNIX;
+        strcpy(sa.sun_path, server);
+        tv.tv_sec = EVAS_SURFACE_CACHE_TIMEOUT_MS / 1000;
+        tv.tv_usec = (EVAS_SURFACE_CACHE_TIMEOUT_MS % 1000) * 1000;
+        c->server = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+        /* A server that does not answer in time is dropped instead of
+         * blocking the main loop, a late answer would come out of turn. */
+        if ((c->server >= 0) &&
+            ((connect(c->server, (struct sockaddr *)&sa, sizeof(sa)) < 0) ||
+             (!_evas_surface_cache_peer_check(c->server)) ||
+             (setsockopt(c->server, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) < 0) ||
+             (setsockopt(c->server, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)) < 0)))
+          {
+             close(c->server);
+             c->server = -1;
+          }
+     }
+   return c;
+}
+
+static inline void
+evas_surface_cache_free(Evas_Surface_Cache *c)
+{
+   Evas_Surface_Cache_Entry *e;
+   Eina_Iterator *it;
+   void *d;
+
+   if (!c) return;
+
+   /* Objects still showing our pixels let go of them first. */
+   it = eina_hash_iterator_data_new(c->entries);
+   EINA_ITERATOR_FOREACH(it, d)
+     {
+        e = (Evas_Surface_Cache_Entry *)d;
+        while (e->objs)
+          {
+             Evas_Object *obj = (Evas_Object *)eina_list_data_get(e->objs);
+
+             _evas_surface_cache_unbind(e, obj);
+             evas_object_image_data_set(obj, NULL);
+          }
+     }
+   eina_iterator_free(it);
+
+   eina_hash_free(c->entries);
+   eina_hash_free(c->stats);
+   if (c->server >= 0) close(c->server);
+   free(c);
+}
+
+static inline Evas_Load_Error
+evas_surface_cache_image_set(Evas_Surface_Cache *c, Evas_Object *obj,
+                             const char *file, const char *key, int priority)
+{
+   char ckey[EVAS_SURFACE_CACHE_KEY_MAX];
+   Evas_Surface_Cache_Entry *e, *old;
+   Evas_Surface_Cache_Stats *st;
+   Evas_Load_Error err;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(c, EVAS_LOAD_ERROR_GENERIC);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(obj, EVAS_LOAD_ERROR_GENERIC);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(file, EVAS_LOAD_ERROR_GENERIC);
+
+   if (!_evas_surface_cache_key_get(obj, file, key, ckey, sizeof(ckey)))
+     return EVAS_LOAD_ERROR_DOES_NOT_EXIST;
+   st = _evas_surface_cache_stats_find(c, file);
+
+   e = (Evas_Surface_Cache_Entry *)eina_hash_find(c->entries, ckey);
+   if (e)
+     {
+        if (st) st->hits++;
+     }
+   else
+     {
+        e = _evas_surface_cache_remote_get(c, ckey);
+        if (e)
+          {
+             if (st) st->shared_hits++;
+          }
+        else
+          {
+             err = _evas_surface_cache_decode(c, obj, file, key, ckey, &e);
+             if (st) st->misses++;
+             if (err != EVAS_LOAD_ERROR_NONE) return err;
+             if (st) st->decode_time += e->cost;
+          }
+        e->stats = st;
+        e->priority = priority;
+        if (st) st->bytes += e->size;
+        c->bytes += e->size;
+        eina_hash_add(c->entries, e->key, e);
+     }
+   if (priority > e->priority) e->priority = priority;
+   _evas_surface_cache_entry_touch(e);
+
+   old = (Evas_Surface_Cache_Entry *)evas_object_data_get(obj, EVAS_SURFACE_CACHE_KEY);
+   if (old != e)
+     {
+        if (old) _evas_surface_cache_unbind(old, obj);
+        _evas_surface_cache_bind(e, obj);
+     }
+   _evas_surface_cache_trim(c, c->limit);
+   return EVAS_LOAD_ERROR_NONE;
+}
+
+static inline void
+evas_surface_cache_image_unset(Evas_Surface_Cache *c, Evas_Object *obj)
+{
+   Evas_Surface_Cache_Entry *e;
+
+   EINA_SAFETY_ON_NULL_RETURN(c);
+   EINA_SAFETY_ON_NULL_RETURN(obj);
+
+   e = (Evas_Surface_Cache_Entry *)evas_object_data_get(obj, EVAS_SURFACE_CACHE_KEY);
+   if ((!e) || (e->cache != c)) return;
+   _evas_surface_cache_unbind(e, obj);
+   evas_object_image_data_set(obj, NULL);
+   _evas_surface_cache_trim(c, c->limit);
+}
+
+static inline void
+evas_surface_cache_max_bytes_set(Evas_Surface_Cache *c, size_t max_bytes)
+{
+   EINA_SAFETY_ON_NULL_RETURN(c);
+
+   if (c->limit == c->max_bytes) c->limit = max_bytes;
+   else if (c->limit > max_bytes) c->limit = max_bytes;
+   c->max_bytes = max_bytes;
+   _evas_surface_cache_trim(c, c->limit);
+}
+
+static inline void
+evas_surface_cache_memory_state_set(Evas_Surface_Cache *c, Evas_Surface_Cache_Memory_State state)
+{
+   EINA_SAFETY_ON_NULL_RETURN(c);
+
+   switch (state)
+     {
+      case EVAS_SURFACE_CACHE_MEMORY_LOW:
+        c->limit = c->max_bytes / 2;
+        break;
+      case EVAS_SURFACE_CACHE_MEMORY_CRITICAL:
+        c->limit = 0;
+        break;
+      default:
+        c->limit = c->max_bytes;
+        break;
+     }
+   _evas_surface_cache_trim(c, c->limit);
+}
+
+static inline size_t
+evas_surface_cache_bytes_get(const Evas_Surface_Cache *c)
+{
+   EINA_SAFETY_ON_NULL_RETURN_VAL(c, 0);
+
+   return c->bytes;
+}
+
+static inline Eina_Iterator *
+evas_surface_cache_stats_iterator_new(const Evas_Surface_Cache *c)
+{
+   EINA_SAFETY_ON_NULL_RETURN_VAL(c, NULL);
+
+   return eina_hash_iterator_data_new(c->stats);
+}
+
+static inline Evas_Surface_Cache_Server *
+evas_surface_cache_server_add(const char *path, size_t max_bytes)
+{
+   Evas_Surface_Cache_Server *srv;
+   struct sockaddr_un sa;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(path, NULL);
+   EINA_SAFETY_ON_TRUE_RETURN_VAL(strlen(path) >= sizeof(sa.sun_path), NULL);
+
+   if (!_evas_surface_cache_dir_check(path)) return NULL;
+
+   srv = (Evas_Surface_Cache_Server *)calloc(1, sizeof(Evas_Surface_Cache_Server));
+   if (!srv) return NULL;
+   srv->fd = srv->quit[0] = srv->quit[1] = -1;
+   srv->max_bytes = max_bytes;
+   srv->path = strdup(path);
+   srv->entries = eina_hash_string_superfast_new(NULL);
+   if ((!srv->path) || (!srv->entries)) goto on_error;
+
+   memset(&sa, 0, sizeof(sa));
+   sa.sun_family = AF_UNIX;
+   strcpy(sa.sun_path, path);
+   srv->fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+   if (srv->fd < 0) goto on_error;
+   unlink(path);
+   if ((bind(srv->fd, (struct sockaddr *)&sa, sizeof(sa)) < 0) ||
+       (chmod(path, 0600) < 0) ||
+       (listen(srv->fd, 16) < 0))
+     goto on_error;
+   if (pipe(srv->quit) < 0)
+     {
+        srv->quit[0] = srv->quit[1] = -1;
+        goto on_error;
+     }
+   if (!eina_thread_create(&srv->thread, EINA_THREAD_BACKGROUND, -1,
+                           _evas_surface_cache_server_run, srv))
+     goto on_error;
+   return srv;
+
+ on_error:
+   if (srv->quit[0] >= 0) close(srv->quit[0]);
+   if (srv->quit[1] >= 0) close(srv->quit[1]);
+   if (srv->fd >= 0)
+     {
+        close(srv->fd);
+        unlink(path);
+     }
+   if (srv->entries) eina_hash_free(srv->entries);
+   free(srv->path);
+   free(srv);
+   return NULL;
+}
+
+static inline void
+evas_surface_cache_server_del(Evas_Surface_Cache_Server *srv)
+{
+   if (!srv) return;
+
+   while ((write(srv->quit[1], "", 1) < 0) && (errno == EINTR)) ;
+   eina_thread_join(srv->thread);
+   while (srv->lru)
+     _evas_surface_cache_server_entry_del
+       (srv, EINA_INLIST_CONTAINER_GET(srv->lru, Evas_Surface_Cache_Server_Entry));
+   eina_hash_free(srv->entries);
+   close(srv->quit[0]);
+   close(srv->quit[1]);
+   close(srv->fd);
+   unlink(srv->path);
+   free(srv->path);
+   free(srv);
+}
+
+#endif
@@ -0,0 +1,548 @@
+/* EVAS - EFL Scene Graph
+ * Copyright (C) 2016 Samsung Electronics Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library;
+ * if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EVAS_INLINE_DECODE_X_
+#define EVAS_INLINE_DECODE_X_
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+/**
+ * @cond LOCAL
+ */
+
+#define EVAS_IMAGE_DECODE_KEY "_evas_image_decode"
+
+typedef struct _Evas_Image_Decode Evas_Image_Decode;
+
+typedef enum _Evas_Image_Decode_Class
+{
+   EVAS_IMAGE_DECODE_VISIBLE = 0,
+   EVAS_IMAGE_DECODE_NEAR,
+   EVAS_IMAGE_DECODE_AWAY
+} Evas_Image_Decode_Class;
+
+struct _Evas_Image_Decode
+{
+   EINA_INLIST; // in running
+   Evas_Image_Decode_Queue *queue;
+   Evas_Object *obj;
+   Evas_Image_Decode_Cb done_cb;
+   const void *data;
+   Evas_Image_Decode_Stats *stats;
+   double requested;
+   double started;
+   unsigned long long serial;
+   unsigned int index; // in pending, while not running
+   int priority;
+   Evas_Image_Decode_Class cls;
+   Eina_Bool running : 1;
+};
+
+struct _Evas_Image_Decode_Queue
+{
+   Evas *evas;
+   Evas_Image_Decode **pending; // binary heap, the next to decode first
+   unsigned int npending;
+   unsigned int size; // of pending, room for every decode of the queue
+   Eina_Inlist *running;
+   Eina_Hash *stats;
+   unsigned long long serial;
+   unsigned int max_running;
+   unsigned int nrunning;
+   Evas_Coord margin;
+   int walking;
+   Eina_Bool delete_me : 1;
+
+   /* Every user of this header has its own copy of the callbacks, add and
+    * remove them through the ones of the queue. */
+   Evas_Object_Event_Cb preloaded_cb;
+   Evas_Object_Event_Cb del_cb;
+   Evas_Object_Event_Cb geometry_cb;
+};
+
+static inline double
+_evas_image_time_get(void)
+{
+   struct timespec t;
+
+   clock_gettime(CLOCK_MONOTONIC, &t);
+   return (double)t.tv_sec + (double)t.tv_nsec / 1000000000.0;
+}
+
+/* The loader evas tries first is the one for the file extension. */
+static inline void
+_evas_image_loader_name_get(const char *file, char *name, size_t size)
+{
+   const char *ext = file ? strrchr(file, '.') : NULL;
+   size_t i;
+
+   if ((ext) && (!strchr(ext, '/')) && (ext[1]))
+     {
+        for (i = 0; (ext[i + 1]) && (i < size - 1); i++)
+          name[i] = tolower((unsigned char)ext[i + 1]);
+        name[i] = '\0';
+     }
+   else
+     eina_strlcpy(name, "unknown", size);
+}
+
+static inline Evas_Image_Decode_Stats *
+_evas_image_decode_stats_find(Evas_Image_Decode_Queue *q, Evas_Object *obj)
+{
+   Evas_Image_Decode_Stats *st;
+   const char *file = NULL, *key = NULL;
+   char name[sizeof(st->loader)];
+
+   evas_object_image_file_get(obj, &file, &key);
+   _evas_image_loader_name_get(file, name, sizeof(name));
+   st = (Evas_Image_Decode_Stats *)eina_hash_find(q->stats, name);
+   if (st) return st;
+   st = (Evas_Image_Decode_Stats *)calloc(1, sizeof(Evas_Image_Decode_Stats));
+   if (!st) return NULL;
+   strcpy(st->loader, name);
+   if (!eina_hash_add(q->stats, name, st))
+     {
+        free(st);
+        return NULL;
+     }
+   return st;
+}
+
+static inline Evas_Image_Decode_Class
+_evas_image_decode_class_get(const Evas_Image_Decode *d)
+{
+   Evas_Coord x, y, w, h, vx, vy, vw, vh, m;
+
+   if (!evas_object_visible_get(d->obj)) return EVAS_IMAGE_DECODE_AWAY;
+   evas_object_geometry_get(d->obj, &x, &y, &w, &h);
+   evas_output_viewport_get(d->queue->evas, &vx, &vy, &vw, &vh);
+   if ((x < vx + vw) && (x + w > vx) && (y < vy + vh) && (y + h > vy))
+     return EVAS_IMAGE_DECODE_VISIBLE;
+   m = d->queue->margin;
+   if ((x < vx + vw + m) && (x + w > vx - m) && (y < vy + vh + m) && (y + h > vy - m))
+     return EVAS_IMAGE_DECODE_NEAR;
+   return EVAS_IMAGE_DECODE_AWAY;
+}
+
+static inline Eina_Bool
+_evas_image_decode_before(const Evas_Image_Decode *a, const Evas_Image_Decode *b)
+{
+   if (a->cls != b->cls) return a->cls < b->cls;
+   if (a->priority != b->priority) return a->priority < b->priority;
+   return a->serial < b->serial;
+}
+
+static inline void
+_evas_image_decode_heap_set(Evas_Image_Decode_Queue *q, unsigned int i,
+                            Evas_Image_Decode *d)
+{
+   q->pending[i] = d;
+   d->index = i;
+}
+
+static inline void
+_evas_image_decode_heap_up(Evas_Image_Decode_Queue *q, unsigned int i)
+{
+   Evas_Image_Decode *d = q->pending[i];
+
+   while (i > 0)
+     {
+        unsigned int parent = (i - 1) / 2;
+
+        if (!_evas_image_decode_before(d, q->pending[parent])) break;
+        _evas_image_decode_heap_set(q, i, q->pending[parent]);
+        i = parent;
+     }
+   _evas_image_decode_heap_set(q, i, d);
+}
+
+static inline void
+_evas_image_decode_heap_down(Evas_Image_Decode_Queue *q, unsigned int i)
+{
+   Evas_Image_Decode *d = q->pending[i];
+
+   for (;;)
+     {
+        unsigned int child = i * 2 + 1;
+
+        if (child >= q->npending) break;
+        if ((child + 1 < q->npending) &&
+            (_evas_image_decode_before(q->pending[child + 1], q->pending[child])))
+          child++;
+        if (!_evas_image_decode_before(q->pending[child], d)) break;
+        _evas_image_decode_heap_set(q, i, q->pending[child]);
+        i = child;
+     }
+   _evas_image_decode_heap_set(q, i, d);
+}
+
+/* The class or the priority of a pending decode changed. */
+static inline void
+_evas_image_decode_heap_fix(Evas_Image_Decode_Queue *q, Evas_Image_Decode *d)
+{
+   _evas_image_decode_heap_up(q, d->index);
+   _evas_image_decode_heap_down(q, d->index);
+}
+
+/* There is always room, see evas_image_decode_request(). */
+static inline void
+_evas_image_decode_heap_push(Evas_Image_Decode_Queue *q, Evas_Image_Decode *d)
+{
+   _evas_image_decode_heap_set(q, q->npending++, d);
+   _evas_image_decode_heap_up(q, d->index);
+}
+
+static inline void
+_evas_image_decode_heap_remove(Evas_Image_Decode_Queue *q, Evas_Image_Decode *d)
+{
+   unsigned int i = d->index;
+
+   if (i == --q->npending) return;
+   _evas_image_decode_heap_set(q, i, q->pending[q->npending]);
+   _evas_image_decode_heap_fix(q, q->pending[i]);
+}
+
+static inline Evas_Image_Decode *
+_evas_image_decode_best(Evas_Image_Decode_Queue *q)
+{
+   return q->npending ? q->pending[0] : NULL;
+}
+
+static inline void _evas_image_decode_dispatch(Evas_Image_Decode_Queue *q);
+
+/* The queue may be deleted from a done callback, it goes once nothing
+ * walks it anymore. */
+static inline void
+_evas_image_decode_queue_free(Evas_Image_Decode_Queue *q)
+{
+   eina_hash_free(q->stats);
+   free(q->pending);
+   free(q);
+}
+
+static inline Eina_Bool
+_evas_image_decode_unwalk(Evas_Image_Decode_Queue *q)
+{
+   if ((--q->walking) || (!q->delete_me)) return !q->delete_me;
+   _evas_image_decode_queue_free(q);
+   return EINA_FALSE;
+}
+
+static void _evas_image_decode_preloaded_cb(void *data, Evas *e, Evas_Object *obj, void *event_info);
+static void _evas_image_decode_del_cb(void *data, Evas *e, Evas_Object *obj, void *event_info);
+static void _evas_image_decode_geometry_cb(void *data, Evas *e, Evas_Object *obj, void *event_info);
+
+static inline void
+_evas_image_decode_free(Evas_Image_Decode *d)
+{
+   Evas_Image_Decode_Queue *q = d->queue;
+   Evas_Object *obj = d->obj;
+
+   if (d->running)
+     {
+        q->running = eina_inlist_remove(q->running, EINA_INLIST_GET(d));
+        q->nrunning--;
+     }
+   else
+     _evas_image_decode_heap_remove(q, d);
+   evas_object_event_callback_del_full(obj, EVAS_CALLBACK_IMAGE_PRELOADED, q->preloaded_cb, d);
+   evas_object_event_callback_del_full(obj, EVAS_CALLBACK_DEL, q->del_cb, d);
+   evas_object_event_callback_del_full(obj, EVAS_CALLBACK_MOVE, q->geometry_cb, d);
+   evas_object_event_callback_del_full(obj, EVAS_CALLBACK_RESIZE, q->geometry_cb, d);
+   evas_object_event_callback_del_full(obj, EVAS_CALLBACK_SHOW, q->geometry_cb, d);
+   evas_object_event_callback_del_full(obj, EVAS_CALLBACK_HIDE, q->geometry_cb, d);
+   evas_object_data_del(obj, EVAS_IMAGE_DECODE_KEY);
+   free(d);
+}
+
+/* Stop a running decode and queue it again, evas drops the data it
+ * already has decoded. */
+static inline void
+_evas_image_decode_requeue(Evas_Image_Decode *d)
+{
+   Evas_Image_Decode_Queue *q = d->queue;
+
+   evas_object_image_preload(d->obj, EINA_TRUE);
+   q->running = eina_inlist_remove(q->running, EINA_INLIST_GET(d));
+   q->nrunning--;
+   d->running = EINA_FALSE;
+   _evas_image_decode_heap_push(q, d);
+   if (d->stats) d->stats->cancelled++;
+}
+
+static void
+_evas_image_decode_preloaded_cb(void *data, Evas *e EINA_UNUSED, Evas_Object *obj, void *event_info EINA_UNUSED)
+{
+   Evas_Image_Decode *d = (Evas_Image_Decode *)data;
+   Evas_Image_Decode_Queue *q = d->queue;
+   Evas_Image_Decode_Stats *st = d->stats;
+   Evas_Image_Decode_Cb done_cb = d->done_cb;
+   const void *cb_data = d->data;
+   Evas_Load_Error err;
+
+   if (!d->running) return;
+   err = evas_object_image_load_error_get(obj);
+   if (st)
+     {
+        double now = _evas_image_time_get();
+        double decode = now - d->started;
+
+        if (err == EVAS_LOAD_ERROR_NONE)
+          {
+             int w = 0, h = 0;
+
+             evas_object_image_size_get(obj, &w, &h);
+             st->decoded++;
+             st->pixels += (unsigned long long)w * h;
+          }
+        else
+          st->failed++;
+        st->wait_total += d->started - d->requested;
+        st->decode_total += decode;
+        if (decode > st->decode_max) st->decode_max = decode;
+     }
+
+   q->walking++;
+   _evas_image_decode_free(d);
+   if (done_cb) done_cb((void *)cb_data, obj, err);
+   if (_evas_image_decode_unwalk(q)) _evas_image_decode_dispatch(q);
+}
+
+static void
+_evas_image_decode_del_cb(void *data, Evas *e EINA_UNUSED, Evas_Object *obj EINA_UNUSED, void *event_info EINA_UNUSED)
+{
+   Evas_Image_Decode *d = (Evas_Image_Decode *)data;
+   Evas_Image_Decode_Queue *q = d->queue;
+   Eina_Bool running = d->running;
+
+   if ((running) && (d->stats)) d->stats->cancelled++;
+   _evas_image_decode_free(d);
+   if (running) _evas_image_decode_dispatch(q);
+}
+
+/* Moving out of sight gives the slot to anything closer that waits. */
+static void
+_evas_image_decode_geometry_cb(void *data, Evas *e EINA_UNUSED, Evas_Object *obj EINA_UNUSED, void *event_info EINA_UNUSED)
+{
+   Evas_Image_Decode *d = (Evas_Image_Decode *)data;
+   Evas_Image_Decode_Queue *q = d->queue;
+   Evas_Image_Decode *best;
+
+   d->cls = _evas_image_decode_class_get(d);
+   if (!d->running)
+     {
+        _evas_image_decode_heap_fix(q, d);
+        return;
+     }
+   if (d->cls != EVAS_IMAGE_DECODE_AWAY) return;
+   best = _evas_image_decode_best(q);
+   if ((!best) || (!_evas_image_decode_before(best, d))) return;
+   _evas_image_decode_requeue(d);
+   _evas_image_decode_dispatch(q);
+}
+
+static inline void
+_evas_image_decode_dispatch(Evas_Image_Decode_Queue *q)
+{
+   if (q->walking) return;
+   q->walking++;
+   while (q->nrunning < q->max_running)
+     {
+        Evas_Image_Decode *d = _evas_image_decode_best(q);
+
+        if (!d) break;
+        _evas_image_decode_heap_remove(q, d);
+        q->running = eina_inlist_append(q->running, EINA_INLIST_GET(d));
+        q->nrunning++;
+        d->running = EINA_TRUE;
+        d->started = _evas_image_time_get();
+        /* Already decoded data makes evas call back right away, d may
+         * be gone after this. */
+        evas_object_image_preload(d->obj, EINA_FALSE);
+        if (q->delete_me) break;
+     }
+   _evas_image_decode_unwalk(q);
+}
+
+/**
+ * @endcond
+ */
+
+static inline Evas_Image_Decode_Queue *
+evas_image_decode_queue_add(Evas *e, unsigned int max_running)
+{
+   Evas_Image_Decode_Queue *q;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(e, NULL);
+
+   q = (Evas_Image_Decode_Queue *)calloc(1, sizeof(Evas_Image_Decode_Queue));
+   if (!q) return NULL;
+   q->stats = eina_hash_string_small_new(free);
+   if (!q->stats)
+     {
+        free(q);
+        return NULL;
+     }
+   q->evas = e;
+   q->preloaded_cb = _evas_image_decode_preloaded_cb;
+   q->del_cb = _evas_image_decode_del_cb;
+   q->geometry_cb = _evas_image_decode_geometry_cb;
+   q->max_running = max_running ? max_running : (unsigned int)eina_cpu_count();
+   if (!q->max_running) q->max_running = 1;
+   return q;
+}
+
+static inline void
+evas_image_decode_queue_del(Evas_Image_Decode_Queue *q)
+{
+   if (!q) return;
+
+   while (q->running)
+     {
+        Evas_Image_Decode *d = EINA_INLIST_CONTAINER_GET(q->running, Evas_Image_Decode);
+
+        evas_object_image_preload(d->obj, EINA_TRUE);
+        _evas_image_decode_free(d);
+     }
+   while (q->npending)
+     _evas_image_decode_free(q->pending[q->npending - 1]);
+   if (q->walking)
+     {
+        q->delete_me = EINA_TRUE;
+        return;
+     }
+   _evas_image_decode_queue_free(q);
+}
+
+static inline void
+evas_image_decode_queue_margin_set(Evas_Image_Decode_Queue *q, Evas_Coord margin)
+{
+   unsigned int i;
+
+   EINA_SAFETY_ON_NULL_RETURN(q);
+
+   q->margin = margin < 0 ? 0 : margin;
+   for (i = 0; i < q->npending; i++)
+     q->pending[i]->cls = _evas_image_decode_class_get(q->pending[i]);
+   for (i = q->npending / 2; i-- > 0; )
+     _evas_image_decode_heap_down(q, i);
+}
+
+static inline Eina_Bool
+evas_image_decode_cancel(Evas_Image_Decode_Queue *q, Evas_Object *obj)
+{
+   Evas_Image_Decode *d;
+   Eina_Bool running;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(q, EINA_FALSE);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(obj, EINA_FALSE);
+
+   d = (Evas_Image_Decode *)evas_object_data_get(obj, EVAS_IMAGE_DECODE_KEY);
+   if ((!d) || (d->queue != q)) return EINA_FALSE;
+   running = d->running;
+   if (running) evas_object_image_preload(obj, EINA_TRUE);
+   if (d->stats) d->stats->cancelled++;
+   _evas_image_decode_free(d);
+   if (running) _evas_image_decode_dispatch(q);
+   return EINA_TRUE;
+}
+
+static inline Eina_Bool
+evas_image_decode_request(Evas_Image_Decode_Queue *q, Evas_Object *obj, int priority,
+                          Evas_Image_Decode_Cb done_cb, const void *data)
+{
+   Evas_Image_Decode *d;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(q, EINA_FALSE);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(obj, EINA_FALSE);
+
+   /* A new request means new load options, start over. */
+   d = (Evas_Image_Decode *)evas_object_data_get(obj, EVAS_IMAGE_DECODE_KEY);
+   if (d) evas_image_decode_cancel(d->queue, obj);
+
+   /* A running decode may go back to pending, keep room for all. */
+   if (q->npending + q->nrunning >= q->size)
+     {
+        Evas_Image_Decode **pending;
+        unsigned int size = q->size ? q->size * 2 : 64;
+
+        pending = (Evas_Image_Decode **)realloc(q->pending, size * sizeof(Evas_Image_Decode *));
+        if (!pending) return EINA_FALSE;
+        q->pending = pending;
+        q->size = size;
+     }
+
+   d = (Evas_Image_Decode *)calloc(1, sizeof(Evas_Image_Decode));
+   if (!d) return EINA_FALSE;
+   d->queue = q;
+   d->obj = obj;
+   d->done_cb = done_cb;
+   d->data = data;
+   d->priority = priority;
+   d->serial = q->serial++;
+   d->requested = _evas_image_time_get();
+   d->stats = _evas_image_decode_stats_find(q, obj);
+   d->cls = _evas_image_decode_class_get(d);
+
+   evas_object_data_set(obj, EVAS_IMAGE_DECODE_KEY, d);
+   evas_object_event_callback_add(obj, EVAS_CALLBACK_IMAGE_PRELOADED, q->preloaded_cb, d);
+   evas_object_event_callback_add(obj, EVAS_CALLBACK_DEL, q->del_cb, d);
+   evas_object_event_callback_add(obj, EVAS_CALLBACK_MOVE, q->geometry_cb, d);
+   evas_object_event_callback_add(obj, EVAS_CALLBACK_RESIZE, q->geometry_cb, d);
+   evas_object_event_callback_add(obj, EVAS_CALLBACK_SHOW, q->geometry_cb, d);
+   evas_object_event_callback_add(obj, EVAS_CALLBACK_HIDE, q->geometry_cb, d);
+   _evas_image_decode_heap_push(q, d);
+
+   _evas_image_decode_dispatch(q);
+   return EINA_TRUE;
+}
+
+static inline void
+evas_image_decode_priority_set(Evas_Image_Decode_Queue *q, Evas_Object *obj, int priority)
+{
+   Evas_Image_Decode *d;
+
+   EINA_SAFETY_ON_NULL_RETURN(q);
+   EINA_SAFETY_ON_NULL_RETURN(obj);
+
+   d = (Evas_Image_Decode *)evas_object_data_get(obj, EVAS_IMAGE_DECODE_KEY);
+   if ((!d) || (d->queue != q)) return;
+   d->priority = priority;
+   if (!d->running) _evas_image_decode_heap_fix(q, d);
+}
+
+static inline unsigned int
+evas_image_decode_queue_pending_count(const Evas_Image_Decode_Queue *q)
+{
+   EINA_SAFETY_ON_NULL_RETURN_VAL(q, 0);
+
+   return q->npending + q->nrunning;
+}
+
+static inline Eina_Iterator *
+evas_image_decode_queue_stats_iterator_new(const Evas_Image_Decode_Queue *q)
+{
+   EINA_SAFETY_ON_NULL_RETURN_VAL(q, NULL);
+
+   return eina_hash_iterator_data_new(q->stats);
+}
+
+#endif
@@ -0,0 +1,993 @@
+/* EVAS - EFL Scene Graph
+ * Copyright (C) 2016 Samsung Electronics Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library;
+ * if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EVAS_INLINE_PIXEL_X_
+#define EVAS_INLINE_PIXEL_X_
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @cond LOCAL
+ */
+
+/* The x86 paths are built with per function target attributes so that
+ * they are there whatever the application is compiled with, and only
+ * picked when the cpu has them. NEON has no such thing on 32 bit ARM,
+ * it is there when the compiler was told to use it. */
+#if (defined(__x86_64__) || defined(__i386__)) && \
+  (defined(__clang__) || (__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 9)))
+# define EVAS_PIXEL_X86 1
+# include <immintrin.h>
+# define EVAS_PIXEL_SSE41 __attribute__ ((target("sse4.1")))
+# define EVAS_PIXEL_AVX2 __attribute__ ((target("avx2")))
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+# define EVAS_PIXEL_NEON 1
+# include <arm_neon.h>
+#endif
+
+/* Everything works on the two halves of a pixel, 0x00RR00BB and
+ * 0x00AA00GG, as 16 bit lanes, so that the vector paths give the exact
+ * same result as the C one. */
+static inline unsigned int
+_evas_pixel_mul_256(unsigned int c, unsigned int f)
+{
+   return (((c & 0xff00ff) * f >> 8) & 0xff00ff) |
+     ((((c >> 8) & 0xff00ff) * f) & 0xff00ff00);
+}
+
+static inline unsigned int
+_evas_pixel_mul_color(unsigned int c, unsigned int col)
+{
+   unsigned int a = ((c >> 24) * ((col >> 24) + 1)) >> 8;
+   unsigned int r = (((c >> 16) & 0xff) * (((col >> 16) & 0xff) + 1)) >> 8;
+   unsigned int g = (((c >> 8) & 0xff) * (((col >> 8) & 0xff) + 1)) >> 8;
+   unsigned int b = ((c & 0xff) * ((col & 0xff) + 1)) >> 8;
+
+   return (a << 24) | (r << 16) | (g << 8) | b;
+}
+
+static inline unsigned int
+_evas_pixel_add_sat(unsigned int c1, unsigned int c2)
+{
+   unsigned int rb = (c1 & 0xff00ff) + (c2 & 0xff00ff);
+   unsigned int ag = ((c1 >> 8) & 0xff00ff) + ((c2 >> 8) & 0xff00ff);
+
+   rb = (rb | (((rb >> 8) & 0x10001) * 0xff)) & 0xff00ff;
+   ag = (ag | (((ag >> 8) & 0x10001) * 0xff)) & 0xff00ff;
+   return rb | (ag << 8);
+}
+
+static inline unsigned int
+_evas_pixel_over(unsigned int d, unsigned int s)
+{
+   return _evas_pixel_add_sat(s, _evas_pixel_mul_256(d, 256 - (s >> 24)));
+}
+
+static inline unsigned int
+_evas_pixel_lerp(unsigned int c0, unsigned int c1, unsigned int f)
+{
+   return _evas_pixel_mul_256(c0, 256 - f) + _evas_pixel_mul_256(c1, f);
+}
+
+static inline void
+_evas_pixel_c_blend(unsigned int *dst, const unsigned int *src, int len)
+{
+   int i;
+
+   for (i = 0; i < len; i++)
+     dst[i] = _evas_pixel_over(dst[i], src[i]);
+}
+
+static inline void
+_evas_pixel_c_blend_color(unsigned int *dst, const unsigned int *src,
+                          unsigned int color, int len)
+{
+   int i;
+
+   for (i = 0; i < len; i++)
+     dst[i] = _evas_pixel_over(dst[i], _evas_pixel_mul_color(src[i], color));
+}
+
+static inline void
+_evas_pixel_c_blend_mask(unsigned int *dst, const unsigned int *src,
+                         const unsigned char *mask, int len)
+{
+   int i;
+
+   for (i = 0; i < len; i++)
+     dst[i] = _evas_pixel_over(dst[i],
+                               _evas_pixel_mul_256(src[i], mask[i] + 1));
+}
+
+static inline void
+_evas_pixel_c_scale_smooth(unsigned int *dst, int len,
+                           const unsigned int *row0, const unsigned int *row1,
+                           int sw, int sx, int step, int fy)
+{
+   int i;
+
+   for (i = 0; i < len; i++, sx += step)
+     {
+        int x = sx >> 16, x1 = x + 1;
+        unsigned int fx = (sx >> 8) & 0xff;
+
+        if (x > sw - 1) x = sw - 1;
+        if (x1 > sw - 1) x1 = sw - 1;
+        dst[i] = _evas_pixel_lerp(_evas_pixel_lerp(row0[x], row0[x1], fx),
+                                  _evas_pixel_lerp(row1[x], row1[x1], fx),
+                                  fy);
+     }
+}
+
+static inline void
+_evas_pixel_c_to_rgb565(unsigned short *dst, const unsigned int *src, int len)
+{
+   int i;
+
+   for (i = 0; i < len; i++)
+     {
+        unsigned int p = src[i];
+
+        dst[i] = ((p >> 8) & 0xf800) | ((p >> 5) & 0x07e0) | ((p >> 3) & 0x1f);
+     }
+}
+
+static inline void
+_evas_pixel_c_to_rgb24(unsigned char *dst, const unsigned int *src, int len)
+{
+   int i;
+
+   for (i = 0; i < len; i++, dst += 3)
+     {
+        dst[0] = src[i] >> 16;
+        dst[1] = src[i] >> 8;
+        dst[2] = src[i];
+     }
+}
+
+static inline void
+_evas_pixel_c_to_bgr24(unsigned char *dst, const unsigned int *src, int len)
+{
+   int i;
+
+   for (i = 0; i < len; i++, dst += 3)
+     {
+        dst[0] = src[i];
+        dst[1] = src[i] >> 8;
+        dst[2] = src[i] >> 16;
+     }
+}
+
+static inline void
+_evas_pixel_c_to_bgra32(unsigned int *dst, const unsigned int *src, int len)
+{
+   int i;
+
+   for (i = 0; i < len; i++)
+     {
+        unsigned int p = src[i];
+
+        dst[i] = (p << 24) | ((p & 0xff00) << 8) | ((p >> 8) & 0xff00) | (p >> 24);
+     }
+}
+
+static inline void
+_evas_pixel_c_to_rgb32(unsigned int *dst, const unsigned int *src, int len)
+{
+   int i;
+
+   for (i = 0; i < len; i++)
+     dst[i] = src[i] & 0x00ffffff;
+}
+
+static const Evas_Pixel_Kernels _evas_pixel_kernels_c =
+{
+   EVAS_PIXEL_KERNEL_SET_C, "c",
+   _evas_pixel_c_blend,
+   _evas_pixel_c_blend_color,
+   _evas_pixel_c_blend_mask,
+   _evas_pixel_c_scale_smooth,
+   _evas_pixel_c_to_rgb565,
+   _evas_pixel_c_to_rgb24,
+   _evas_pixel_c_to_bgr24,
+   _evas_pixel_c_to_bgra32,
+   _evas_pixel_c_to_rgb32
+};
+
+#ifdef EVAS_PIXEL_X86
+
+/* SSE4.1, 4 pixels at a time. */
+
+EVAS_PIXEL_SSE41 static inline __m128i
+_evas_pixel_sse41_mul(__m128i c, __m128i frb, __m128i fag)
+{
+   const __m128i m = _mm_set1_epi32(0x00ff00ff);
+   __m128i rb = _mm_and_si128(c, m);
+   __m128i ag = _mm_srli_epi16(c, 8);
+
+   rb = _mm_srli_epi16(_mm_mullo_epi16(rb, frb), 8);
+   ag = _mm_andnot_si128(m, _mm_mullo_epi16(ag, fag));
+   return _mm_or_si128(rb, ag);
+}
+
+EVAS_PIXEL_SSE41 static inline __m128i
+_evas_pixel_sse41_over(__m128i d, __m128i s)
+{
+   const __m128i alpha = _mm_setr_epi8(3, -1, 3, -1, 7, -1, 7, -1,
+                                       11, -1, 11, -1, 15, -1, 15, -1);
+   __m128i f = _mm_sub_epi16(_mm_set1_epi16(256), _mm_shuffle_epi8(s, alpha));
+
+   return _mm_adds_epu8(s, _evas_pixel_sse41_mul(d, f, f));
+}
+
+EVAS_PIXEL_SSE41 static inline __m128i
+_evas_pixel_sse41_factor(__m128i f)
+{
+   return _mm_or_si128(f, _mm_slli_epi32(f, 16));
+}
+
+EVAS_PIXEL_SSE41 static void
+_evas_pixel_sse41_blend(unsigned int *dst, const unsigned int *src, int len)
+{
+   int i;
+
+   for (i = 0; i + 4 <= len; i += 4)
+     {
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+
+        _mm_storeu_si128((__m128i *)(dst + i), _evas_pixel_sse41_over(d, s));
+     }
+   _evas_pixel_c_blend(dst + i, src + i, len - i);
+}
+
+EVAS_PIXEL_SSE41 static void
+_evas_pixel_sse41_blend_color(unsigned int *dst, const unsigned int *src,
+                              unsigned int color, int len)
+{
+   __m128i frb = _mm_set1_epi32(((((color >> 16) & 0xff) + 1) << 16) |
+                                ((color & 0xff) + 1));
+   __m128i fag = _mm_set1_epi32((((color >> 24) + 1) << 16) |
+                                (((color >> 8) & 0xff) + 1));
+   int i;
+
+   for (i = 0; i + 4 <= len; i += 4)
+     {
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+
+        s = _evas_pixel_sse41_mul(s, frb, fag);
+        _mm_storeu_si128((__m128i *)(dst + i), _evas_pixel_sse41_over(d, s));
+     }
+   _evas_pixel_c_blend_color(dst + i, src + i, color, len - i);
+}
+
+EVAS_PIXEL_SSE41 static void
+_evas_pixel_sse41_blend_mask(unsigned int *dst, const unsigned int *src,
+                             const unsigned char *mask, int len)
+{
+   const __m128i one = _mm_set1_epi32(1);
+   int i;
+
+   for (i = 0; i + 4 <= len; i += 4)
+     {
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+        __m128i f;
+        int m;
+
+        memcpy(&m, mask + i, sizeof(m));
+        f = _mm_add_epi32(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(m)), one);
+        f = _evas_pixel_sse41_factor(f);
+        s = _evas_pixel_sse41_mul(s, f, f);
+        _mm_storeu_si128((__m128i *)(dst + i), _evas_pixel_sse41_over(d, s));
+     }
+   _evas_pixel_c_blend_mask(dst + i, src + i, mask + i, len - i);
+}
+
+EVAS_PIXEL_SSE41 static inline __m128i
+_evas_pixel_sse41_lerp(__m128i c0, __m128i c1, __m128i f)
+{
+   __m128i nf = _mm_sub_epi16(_mm_set1_epi16(256), f);
+
+   return _mm_add_epi32(_evas_pixel_sse41_mul(c0, nf, nf),
+                        _evas_pixel_sse41_mul(c1, f, f));
+}
+
+EVAS_PIXEL_SSE41 static void
+_evas_pixel_sse41_scale_smooth(unsigned int *dst, int len,
+                               const unsigned int *row0, const unsigned int *row1,
+                               int sw, int sx, int step, int fy)
+{
+   __m128i vfy = _mm_set1_epi16(fy);
+   int i;
+
+   for (i = 0; i + 4 <= len; i += 4, sx += 4 * step)
+     {
+        unsigned int p[4][4];
+        __m128i t, b, fx;
+        int k;
+
+        for (k = 0; k < 4; k++)
+          {
+             int x = (sx + k * step) >> 16, x1 = x + 1;
+
+             if (x > sw - 1) x = sw - 1;
+             if (x1 > sw - 1) x1 = sw - 1;
+             p[0][k] = row0[x];
+             p[1][k] = row0[x1];
+             p[2][k] = row1[x];
+             p[3][k] = row1[x1];
+          }
+        fx = _mm_setr_epi32(sx, sx + step, sx + 2 * step, sx + 3 * step);
+        fx = _evas_pixel_sse41_factor(_mm_and_si128(_mm_srli_epi32(fx, 8),
+                                                    _mm_set1_epi32(0xff)));
+        t = _evas_pixel_sse41_lerp(_mm_loadu_si128((const __m128i *)p[0]),
+                                   _mm_loadu_si128((const __m128i *)p[1]), fx);
+        b = _evas_pixel_sse41_lerp(_mm_loadu_si128((const __m128i *)p[2]),
+                                   _mm_loadu_si128((const __m128i *)p[3]), fx);
+        _mm_storeu_si128((__m128i *)(dst + i), _evas_pixel_sse41_lerp(t, b, vfy));
+     }
+   _evas_pixel_c_scale_smooth(dst + i, len - i, row0, row1, sw, sx, step, fy);
+}
+
+EVAS_PIXEL_SSE41 static inline __m128i
+_evas_pixel_sse41_565(__m128i p)
+{
+   __m128i r = _mm_and_si128(_mm_srli_epi32(p, 8), _mm_set1_epi32(0xf800));
+   __m128i g = _mm_and_si128(_mm_srli_epi32(p, 5), _mm_set1_epi32(0x07e0));
+   __m128i b = _mm_and_si128(_mm_srli_epi32(p, 3), _mm_set1_epi32(0x001f));
+
+   return _mm_or_si128(_mm_or_si128(r, g), b);
+}
+
+EVAS_PIXEL_SSE41 static void
+_evas_pixel_sse41_to_rgb565(unsigned short *dst, const unsigned int *src, int len)
+{
+   int i;
+
+   for (i = 0; i + 8 <= len; i += 8)
+     {
+        __m128i p0 = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i p1 = _mm_loadu_si128((const __m128i *)(src + i + 4));
+
+        _mm_storeu_si128((__m128i *)(dst + i),
+                         _mm_packus_epi32(_evas_pixel_sse41_565(p0),
+                                          _evas_pixel_sse41_565(p1)));
+     }
+   _evas_pixel_c_to_rgb565(dst + i, src + i, len - i);
+}
+
+/* 4 pixels to 12 bytes, the 4 last ones of the shuffle are garbage. */
+EVAS_PIXEL_SSE41 static inline void
+_evas_pixel_sse41_store_24(unsigned char *dst, __m128i v)
+{
+   int last = _mm_extract_epi32(v, 2);
+
+   _mm_storel_epi64((__m128i *)dst, v);
+   memcpy(dst + 8, &last, 4);
+}
+
+EVAS_PIXEL_SSE41 static void
+_evas_pixel_sse41_to_rgb24(unsigned char *dst, const unsigned int *src, int len)
+{
+   const __m128i shuf = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12,
+                                      -1, -1, -1, -1);
+   int i;
+
+   for (i = 0; i + 4 <= len; i += 4)
+     _evas_pixel_sse41_store_24(dst + i * 3,
+                                _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src + i)), shuf));
+   _evas_pixel_c_to_rgb24(dst + i * 3, src + i, len - i);
+}
+
+EVAS_PIXEL_SSE41 static void
+_evas_pixel_sse41_to_bgr24(unsigned char *dst, const unsigned int *src, int len)
+{
+   const __m128i shuf = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14,
+                                      -1, -1, -1, -1);
+   int i;
+
+   for (i = 0; i + 4 <= len; i += 4)
+     _evas_pixel_sse41_store_24(dst + i * 3,
+                                _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src + i)), shuf));
+   _evas_pixel_c_to_bgr24(dst + i * 3, src + i, len - i);
+}
+
+EVAS_PIXEL_SSE41 static void
+_evas_pixel_sse41_to_bgra32(unsigned int *dst, const unsigned int *src, int len)
+{
+   const __m128i shuf = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4,
+                                      11, 10, 9, 8, 15, 14, 13, 12);
+   int i;
+
+   for (i = 0; i + 4 <= len; i += 4)
+     _mm_storeu_si128((__m128i *)(dst + i),
+                      _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src + i)), shuf));
+   _evas_pixel_c_to_bgra32(dst + i, src + i, len - i);
+}
+
+EVAS_PIXEL_SSE41 static void
+_evas_pixel_sse41_to_rgb32(unsigned int *dst, const unsigned int *src, int len)
+{
+   const __m128i m = _mm_set1_epi32(0x00ffffff);
+   int i;
+
+   for (i = 0; i + 4 <= len; i += 4)
+     _mm_storeu_si128((__m128i *)(dst + i),
+                      _mm_and_si128(_mm_loadu_si128((const __m128i *)(src + i)), m));
+   _evas_pixel_c_to_rgb32(dst + i, src + i, len - i);
+}
+
+static const Evas_Pixel_Kernels _evas_pixel_kernels_sse41 =
+{
+   EVAS_PIXEL_KERNEL_SET_SSE41, "sse4.1",
+   _evas_pixel_sse41_blend,
+   _evas_pixel_sse41_blend_color,
+   _evas_pixel_sse41_blend_mask,
+   _evas_pixel_sse41_scale_smooth,
+   _evas_pixel_sse41_to_rgb565,
+   _evas_pixel_sse41_to_rgb24,
+   _evas_pixel_sse41_to_bgr24,
+   _evas_pixel_sse41_to_bgra32,
+   _evas_pixel_sse41_to_rgb32
+};
+
+/* AVX2, 8 pixels at a time. Shuffles and packs stay within 128 bit
+ * lanes, so the lane layout only matters for the packs. */
+
+EVAS_PIXEL_AVX2 static inline __m256i
+_evas_pixel_avx2_mul(__m256i c, __m256i frb, __m256i fag)
+{
+   const __m256i m = _mm256_set1_epi32(0x00ff00ff);
+   __m256i rb = _mm256_and_si256(c, m);
+   __m256i ag = _mm256_srli_epi16(c, 8);
+
+   rb = _mm256_srli_epi16(_mm256_mullo_epi16(rb, frb), 8);
+   ag = _mm256_andnot_si256(m, _mm256_mullo_epi16(ag, fag));
+   return _mm256_or_si256(rb, ag);
+}
+
+EVAS_PIXEL_AVX2 static inline __m256i
+_evas_pixel_avx2_over(__m256i d, __m256i s)
+{
+   const __m256i alpha = _mm256_setr_epi8(3, -1, 3, -1, 7, -1, 7, -1,
+                                          11, -1, 11, -1, 15, -1, 15, -1,
+                                          3, -1, 3, -1, 7, -1, 7, -1,
+                                          11, -1, 11, -1, 15, -1, 15, -1);
+   __m256i f = _mm256_sub_epi16(_mm256_set1_epi16(256),
+                                _mm256_shuffle_epi8(s, alpha));
+
+   return _mm256_adds_epu8(s, _evas_pixel_avx2_mul(d, f, f));
+}
+
+EVAS_PIXEL_AVX2 static inline __m256i
+_evas_pixel_avx2_factor(__m256i f)
+{
+   return _mm256_or_si256(f, _mm256_slli_epi32(f, 16));
+}
+
+EVAS_PIXEL_AVX2 static void
+_evas_pixel_avx2_blend(unsigned int *dst, const unsigned int *src, int len)
+{
+   int i;
+
+   for (i = 0; i + 8 <= len; i += 8)
+     {
+        __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i));
+
+        _mm256_storeu_si256((__m256i *)(dst + i), _evas_pixel_avx2_over(d, s));
+     }
+   _evas_pixel_c_blend(dst + i, src + i, len - i);
+}
+
+EVAS_PIXEL_AVX2 static void
+_evas_pixel_avx2_blend_color(unsigned int *dst, const unsigned int *src,
+                             unsigned int color, int len)
+{
+   __m256i frb = _mm256_set1_epi32(((((color >> 16) & 0xff) + 1) << 16) |
+                                   ((color & 0xff) + 1));
+   __m256i fag = _mm256_set1_epi32((((color >> 24) + 1) << 16) |
+                                   (((color >> 8) & 0xff) + 1));
+   int i;
+
+   for (i = 0; i + 8 <= len; i += 8)
+     {
+        __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i));
+
+        s = _evas_pixel_avx2_mul(s, frb, fag);
+        _mm256_storeu_si256((__m256i *)(dst + i), _evas_pixel_avx2_over(d, s));
+     }
+   _evas_pixel_c_blend_color(dst + i, src + i, color, len - i);
+}
+
+EVAS_PIXEL_AVX2 static void
+_evas_pixel_avx2_blend_mask(unsigned int *dst, const unsigned int *src,
+                            const unsigned char *mask, int len)
+{
+   const __m256i one = _mm256_set1_epi32(1);
+   int i;
+
+   for (i = 0; i + 8 <= len; i += 8)
+     {
+        __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i));
+        __m256i f;
+
+        f = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(mask + i)));
+        f = _evas_pixel_avx2_factor(_mm256_add_epi32(f, one));
+        s = _evas_pixel_avx2_mul(s, f, f);
+        _mm256_storeu_si256((__m256i *)(dst + i), _evas_pixel_avx2_over(d, s));
+     }
+   _evas_pixel_c_blend_mask(dst + i, src + i, mask + i, len - i);
+}
+
+EVAS_PIXEL_AVX2 static inline __m256i
+_evas_pixel_avx2_lerp(__m256i c0, __m256i c1, __m256i f)
+{
+   __m256i nf = _mm256_sub_epi16(_mm256_set1_epi16(256), f);
+
+   return _mm256_add_epi32(_evas_pixel_avx2_mul(c0, nf, nf),
+                           _evas_pixel_avx2_mul(c1, f, f));
+}
+
+EVAS_PIXEL_AVX2 static void
+_evas_pixel_avx2_scale_smooth(unsigned int *dst, int len,
+                              const unsigned int *row0, const unsigned int *row1,
+                              int sw, int sx, int step, int fy)
+{
+   const __m256i last = _mm256_set1_epi32(sw - 1);
+   const __m256i steps = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+                                            _mm256_set1_epi32(step));
+   __m256i vfy = _mm256_set1_epi16(fy);
+   int i;
+
+   for (i = 0; i + 8 <= len; i += 8, sx += 8 * step)
+     {
+        __m256i xs = _mm256_add_epi32(_mm256_set1_epi32(sx), steps);
+        __m256i x0 = _mm256_srai_epi32(xs, 16);
+        __m256i x1 = _mm256_min_epi32(_mm256_add_epi32(x0, _mm256_set1_epi32(1)), last);
+        __m256i fx, t, b;
+
+        x0 = _mm256_min_epi32(x0, last);
+        fx = _mm256_and_si256(_mm256_srli_epi32(xs, 8), _mm256_set1_epi32(0xff));
+        fx = _evas_pixel_avx2_factor(fx);
+        t = _evas_pixel_avx2_lerp(_mm256_i32gather_epi32((const int *)row0, x0, 4),
+                                  _mm256_i32gather_epi32((const int *)row0, x1, 4), fx);
+        b = _evas_pixel_avx2_lerp(_mm256_i32gather_epi32((const int *)row1, x0, 4),
+                                  _mm256_i32gather_epi32((const int *)row1, x1, 4), fx);
+        _mm256_storeu_si256((__m256i *)(dst + i), _evas_pixel_avx2_lerp(t, b, vfy));
+     }
+   _evas_pixel_c_scale_smooth(dst + i, len - i, row0, row1, sw, sx, step, fy);
+}
+
+EVAS_PIXEL_AVX2 static inline __m256i
+_evas_pixel_avx2_565(__m256i p)
+{
+   __m256i r = _mm256_and_si256(_mm256_srli_epi32(p, 8), _mm256_set1_epi32(0xf800));
+   __m256i g = _mm256_and_si256(_mm256_srli_epi32(p, 5), _mm256_set1_epi32(0x07e0));
+   __m256i b = _mm256_and_si256(_mm256_srli_epi32(p, 3), _mm256_set1_epi32(0x001f));
+
+   return _mm256_or_si256(_mm256_or_si256(r, g), b);
+}
+
+EVAS_PIXEL_AVX2 static void
+_evas_pixel_avx2_to_rgb565(unsigned short *dst, const unsigned int *src, int len)
+{
+   int i;
+
+   for (i = 0; i + 16 <= len; i += 16)
+     {
+        __m256i p0 = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i p1 = _mm256_loadu_si256((const __m256i *)(src + i + 8));
+        __m256i v = _mm256_packus_epi32(_evas_pixel_avx2_565(p0),
+                                        _evas_pixel_avx2_565(p1));
+
+        _mm256_storeu_si256((__m256i *)(dst + i),
+                            _mm256_permute4x64_epi64(v, _MM_SHUFFLE(3, 1, 2, 0)));
+     }
+   _evas_pixel_sse41_to_rgb565(dst + i, src + i, len - i);
+}
+
+EVAS_PIXEL_AVX2 static inline void
+_evas_pixel_avx2_store_24(unsigned char *dst, __m256i v)
+{
+   _evas_pixel_sse41_store_24(dst, _mm256_castsi256_si128(v));
+   _evas_pixel_sse41_store_24(dst + 12, _mm256_extracti128_si256(v, 1));
+}
+
+EVAS_PIXEL_AVX2 static void
+_evas_pixel_avx2_to_rgb24(unsigned char *dst, const unsigned int *src, int len)
+{
+   const __m256i shuf = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12,
+                                         -1, -1, -1, -1,
+                                         2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12,
+                                         -1, -1, -1, -1);
+   int i;
+
+   for (i = 0; i + 8 <= len; i += 8)
+     _evas_pixel_avx2_store_24(dst + i * 3,
+                               _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(src + i)), shuf));
+   _evas_pixel_c_to_rgb24(dst + i * 3, src + i, len - i);
+}
+
+EVAS_PIXEL_AVX2 static void
+_evas_pixel_avx2_to_bgr24(unsigned char *dst, const unsigned int *src, int len)
+{
+   const __m256i shuf = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14,
+                                         -1, -1, -1, -1,
+                                         0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14,
+                                         -1, -1, -1, -1);
+   int i;
+
+   for (i = 0; i + 8 <= len; i += 8)
+     _evas_pixel_avx2_store_24(dst + i * 3,
+                               _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(src + i)), shuf));
+   _evas_pixel_c_to_bgr24(dst + i * 3, src + i, len - i);
+}
+
+EVAS_PIXEL_AVX2 static void
+_evas_pixel_avx2_to_bgra32(unsigned int *dst, const unsigned int *src, int len)
+{
+   const __m256i shuf = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4,
+                                         11, 10, 9, 8, 15, 14, 13, 12,
+                                         3, 2, 1, 0, 7, 6, 5, 4,
+                                         11, 10, 9, 8, 15, 14, 13, 12);
+   int i;
+
+   for (i = 0; i + 8 <= len; i += 8)
+     _mm256_storeu_si256((__m256i *)(dst + i),
+                         _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(src + i)), shuf));
+   _evas_pixel_c_to_bgra32(dst + i, src + i, len - i);
+}
+
+EVAS_PIXEL_AVX2 static void
+_evas_pixel_avx2_to_rgb32(unsigned int *dst, const unsigned int *src, int len)
+{
+   const __m256i m = _mm256_set1_epi32(0x00ffffff);
+   int i;
+
+   for (i = 0; i + 8 <= len; i += 8)
+     _mm256_storeu_si256((__m256i *)(dst + i),
+                         _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(src + i)), m));
+   _evas_pixel_c_to_rgb32(dst + i, src + i, len - i);
+}
+
+static const Evas_Pixel_Kernels _evas_pixel_kernels_avx2 =
+{
+   EVAS_PIXEL_KERNEL_SET_AVX2, "avx2",
+   _evas_pixel_avx2_blend,
+   _evas_pixel_avx2_blend_color,
+   _evas_pixel_avx2_blend_mask,
+   _evas_pixel_avx2_scale_smooth,
+   _evas_pixel_avx2_to_rgb565,
+   _evas_pixel_avx2_to_rgb24,
+   _evas_pixel_avx2_to_bgr24,
+   _evas_pixel_avx2_to_bgra32,
+   _evas_pixel_avx2_to_rgb32
+};
+
+#endif
+
+#ifdef EVAS_PIXEL_NEON
+
+/* NEON, 8 pixels at a time, split in planes by vld4. d * (256 - a) is
+ * done as (d << 8) - d * a to stay in 8 bit multiplies. */
+
+static inline uint8x8_t
+_evas_pixel_neon_mul_inv(uint8x8_t c, uint8x8_t a)
+{
+   return vshrn_n_u16(vsubq_u16(vshll_n_u8(c, 8), vmull_u8(c, a)), 8);
+}
+
+static inline uint8x8_t
+_evas_pixel_neon_mul_sym(uint8x8_t c, uint8x8_t f)
+{
+   return vshrn_n_u16(vaddw_u8(vmull_u8(c, f), c), 8);
+}
+
+static inline void
+_evas_pixel_neon_over(uint8x8x4_t *d, const uint8x8x4_t *s)
+{
+   int k;
+
+   for (k = 0; k < 4; k++)
+     d->val[k] = vqadd_u8(s->val[k], _evas_pixel_neon_mul_inv(d->val[k], s->val[3]));
+}
+
+static void
+_evas_pixel_neon_blend(unsigned int *dst, const unsigned int *src, int len)
+{
+   int i;
+
+   for (i = 0; i + 8 <= len; i += 8)
+     {
+        uint8x8x4_t s = vld4_u8((const uint8_t *)(src + i));
+        uint8x8x4_t d = vld4_u8((const uint8_t *)(dst + i));
+
+        _evas_pixel_neon_over(&d, &s);
+        vst4_u8((uint8_t *)(dst + i), d);
+     }
+   _evas_pixel_c_blend(dst + i, src + i, len - i);
+}
+
+static void
+_evas_pixel_neon_blend_color(unsigned int *dst, const unsigned int *src,
+                             unsigned int color, int len)
+{
+   uint8x8_t col[4];
+   int i, k;
+
+   for (k = 0; k < 4; k++)
+     col[k] = vdup_n_u8((color >> (k * 8)) & 0xff);
+   for (i = 0; i + 8 <= len; i += 8)
+     {
+        uint8x8x4_t s = vld4_u8((const uint8_t *)(src + i));
+        uint8x8x4_t d = vld4_u8((const uint8_t *)(dst + i));
+
+        for (k = 0; k < 4; k++)
+          s.val[k] = _evas_pixel_neon_mul_sym(s.val[k], col[k]);
+        _evas_pixel_neon_over(&d, &s);
+        vst4_u8((uint8_t *)(dst + i), d);
+     }
+   _evas_pixel_c_blend_color(dst + i, src + i, color, len - i);
+}
+
+static void
+_evas_pixel_neon_blend_mask(unsigned int *dst, const unsigned int *src,
+                            const unsigned char *mask, int len)
+{
+   int i, k;
+
+   for (i = 0; i + 8 <= len; i += 8)
+     {
+        uint8x8x4_t s = vld4_u8((const uint8_t *)(src + i));
+        uint8x8x4_t d = vld4_u8((const uint8_t *)(dst + i));
+        uint8x8_t m = vld1_u8(mask + i);
+
+        for (k = 0; k < 4; k++)
+          s.val[k] = _evas_pixel_neon_mul_sym(s.val[k], m);
+        _evas_pixel_neon_over(&d, &s);
+        vst4_u8((uint8_t *)(dst + i), d);
+     }
+   _evas_pixel_c_blend_mask(dst + i, src + i, mask + i, len - i);
+}
+
+static inline uint8x8_t
+_evas_pixel_neon_lerp(uint8x8_t c0, uint8x8_t c1, uint8x8_t f)
+{
+   return vadd_u8(_evas_pixel_neon_mul_inv(c0, f),
+                  vshrn_n_u16(vmull_u8(c1, f), 8));
+}
+
+static void
+_evas_pixel_neon_scale_smooth(unsigned int *dst, int len,
+                              const unsigned int *row0, const unsigned int *row1,
+                              int sw, int sx, int step, int fy)
+{
+   uint8x8_t vfy = vdup_n_u8(fy);
+   int i, k;
+
+   for (i = 0; i + 8 <= len; i += 8)
+     {
+        unsigned int p[4][8];
+        unsigned char f[8];
+        uint8x8x4_t p00, p01, p10, p11, out;
+        uint8x8_t fx;
+
+        for (k = 0; k < 8; k++, sx += step)
+          {
+             int x = sx >> 16, x1 = x + 1;
+
+             if (x > sw - 1) x = sw - 1;
+             if (x1 > sw - 1) x1 = sw - 1;
+             p[0][k] = row0[x];
+             p[1][k] = row0[x1];
+             p[2][k] = row1[x];
+             p[3][k] = row1[x1];
+             f[k] = sx >> 8;
+          }
+        fx = vld1_u8(f);
+        p00 = vld4_u8((const uint8_t *)p[0]);
+        p01 = vld4_u8((const uint8_t *)p[1]);
+        p10 = vld4_u8((const uint8_t *)p[2]);
+        p11 = vld4_u8((const uint8_t *)p[3]);
+        for (k = 0; k < 4; k++)
+          out.val[k] = _evas_pixel_neon_lerp(_evas_pixel_neon_lerp(p00.val[k], p01.val[k], fx),
+                                             _evas_pixel_neon_lerp(p10.val[k], p11.val[k], fx),
+                                             vfy);
+        vst4_u8((uint8_t *)(dst + i), out);
+     }
+   _evas_pixel_c_scale_smooth(dst + i, len - i, row0, row1, sw, sx, step, fy);
+}
+
+static void
+_evas_pixel_neon_to_rgb565(unsigned short *dst, const unsigned int *src, int len)
+{
+   int i;
+
+   for (i = 0; i + 8 <= len; i += 8)
+     {
+        uint8x8x4_t s = vld4_u8((const uint8_t *)(src + i));
+        uint16x8_t v = vshll_n_u8(s.val[2], 8);
+
+        v = vsriq_n_u16(v, vshll_n_u8(s.val[1], 8), 5);
+        v = vsriq_n_u16(v, vshll_n_u8(s.val[0], 8), 11);
+        vst1q_u16(dst + i, v);
+     }
+   _evas_pixel_c_to_rgb565(dst + i, src + i, len - i);
+}
+
+static void
+_evas_pixel_neon_to_rgb24(unsigned char *dst, const unsigned int *src, int len)
+{
+   int i;
+
+   for (i = 0; i + 8 <= len; i += 8)
+     {
+        uint8x8x4_t s = vld4_u8((const uint8_t *)(src + i));
+        uint8x8x3_t d;
+
+        d.val[0] = s.val[2];
+        d.val[1] = s.val[1];
+        d.val[2] = s.val[0];
+        vst3_u8(dst + i * 3, d);
+     }
+   _evas_pixel_c_to_rgb24(dst + i * 3, src + i, len - i);
+}
+
+static void
+_evas_pixel_neon_to_bgr24(unsigned char *dst, const unsigned int *src, int len)
+{
+   int i;
+
+   for (i = 0; i + 8 <= len; i += 8)
+     {
+        uint8x8x4_t s = vld4_u8((const uint8_t *)(src + i));
+        uint8x8x3_t d;
+
+        d.val[0] = s.val[0];
+        d.val[1] = s.val[1];
+        d.val[2] = s.val[2];
+        vst3_u8(dst + i * 3, d);
+     }
+   _evas_pixel_c_to_bgr24(dst + i * 3, src + i, len - i);
+}
+
+static void
+_evas_pixel_neon_to_bgra32(unsigned int *dst, const unsigned int *src, int len)
+{
+   int i;
+
+   for (i = 0; i + 8 <= len; i += 8)
+     {
+        uint8x8x4_t s = vld4_u8((const uint8_t *)(src + i));
+        uint8x8x4_t d;
+
+        d.val[0] = s.val[3];
+        d.val[1] = s.val[2];
+        d.val[2] = s.val[1];
+        d.val[3] = s.val[0];
+        vst4_u8((uint8_t *)(dst + i), d);
+     }
+   _evas_pixel_c_to_bgra32(dst + i, src + i, len - i);
+}
+
+static void
+_evas_pixel_neon_to_rgb32(unsigned int *dst, const unsigned int *src, int len)
+{
+   const uint32x4_t m = vdupq_n_u32(0x00ffffff);
+   int i;
+
+   for (i = 0; i + 4 <= len; i += 4)
+     vst1q_u32(dst + i, vandq_u32(vld1q_u32(src + i), m));
+   _evas_pixel_c_to_rgb32(dst + i, src + i, len - i);
+}
+
+static const Evas_Pixel_Kernels _evas_pixel_kernels_neon =
+{
+   EVAS_PIXEL_KERNEL_SET_NEON, "neon",
+   _evas_pixel_neon_blend,
+   _evas_pixel_neon_blend_color,
+   _evas_pixel_neon_blend_mask,
+   _evas_pixel_neon_scale_smooth,
+   _evas_pixel_neon_to_rgb565,
+   _evas_pixel_neon_to_rgb24,
+   _evas_pixel_neon_to_bgr24,
+   _evas_pixel_neon_to_bgra32,
+   _evas_pixel_neon_to_rgb32
+};
+
+#endif
+
+/**
+ * @endcond
+ */
+
+static inline const Evas_Pixel_Kernels *
+evas_pixel_kernels_find(Evas_Pixel_Kernel_Set set)
+{
+   switch (set)
+     {
+      case EVAS_PIXEL_KERNEL_SET_C:
+        return &_evas_pixel_kernels_c;
+#ifdef EVAS_PIXEL_X86
+      case EVAS_PIXEL_KERNEL_SET_SSE41:
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("sse4.1")) return &_evas_pixel_kernels_sse41;
+        return NULL;
+      case EVAS_PIXEL_KERNEL_SET_AVX2:
+        /* Eina does not know about AVX2, and the compiler checks the os
+         * saves the registers too. */
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return &_evas_pixel_kernels_avx2;
+        return NULL;
+#endif
+#ifdef EVAS_PIXEL_NEON
+      case EVAS_PIXEL_KERNEL_SET_NEON:
+# ifndef __aarch64__
+        if (!(eina_cpu_features_get() & EINA_CPU_NEON)) return NULL;
+# endif
+        return &_evas_pixel_kernels_neon;
+#endif
+      default:
+        return NULL;
+     }
+}
+
+static inline const Evas_Pixel_Kernels *
+evas_pixel_kernels_get(void)
+{
+   static const struct {
+      const char *name;
+      Evas_Pixel_Kernel_Set set;
+   } order[] = {
+      { "avx2", EVAS_PIXEL_KERNEL_SET_AVX2 },
+      { "sse4.1", EVAS_PIXEL_KERNEL_SET_SSE41 },
+      { "neon", EVAS_PIXEL_KERNEL_SET_NEON },
+      { "c", EVAS_PIXEL_KERNEL_SET_C }
+   };
+   /* The tables are those of this file, so is the choice. Racing threads
+    * may each make it, they store the same pointer. */
+   static const Evas_Pixel_Kernels *kernels = NULL;
+   const Evas_Pixel_Kernels *k;
+   const char *env;
+   unsigned int i;
+
+   k = __atomic_load_n(&kernels, __ATOMIC_ACQUIRE);
+   if (k) return k;
+
+   env = getenv("EVAS_PIXEL_KERNELS");
+   if (env)
+     {
+        for (i = 0; i < sizeof(order) / sizeof(order[0]); i++)
+          if (!strcmp(env, order[i].name))
+            k = evas_pixel_kernels_find(order[i].set);
+     }
+   for (i = 0; (!k) && (i < sizeof(order) / sizeof(order[0])); i++)
+     k = evas_pixel_kernels_find(order[i].set);
+
+   __atomic_store_n(&kernels, k, __ATOMIC_RELEASE);
+   return k;
+}
+
+#endif